@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "hdr_hist.h"
+
+int hdr_hist_init(hdr_hist_t *h, uint8_t precision_bits) {
+    if (precision_bits < 2 || precision_bits > 16) return -1;
+
+    memset(h, 0, sizeof(*h));
+    h->precision_bits = precision_bits;
+    h->bucket_count = (1u << precision_bits) + (64u - precision_bits) * (1u << (precision_bits - 1));
+    h->counts = calloc(h->bucket_count, sizeof(*h->counts));
+    if (!h->counts) return -1;
+
+    h->min = UINT64_MAX;
+    return 0;
+}
+
+void hdr_hist_free(hdr_hist_t *h) {
+    free(h->counts);
+    h->counts = NULL;
+}
+
+void hdr_hist_reset(hdr_hist_t *h) {
+    memset(h->counts, 0, h->bucket_count * sizeof(*h->counts));
+    h->total = h->sum = h->max = 0;
+    h->min = UINT64_MAX;
+}
+
+int hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src) {
+    if (dst->precision_bits != src->precision_bits) return -1;
+
+    for (uint32_t i = 0; i < dst->bucket_count; i++) dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    return 0;
+}
+
+// Highest value that maps to bucket idx
+static uint64_t hdr_hist_bucket_top(const hdr_hist_t *h, uint32_t idx) {
+    uint32_t s = h->precision_bits;
+    uint32_t linear = 1u << s, half = 1u << (s - 1);
+
+    if (idx < linear) return idx;
+
+    uint32_t m = s + (idx - linear) / half;
+    uint64_t sub = (idx - linear) % half + half;
+    uint64_t width = 1ull << (m - s + 1);
+    return sub * width + width - 1;
+}
+
+uint64_t hdr_hist_percentile(const hdr_hist_t *h, double percentile) {
+    if (!h->total) return 0;
+    if (percentile >= 100.0) return h->max;
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)h->total + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < h->bucket_count; i++) {
+        seen += h->counts[i];
+        if (seen >= target) {
+            uint64_t top = hdr_hist_bucket_top(h, i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+void hdr_hist_print(FILE *out, const char *label, const hdr_hist_t *h) {
+    if (!h->total) {
+        fprintf(out, "  %-22s no samples\n", label);
+        return;
+    }
+    fprintf(out, "  %-22s n=%-10llu min=%-7llu p50=%-7llu p99=%-7llu p99.9=%-7llu max=%-7llu mean=%.1f\n",
+            label,
+            (unsigned long long)h->total,
+            (unsigned long long)h->min,
+            (unsigned long long)hdr_hist_percentile(h, 50.0),
+            (unsigned long long)hdr_hist_percentile(h, 99.0),
+            (unsigned long long)hdr_hist_percentile(h, 99.9),
+            (unsigned long long)h->max,
+            (double)h->sum / (double)h->total);
+}
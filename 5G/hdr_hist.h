@@ -0,0 +1,63 @@
+// hdr_hist.h
+#ifndef _HDR_HIST_H_
+#define _HDR_HIST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * HDR (High Dynamic Range) latency histogram
+ *
+ * Description:
+ * Log-linear bucketing in the style of HdrHistogram: values below
+ * 2^precision_bits get their own bucket, every power-of-two range above is
+ * split into 2^(precision_bits - 1) equal sub-buckets. The relative error
+ * of any recorded value is therefore bounded by 2^-(precision_bits - 1)
+ * across the full 64-bit range, with a fixed, small counts array and an
+ * O(1) record path (one clz and a few shifts).
+ *
+ * With precision_bits = 7 the error is below 1.6% and the counts array is
+ * 3776 entries.
+ */
+typedef struct hdr_hist {
+    uint64_t *counts;
+    uint32_t bucket_count;
+    uint8_t  precision_bits;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+} hdr_hist_t;
+
+int  hdr_hist_init(hdr_hist_t *h, uint8_t precision_bits);
+void hdr_hist_free(hdr_hist_t *h);
+void hdr_hist_reset(hdr_hist_t *h);
+
+// Index of the bucket holding value
+static inline uint32_t hdr_hist_index(const hdr_hist_t *h, uint64_t value) {
+    uint32_t s = h->precision_bits;
+    if (value < (1ull << s)) return (uint32_t)value;
+
+    uint32_t m = 63 - (uint32_t)__builtin_clzll(value);
+    return (1u << s) + (m - s) * (1u << (s - 1)) +
+           (uint32_t)((value >> (m - s + 1)) - (1ull << (s - 1)));
+}
+
+static inline void hdr_hist_record(hdr_hist_t *h, uint64_t value) {
+    h->counts[hdr_hist_index(h, value)]++;
+    h->total++;
+    h->sum += value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+// Add all samples of src into dst (same precision required)
+int hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src);
+
+// Value at percentile (0-100), reported as the highest value of its bucket
+uint64_t hdr_hist_percentile(const hdr_hist_t *h, double percentile);
+
+// One line "count min p50 p99 p99.9 max mean" summary
+void hdr_hist_print(FILE *out, const char *label, const hdr_hist_t *h);
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * RRC decode benchmark
+ *
+ * Loads a corpus of UPER encoded messages from disk and runs the decoders
+ * from rrc_decoder.c over it, first on one thread and then on N threads.
+ * Reports throughput plus p50/p99/p99.9 decode latency (HDR histograms)
+ * and heap allocations per message for every channel.
+ *
+ * Corpus layout (one raw UPER message per file, any file name):
+ *   <corpus>/bcch-bch/      MIB
+ *   <corpus>/bcch-dl-sch/   SIB1 / SystemInformation
+ *   <corpus>/dl-dcch/       RRCReconfiguration, SecurityModeCommand, ...
+ *
+ * Build (allocation counting needs the --wrap link flags):
+ *   gcc -O2 -pthread -DRRC_BENCH_COUNT_ALLOCS \
+ *       -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc \
+ *       -I<asn1c output> rrc_bench.c rrc_decoder.c hdr_hist.c <asn1c objects> -o rrc_bench
+ *
+ * Usage:
+ *   ./rrc_bench <corpus> [-t threads] [-n iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "rrc_decoder.h"
+#include "hdr_hist.h"
+
+#define BENCH_PRECISION_BITS 7
+
+static const char *const corpus_dirs[RRC_CHANNEL_COUNT] = {
+    [RRC_CHANNEL_BCCH_BCH]    = "bcch-bch",
+    [RRC_CHANNEL_BCCH_DL_SCH] = "bcch-dl-sch",
+    [RRC_CHANNEL_DL_DCCH]     = "dl-dcch",
+};
+
+/*----------------------------------------------------------------------------
+ * Allocation counting
+ *--------------------------------------------------------------------------*/
+
+static __thread uint64_t bench_allocs;
+
+#ifdef RRC_BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) { bench_allocs++; return __real_malloc(size); }
+void *__wrap_calloc(size_t nmemb, size_t size) { bench_allocs++; return __real_calloc(nmemb, size); }
+void *__wrap_realloc(void *ptr, size_t size) { bench_allocs++; return __real_realloc(ptr, size); }
+#endif
+
+/*----------------------------------------------------------------------------
+ * Corpus
+ *--------------------------------------------------------------------------*/
+
+typedef struct corpus_msg {
+    uint8_t *data;
+    size_t size;
+} corpus_msg_t;
+
+typedef struct corpus {
+    corpus_msg_t *msgs[RRC_CHANNEL_COUNT];
+    size_t count[RRC_CHANNEL_COUNT];
+} corpus_t;
+
+static int corpus_load_file(const char *path, corpus_msg_t *msg) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    msg->data = size > 0 ? malloc((size_t)size) : NULL;
+    msg->size = (size_t)size;
+    int ok = msg->data && fread(msg->data, 1, msg->size, f) == msg->size;
+    fclose(f);
+    if (!ok) free(msg->data);
+    return ok ? 0 : -1;
+}
+
+static int corpus_load(corpus_t *c, const char *root) {
+    char path[4096];
+    size_t total = 0;
+
+    memset(c, 0, sizeof(*c));
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) {
+        snprintf(path, sizeof(path), "%s/%s", root, corpus_dirs[ch]);
+        DIR *dir = opendir(path);
+        if (!dir) continue;
+
+        size_t cap = 0;
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL) {
+            if (de->d_name[0] == '.') continue;
+            if (c->count[ch] == cap) {
+                cap = cap ? cap * 2 : 64;
+                corpus_msg_t *grown = realloc(c->msgs[ch], cap * sizeof(*grown));
+                if (!grown) break;
+                c->msgs[ch] = grown;
+            }
+            snprintf(path, sizeof(path), "%s/%s/%s", root, corpus_dirs[ch], de->d_name);
+            if (corpus_load_file(path, &c->msgs[ch][c->count[ch]]) == 0) c->count[ch]++;
+        }
+        closedir(dir);
+        total += c->count[ch];
+    }
+    return total ? 0 : -1;
+}
+
+static void corpus_free(corpus_t *c) {
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) {
+        for (size_t i = 0; i < c->count[ch]; i++) free(c->msgs[ch][i].data);
+        free(c->msgs[ch]);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Workers
+ *--------------------------------------------------------------------------*/
+
+typedef struct bench_result {
+    hdr_hist_t latency[RRC_CHANNEL_COUNT];   // ns per decode
+    uint64_t decoded[RRC_CHANNEL_COUNT];
+    uint64_t failed[RRC_CHANNEL_COUNT];
+    uint64_t allocs[RRC_CHANNEL_COUNT];
+} bench_result_t;
+
+typedef struct bench_worker {
+    pthread_t thread;
+    const corpus_t *corpus;
+    int iterations;
+    bench_result_t result;
+} bench_worker_t;
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_result_init(bench_result_t *r) {
+    memset(r, 0, sizeof(*r));
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++)
+        if (hdr_hist_init(&r->latency[ch], BENCH_PRECISION_BITS) < 0) return -1;
+    return 0;
+}
+
+static void bench_result_free(bench_result_t *r) {
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) hdr_hist_free(&r->latency[ch]);
+}
+
+static void *bench_worker_run(void *arg) {
+    bench_worker_t *w = arg;
+    bench_result_t *r = &w->result;
+
+    for (int it = 0; it < w->iterations; it++) {
+        for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) {
+            asn_TYPE_descriptor_t *td = rrc_channel_descriptor((rrc_channel_t)ch);
+            for (size_t i = 0; i < w->corpus->count[ch]; i++) {
+                const corpus_msg_t *m = &w->corpus->msgs[ch][i];
+
+                uint64_t allocs = bench_allocs;
+                uint64_t t0 = bench_now_ns();
+                void *msg = rrc_decode((rrc_channel_t)ch, m->data, m->size);
+                uint64_t t1 = bench_now_ns();
+                r->allocs[ch] += bench_allocs - allocs;
+
+                hdr_hist_record(&r->latency[ch], t1 - t0);
+                if (msg) {
+                    r->decoded[ch]++;
+                    ASN_STRUCT_FREE(*td, msg);
+                } else {
+                    r->failed[ch]++;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int bench_run(const corpus_t *corpus, int threads, int iterations) {
+    bench_worker_t *workers = calloc((size_t)threads, sizeof(*workers));
+    bench_result_t total;
+
+    if (!workers || bench_result_init(&total) < 0) {
+        free(workers);
+        return -1;
+    }
+    for (int t = 0; t < threads; t++) {
+        workers[t].corpus = corpus;
+        workers[t].iterations = iterations;
+        if (bench_result_init(&workers[t].result) < 0) {
+            for (int i = 0; i <= t; i++) bench_result_free(&workers[i].result);
+            bench_result_free(&total);
+            free(workers);
+            return -1;
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int t = 0; t < threads; t++)
+        pthread_create(&workers[t].thread, NULL, bench_worker_run, &workers[t]);
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) {
+            hdr_hist_merge(&total.latency[ch], &workers[t].result.latency[ch]);
+            total.decoded[ch] += workers[t].result.decoded[ch];
+            total.failed[ch] += workers[t].result.failed[ch];
+            total.allocs[ch] += workers[t].result.allocs[ch];
+        }
+        bench_result_free(&workers[t].result);
+    }
+    double elapsed = (double)(bench_now_ns() - start) / 1e9;
+
+    uint64_t msgs = 0;
+    printf("\n--- %d thread(s), %d iteration(s), %.3f s ---\n", threads, iterations, elapsed);
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++) {
+        uint64_t n = total.latency[ch].total;
+        if (!n) continue;
+        msgs += n;
+        printf("%s: %.0f msg/s, %llu ok, %llu failed, %.1f allocs/msg\n",
+               rrc_channel_name((rrc_channel_t)ch), (double)n / elapsed,
+               (unsigned long long)total.decoded[ch], (unsigned long long)total.failed[ch],
+               (double)total.allocs[ch] / (double)n);
+        hdr_hist_print(stdout, "latency (ns)", &total.latency[ch]);
+    }
+    printf("Total: %.0f msg/s\n", (double)msgs / elapsed);
+
+    bench_result_free(&total);
+    free(workers);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int threads = 4, iterations = 1000;
+    const char *root = NULL;
+    corpus_t corpus;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else root = argv[i];
+    }
+    if (!root || threads < 1 || iterations < 1) {
+        fprintf(stderr, "usage: %s <corpus> [-t threads] [-n iterations]\n", argv[0]);
+        return 1;
+    }
+
+    if (corpus_load(&corpus, root) < 0) {
+        fprintf(stderr, "No messages found under %s\n", root);
+        return 1;
+    }
+    printf("=== RRC Decode Benchmark ===\n");
+    for (int ch = 0; ch < RRC_CHANNEL_COUNT; ch++)
+        printf("  %-16s %zu message(s)\n", rrc_channel_name((rrc_channel_t)ch), corpus.count[ch]);
+#ifndef RRC_BENCH_COUNT_ALLOCS
+    printf("  (built without RRC_BENCH_COUNT_ALLOCS, allocs/msg reads 0)\n");
+#endif
+
+    rrc_decoder_set_verbose(0);
+    int ret = bench_run(&corpus, 1, iterations);
+    if (ret == 0 && threads > 1) ret = bench_run(&corpus, threads, iterations);
+    if (ret < 0) fprintf(stderr, "Out of memory for the latency histograms\n");
+
+    corpus_free(&corpus);
+    return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+// rrc_channel.h
+#ifndef _RRC_CHANNEL_H_
+#define _RRC_CHANNEL_H_
+
+/**
+ * RRC logical channels handled by the decoders
+ *
+ * Reference: 3GPP TS 38.331 Section 6.2.1
+ *
+ * The numeric values are stored in frozen records and on the wire of the
+ * decode daemon, so they must never be renumbered. Kept apart from
+ * rrc_decoder.h so that code sized by RRC_CHANNEL_COUNT (the L2
+ * statistics region) does not need the asn1c headers.
+ */
+typedef enum rrc_channel {
+    RRC_CHANNEL_BCCH_BCH    = 0,   // MIB
+    RRC_CHANNEL_BCCH_DL_SCH = 1,   // SIB1 / SystemInformation
+    RRC_CHANNEL_DL_DCCH     = 2,   // Dedicated DL signalling
+    RRC_CHANNEL_COUNT
+} rrc_channel_t;
+
+#endif
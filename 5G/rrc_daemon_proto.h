@@ -0,0 +1,115 @@
+// rrc_daemon_proto.h
+#ifndef _RRC_DAEMON_PROTO_H_
+#define _RRC_DAEMON_PROTO_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/**
+ * RRC decode daemon wire protocol and shared-memory ring
+ *
+ * Description:
+ * Clients connect to the daemon's UNIX stream socket. On accept the daemon
+ * creates a memfd holding a single-producer / single-consumer ring of
+ * decode summaries and passes it to the client with SCM_RIGHTS alongside
+ * an rrcd_hello_t. The client mmaps it and from then on reads results
+ * straight out of shared memory.
+ *
+ * Request (client -> daemon), length prefixed:
+ * +------------------+------------------+------------------+-----+
+ * | rrcd_batch_hdr_t | rrcd_req_entry_t | message bytes    | ... |
+ * | 16 bytes         | 4 bytes          | entry.len bytes  |     |
+ * +------------------+------------------+------------------+-----+
+ * batch_len counts everything after the batch header.
+ *
+ * Response:
+ * - One rrcd_summary_t per request entry is pushed to the ring
+ * - Then an rrcd_batch_ack_t is written to the socket so the client can
+ *   block on the socket instead of spinning on the ring
+ *
+ * When the ring is full, the remaining summaries of the batch are dropped
+ * and counted in the ack; the daemon never waits on a slow client.
+ */
+#define RRCD_MAGIC             0x44435252u   // "RRCD"
+#define RRCD_VERSION           1
+#define RRCD_DEFAULT_SOCKET    "/tmp/rrcd.sock"
+#define RRCD_MAX_BATCH_BYTES   (1u << 20)
+#define RRCD_CACHELINE         64
+
+typedef struct rrcd_hello {
+    uint32_t magic;            // RRCD_MAGIC
+    uint32_t version;          // RRCD_VERSION
+    uint32_t ring_entries;     // Power of two
+    uint32_t ring_bytes;       // Size to mmap
+} rrcd_hello_t;
+
+typedef struct rrcd_batch_hdr {
+    uint32_t magic;            // RRCD_MAGIC
+    uint32_t batch_id;         // Echoed in summaries and the ack
+    uint32_t count;            // Number of request entries
+    uint32_t batch_len;        // Bytes following this header
+} rrcd_batch_hdr_t;
+
+typedef struct rrcd_req_entry {
+    uint8_t  channel;          // rrc_channel_t
+    uint8_t  rsv;              // Reserved (set to 0)
+    uint16_t len;              // UPER message length in bytes
+    // Message bytes follow
+} rrcd_req_entry_t;
+
+typedef enum rrcd_status {
+    RRCD_STATUS_OK          = 0,
+    RRCD_STATUS_DECODE_FAIL = 1,
+    RRCD_STATUS_BAD_CHANNEL = 2,
+} rrcd_status_t;
+
+typedef struct rrcd_summary {
+    uint32_t batch_id;         // Batch the entry came from
+    uint16_t index;            // Entry index inside the batch
+    uint8_t  channel;          // rrc_channel_t
+    uint8_t  status;           // rrcd_status_t
+    uint8_t  msg_type;         // c1 choice present value
+    uint8_t  transaction_id;   // 0-3 or 0xFF
+    uint16_t len;              // Request message length
+    uint32_t decode_ns;        // Time spent in the decoder
+} rrcd_summary_t;
+
+typedef struct rrcd_batch_ack {
+    uint32_t magic;            // RRCD_MAGIC
+    uint32_t batch_id;
+    uint32_t written;          // Summaries pushed to the ring
+    uint32_t dropped;          // Summaries lost to a full ring
+} rrcd_batch_ack_t;
+
+/**
+ * Shared-memory summary ring
+ *
+ * head is only written by the daemon, tail only by the client; they live
+ * on separate cache lines so the two sides never false-share.
+ */
+typedef struct rrcd_ring {
+    uint32_t magic;
+    uint32_t entries;          // Power of two
+    _Alignas(RRCD_CACHELINE) _Atomic uint64_t head;   // Next slot the daemon writes
+    _Alignas(RRCD_CACHELINE) _Atomic uint64_t tail;   // Next slot the client reads
+    _Alignas(RRCD_CACHELINE) rrcd_summary_t slots[];
+} rrcd_ring_t;
+
+static inline uint32_t rrcd_ring_bytes(uint32_t entries) {
+    return (uint32_t)(sizeof(rrcd_ring_t) + (uint64_t)entries * sizeof(rrcd_summary_t));
+}
+
+// Client side: copy up to max pending summaries out of the ring
+static inline uint32_t rrcd_ring_pop(rrcd_ring_t *ring, rrcd_summary_t *out, uint32_t max) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t n = 0;
+
+    while (tail != head && n < max)
+        out[n++] = ring->slots[tail++ & (ring->entries - 1)];
+
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    return n;
+}
+
+#endif
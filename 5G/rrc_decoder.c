@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "rrc_decoder.h"
+
+// Decoder console output, switched off by tools that decode in a loop
+static int rrc_decoder_verbose = 1;
+
+#define RRC_LOG(stream, ...) do { if (rrc_decoder_verbose) fprintf(stream, __VA_ARGS__); } while (0)
+
+void rrc_decoder_set_verbose(int verbose) {
+    rrc_decoder_verbose = verbose;
+}
+
+static asn_TYPE_descriptor_t *const rrc_channel_descriptors[RRC_CHANNEL_COUNT] = {
+    [RRC_CHANNEL_BCCH_BCH]    = &asn_DEF_MIB,
+    [RRC_CHANNEL_BCCH_DL_SCH] = &asn_DEF_BCCH_DL_SCH_Message,
+    [RRC_CHANNEL_DL_DCCH]     = &asn_DEF_DL_DCCH_Message,
+};
+
+static const char *const rrc_channel_names[RRC_CHANNEL_COUNT] = {
+    [RRC_CHANNEL_BCCH_BCH]    = "BCCH-BCH (MIB)",
+    [RRC_CHANNEL_BCCH_DL_SCH] = "BCCH-DLSCH",
+    [RRC_CHANNEL_DL_DCCH]     = "DL-DCCH",
+};
+
+asn_TYPE_descriptor_t *rrc_channel_descriptor(rrc_channel_t channel) {
+    if ((unsigned)channel >= RRC_CHANNEL_COUNT) return NULL;
+    return rrc_channel_descriptors[channel];
+}
+
+const char *rrc_channel_name(rrc_channel_t channel) {
+    if ((unsigned)channel >= RRC_CHANNEL_COUNT) return "unknown";
+    return rrc_channel_names[channel];
+}
+
+// 1.Decoder for BCCH-BCH (MIB) 
+MIB_t *decode_mib(const uint8_t *buffer, size_t size) {
+    MIB_t *mib_ptr = NULL;
+
+    asn_dec_rval_t rval = uper_decode_complete(
+        NULL,
+        &asn_DEF_MIB,
+        (void **)&mib_ptr,
+        buffer,
+        size
+    );
+
+    if (rval.code != RC_OK) {
+        RRC_LOG(stderr, " BCCH-BCH (MIB) decoding failed at byte %zd.\n", rval.consumed);
+        if (mib_ptr) ASN_STRUCT_FREE(asn_DEF_MIB, mib_ptr);
+        return NULL;
+    }
+    RRC_LOG(stdout, " BCCH-BCH (MIB) successfully decoded.\n");
+    return mib_ptr;
+}
+
+// 2.Decoder for BCCH-DLSCH 
+BCCH_DL_SCH_Message_t *decode_bcch_dlsch(const uint8_t *buffer, size_t size) {
+    BCCH_DL_SCH_Message_t *msg_ptr = NULL;
+
+    asn_dec_rval_t rval = uper_decode_complete(
+        NULL,
+        &asn_DEF_BCCH_DL_SCH_Message,
+        (void **)&msg_ptr,
+        buffer,
+        size
+    );
+
+    if (rval.code != RC_OK) {
+        RRC_LOG(stderr, " BCCH-DLSCH decoding failed at byte %zd.\n", rval.consumed);
+        if (msg_ptr) ASN_STRUCT_FREE(asn_DEF_BCCH_DL_SCH_Message, msg_ptr);
+        return NULL;
+    }
+
+    RRC_LOG(stdout, " BCCH-DLSCH container successfully decoded.\n");
+
+    if (msg_ptr->message.present == BCCH_DL_SCH_MessageType_PR_c1) {
+        BCCH_DL_SCH_MessageType__c1_PR type = msg_ptr->message.choice.c1.present;
+        switch (type) {
+            case BCCH_DL_SCH_MessageType__c1_PR_systemInformationBlockType1:
+                RRC_LOG(stdout, " -> Contained Payload: **SystemInformationBlockType1 (SIB1)**.\n");
+                break;
+            case BCCH_DL_SCH_MessageType__c1_PR_systemInformation:
+                RRC_LOG(stdout, " -> Contained Payload: **SystemInformation (Multiple SIBs)**.\n");
+                break;
+             default:
+                RRC_LOG(stdout, " -> Contained Payload: Unknown c1 message type.\n");
+        }
+    }
+    return msg_ptr;
+}
+
+
+// 3.Decoder for DL-DCCH
+DL_DCCH_Message_t *decode_dl_dcch(const uint8_t *buffer, size_t size) {
+    DL_DCCH_Message_t *msg_ptr = NULL;
+
+    asn_dec_rval_t rval = uper_decode_complete(
+        NULL,
+        &asn_DEF_DL_DCCH_Message,
+        (void **)&msg_ptr,
+        buffer,
+        size
+    );
+
+    if (rval.code != RC_OK) {
+        RRC_LOG(stderr, " DL-DCCH decoding failed at byte %zd.\n", rval.consumed);
+        if (msg_ptr) ASN_STRUCT_FREE(asn_DEF_DL_DCCH_Message, msg_ptr);
+        return NULL;
+    }
+
+    RRC_LOG(stdout, " DL-DCCH container successfully decoded.\n");
+
+    if (msg_ptr->message.present == DL_DCCH_MessageType_PR_c1) {
+        DL_DCCH_MessageType__c1_PR type = msg_ptr->message.choice.c1.present;
+
+        RRC_LOG(stdout, " -> Contained Message: ");
+        switch (type) {
+            case DL_DCCH_MessageType__c1_PR_rrcSetup:
+                RRC_LOG(stdout, "**RRCResume**\n");
+                break;
+            case DL_DCCH_MessageType__c1_PR_rrcReconfiguration:
+                RRC_LOG(stdout, "**RRCReconfiguration**\n");
+                break;
+            case DL_DCCH_MessageType__c1_PR_securityModeCommand:
+                RRC_LOG(stdout, "**SecurityModeCommand**\n");
+                break;
+            case DL_DCCH_MessageType__c1_PR_rrcRelease:
+                RRC_LOG(stdout, "**RRCRelease**\n");
+                break;
+            default:
+                RRC_LOG(stdout, "Unknown/Unhandled Dedicated Message Type.\n");
+        }
+    }
+    return msg_ptr;
+}
+
+
+RRC_TransactionIdentifier_t *rrc_dl_dcch_transaction_id(DL_DCCH_Message_t *msg) {
+    if (msg->message.present != DL_DCCH_MessageType_PR_c1) return NULL;
+
+    DL_DCCH_MessageType__c1_t *c1 = &msg->message.choice.c1;
+    switch (c1->present) {
+        case DL_DCCH_MessageType__c1_PR_rrcReconfiguration:
+            return &c1->choice.rrcReconfiguration.rrc_TransactionIdentifier;
+        case DL_DCCH_MessageType__c1_PR_rrcResume:
+            return &c1->choice.rrcResume.rrc_TransactionIdentifier;
+        case DL_DCCH_MessageType__c1_PR_rrcRelease:
+            return &c1->choice.rrcRelease.rrc_TransactionIdentifier;
+        case DL_DCCH_MessageType__c1_PR_securityModeCommand:
+            return &c1->choice.securityModeCommand.rrc_TransactionIdentifier;
+        case DL_DCCH_MessageType__c1_PR_ueCapabilityEnquiry:
+            return &c1->choice.ueCapabilityEnquiry.rrc_TransactionIdentifier;
+        default:
+            return NULL;
+    }
+}
+
+void *rrc_decode(rrc_channel_t channel, const uint8_t *buffer, size_t size) {
+    switch (channel) {
+        case RRC_CHANNEL_BCCH_BCH:    return decode_mib(buffer, size);
+        case RRC_CHANNEL_BCCH_DL_SCH: return decode_bcch_dlsch(buffer, size);
+        case RRC_CHANNEL_DL_DCCH:     return decode_dl_dcch(buffer, size);
+        default:                      return NULL;
+    }
+}
+
+void rrc_summarize(rrc_channel_t channel, const void *msg, uint8_t *msg_type, uint8_t *transaction_id) {
+    *msg_type = 0;
+    *transaction_id = 0xFF;
+
+    if (channel == RRC_CHANNEL_BCCH_DL_SCH) {
+        const BCCH_DL_SCH_Message_t *bcch = msg;
+        if (bcch->message.present == BCCH_DL_SCH_MessageType_PR_c1)
+            *msg_type = (uint8_t)bcch->message.choice.c1.present;
+    } else if (channel == RRC_CHANNEL_DL_DCCH) {
+        // The tree is only read, the cast is for the shared lookup helper
+        DL_DCCH_Message_t *dcch = (DL_DCCH_Message_t *)msg;
+        if (dcch->message.present != DL_DCCH_MessageType_PR_c1) return;
+
+        *msg_type = (uint8_t)dcch->message.choice.c1.present;
+        const RRC_TransactionIdentifier_t *tid = rrc_dl_dcch_transaction_id(dcch);
+        if (tid) *transaction_id = (uint8_t)*tid;
+    }
+}
+
+// Release whatever the decoders returned
+void cleanup_decoded_messages(MIB_t *mib, BCCH_DL_SCH_Message_t *bch_dl, DL_DCCH_Message_t *dcch) {
+    if (mib) ASN_STRUCT_FREE(asn_DEF_MIB, mib);
+    if (bch_dl) ASN_STRUCT_FREE(asn_DEF_BCCH_DL_SCH_Message, bch_dl);
+    if (dcch) ASN_STRUCT_FREE(asn_DEF_DL_DCCH_Message, dcch);
+    printf("\nMemory cleaned up.\n");
+}
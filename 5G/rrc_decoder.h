@@ -0,0 +1,54 @@
+// rrc_decoder.h
+#ifndef _RRC_DECODER_H_
+#define _RRC_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <asn_application.h>
+
+#include "rrc_channel.h"
+
+// include the headers for the 3 message types
+#include "MIB.h"
+#include "BCCH-DL-SCH-Message.h"
+#include "DL-DCCH-Message.h"
+
+extern asn_TYPE_descriptor_t asn_DEF_MIB;
+extern asn_TYPE_descriptor_t asn_DEF_BCCH_DL_SCH_Message;
+extern asn_TYPE_descriptor_t asn_DEF_DL_DCCH_Message;
+
+// Returns the asn1c descriptor for a channel, NULL if out of range
+asn_TYPE_descriptor_t *rrc_channel_descriptor(rrc_channel_t channel);
+
+// Returns a printable channel name ("BCCH-BCH (MIB)", ...)
+const char *rrc_channel_name(rrc_channel_t channel);
+
+// Enable (default) or silence the decoders' console output
+void rrc_decoder_set_verbose(int verbose);
+
+MIB_t *decode_mib(const uint8_t *buffer, size_t size);
+BCCH_DL_SCH_Message_t *decode_bcch_dlsch(const uint8_t *buffer, size_t size);
+DL_DCCH_Message_t *decode_dl_dcch(const uint8_t *buffer, size_t size);
+
+/**
+ * Location of the rrc-TransactionIdentifier inside a DL-DCCH c1 message,
+ * NULL for messages without one or outside c1.
+ */
+RRC_TransactionIdentifier_t *rrc_dl_dcch_transaction_id(DL_DCCH_Message_t *msg);
+
+/**
+ * Decode a message of any channel with the matching decoder above.
+ * Free the result with ASN_STRUCT_FREE on rrc_channel_descriptor(channel).
+ */
+void *rrc_decode(rrc_channel_t channel, const uint8_t *buffer, size_t size);
+
+/**
+ * Summary fields used by frozen records and the decode daemon:
+ * - msg_type: c1 "present" value (0 for MIB and non-c1 messages)
+ * - transaction_id: RRC-TransactionIdentifier, 0xFF if the message has none
+ */
+void rrc_summarize(rrc_channel_t channel, const void *msg, uint8_t *msg_type, uint8_t *transaction_id);
+
+void cleanup_decoded_messages(MIB_t *mib, BCCH_DL_SCH_Message_t *bch_dl, DL_DCCH_Message_t *dcch);
+
+#endif
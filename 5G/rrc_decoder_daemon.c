@@ -0,0 +1,324 @@
+/**
+ * RRC decode daemon
+ *
+ * Long-running replacement for spawning rrc_decoder_main per capture.
+ * Descriptors are initialised once, clients submit length-prefixed batches
+ * of (channel, bytes) over a UNIX socket and read decode summaries from a
+ * per-client shared-memory ring (see rrc_daemon_proto.h).
+ *
+ * A single epoll loop serves all clients; sockets are non-blocking and
+ * partial batches are buffered per client until complete.
+ *
+ * Usage:
+ *   ./rrc_decoder_daemon [-s socket_path] [-r ring_entries]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "rrc_decoder.h"
+#include "rrc_daemon_proto.h"
+
+#define RRCD_MAX_EVENTS     256
+#define RRCD_DEFAULT_RING   4096
+
+typedef struct rrcd_client {
+    int fd;
+    rrcd_ring_t *ring;
+    uint32_t ring_bytes;
+    // Private copies: the client can write the whole mapping, so only tail
+    // is read back from it, and only after clamping
+    uint32_t ring_entries;
+    uint32_t ring_mask;
+    uint64_t head;
+    uint8_t *rx;              // Partial batch buffer
+    size_t rx_len;
+    size_t rx_cap;
+    uint64_t acks_dropped;    // Batch acks lost to a full socket, reported on close
+} rrcd_client_t;
+
+static volatile sig_atomic_t rrcd_running = 1;
+
+static void rrcd_stop(int sig) {
+    (void)sig;
+    rrcd_running = 0;
+}
+
+static inline uint64_t rrcd_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+ * Client lifecycle
+ *--------------------------------------------------------------------------*/
+
+// Create the client's ring in a memfd and hand it over with SCM_RIGHTS
+static int rrcd_client_setup_ring(rrcd_client_t *c, uint32_t entries) {
+    int memfd = memfd_create("rrcd-ring", MFD_CLOEXEC);
+    if (memfd < 0) return -1;
+
+    c->ring_bytes = rrcd_ring_bytes(entries);
+    if (ftruncate(memfd, c->ring_bytes) < 0) goto fail;
+
+    c->ring = mmap(NULL, c->ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (c->ring == MAP_FAILED) {
+        c->ring = NULL;
+        goto fail;
+    }
+    c->ring->magic = RRCD_MAGIC;
+    c->ring->entries = entries;
+    c->ring_entries = entries;
+    c->ring_mask = entries - 1;
+    c->head = 0;
+    atomic_store(&c->ring->head, 0);
+    atomic_store(&c->ring->tail, 0);
+
+    rrcd_hello_t hello = { RRCD_MAGIC, RRCD_VERSION, entries, c->ring_bytes };
+    struct iovec iov = { &hello, sizeof(hello) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+    struct msghdr msg = { 0 };
+
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &memfd, sizeof(int));
+
+    if (sendmsg(c->fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(hello)) goto fail;
+
+    // The client holds its own reference now
+    close(memfd);
+    return 0;
+
+fail:
+    close(memfd);
+    return -1;
+}
+
+static void rrcd_client_close(int epfd, rrcd_client_t *c) {
+    if (c->acks_dropped)
+        fprintf(stderr, " rrcd: client fd %d: %llu batch ack(s) not sent, socket buffer full.\n", c->fd,
+                (unsigned long long)c->acks_dropped);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    if (c->ring) munmap(c->ring, c->ring_bytes);
+    free(c->rx);
+    free(c);
+}
+
+static void rrcd_accept(int epfd, int listen_fd, uint32_t ring_entries) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN: backlog drained
+
+        rrcd_client_t *c = calloc(1, sizeof(*c));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (rrcd_client_setup_ring(c, ring_entries) < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            fprintf(stderr, " rrcd: client setup failed: %s\n", strerror(errno));
+            close(fd);
+            if (c->ring) munmap(c->ring, c->ring_bytes);
+            free(c);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Batch processing
+ *--------------------------------------------------------------------------*/
+
+static void rrcd_process_batch(rrcd_client_t *c, const rrcd_batch_hdr_t *hdr, const uint8_t *p) {
+    rrcd_ring_t *ring = c->ring;
+    const uint8_t *end = p + hdr->batch_len;
+    uint64_t head = c->head;
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    // A tail outside [head - entries, head] is garbage: treat the ring as full
+    if (head - tail > c->ring_entries) tail = head - c->ring_entries;
+    rrcd_batch_ack_t ack = { RRCD_MAGIC, hdr->batch_id, 0, 0 };
+
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        rrcd_req_entry_t entry;
+        if ((size_t)(end - p) < sizeof(entry)) break;
+        memcpy(&entry, p, sizeof(entry));
+        p += sizeof(entry);
+        if ((size_t)(end - p) < entry.len) break;
+
+        if (head - tail >= c->ring_entries) {
+            ack.dropped++;
+            p += entry.len;
+            continue;
+        }
+
+        rrcd_summary_t *s = &ring->slots[head & c->ring_mask];
+        s->batch_id = hdr->batch_id;
+        s->index = (uint16_t)i;
+        s->channel = entry.channel;
+        s->len = entry.len;
+        s->msg_type = 0;
+        s->transaction_id = 0xFF;
+
+        asn_TYPE_descriptor_t *td = rrc_channel_descriptor((rrc_channel_t)entry.channel);
+        if (!td) {
+            s->status = RRCD_STATUS_BAD_CHANNEL;
+            s->decode_ns = 0;
+        } else {
+            uint64_t t0 = rrcd_now_ns();
+            void *msg = rrc_decode((rrc_channel_t)entry.channel, p, entry.len);
+            s->decode_ns = (uint32_t)(rrcd_now_ns() - t0);
+            if (msg) {
+                s->status = RRCD_STATUS_OK;
+                rrc_summarize((rrc_channel_t)entry.channel, msg, &s->msg_type, &s->transaction_id);
+                ASN_STRUCT_FREE(*td, msg);
+            } else {
+                s->status = RRCD_STATUS_DECODE_FAIL;
+            }
+        }
+        head++;
+        ack.written++;
+        p += entry.len;
+    }
+
+    // Publish the whole batch at once
+    c->head = head;
+    atomic_store_explicit(&ring->head, head, memory_order_release);
+
+    if (send(c->fd, &ack, sizeof(ack), MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)sizeof(ack))
+        c->acks_dropped++;
+}
+
+// Returns -1 when the client must be dropped (EOF, error or protocol violation)
+static int rrcd_client_read(rrcd_client_t *c) {
+    for (;;) {
+        if (c->rx_len == c->rx_cap) {
+            const size_t max = RRCD_MAX_BATCH_BYTES + sizeof(rrcd_batch_hdr_t);
+            size_t cap = c->rx_cap ? c->rx_cap * 2 : 64 * 1024;
+            if (c->rx_cap >= max) return -1;
+            if (cap > max) cap = max;
+            uint8_t *rx = realloc(c->rx, cap);
+            if (!rx) return -1;
+            c->rx = rx;
+            c->rx_cap = cap;
+        }
+
+        ssize_t n = read(c->fd, c->rx + c->rx_len, c->rx_cap - c->rx_len);
+        if (n == 0) return -1;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        c->rx_len += (size_t)n;
+
+        // Consume every complete batch in the buffer
+        size_t off = 0;
+        while (c->rx_len - off >= sizeof(rrcd_batch_hdr_t)) {
+            rrcd_batch_hdr_t hdr;
+            memcpy(&hdr, c->rx + off, sizeof(hdr));
+            if (hdr.magic != RRCD_MAGIC || hdr.batch_len > RRCD_MAX_BATCH_BYTES) return -1;
+            if (c->rx_len - off < sizeof(hdr) + hdr.batch_len) break;
+
+            rrcd_process_batch(c, &hdr, c->rx + off + sizeof(hdr));
+            off += sizeof(hdr) + hdr.batch_len;
+        }
+        if (off) {
+            memmove(c->rx, c->rx + off, c->rx_len - off);
+            c->rx_len -= off;
+        }
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Main loop
+ *--------------------------------------------------------------------------*/
+
+static int rrcd_listen(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char **argv) {
+    const char *path = RRCD_DEFAULT_SOCKET;
+    uint32_t ring_entries = RRCD_DEFAULT_RING;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) path = argv[++i];
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) ring_entries = (uint32_t)strtoul(argv[++i], NULL, 0);
+    }
+    if (ring_entries < 2 || (ring_entries & (ring_entries - 1))) {
+        fprintf(stderr, "ring entries must be a power of two\n");
+        return 1;
+    }
+
+    signal(SIGINT, rrcd_stop);
+    signal(SIGTERM, rrcd_stop);
+    signal(SIGPIPE, SIG_IGN);
+    rrc_decoder_set_verbose(0);
+
+    int listen_fd = rrcd_listen(path);
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (listen_fd < 0 || epfd < 0) {
+        fprintf(stderr, " rrcd: cannot listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    printf("RRC decode daemon listening on %s (%u summaries per client ring)\n", path, ring_entries);
+
+    struct epoll_event events[RRCD_MAX_EVENTS];
+    while (rrcd_running) {
+        int n = epoll_wait(epfd, events, RRCD_MAX_EVENTS, 1000);
+        for (int i = 0; i < n; i++) {
+            rrcd_client_t *c = events[i].data.ptr;
+            if (!c) {
+                rrcd_accept(epfd, listen_fd, ring_entries);
+                continue;
+            }
+            if ((events[i].events & EPOLLIN) && rrcd_client_read(c) == 0 &&
+                !(events[i].events & (EPOLLHUP | EPOLLERR)))
+                continue;
+            rrcd_client_close(epfd, c);
+        }
+    }
+
+    close(epfd);
+    close(listen_fd);
+    unlink(path);
+    return 0;
+}
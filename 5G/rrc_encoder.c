@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rrc_encoder.h"
+
+// Write the low n bits of value MSB-first at bit offset off of buf
+static void rrc_put_bits(uint8_t *buf, uint32_t off, uint8_t n, uint32_t value) {
+    for (int i = n - 1; i >= 0; i--, off++) {
+        uint8_t mask = (uint8_t)(0x80 >> (off & 7));
+        if ((value >> i) & 1)
+            buf[off >> 3] |= mask;
+        else
+            buf[off >> 3] &= (uint8_t)~mask;
+    }
+}
+
+// Translate the public value (full SFN, transaction id) into the field value
+static uint32_t rrc_field_value(const rrc_msg_template_t *t, uint32_t value) {
+    if (t->channel == RRC_CHANNEL_BCCH_BCH) value >>= 4;   // 6 MSBs of the 10-bit SFN
+    return value & t->field_max;
+}
+
+// Store a field value in the tree. Returns -1 if the template has no such field.
+static int rrc_template_poke(rrc_msg_template_t *t, uint32_t field) {
+    if (t->channel == RRC_CHANNEL_BCCH_BCH) {
+        MIB_t *mib = t->msg;
+        if (!mib->systemFrameNumber.buf || mib->systemFrameNumber.size < 1) return -1;
+        mib->systemFrameNumber.buf[0] = (uint8_t)(field << 2);
+        mib->systemFrameNumber.bits_unused = 2;
+        return 0;
+    }
+    if (t->channel == RRC_CHANNEL_DL_DCCH) {
+        RRC_TransactionIdentifier_t *tid = rrc_dl_dcch_transaction_id(t->msg);
+        if (!tid) return -1;
+        *tid = field;
+        return 0;
+    }
+    return -1;
+}
+
+static ssize_t rrc_template_encode_tree(const rrc_msg_template_t *t, uint8_t *buf, size_t size) {
+    asn_enc_rval_t er = uper_encode_to_buffer(rrc_channel_descriptor(t->channel), NULL, t->msg, buf, size);
+    if (er.encoded < 0) return -1;
+    return (er.encoded + 7) / 8;
+}
+
+/**
+ * Find where the varying field sits in the bitstream: encode with the field
+ * all zeros and all ones, then the differing bits must form one run of
+ * exactly the field width.
+ */
+static void rrc_template_locate_field(rrc_msg_template_t *t, uint8_t *ones) {
+    uint8_t width = (uint8_t)(32 - __builtin_clz(t->field_max));
+
+    t->field.bit_len = 0;
+    if (rrc_template_poke(t, t->field_max) < 0) return;
+
+    ssize_t len = rrc_template_encode_tree(t, ones, RRC_ENCODER_MAX_PER);
+    rrc_template_poke(t, 0);
+    if (len != (ssize_t)t->per_len) return;
+
+    int32_t first = -1, last = -1;
+    for (size_t i = 0; i < t->per_len; i++) {
+        uint8_t diff = t->per[i] ^ ones[i];
+        if (!diff) continue;
+        if (first < 0) first = (int32_t)(i * 8 + __builtin_clz(diff) - 24);
+        last = (int32_t)(i * 8 + 7 - __builtin_ctz(diff));
+    }
+    if (first < 0 || last - first + 1 != width) return;
+
+    t->field.bit_offset = (uint32_t)first;
+    t->field.bit_len = width;
+}
+
+int rrc_template_refresh(rrc_msg_template_t *t) {
+    uint8_t *scratch = malloc(RRC_ENCODER_MAX_PER);
+    if (!scratch) return -1;
+
+    // Cache the encoding with the field zeroed; encode() patches it per call
+    rrc_template_poke(t, 0);
+    ssize_t len = rrc_template_encode_tree(t, t->per, RRC_ENCODER_MAX_PER);
+    if (len < 0) {
+        free(scratch);
+        return -1;
+    }
+    t->per_len = (size_t)len;
+
+    if (t->field_max) rrc_template_locate_field(t, scratch);
+    free(scratch);
+    return 0;
+}
+
+int rrc_template_init(rrc_msg_template_t *t, rrc_channel_t channel,
+                      const uint8_t *seed, size_t seed_size) {
+    asn_TYPE_descriptor_t *td = rrc_channel_descriptor(channel);
+
+    memset(t, 0, sizeof(*t));
+    if (!td) return -1;
+    t->channel = channel;
+
+    asn_dec_rval_t rval = uper_decode_complete(NULL, td, &t->msg, seed, seed_size);
+    if (rval.code != RC_OK) {
+        fprintf(stderr, " %s template seed decoding failed at byte %zd.\n", rrc_channel_name(channel), rval.consumed);
+        rrc_template_free(t);
+        return -1;
+    }
+
+    switch (channel) {
+        case RRC_CHANNEL_BCCH_BCH: t->field_max = 0x3F; break;   // 6-bit systemFrameNumber
+        case RRC_CHANNEL_DL_DCCH:  t->field_max = 0x03; break;   // RRC-TransactionIdentifier
+        default:                   t->field_max = 0;    break;
+    }
+    if (t->field_max && rrc_template_poke(t, 0) < 0) t->field_max = 0;
+
+    t->per = malloc(RRC_ENCODER_MAX_PER);
+    if (!t->per || rrc_template_refresh(t) < 0) {
+        fprintf(stderr, " %s template encoding failed.\n", rrc_channel_name(channel));
+        rrc_template_free(t);
+        return -1;
+    }
+    return 0;
+}
+
+void rrc_template_free(rrc_msg_template_t *t) {
+    asn_TYPE_descriptor_t *td = rrc_channel_descriptor(t->channel);
+    if (t->msg && td) ASN_STRUCT_FREE(*td, t->msg);
+    free(t->per);
+    t->msg = NULL;
+    t->per = NULL;
+}
+
+ssize_t rrc_encode(rrc_msg_template_t *t, uint32_t value, uint8_t *buf, size_t size) {
+    uint32_t field = rrc_field_value(t, value);
+
+    // Slow path: the field moves the encoding around, re-encode the tree
+    if (t->field_max && !t->field.bit_len) {
+        rrc_template_poke(t, field);
+        ssize_t len = rrc_template_encode_tree(t, buf, size);
+        rrc_template_poke(t, 0);
+        return len;
+    }
+
+    if (t->per_len > size) return -1;
+    memcpy(buf, t->per, t->per_len);
+    if (t->field.bit_len) rrc_put_bits(buf, t->field.bit_offset, t->field.bit_len, field);
+    return (ssize_t)t->per_len;
+}
@@ -0,0 +1,88 @@
+// rrc_encoder.h
+#ifndef _RRC_ENCODER_H_
+#define _RRC_ENCODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "rrc_decoder.h"
+
+/**
+ * RRC message template for the encode path
+ *
+ * Description:
+ * Load simulators send the same handful of messages over and over with
+ * only a transaction identifier or the SFN changing. A template is decoded
+ * once from a seed message and its UPER encoding is cached. Encoding then
+ * copies the cached bytes into the caller's buffer and patches the single
+ * varying field at its bit position, without touching the asn1c tree.
+ *
+ * Varying field per channel:
+ * - BCCH-BCH (MIB): systemFrameNumber, the 6 MSBs of the 10-bit SFN
+ *   (the 4 LSBs are carried in the PBCH payload, TS 38.331 Section 6.2.2)
+ * - DL-DCCH: rrc-TransactionIdentifier (0-3) of the c1 message
+ * - BCCH-DL-SCH: none, the cached SIB encoding is copied as-is
+ *
+ * The field position is found at init time by encoding the template with
+ * two different field values and diffing the bitstreams, so it follows
+ * whatever the schema puts in front of the field. When that fails (e.g. the
+ * encoded length depends on the value) every encode falls back to a full
+ * uper_encode_to_buffer() of the patched tree.
+ */
+#define RRC_ENCODER_MAX_PER 8192   // Largest cached encoding in bytes
+
+typedef struct rrc_patch_field {
+    uint32_t bit_offset;   // MSB-first bit offset in the PER stream
+    uint8_t  bit_len;      // Field width, 0 if the field cannot be patched in place
+} rrc_patch_field_t;
+
+typedef struct rrc_msg_template {
+    rrc_channel_t channel;
+    void *msg;                  // Decoded tree (owned)
+    uint8_t *per;               // Cached UPER encoding (owned)
+    size_t per_len;             // Cached encoding length in bytes
+    rrc_patch_field_t field;    // Varying field location
+    uint32_t field_max;         // Largest value the varying field can take
+} rrc_msg_template_t;
+
+/**
+ * Build a template from a UPER encoded seed message.
+ *
+ * Returns 0 on success, -1 if the seed does not decode or encode.
+ */
+int rrc_template_init(rrc_msg_template_t *t, rrc_channel_t channel,
+                      const uint8_t *seed, size_t seed_size);
+
+void rrc_template_free(rrc_msg_template_t *t);
+
+/**
+ * Re-encode the tree after the caller edited t->msg directly and refresh
+ * the cached bytes and the field position.
+ */
+int rrc_template_refresh(rrc_msg_template_t *t);
+
+/**
+ * Encode the template with its varying field set to value into buf.
+ *
+ * value is the full 10-bit SFN for MIB, the transaction id for DL-DCCH and
+ * ignored for BCCH-DL-SCH.
+ *
+ * Returns the number of bytes written, -1 if buf is too small or encoding
+ * fails.
+ */
+ssize_t rrc_encode(rrc_msg_template_t *t, uint32_t value, uint8_t *buf, size_t size);
+
+static inline ssize_t rrc_encode_mib(rrc_msg_template_t *t, uint16_t sfn, uint8_t *buf, size_t size) {
+    return rrc_encode(t, sfn, buf, size);
+}
+
+static inline ssize_t rrc_encode_bcch_dlsch(rrc_msg_template_t *t, uint8_t *buf, size_t size) {
+    return rrc_encode(t, 0, buf, size);
+}
+
+static inline ssize_t rrc_encode_dl_dcch(rrc_msg_template_t *t, uint8_t transaction_id, uint8_t *buf, size_t size) {
+    return rrc_encode(t, transaction_id, buf, size);
+}
+
+#endif
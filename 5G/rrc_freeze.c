@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rrc_freeze.h"
+
+ssize_t rrc_freeze(rrc_channel_t channel, const void *msg, uint32_t ue_id,
+                   uint64_t timestamp, void *buf, size_t buf_size) {
+    asn_TYPE_descriptor_t *td = rrc_channel_descriptor(channel);
+    rrc_frozen_msg_t *rec = buf;
+
+    if (!td || !msg || buf_size < sizeof(*rec)) return -1;
+
+    asn_enc_rval_t er = uper_encode_to_buffer(td, NULL, msg, rec->per, buf_size - sizeof(*rec));
+    if (er.encoded < 0) return -1;
+
+    size_t len = rrc_frozen_record_size((uint32_t)er.encoded);
+    if (len > buf_size) return -1;
+
+    rec->rec_len = (uint32_t)len;
+    rec->channel = (uint8_t)channel;
+    rec->rsv = 0;
+    rec->ue_id = ue_id;
+    rec->per_bits = (uint32_t)er.encoded;
+    rec->timestamp = timestamp;
+    rrc_summarize(channel, msg, &rec->msg_type, &rec->transaction_id);
+
+    // Zero the alignment tail so files are reproducible
+    size_t payload = ((size_t)rec->per_bits + 7) / 8;
+    memset(rec->per + payload, 0, len - sizeof(*rec) - payload);
+    return (ssize_t)len;
+}
+
+void *rrc_thaw(const rrc_frozen_msg_t *rec) {
+    asn_TYPE_descriptor_t *td = rrc_channel_descriptor((rrc_channel_t)rec->channel);
+    void *msg = NULL;
+
+    if (!td) return NULL;
+
+    asn_dec_rval_t rval = uper_decode_complete(NULL, td, &msg, rec->per, ((size_t)rec->per_bits + 7) / 8);
+    if (rval.code != RC_OK) {
+        fprintf(stderr, " %s thaw failed at byte %zd.\n", rrc_channel_name((rrc_channel_t)rec->channel), rval.consumed);
+        if (msg) ASN_STRUCT_FREE(*td, msg);
+        return NULL;
+    }
+    return msg;
+}
+
+static void rrc_history_reset(rrc_history_hdr_t *hdr, size_t capacity) {
+    hdr->magic = RRC_HISTORY_MAGIC;
+    hdr->version = RRC_HISTORY_VERSION;
+    hdr->capacity = capacity;
+    hdr->used = sizeof(*hdr);
+    hdr->count = 0;
+}
+
+int rrc_history_init(rrc_history_t *h, size_t capacity) {
+    if (capacity < sizeof(rrc_history_hdr_t)) return -1;
+
+    void *base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return -1;
+
+    h->hdr = base;
+    h->fd = -1;
+    rrc_history_reset(h->hdr, capacity);
+    return 0;
+}
+
+int rrc_history_open(rrc_history_t *h, const char *path, size_t capacity) {
+    struct stat st;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+
+    if (fstat(fd, &st) < 0) goto fail;
+
+    int fresh = (st.st_size == 0);
+    if (fresh) {
+        if (capacity < sizeof(rrc_history_hdr_t) || ftruncate(fd, (off_t)capacity) < 0) goto fail;
+    } else {
+        capacity = (size_t)st.st_size;
+    }
+
+    void *base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) goto fail;
+
+    h->hdr = base;
+    h->fd = fd;
+    if (fresh) {
+        rrc_history_reset(h->hdr, capacity);
+    } else if (h->hdr->magic != RRC_HISTORY_MAGIC || h->hdr->version != RRC_HISTORY_VERSION ||
+               h->hdr->capacity != capacity || h->hdr->used > capacity) {
+        fprintf(stderr, " %s is not an RRC history file.\n", path);
+        munmap(base, capacity);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+void rrc_history_close(rrc_history_t *h) {
+    if (!h->hdr) return;
+    munmap(h->hdr, h->hdr->capacity);
+    if (h->fd >= 0) close(h->fd);
+    h->hdr = NULL;
+    h->fd = -1;
+}
+
+uint64_t rrc_history_append(rrc_history_t *h, rrc_channel_t channel, const void *msg,
+                            uint32_t ue_id, uint64_t timestamp) {
+    rrc_history_hdr_t *hdr = h->hdr;
+    uint64_t offset = hdr->used;
+
+    ssize_t len = rrc_freeze(channel, msg, ue_id, timestamp,
+                             (uint8_t *)hdr + offset, hdr->capacity - offset);
+    if (len < 0) return 0;
+
+    hdr->used += (uint64_t)len;
+    hdr->count++;
+    return offset;
+}
+
+const rrc_frozen_msg_t *rrc_history_at(const rrc_history_t *h, uint64_t offset) {
+    const rrc_history_hdr_t *hdr = h->hdr;
+
+    if (offset < sizeof(*hdr) || offset + sizeof(rrc_frozen_msg_t) > hdr->used) return NULL;
+
+    const rrc_frozen_msg_t *rec = (const rrc_frozen_msg_t *)((const uint8_t *)hdr + offset);
+    if (rec->rec_len < sizeof(*rec) || offset + rec->rec_len > hdr->used) return NULL;
+    return rec;
+}
+
+uint64_t rrc_history_first(const rrc_history_t *h) {
+    return h->hdr->count ? sizeof(rrc_history_hdr_t) : 0;
+}
+
+uint64_t rrc_history_next(const rrc_history_t *h, uint64_t offset) {
+    const rrc_frozen_msg_t *rec = rrc_history_at(h, offset);
+    if (!rec) return 0;
+
+    offset += rec->rec_len;
+    return offset < h->hdr->used ? offset : 0;
+}
@@ -0,0 +1,129 @@
+// rrc_freeze.h
+#ifndef _RRC_FREEZE_H_
+#define _RRC_FREEZE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "rrc_decoder.h"
+
+/**
+ * Frozen RRC message record
+ *
+ * Description:
+ * A decoded asn1c tree is made of dozens to hundreds of small mallocs
+ * linked by pointers. Retaining one per UE for audit is expensive and the
+ * pointers make it impossible to mmap or move. Freezing re-encodes the tree
+ * with UPER into a single flat record: a fixed summary header that can be
+ * read in place, followed by the PER bytes. Thawing decodes the bytes back
+ * into a fresh asn1c tree only when somebody needs the full content.
+ *
+ * Layout (all fields host byte order, record 8-byte aligned):
+ * +-----------+---------+----------+--------+--------+----------+---------+
+ * | rec_len   | channel | msg_type | trans  | rsv    | ue_id    | per_bits|
+ * | 4 bytes   | 1 byte  | 1 byte   | 1 byte | 1 byte | 4 bytes  | 4 bytes |
+ * +-----------+---------+----------+--------+--------+----------+---------+
+ * | timestamp (8 bytes) | UPER payload ((per_bits + 7) / 8 bytes) | pad   |
+ * +---------------------+-----------------------------------------+-------+
+ *
+ * Fields:
+ * - rec_len: Total record size including header and padding
+ * - channel: rrc_channel_t the payload was decoded from
+ * - msg_type: c1 "present" value of the message (0 for MIB / extensions)
+ * - transaction_id: RRC-TransactionIdentifier (0-3), RRC_FROZEN_NO_TRANSACTION if absent
+ * - ue_id: Caller supplied UE handle (RNTI, UE index...)
+ * - per_bits: Exact UPER length in bits
+ * - timestamp: Caller supplied capture time
+ */
+#define RRC_FROZEN_NO_TRANSACTION 0xFF
+#define RRC_FROZEN_ALIGN          8
+
+typedef struct rrc_frozen_msg {
+    uint32_t rec_len;          // Record length in bytes (multiple of 8)
+    uint8_t  channel;          // rrc_channel_t
+    uint8_t  msg_type;         // c1 choice present value
+    uint8_t  transaction_id;   // 0-3 or RRC_FROZEN_NO_TRANSACTION
+    uint8_t  rsv;              // Reserved (set to 0)
+    uint32_t ue_id;            // UE handle
+    uint32_t per_bits;         // UPER payload length in bits
+    uint64_t timestamp;        // Capture time
+    uint8_t  per[];            // UPER payload
+} rrc_frozen_msg_t;
+
+/**
+ * RRC history arena
+ *
+ * Frozen records appended back to back into one contiguous region. Only
+ * offsets are ever stored, so the region can be written to a file, mmapped
+ * at a different address in another process and read in place.
+ *
+ * The region starts with rrc_history_hdr_t, records follow.
+ */
+#define RRC_HISTORY_MAGIC   0x52524346u   // "FCRR"
+#define RRC_HISTORY_VERSION 1
+
+typedef struct rrc_history_hdr {
+    uint32_t magic;            // RRC_HISTORY_MAGIC
+    uint32_t version;          // RRC_HISTORY_VERSION
+    uint64_t capacity;         // Region size in bytes (header included)
+    uint64_t used;             // Bytes in use (header included)
+    uint64_t count;            // Number of records
+} rrc_history_hdr_t;
+
+typedef struct rrc_history {
+    rrc_history_hdr_t *hdr;    // Start of the region
+    int fd;                    // Backing file, -1 for anonymous memory
+} rrc_history_t;
+
+// Size of the frozen record for a PER payload of per_bits bits
+static inline size_t rrc_frozen_record_size(uint32_t per_bits) {
+    size_t len = sizeof(rrc_frozen_msg_t) + ((size_t)per_bits + 7) / 8;
+    return (len + RRC_FROZEN_ALIGN - 1) & ~(size_t)(RRC_FROZEN_ALIGN - 1);
+}
+
+/**
+ * Freeze a decoded tree into buf.
+ *
+ * Returns the record length on success, -1 if the tree could not be
+ * encoded or buf is too small.
+ */
+ssize_t rrc_freeze(rrc_channel_t channel, const void *msg, uint32_t ue_id,
+                   uint64_t timestamp, void *buf, size_t buf_size);
+
+/**
+ * Thaw a frozen record into a new asn1c tree.
+ *
+ * Returns the tree (free with ASN_STRUCT_FREE on rrc_channel_descriptor())
+ * or NULL on failure.
+ */
+void *rrc_thaw(const rrc_frozen_msg_t *rec);
+
+// Anonymous in-memory arena of the given capacity
+int rrc_history_init(rrc_history_t *h, size_t capacity);
+
+/**
+ * File backed arena. An existing file is reattached as-is and its records
+ * stay readable; a new file is created and sized to capacity.
+ */
+int rrc_history_open(rrc_history_t *h, const char *path, size_t capacity);
+
+void rrc_history_close(rrc_history_t *h);
+
+/**
+ * Freeze msg and append it to the arena.
+ *
+ * Returns the record offset from the start of the region, 0 on failure
+ * (the header occupies offset 0, so no record can live there).
+ */
+uint64_t rrc_history_append(rrc_history_t *h, rrc_channel_t channel, const void *msg,
+                            uint32_t ue_id, uint64_t timestamp);
+
+// Record at offset, NULL if offset does not point into the used region
+const rrc_frozen_msg_t *rrc_history_at(const rrc_history_t *h, uint64_t offset);
+
+// Offset of the first record and of the record after offset, 0 at the end
+uint64_t rrc_history_first(const rrc_history_t *h);
+uint64_t rrc_history_next(const rrc_history_t *h, uint64_t offset);
+
+#endif
@@ -490,25 +490,25 @@ typedef struct rlc_am_data_pdu_12bit_sn_segmented {
  * - dc (1 bit): Data/Control (1 = Data)
  * - p (1 bit): Polling bit
  * - si (2 bits): Segmentation Info (00 = complete)
- * - sn_high (4 bits): SN upper 4 bits
- * - sn_mid (8 bits): SN middle 8 bits
- * - sn_low (6 bits): SN lower 6 bits
  * - rsv (2 bits): Reserved
+ * - sn_high (2 bits): SN upper 2 bits
+ * - sn_mid (8 bits): SN middle 8 bits
+ * - sn_low (8 bits): SN lower 8 bits
  * 
  * Total header size: 3 bytes
- * Complete SN = (sn_high << 14) | (sn_mid << 6) | sn_low
+ * Complete SN = (sn_high << 16) | (sn_mid << 8) | sn_low
  */
 typedef struct rlc_am_data_pdu_18bit_sn_complete {
     // Byte 0
     uint8_t dc : 1;       // D/C: 1 = Data PDU
     uint8_t p : 1;        // Polling bit
     uint8_t si : 2;       // Segmentation Info: 00 = complete
-    uint8_t sn_high : 4;  // SN upper 4 bits
+    uint8_t rsv : 2;      // Reserved bits
+    uint8_t sn_high : 2;  // SN upper 2 bits
     // Byte 1
     uint8_t sn_mid : 8;   // SN middle 8 bits
     // Byte 2
-    uint8_t sn_low : 6;   // SN lower 6 bits
-    uint8_t rsv : 2;      // Reserved bits
+    uint8_t sn_low : 8;   // SN lower 8 bits
 } rlc_am_data_pdu_18bit_sn_complete_t;
 
 /**
@@ -532,12 +532,12 @@ typedef struct rlc_am_data_pdu_18bit_sn_segmented {
     uint8_t dc : 1;       // D/C: 1 = Data PDU
     uint8_t p : 1;        // Polling bit
     uint8_t si : 2;       // Segmentation Info: 01, 10, or 11
-    uint8_t sn_high : 4;  // SN upper 4 bits
+    uint8_t rsv : 2;      // Reserved bits
+    uint8_t sn_high : 2;  // SN upper 2 bits
     // Byte 1
     uint8_t sn_mid : 8;   // SN middle 8 bits
     // Byte 2
-    uint8_t sn_low : 6;   // SN lower 6 bits
-    uint8_t rsv : 2;      // Reserved bits
+    uint8_t sn_low : 8;   // SN lower 8 bits
     // Byte 3
     uint8_t so_high : 8;  // Segment Offset upper byte
     // Byte 4
@@ -682,12 +682,13 @@ typedef struct rlc_am_status_pdu_18bit {
  * - lcid (6 bits): Logical Channel ID
  *   - 0-32: Identifies the logical channel for MAC SDU
  *   - 33-63: Reserved values for MAC Control Elements
- *     Examples:
- *     - 52: C-RNTI MAC CE
- *     - 54: Short Truncated BSR
- *     - 59: Single Entry PHR
- *     - 62: Long Truncated BSR
+ *     Examples (UL-SCH, TS 38.321 Table 6.2.1-2):
+ *     - 57: Single Entry PHR
+ *     - 58: C-RNTI MAC CE
+ *     - 59: Short Truncated BSR
+ *     - 62: Long BSR
  *     - 63: Padding
+ *     DL-SCH uses its own table (6.2.1-1); see mac_ce.h for both.
  * - l (8 bits): Length field
  *   - Indicates size of MAC SDU or MAC CE in bytes (0-255)
  * 
@@ -755,10 +756,10 @@ typedef struct mac_subheader_long {
  * Fields:
  * - r (1 bit): Reserved bit, set to 0
  * - lcid (6 bits): Logical Channel ID identifying the MAC CE type
- *   Examples of fixed-size MAC CEs:
- *   - LCID 52: C-RNTI (2 bytes)
- *   - LCID 54: Short Truncated BSR (1 byte)
- *   - LCID 59: Single Entry PHR (1 byte)
+ *   Examples of fixed-size MAC CEs (UL-SCH):
+ *   - LCID 57: Single Entry PHR (2 bytes)
+ *   - LCID 58: C-RNTI (2 bytes)
+ *   - LCID 59: Short Truncated BSR (1 byte)
  *   - LCID 63: Padding (variable, but fills remaining space)
  * 
  * Total subheader size: 1 byte
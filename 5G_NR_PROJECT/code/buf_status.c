@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "buf_status.h"
+
+#define BS_MAC_I_LEN  4   // PDCP MAC-I (TS 38.323 Section 6.3.4)
+
+void bs_ue_init(bs_ue_t *ue) {
+    memset(ue, 0, sizeof(*ue));
+    memset(ue->lcg, BS_LCG_NONE, sizeof(ue->lcg));
+}
+
+int bs_lc_config(bs_ue_t *ue, uint8_t lcid, uint8_t lcg, uint8_t pdcp_sn_bits, int integrity,
+                 const rlc_entity_ops_t *rlc) {
+    if (lcid >= BS_NUM_LCID || lcg >= MAC_NUM_LCG) return -1;
+
+    uint8_t pdcp;
+    if (pdcp_sn_bits == 12)
+        pdcp = sizeof(pdcp_data_pdu_12bit_sn_t);
+    else if (pdcp_sn_bits == 18)
+        pdcp = sizeof(pdcp_data_pdu_18bit_sn_t);
+    else
+        return -1;
+    if (integrity) pdcp += BS_MAC_I_LEN;
+
+    // Complete SDU: AM keeps its SN header, UM sends a 1-byte SI header
+    uint8_t rlc_hdr = 0, rlc_seg = 0;
+    if (rlc) {
+        rlc_hdr = rlc->mode == RLC_MODE_AM ? rlc->hdr_len : 1;
+        rlc_seg = rlc->hdr_len_so;
+    }
+
+    // Move the channel's current volume out of its old LCG first
+    uint8_t old = ue->lcg[lcid];
+    if (old != BS_LCG_NONE && ue->lc_bytes[lcid]) {
+        uint32_t v = ue->lc_bytes[lcid];
+        ue->lc_bytes[lcid] = 0;
+        ue->lcg_bytes[old] -= v;
+        ue->total_bytes -= v;
+        ue->lcg_idx5[old] = mac_bsr_index_5bit(ue->lcg_bytes[old]);
+        ue->lcg_idx8[old] = mac_bsr_index_8bit(ue->lcg_bytes[old]);
+        if (!ue->lcg_bytes[old]) ue->lcg_mask &= (uint8_t)~(1u << old);
+    }
+
+    ue->lcg[lcid] = lcg;
+    ue->sdu_hdr[lcid] = (uint8_t)(pdcp + rlc_hdr);
+    ue->rlc_hdr[lcid] = rlc_hdr;
+    ue->seg_extra[lcid] = (uint8_t)(rlc_seg > rlc_hdr ? rlc_seg - rlc_hdr : 0);
+    bs_lc_update(ue, lcid);
+    return 0;
+}
+
+void bs_lc_update(bs_ue_t *ue, uint8_t lcid) {
+    uint8_t g = ue->lcg[lcid];
+    if (g == BS_LCG_NONE) return;
+
+    uint8_t hdr = ue->pdcp_pdus[lcid] ? ue->rlc_hdr[lcid] : ue->sdu_hdr[lcid];
+    uint32_t v = ue->new_bytes[lcid] + ue->new_sdus[lcid] * hdr +
+                 (ue->seg_head[lcid] && ue->new_sdus[lcid] ? ue->seg_extra[lcid] : 0) +
+                 ue->retx_bytes[lcid] + ue->status_bytes[lcid];
+    uint32_t old = ue->lc_bytes[lcid];
+    if (v == old) return;
+
+    ue->lc_bytes[lcid] = v;
+    ue->lcg_bytes[g] = ue->lcg_bytes[g] - old + v;
+    ue->total_bytes = ue->total_bytes - old + v;
+    ue->lcg_idx5[g] = mac_bsr_index_5bit(ue->lcg_bytes[g]);
+    ue->lcg_idx8[g] = mac_bsr_index_8bit(ue->lcg_bytes[g]);
+    if (ue->lcg_bytes[g])
+        ue->lcg_mask |= (uint8_t)(1u << g);
+    else
+        ue->lcg_mask &= (uint8_t)~(1u << g);
+}
+
+uint32_t bs_lcp_pending(void *ctx, uint8_t lcid) {
+    const bs_ue_t *ue = ctx;
+    return lcid < BS_NUM_LCID ? ue->lc_bytes[lcid] : 0;
+}
+
+int bs_build_bsr(const bs_ue_t *ue, uint8_t *buf, size_t size) {
+    uint8_t mask = ue->lcg_mask;
+
+    if (!(mask & (mask - 1))) {
+        // Zero or one LCG with data: Short BSR
+        uint8_t lcg = mask ? (uint8_t)__builtin_ctz(mask) : 0;
+        if (size < 2) return -1;
+        buf[0] = MAC_LCID_UL_SHORT_BSR;
+        buf[1] = (uint8_t)(lcg << 5 | (mask ? ue->lcg_idx5[lcg] : 0));
+        return 2;
+    }
+
+    uint16_t plen = (uint16_t)(1 + __builtin_popcount(mask));
+    int h = mac_subhdr_write(buf, size, MAC_LCID_UL_LONG_BSR, 1, plen);
+    if (h < 0 || (size_t)h + plen > size) return -1;
+
+    uint8_t *p = buf + h;
+    *p++ = mask;
+    for (uint8_t m = mask; m; m &= (uint8_t)(m - 1)) *p++ = ue->lcg_idx8[__builtin_ctz(m)];
+    return h + plen;
+}
@@ -0,0 +1,160 @@
+// buf_status.h
+#ifndef _BUF_STATUS_H_
+#define _BUF_STATUS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mac_ce.h"
+#include "rlc_entity.h"
+#include "sdu_queue.h"
+
+/*============================================================================
+ * INCREMENTAL BUFFER STATUS PER LOGICAL CHANNEL / LCG
+ * Reference: 3GPP TS 38.321 Section 5.4.5, TS 38.322 Section 5.5,
+ *            TS 38.323 Section 5.6 (data volume)
+ *==========================================================================*/
+
+/**
+ * Buffer status tracker
+ *
+ * Description:
+ * Keeps the data volume of every logical channel and LCG of one UE up to
+ * date as SDUs are queued, segmented, sent, dropped or retransmitted, so
+ * the UE emulator (BSR generation) and the gNB scheduler read the values
+ * every slot without walking any queue.
+ *
+ * Data volume of a logical channel (PDCP + RLC, no MAC subheaders):
+ *
+ *   new_bytes + new_sdus x sdu_hdr    untransmitted SDUs, each with the
+ *                                     PDCP header (+ MAC-I) and a complete
+ *                                     RLC header; queued PDCP PDUs (see
+ *                                     bs_lc_sync_queue) add the RLC
+ *                                     header only
+ *   + seg_extra                       head SDU partly sent: the rest needs
+ *                                     a segment header with SO
+ *   + retx_bytes                      RLC AM retransmissions incl. headers
+ *   + status_bytes                    pending STATUS PDU
+ *
+ * Header sizes come from the PDCP structs in 5g_nr_pdu_structures.h and
+ * the bearer's rlc_entity_ops_t, once at configuration time. Each event
+ * recomputes one channel, applies the difference to its LCG and refreshes
+ * the LCG's 5-bit and 8-bit BSR indexes, so every query is a field read.
+ */
+#define BS_NUM_LCID    (MAC_LCID_MAX_SDU + 1)
+#define BS_LCG_NONE    0xFF
+
+typedef struct bs_ue {
+    // Inputs per LCID
+    uint32_t new_bytes[BS_NUM_LCID];      // Untransmitted SDU payload
+    uint32_t new_sdus[BS_NUM_LCID];       // SDUs behind new_bytes
+    uint32_t retx_bytes[BS_NUM_LCID];     // AM retransmissions, with headers
+    uint16_t status_bytes[BS_NUM_LCID];   // Pending STATUS PDU
+    uint8_t  seg_head[BS_NUM_LCID];       // Head SDU partly sent
+    uint8_t  pdcp_pdus[BS_NUM_LCID];      // new_bytes are PDCP PDUs, header included
+
+    // Configuration per LCID
+    uint8_t  lcg[BS_NUM_LCID];            // BS_LCG_NONE = not configured
+    uint8_t  sdu_hdr[BS_NUM_LCID];        // PDCP + complete RLC header
+    uint8_t  rlc_hdr[BS_NUM_LCID];        // Complete RLC header only
+    uint8_t  seg_extra[BS_NUM_LCID];      // Segment header minus complete header
+
+    // Outputs
+    uint32_t lc_bytes[BS_NUM_LCID];       // Data volume per LCID
+    uint32_t lcg_bytes[MAC_NUM_LCG];
+    uint8_t  lcg_idx5[MAC_NUM_LCG];       // Short BSR index (Table 6.1.3.1-1)
+    uint8_t  lcg_idx8[MAC_NUM_LCG];       // Long BSR index (Table 6.1.3.1-2)
+    uint8_t  lcg_mask;                    // LCGs with data
+    uint64_t total_bytes;
+} bs_ue_t;
+
+void bs_ue_init(bs_ue_t *ue);
+
+/**
+ * Configure a logical channel.
+ *
+ * pdcp_sn_bits: 12 or 18; integrity: MAC-I appended (SRBs, DRBs with
+ * integrity protection); rlc: the bearer's bound entity ops, NULL for TM.
+ * Returns 0, -1 on bad arguments.
+ */
+int bs_lc_config(bs_ue_t *ue, uint8_t lcid, uint8_t lcg, uint8_t pdcp_sn_bits, int integrity,
+                 const rlc_entity_ops_t *rlc);
+
+// Recompute one channel after its inputs changed and propagate to its LCG
+void bs_lc_update(bs_ue_t *ue, uint8_t lcid);
+
+/*----------------------------------------------------------------------------
+ * Events
+ *--------------------------------------------------------------------------*/
+
+static inline void bs_sdu_enqueued(bs_ue_t *ue, uint8_t lcid, uint32_t bytes) {
+    ue->new_bytes[lcid] += bytes;
+    ue->new_sdus[lcid]++;
+    bs_lc_update(ue, lcid);
+}
+
+// Head SDU sent completely (or its last segment), dropped or discarded
+static inline void bs_sdu_removed(bs_ue_t *ue, uint8_t lcid, uint32_t bytes) {
+    ue->new_bytes[lcid] -= bytes;
+    ue->new_sdus[lcid]--;
+    ue->seg_head[lcid] = 0;
+    bs_lc_update(ue, lcid);
+}
+
+// bytes of the head SDU went out in a segment; the rest stays queued
+static inline void bs_sdu_segmented(bs_ue_t *ue, uint8_t lcid, uint32_t bytes) {
+    ue->new_bytes[lcid] -= bytes;
+    ue->seg_head[lcid] = 1;
+    bs_lc_update(ue, lcid);
+}
+
+static inline void bs_retx_added(bs_ue_t *ue, uint8_t lcid, uint32_t bytes) {
+    ue->retx_bytes[lcid] += bytes;
+    bs_lc_update(ue, lcid);
+}
+
+static inline void bs_retx_sent(bs_ue_t *ue, uint8_t lcid, uint32_t bytes) {
+    ue->retx_bytes[lcid] = bytes < ue->retx_bytes[lcid] ? ue->retx_bytes[lcid] - bytes : 0;
+    bs_lc_update(ue, lcid);
+}
+
+// Size of the STATUS PDU waiting to be sent, 0 once it has gone
+static inline void bs_status_pending(bs_ue_t *ue, uint8_t lcid, uint16_t bytes) {
+    ue->status_bytes[lcid] = bytes;
+    bs_lc_update(ue, lcid);
+}
+
+/**
+ * Take new_bytes / new_sdus / seg_head straight from the bearer's SDU
+ * queue, which already accounts for tail and CoDel drops. O(1); call after
+ * any sequence of queue operations. The queue holds PDCP PDUs, so from
+ * here on each queued entry adds only the RLC header.
+ */
+static inline void bs_lc_sync_queue(bs_ue_t *ue, uint8_t lcid, const sdu_queue_t *q) {
+    const sdu_queue_entry_t *head = sdu_queue_peek(q);
+    ue->pdcp_pdus[lcid] = 1;
+    ue->new_bytes[lcid] = (uint32_t)sdu_queue_bytes(q);
+    ue->new_sdus[lcid] = sdu_queue_pkts(q);
+    ue->seg_head[lcid] = head && head->off;
+    bs_lc_update(ue, lcid);
+}
+
+/*----------------------------------------------------------------------------
+ * Queries
+ *--------------------------------------------------------------------------*/
+
+static inline uint32_t bs_lc_bytes(const bs_ue_t *ue, uint8_t lcid) { return ue->lc_bytes[lcid]; }
+static inline uint32_t bs_lcg_bytes(const bs_ue_t *ue, uint8_t lcg) { return ue->lcg_bytes[lcg]; }
+static inline uint64_t bs_total_bytes(const bs_ue_t *ue) { return ue->total_bytes; }
+
+// lcp_rlc_ops_t.pending adapter: ctx is the bs_ue_t
+uint32_t bs_lcp_pending(void *ctx, uint8_t lcid);
+
+/**
+ * Regular BSR (TS 38.321 Section 5.4.5): Short BSR when at most one LCG
+ * has data, Long BSR otherwise. Uses the precomputed indexes.
+ * Returns bytes written, -1 if it does not fit.
+ */
+int bs_build_bsr(const bs_ue_t *ue, uint8_t *buf, size_t size);
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cal_queue.h"
+
+// Smallest shift with 2^shift >= width
+static uint8_t cq_width_shift(uint64_t width) {
+    if (width <= 1) return 0;
+    return (uint8_t)(64 - __builtin_clzll(width - 1));
+}
+
+int cq_init(cal_queue_t *q, uint64_t width_ns, uint64_t now) {
+    memset(q, 0, sizeof(*q));
+    q->buckets = calloc(CQ_MIN_BUCKETS, sizeof(*q->buckets));
+    if (!q->buckets) return -1;
+    q->n_buckets = CQ_MIN_BUCKETS;
+    q->mask = CQ_MIN_BUCKETS - 1;
+    q->shift = cq_width_shift(width_ns);
+    q->now = now;
+    q->day = now >> q->shift;
+    return 0;
+}
+
+void cq_destroy(cal_queue_t *q) {
+    free(q->buckets);
+    memset(q, 0, sizeof(*q));
+}
+
+static inline int cq_before(const cq_event_t *a, const cq_event_t *b) {
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+/**
+ * Insert e into its bucket, keeping the bucket sorted. Events mostly
+ * arrive in time order (slot ticks, HARQ feedback k1 slots out), so the
+ * tail check makes the common case O(1).
+ */
+static void cq_link(cal_queue_t *q, cq_event_t *e) {
+    cq_bucket_t *b = &q->buckets[(e->time >> q->shift) & q->mask];
+
+    if (!b->head) {
+        e->next = NULL;
+        b->head = b->tail = e;
+    } else if (cq_before(b->tail, e)) {
+        e->next = NULL;
+        b->tail->next = e;
+        b->tail = e;
+    } else if (cq_before(e, b->head)) {
+        e->next = b->head;
+        b->head = e;
+    } else {
+        cq_event_t *p = b->hint && cq_before(b->hint, e) ? b->hint : b->head;
+        while (!cq_before(e, p->next)) p = p->next;
+        e->next = p->next;
+        p->next = e;
+    }
+    b->hint = e;
+    q->n++;
+}
+
+static inline cq_event_t *cq_unlink_head(cal_queue_t *q, cq_bucket_t *b) {
+    cq_event_t *e = b->head;
+    b->head = e->next;
+    if (!b->head) b->tail = NULL;
+    if (b->hint == e) b->hint = NULL;
+    e->next = NULL;
+    q->n--;
+    q->now = e->time;
+    return e;
+}
+
+// Pop without resizing
+static cq_event_t *cq_take(cal_queue_t *q) {
+    if (!q->n) return NULL;
+
+    for (uint32_t i = 0; i < q->n_buckets; i++, q->day++) {
+        cq_bucket_t *b = &q->buckets[q->day & q->mask];
+        if (b->head && (b->head->time >> q->shift) == q->day) return cq_unlink_head(q, b);
+    }
+
+    // Nothing due within a year: jump straight to the earliest head
+    q->direct_searches++;
+    cq_bucket_t *min = NULL;
+    for (uint32_t i = 0; i < q->n_buckets; i++) {
+        cq_bucket_t *b = &q->buckets[i];
+        if (b->head && (!min || cq_before(b->head, min->head))) min = b;
+    }
+    q->day = min->head->time >> q->shift;
+    return cq_unlink_head(q, min);
+}
+
+/**
+ * Bucket width from the earliest events (list is in time order): three
+ * times the mean gap between distinct times, recomputed without the gaps
+ * above twice the mean. Simultaneous events (a slot boundary) count as
+ * one: they share a bucket whatever its width, and counting their zero
+ * gaps would shrink the width to nothing. Keeps the current width when
+ * every event has the same time.
+ */
+static uint8_t cq_estimate_shift(const cal_queue_t *q, const cq_event_t *list) {
+    uint64_t gap[CQ_SAMPLE];
+    uint64_t sum = 0;
+    int k = 0;
+
+    for (const cq_event_t *e = list; e && e->next && k < CQ_SAMPLE; e = e->next) {
+        if (e->next->time == e->time) continue;
+        gap[k] = e->next->time - e->time;
+        sum += gap[k++];
+    }
+    if (!k) return q->shift;
+
+    uint64_t mean = sum / (uint64_t)k, sum2 = 0;
+    int k2 = 0;
+    for (int i = 0; i < k; i++) {
+        if (gap[i] > 2 * mean) continue;
+        sum2 += gap[i];
+        k2++;
+    }
+    if (k2) mean = sum2 / (uint64_t)k2;
+    return cq_width_shift(3 * (mean ? mean : 1));
+}
+
+/**
+ * Rebuild with n_buckets buckets: drain in order, size the buckets from
+ * the front of the drained list, relink. Relinking in time order always
+ * appends at a bucket tail, so a resize is O(n).
+ */
+static void cq_resize(cal_queue_t *q, uint32_t n_buckets) {
+    cq_event_t *list = NULL, **tail = &list, *e;
+    uint64_t now = q->now;
+
+    while ((e = cq_take(q))) {
+        *tail = e;
+        tail = &e->next;
+    }
+    *tail = NULL;
+    q->now = now;
+
+    cq_bucket_t *b = calloc(n_buckets, sizeof(*b));
+    if (b) {
+        free(q->buckets);
+        q->buckets = b;
+        q->n_buckets = n_buckets;
+        q->mask = n_buckets - 1;
+    } else {
+        // Out of memory: keep the current (now empty) ring
+        memset(q->buckets, 0, q->n_buckets * sizeof(*q->buckets));
+    }
+    q->shift = cq_estimate_shift(q, list);
+    q->day = now >> q->shift;
+    q->resizes++;
+
+    for (e = list; e;) {
+        cq_event_t *next = e->next;
+        cq_link(q, e);
+        e = next;
+    }
+}
+
+void cq_insert(cal_queue_t *q, cq_event_t *e, uint64_t time) {
+    e->time = time < q->now ? q->now : time;
+    e->seq = q->seq++;
+    cq_link(q, e);
+    q->inserted++;
+    if (q->n > 2ull * q->n_buckets && q->n_buckets < (1u << 31)) cq_resize(q, q->n_buckets * 2);
+}
+
+cq_event_t *cq_pop(cal_queue_t *q) {
+    cq_event_t *e = cq_take(q);
+    if (!e) return NULL;
+    q->popped++;
+    if (q->n_buckets > CQ_MIN_BUCKETS && q->n < q->n_buckets / 2) cq_resize(q, q->n_buckets / 2);
+    return e;
+}
@@ -0,0 +1,98 @@
+// cal_queue.h
+#ifndef _CAL_QUEUE_H_
+#define _CAL_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+ * CALENDAR QUEUE FOR DISCRETE-EVENT SIMULATION
+ * Reference: R. Brown, "Calendar Queues: A Fast O(1) Priority Queue
+ *            Implementation for the Simulation Event Set Problem",
+ *            CACM 31(10), 1988
+ *==========================================================================*/
+
+/**
+ * Calendar queue
+ *
+ * Description:
+ * Pending events are kept in a ring of buckets ("days") of 2^shift ns
+ * each; one turn of the ring is a "year". An event goes to bucket
+ * (time >> shift) & mask and buckets are kept sorted, so the next event
+ * is found by walking forward from the current day and taking the head
+ * of the first bucket whose head falls in the current year. With the
+ * bucket width near the typical gap between events, insert and pop are
+ * O(1) on average, whatever the number of pending events. Each bucket
+ * remembers the event linked last, so a run of inserts at increasing
+ * times behind a cluster of simultaneous events (a slot boundary) does not
+ * walk the cluster again each time.
+ *
+ * The ring doubles when there are more than two events per bucket and
+ * halves below one per two buckets. On every resize the width is
+ * re-estimated from the gaps between the earliest distinct event times
+ * (3 x their mean, ignoring outliers above twice the mean), rounded to a
+ * power of two.
+ *
+ * Events are intrusive nodes (cq_event_t) embedded in their owner, as
+ * with tw_timer_t, so scheduling never allocates. Ties are broken by
+ * insertion order, which keeps a simulation run deterministic.
+ *
+ * A queue belongs to one thread; it is not thread safe.
+ */
+#define CQ_MIN_BUCKETS   16
+#define CQ_SAMPLE        25
+
+typedef struct cq_event {
+    struct cq_event *next;
+    uint64_t time;             // Absolute time, ns
+    uint64_t seq;              // Insertion order, breaks ties
+    uint32_t kind;             // Free for the owner (dispatch)
+    uint32_t arg;              // Free for the owner
+} cq_event_t;
+
+typedef struct cq_bucket {
+    cq_event_t *head;
+    cq_event_t *tail;
+    cq_event_t *hint;          // Last event linked, where a sorted walk may start
+} cq_bucket_t;
+
+typedef struct cal_queue {
+    cq_bucket_t *buckets;
+    uint32_t n_buckets;        // Power of two
+    uint32_t mask;
+    uint8_t  shift;            // Bucket width 2^shift ns
+    uint64_t day;              // Current bucket, absolute (time >> shift)
+    uint64_t now;              // Time of the last event popped
+    uint64_t n;                // Pending events
+    uint64_t seq;
+
+    uint64_t inserted;
+    uint64_t popped;
+    uint64_t resizes;
+    uint64_t direct_searches;  // Pops that found no event within a year
+} cal_queue_t;
+
+// width_ns: initial bucket width (rounded to a power of two). Returns 0, -1.
+int  cq_init(cal_queue_t *q, uint64_t width_ns, uint64_t now);
+void cq_destroy(cal_queue_t *q);
+
+static inline void cq_event_init(cq_event_t *e, uint32_t kind, uint32_t arg) {
+    e->next = NULL;
+    e->time = 0;
+    e->seq = 0;
+    e->kind = kind;
+    e->arg = arg;
+}
+
+/**
+ * Schedule e at time (ns, not before q->now; earlier times are clamped to
+ * now). e must not be pending.
+ */
+void cq_insert(cal_queue_t *q, cq_event_t *e, uint64_t time);
+
+// Earliest pending event, NULL when empty. q->now becomes its time.
+cq_event_t *cq_pop(cal_queue_t *q);
+
+static inline uint64_t cq_pending(const cal_queue_t *q) { return q->n; }
+
+#endif
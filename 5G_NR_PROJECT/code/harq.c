@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "harq.h"
+
+static void harq_entity_reset(harq_entity_t *e, uint16_t rnti) {
+    memset(e, 0, sizeof(*e));
+    for (int p = 0; p < HARQ_NUM_PROCESSES; p++) e->proc[p].buf = L2_BUF_NONE;
+    e->idle_mask = (uint16_t)((1u << HARQ_NUM_PROCESSES) - 1);
+    e->rnti = rnti;
+}
+
+int harq_mgr_init(harq_mgr_t *mgr, l2_buf_pool_t *pool, uint16_t max_ues, uint8_t n_carriers, uint8_t max_retx) {
+    memset(mgr, 0, sizeof(*mgr));
+    if (!max_ues || max_ues == HARQ_NO_UE || !n_carriers) return -1;
+
+    mgr->pool = pool;
+    mgr->max_ues = max_ues;
+    mgr->n_carriers = n_carriers;
+    mgr->max_retx = max_retx;
+    mgr->rnti_map = malloc(65536 * sizeof(*mgr->rnti_map));
+    mgr->entities = calloc((size_t)max_ues * n_carriers, sizeof(*mgr->entities));
+    mgr->free_slots = malloc(max_ues * sizeof(*mgr->free_slots));
+    if (!mgr->rnti_map || !mgr->entities || !mgr->free_slots) {
+        harq_mgr_destroy(mgr);
+        return -1;
+    }
+
+    memset(mgr->rnti_map, 0xFF, 65536 * sizeof(*mgr->rnti_map));
+    for (uint16_t i = 0; i < max_ues; i++) mgr->free_slots[i] = (uint16_t)(max_ues - 1 - i);
+    mgr->free_top = max_ues;
+    return 0;
+}
+
+void harq_mgr_destroy(harq_mgr_t *mgr) {
+    free(mgr->rnti_map);
+    free(mgr->entities);
+    free(mgr->free_slots);
+    memset(mgr, 0, sizeof(*mgr));
+}
+
+int harq_ue_add(harq_mgr_t *mgr, uint16_t rnti) {
+    if (mgr->rnti_map[rnti] != HARQ_NO_UE || !mgr->free_top) return -1;
+
+    uint16_t slot = mgr->free_slots[--mgr->free_top];
+    mgr->rnti_map[rnti] = slot;
+    for (uint8_t c = 0; c < mgr->n_carriers; c++)
+        harq_entity_reset(&mgr->entities[(size_t)slot * mgr->n_carriers + c], rnti);
+    return 0;
+}
+
+void harq_ue_remove(harq_mgr_t *mgr, uint16_t rnti) {
+    uint16_t slot = mgr->rnti_map[rnti];
+    if (slot == HARQ_NO_UE) return;
+
+    for (uint8_t c = 0; c < mgr->n_carriers; c++) {
+        harq_entity_t *e = &mgr->entities[(size_t)slot * mgr->n_carriers + c];
+        for (int p = 0; p < HARQ_NUM_PROCESSES; p++)
+            if (e->proc[p].buf != L2_BUF_NONE) l2_buf_put(mgr->pool, e->proc[p].buf);
+        harq_entity_reset(e, 0);
+    }
+    mgr->rnti_map[rnti] = HARQ_NO_UE;
+    mgr->free_slots[mgr->free_top++] = slot;
+}
+
+int harq_new_tx(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid,
+                l2_buf_ref_t buf, uint32_t tb_len) {
+    harq_entity_t *e = harq_entity(mgr, rnti, carrier);
+    if (!e || pid >= HARQ_NUM_PROCESSES || !(e->idle_mask & (1u << pid))) return -1;
+
+    harq_proc_t *p = &e->proc[pid];
+    l2_buf_get(mgr->pool, buf);
+    p->buf = buf;
+    p->tb_len = tb_len;
+    p->state = HARQ_WAIT_ACK;
+    p->ndi ^= 1;
+    p->rv_idx = 0;
+    p->retx = 0;
+    p->rv_mask = 1u << harq_rv_sequence[0];
+    e->idle_mask &= (uint16_t)~(1u << pid);
+    return harq_rv_sequence[0];
+}
+
+static void harq_proc_release(harq_mgr_t *mgr, harq_entity_t *e, uint8_t pid) {
+    harq_proc_t *p = &e->proc[pid];
+    l2_buf_put(mgr->pool, p->buf);
+    p->buf = L2_BUF_NONE;
+    p->state = HARQ_IDLE;
+    e->idle_mask |= (uint16_t)(1u << pid);
+}
+
+int harq_feedback_batch(harq_mgr_t *mgr, const harq_feedback_t *fb, int n,
+                        harq_retx_t *retx, int max_retx_out, int *consumed) {
+    int n_retx = 0, i;
+
+    for (i = 0; i < n; i++) {
+        harq_entity_t *e = harq_entity(mgr, fb[i].rnti, fb[i].carrier);
+        if (!e || fb[i].pid >= HARQ_NUM_PROCESSES) continue;
+
+        harq_proc_t *p = &e->proc[fb[i].pid];
+        if (p->state != HARQ_WAIT_ACK) continue;
+
+        if (fb[i].ack) {
+            mgr->acks++;
+            harq_proc_release(mgr, e, fb[i].pid);
+            continue;
+        }
+
+        if (p->retx < mgr->max_retx && n_retx == max_retx_out) break;   // No room: caller resubmits from here
+
+        mgr->nacks++;
+        if (p->retx >= mgr->max_retx) {
+            // Out of attempts: leave recovery to RLC ARQ
+            mgr->drops++;
+            harq_proc_release(mgr, e, fb[i].pid);
+            continue;
+        }
+
+        p->retx++;
+        p->rv_idx = (p->rv_idx + 1) & 3;
+        p->rv_mask |= (uint8_t)(1u << harq_rv_sequence[p->rv_idx]);
+
+        harq_retx_t *r = &retx[n_retx++];
+        r->rnti = fb[i].rnti;
+        r->carrier = fb[i].carrier;
+        r->pid = fb[i].pid;
+        r->rv = harq_rv_sequence[p->rv_idx];
+        r->ndi = p->ndi;
+        r->tb_len = p->tb_len;
+        r->buf = p->buf;
+    }
+    if (consumed) *consumed = i;
+    return n_retx;
+}
+
+int harq_rx_indicate(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid, uint8_t ndi, uint8_t rv) {
+    harq_entity_t *e = harq_entity(mgr, rnti, carrier);
+    if (!e || pid >= HARQ_NUM_PROCESSES) return 1;
+
+    harq_proc_t *p = &e->proc[pid];
+    int new_tb = !p->rx_valid || p->rx_ndi != (ndi & 1);
+    if (new_tb) {
+        p->rx_ndi = ndi & 1;
+        p->rx_rv_mask = 0;
+        p->rx_valid = 1;
+    }
+    p->rx_rv_mask |= (uint8_t)(1u << (rv & 3));
+    return new_tb;
+}
+
+void harq_rx_done(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid) {
+    harq_entity_t *e = harq_entity(mgr, rnti, carrier);
+    if (!e || pid >= HARQ_NUM_PROCESSES) return;
+
+    e->proc[pid].rx_valid = 0;
+    e->proc[pid].rx_rv_mask = 0;
+}
@@ -0,0 +1,153 @@
+// harq.h
+#ifndef _HARQ_H_
+#define _HARQ_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "l2_pool.h"
+
+/*============================================================================
+ * HARQ PROCESS MANAGER
+ * Reference: 3GPP TS 38.321 Section 5.3.2 (DL), 5.4.2 (UL)
+ *==========================================================================*/
+
+/**
+ * HARQ entities per UE and carrier
+ *
+ * Description:
+ * Each (UE, carrier) pair has one HARQ entity of 16 processes. A process
+ * in WAIT_ACK holds a pool reference to the MAC PDU it sent, so a
+ * retransmission re-sends the very same buffer with no copy and no
+ * allocation. The buffer goes back to the pool on ACK or when max_retx is
+ * exceeded.
+ *
+ * Lookup:
+ * rnti_map is a direct 65536-entry table RNTI -> UE slot, and entities are
+ * stored [ue_slot][carrier], so (RNTI, carrier, HARQ ID) resolves with two
+ * array indexes. All memory is allocated in harq_mgr_init().
+ *
+ * Redundancy versions are cycled in the TS 38.214 order 0, 2, 3, 1.
+ */
+#define HARQ_NUM_PROCESSES  16
+#define HARQ_NO_UE          UINT16_MAX
+
+typedef enum harq_state {
+    HARQ_IDLE     = 0,
+    HARQ_WAIT_ACK = 1,
+} harq_state_t;
+
+typedef struct harq_proc {
+    l2_buf_ref_t buf;          // MAC PDU held for retransmission
+    uint32_t tb_len;           // TB size in bytes
+    uint8_t  state;            // harq_state_t
+    uint8_t  ndi;              // New Data Indicator, toggled per new TB
+    uint8_t  rv_idx;           // Position in the RV sequence
+    uint8_t  retx;             // Retransmissions done for this TB
+    uint8_t  rv_mask;          // RVs already sent (bit rv), soft-combining hint
+    uint8_t  rx_ndi;           // Receive side: NDI of the TB in the soft buffer
+    uint8_t  rx_rv_mask;       // Receive side: RVs combined into the soft buffer
+    uint8_t  rx_valid;         // Receive side: soft buffer holds a TB
+} harq_proc_t;
+
+typedef struct harq_entity {
+    harq_proc_t proc[HARQ_NUM_PROCESSES];
+    uint16_t idle_mask;        // Bit p set when process p is idle
+    uint16_t rnti;
+} harq_entity_t;
+
+typedef struct harq_mgr {
+    l2_buf_pool_t *pool;
+    uint16_t *rnti_map;        // RNTI -> UE slot, HARQ_NO_UE if unknown
+    harq_entity_t *entities;   // [max_ues][n_carriers]
+    uint16_t *free_slots;      // Free UE slot stack
+    uint16_t free_top;
+    uint16_t max_ues;
+    uint8_t  n_carriers;
+    uint8_t  max_retx;
+    uint64_t acks;
+    uint64_t nacks;
+    uint64_t drops;            // TBs abandoned after max_retx
+} harq_mgr_t;
+
+// Feedback entry as received from PUCCH/PUSCH (DL) or decoded PUSCH (UL)
+typedef struct harq_feedback {
+    uint16_t rnti;
+    uint8_t  carrier;
+    uint8_t  pid;
+    uint8_t  ack;              // 1 = ACK, 0 = NACK
+} harq_feedback_t;
+
+// Retransmission to schedule, produced from NACK feedback
+typedef struct harq_retx {
+    uint16_t rnti;
+    uint8_t  carrier;
+    uint8_t  pid;
+    uint8_t  rv;               // Redundancy version to transmit
+    uint8_t  ndi;              // Unchanged NDI
+    uint32_t tb_len;
+    l2_buf_ref_t buf;          // Borrowed: valid until the process completes
+} harq_retx_t;
+
+static const uint8_t harq_rv_sequence[4] = { 0, 2, 3, 1 };
+
+int  harq_mgr_init(harq_mgr_t *mgr, l2_buf_pool_t *pool, uint16_t max_ues, uint8_t n_carriers, uint8_t max_retx);
+void harq_mgr_destroy(harq_mgr_t *mgr);
+
+// Register a UE; returns 0, or -1 if the RNTI exists or the table is full
+int harq_ue_add(harq_mgr_t *mgr, uint16_t rnti);
+
+// Remove a UE and release every buffer its processes hold
+void harq_ue_remove(harq_mgr_t *mgr, uint16_t rnti);
+
+static inline harq_entity_t *harq_entity(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier) {
+    uint16_t slot = mgr->rnti_map[rnti];
+    if (slot == HARQ_NO_UE || carrier >= mgr->n_carriers) return NULL;
+    return &mgr->entities[(size_t)slot * mgr->n_carriers + carrier];
+}
+
+// Lowest idle process ID, -1 if all 16 are waiting for feedback
+static inline int harq_free_pid(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier) {
+    harq_entity_t *e = harq_entity(mgr, rnti, carrier);
+    if (!e || !e->idle_mask) return -1;
+    return __builtin_ctz(e->idle_mask);
+}
+
+/**
+ * Start a new TB on an idle process: NDI toggles, RV restarts at 0.
+ * The process takes its own reference on buf; the caller keeps theirs.
+ *
+ * Returns the RV to transmit (0), or -1 if the process is busy.
+ */
+int harq_new_tx(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid,
+                l2_buf_ref_t buf, uint32_t tb_len);
+
+/**
+ * Apply a batch of feedback.
+ *
+ * ACKs and TBs past max_retx release their buffer and go idle. NACKs of
+ * live TBs advance the RV and are written to retx. Feedback for unknown
+ * UEs or idle processes is ignored.
+ *
+ * When a NACK needs a retransmission and retx already holds max_retx_out
+ * entries, the batch stops before that entry: the process stays in
+ * WAIT_ACK untouched, and the caller drains retx and resubmits
+ * fb + *consumed. consumed may be NULL when max_retx_out >= n.
+ *
+ * Returns the number of retransmissions written.
+ */
+int harq_feedback_batch(harq_mgr_t *mgr, const harq_feedback_t *fb, int n,
+                        harq_retx_t *retx, int max_retx_out, int *consumed);
+
+/**
+ * Receive side soft-buffer bookkeeping for one decoded transmission.
+ *
+ * Returns 1 if the transmission starts a new TB (NDI toggled or buffer
+ * empty: flush the soft buffer), 0 if it must be combined with it.
+ */
+int harq_rx_indicate(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid, uint8_t ndi, uint8_t rv);
+
+// Receive side: TB decoded (CRC ok) or abandoned, soft buffer is free
+void harq_rx_done(harq_mgr_t *mgr, uint16_t rnti, uint8_t carrier, uint8_t pid);
+
+#endif
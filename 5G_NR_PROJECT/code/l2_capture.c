@@ -0,0 +1,359 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "l2_capture.h"
+#include "l2_mem.h"
+
+#define L2_CAPTURE_REC_HDR  (sizeof(l2_pcap_rec_hdr_t) + 20 + 8)   // pcap + IPv4 + UDP
+
+/*----------------------------------------------------------------------------
+ * io_uring, raw syscalls
+ *--------------------------------------------------------------------------*/
+
+static int uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, const void *arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr);
+}
+
+static int l2_capture_ring_init(l2_capture_t *c, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    if (c->cfg.sqpoll) {
+        p.flags = IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = 1000;   // ms before the kernel thread sleeps
+    }
+
+    c->ring_fd = uring_setup(entries, &p);
+    if (c->ring_fd < 0) return -1;
+
+    c->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    c->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (c->cq_ring_len > c->sq_ring_len) c->sq_ring_len = c->cq_ring_len;
+        c->cq_ring_len = c->sq_ring_len;
+    }
+
+    c->sq_ring = mmap(NULL, c->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      c->ring_fd, IORING_OFF_SQ_RING);
+    if (c->sq_ring == MAP_FAILED) return -1;
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        c->cq_ring = c->sq_ring;
+    } else {
+        c->cq_ring = mmap(NULL, c->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          c->ring_fd, IORING_OFF_CQ_RING);
+        if (c->cq_ring == MAP_FAILED) return -1;
+    }
+    c->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    c->sqes = mmap(NULL, c->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   c->ring_fd, IORING_OFF_SQES);
+    if (c->sqes == MAP_FAILED) return -1;
+
+    uint8_t *sq = c->sq_ring, *cq = c->cq_ring;
+    c->sq_head = (uint32_t *)(sq + p.sq_off.head);
+    c->sq_tail = (uint32_t *)(sq + p.sq_off.tail);
+    c->sq_mask = (uint32_t *)(sq + p.sq_off.ring_mask);
+    c->sq_array = (uint32_t *)(sq + p.sq_off.array);
+    c->sq_flags = (uint32_t *)(sq + p.sq_off.flags);
+    c->cq_head = (uint32_t *)(cq + p.cq_off.head);
+    c->cq_tail = (uint32_t *)(cq + p.cq_off.tail);
+    c->cq_mask = (uint32_t *)(cq + p.cq_off.ring_mask);
+    c->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void l2_capture_ring_free(l2_capture_t *c) {
+    if (c->sqes && c->sqes != MAP_FAILED) munmap(c->sqes, c->sqes_len);
+    if (c->cq_ring && c->cq_ring != MAP_FAILED && c->cq_ring != c->sq_ring)
+        munmap(c->cq_ring, c->cq_ring_len);
+    if (c->sq_ring && c->sq_ring != MAP_FAILED) munmap(c->sq_ring, c->sq_ring_len);
+    if (c->ring_fd >= 0) close(c->ring_fd);
+    c->sqes = NULL;
+    c->sq_ring = c->cq_ring = NULL;
+    c->ring_fd = -1;
+}
+
+// Queue a write of len bytes of buffer idx at off; submitted by the next poll
+static void l2_capture_queue_write(l2_capture_t *c, uint32_t idx, uint32_t len, uint64_t off) {
+    uint32_t tail = *c->sq_tail;
+    uint32_t slot = tail & *c->sq_mask;
+    struct io_uring_sqe *sqe = &c->sqes[slot];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = c->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = c->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(c->mem + (size_t)idx * c->cfg.buf_size);
+    sqe->len = len;
+    sqe->off = off;
+    sqe->buf_index = (uint16_t)(c->fixed ? idx : 0);
+    sqe->user_data = (uint64_t)idx << 32 | len;
+    c->sq_array[slot] = slot;
+    __atomic_store_n(c->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    c->busy[idx] = 1;
+    c->sq_pending++;
+    if (++c->inflight > c->ctr.max_inflight) c->ctr.max_inflight = c->inflight;
+    c->ctr.writes++;
+}
+
+static void l2_capture_reap(l2_capture_t *c) {
+    uint32_t head = *c->cq_head;
+    uint32_t tail = __atomic_load_n(c->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &c->cqes[head & *c->cq_mask];
+        uint32_t idx = (uint32_t)(cqe->user_data >> 32);
+        uint32_t len = (uint32_t)cqe->user_data;
+        if (cqe->res < 0)
+            c->ctr.write_errors++;
+        else if ((uint32_t)cqe->res != len)
+            c->ctr.short_writes++;
+        c->busy[idx] = 0;
+        c->inflight--;
+    }
+    __atomic_store_n(c->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static void l2_capture_submit(l2_capture_t *c) {
+    if (!c->sq_pending) return;
+    if (c->cfg.sqpoll) {
+        if (__atomic_load_n(c->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP)
+            uring_enter(c->ring_fd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+    } else {
+        uring_enter(c->ring_fd, c->sq_pending, 0, 0);
+    }
+    c->sq_pending = 0;
+}
+
+void l2_capture_poll(l2_capture_t *c) {
+    l2_capture_reap(c);
+    l2_capture_submit(c);
+}
+
+/*----------------------------------------------------------------------------
+ * Open / close
+ *--------------------------------------------------------------------------*/
+
+int l2_capture_open(l2_capture_t *c, const char *path, const l2_capture_cfg_t *cfg) {
+    memset(c, 0, sizeof(*c));
+    c->fd = c->ring_fd = -1;
+    c->cfg = (l2_capture_cfg_t){ .node = L2_MEM_NODE_LOCAL };
+    if (cfg) c->cfg = *cfg;
+    if (!c->cfg.buf_size) c->cfg.buf_size = L2_CAPTURE_BUF_SIZE;
+    if (!c->cfg.n_bufs) c->cfg.n_bufs = L2_CAPTURE_BUFS;
+    if (!c->cfg.snaplen) c->cfg.snaplen = L2_CAPTURE_SNAPLEN;
+    if (c->cfg.buf_size % L2_CAPTURE_ALIGN || c->cfg.n_bufs < 2 || c->cfg.n_bufs > 1024)
+        return -1;
+    // A record always fits one buffer and one IPv4 / UDP datagram
+    uint32_t max_payload = 65535 - 20 - 8 - L2_PCAP_FRAMING_MAX;
+    if (c->cfg.snaplen > max_payload) c->cfg.snaplen = max_payload;
+    if (c->cfg.snaplen + L2_CAPTURE_REC_HDR + L2_PCAP_FRAMING_MAX > c->cfg.buf_size) return -1;
+
+    c->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    c->direct = c->fd >= 0;
+    if (c->fd < 0 && errno == EINVAL)   // tmpfs and friends
+        c->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (c->fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    size_t bytes = (size_t)c->cfg.n_bufs * c->cfg.buf_size;
+    c->mem = l2_mem_alloc(bytes, c->cfg.node, "capture buffers");
+    c->busy = calloc(c->cfg.n_bufs, 1);
+    if (!c->mem || !c->busy || l2_capture_ring_init(c, c->cfg.n_bufs) < 0) {
+        perror("l2_capture: io_uring setup");
+        goto fail;
+    }
+
+    // Registered buffers spare the kernel pinning pages on every write
+    struct iovec *iov = calloc(c->cfg.n_bufs, sizeof(*iov));
+    if (iov) {
+        for (uint32_t i = 0; i < c->cfg.n_bufs; i++) {
+            iov[i].iov_base = c->mem + (size_t)i * c->cfg.buf_size;
+            iov[i].iov_len = c->cfg.buf_size;
+        }
+        c->fixed = uring_register(c->ring_fd, IORING_REGISTER_BUFFERS, iov, c->cfg.n_bufs) == 0;
+        free(iov);
+    }
+
+    l2_pcap_file_hdr_t fh = {
+        .magic = L2_PCAP_MAGIC_NS,
+        .version_major = 2,
+        .version_minor = 4,
+        .snaplen = 65535,
+        .linktype = L2_PCAP_LINK_IPV4,
+    };
+    memcpy(c->mem, &fh, sizeof(fh));
+    c->used = sizeof(fh);
+    return 0;
+
+fail:
+    l2_capture_ring_free(c);
+    l2_mem_free(c->mem);
+    free(c->busy);
+    close(c->fd);
+    memset(c, 0, sizeof(*c));
+    c->fd = c->ring_fd = -1;
+    return -1;
+}
+
+void l2_capture_close(l2_capture_t *c) {
+    if (c->fd < 0) return;
+
+    // Tail: padded to the O_DIRECT granule, the padding is truncated away
+    uint64_t end = c->file_off + c->used;
+    if (c->used) {
+        uint32_t idx = c->cur;
+        while (c->busy[idx]) {
+            l2_capture_submit(c);
+            uring_enter(c->ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+            l2_capture_reap(c);
+        }
+        uint32_t len = (c->used + L2_CAPTURE_ALIGN - 1) & ~(uint32_t)(L2_CAPTURE_ALIGN - 1);
+        memset(c->mem + (size_t)idx * c->cfg.buf_size + c->used, 0, len - c->used);
+        l2_capture_queue_write(c, idx, len, c->file_off);
+    }
+    while (c->inflight || c->sq_pending) {
+        l2_capture_submit(c);
+        if (c->inflight) uring_enter(c->ring_fd, 0, 1, IORING_ENTER_GETEVENTS);
+        l2_capture_reap(c);
+    }
+    if (ftruncate(c->fd, (off_t)end) < 0) c->ctr.write_errors++;
+
+    l2_capture_ring_free(c);
+    close(c->fd);
+    l2_mem_free(c->mem);
+    free(c->busy);
+    c->fd = -1;
+    c->mem = NULL;
+    c->busy = NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * Records
+ *--------------------------------------------------------------------------*/
+
+// Copy n bytes at the fill position, moving to the next buffer when one fills
+static void l2_capture_put(l2_capture_t *c, const void *src, size_t n) {
+    const uint8_t *s = src;
+    while (n) {
+        size_t room = c->cfg.buf_size - c->used;
+        size_t k = n < room ? n : room;
+        memcpy(c->mem + (size_t)c->cur * c->cfg.buf_size + c->used, s, k);
+        c->used += (uint32_t)k;
+        s += k;
+        n -= k;
+        if (c->used == c->cfg.buf_size) {
+            l2_capture_queue_write(c, c->cur, c->cfg.buf_size, c->file_off);
+            c->file_off += c->cfg.buf_size;
+            c->cur = (c->cur + 1) % c->cfg.n_bufs;
+            c->used = 0;
+        }
+    }
+}
+
+static int l2_capture_record(l2_capture_t *c, uint64_t ts_ns, const uint8_t *framing, int flen,
+                             const uint8_t *pdu, size_t len) {
+    if (flen < 0) return -1;
+
+    uint32_t caplen = len > c->cfg.snaplen ? c->cfg.snaplen : (uint32_t)len;
+    uint32_t rec = (uint32_t)L2_CAPTURE_REC_HDR + (uint32_t)flen + caplen;
+
+    // Backpressure: the record must fit without waiting for a write
+    uint32_t next = (c->cur + 1) % c->cfg.n_bufs;
+    if (c->used + rec >= c->cfg.buf_size && c->busy[next]) {
+        c->ctr.dropped++;
+        c->ctr.dropped_bytes += rec;
+        if (c->cfg.stats) l2_stats_inc(c->cfg.stats, L2_CTR_CAPTURE_DROP);
+        return -1;
+    }
+
+    uint8_t hdr[L2_CAPTURE_REC_HDR];
+    uint32_t ip_len = 20 + 8 + (uint32_t)flen + caplen;
+    l2_pcap_rec_hdr_t rh = {
+        .ts_sec = (uint32_t)(ts_ns / 1000000000ull),
+        .ts_frac = (uint32_t)(ts_ns % 1000000000ull),
+        .incl_len = ip_len,
+        .orig_len = ip_len + (uint32_t)(len - caplen),
+    };
+    memcpy(hdr, &rh, sizeof(rh));
+
+    // IPv4 127.0.0.1 -> 127.0.0.2, DF, UDP
+    uint8_t *ip = hdr + sizeof(rh);
+    static const uint8_t ip_tmpl[20] = { 0x45, 0, 0, 0, 0, 0, 0x40, 0, 64, 17, 0, 0,
+                                         127, 0, 0, 1, 127, 0, 0, 2 };
+    memcpy(ip, ip_tmpl, sizeof(ip_tmpl));
+    ip[2] = (uint8_t)(ip_len >> 8);
+    ip[3] = (uint8_t)ip_len;
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) sum += (uint32_t)(ip[i] << 8 | ip[i + 1]);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = ~(sum + (sum >> 16)) & 0xFFFF;
+    ip[10] = (uint8_t)(sum >> 8);
+    ip[11] = (uint8_t)sum;
+
+    uint8_t *udp = ip + 20;
+    uint32_t udp_len = ip_len - 20;
+    udp[0] = udp[2] = (uint8_t)(L2_CAPTURE_UDP_PORT >> 8);
+    udp[1] = udp[3] = (uint8_t)L2_CAPTURE_UDP_PORT;
+    udp[4] = (uint8_t)(udp_len >> 8);
+    udp[5] = (uint8_t)udp_len;
+    udp[6] = udp[7] = 0;   // No checksum
+
+    l2_capture_put(c, hdr, sizeof(hdr));
+    l2_capture_put(c, framing, (size_t)flen);
+    l2_capture_put(c, pdu, caplen);
+
+    c->ctr.records++;
+    c->ctr.bytes += rec;
+    if (caplen < len) c->ctr.truncated++;
+    return 0;
+}
+
+int l2_capture_mac(l2_capture_t *c, uint64_t ts_ns, const mac_nr_info_t *info,
+                   const uint8_t *pdu, size_t len) {
+    uint8_t f[L2_PCAP_FRAMING_MAX];
+    return l2_capture_record(c, ts_ns, f, mac_nr_framing_write(f, sizeof(f), info), pdu, len);
+}
+
+int l2_capture_rlc(l2_capture_t *c, uint64_t ts_ns, const rlc_nr_info_t *info,
+                   const uint8_t *pdu, size_t len) {
+    uint8_t f[L2_PCAP_FRAMING_MAX];
+    return l2_capture_record(c, ts_ns, f, rlc_nr_framing_write(f, sizeof(f), info), pdu, len);
+}
+
+int l2_capture_pdcp(l2_capture_t *c, uint64_t ts_ns, const pdcp_nr_info_t *info,
+                    const uint8_t *pdu, size_t len) {
+    uint8_t f[L2_PCAP_FRAMING_MAX];
+    return l2_capture_record(c, ts_ns, f, pdcp_nr_framing_write(f, sizeof(f), info), pdu, len);
+}
+
+void l2_capture_report(FILE *out, const l2_capture_t *c) {
+    const l2_capture_counters_t *k = &c->ctr;
+    fprintf(out, "=== L2 Capture ===\n");
+    fprintf(out, "  %s, %s, %u x %u KB buffers%s\n", c->direct ? "O_DIRECT" : "page cache",
+            c->fixed ? "registered buffers" : "unregistered buffers", c->cfg.n_bufs,
+            c->cfg.buf_size >> 10, c->cfg.sqpoll ? ", SQ polling" : "");
+    fprintf(out, "  records %llu (%.1f MB), truncated %llu\n", (unsigned long long)k->records,
+            (double)k->bytes / 1e6, (unsigned long long)k->truncated);
+    fprintf(out, "  dropped %llu (%.1f MB) on backpressure\n", (unsigned long long)k->dropped,
+            (double)k->dropped_bytes / 1e6);
+    fprintf(out, "  writes %llu, errors %llu, short %llu, max in flight %u\n",
+            (unsigned long long)k->writes, (unsigned long long)k->write_errors,
+            (unsigned long long)k->short_writes, k->max_inflight);
+}
@@ -0,0 +1,128 @@
+// l2_capture.h
+#ifndef _L2_CAPTURE_H_
+#define _L2_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "l2_pcap.h"
+#include "l2_stats.h"
+
+/*============================================================================
+ * ASYNCHRONOUS PCAP CAPTURE OF L2 / RRC TRAFFIC (IO_URING)
+ *==========================================================================*/
+
+/**
+ * L2 capture writer
+ *
+ * Description:
+ * Formats MAC-NR, RLC-NR and PDCP-NR PDUs as pcap records (IPv4/UDP with
+ * the Wireshark framing of l2_pcap.h, LINKTYPE_IPV4, ns timestamps) into
+ * a ring of large aligned buffers. A full buffer is queued as one write
+ * to an io_uring instance set up with raw syscalls; the file is opened
+ * with O_DIRECT where the filesystem allows it, so written data does not
+ * pass through or pollute the page cache.
+ *
+ * Nothing on the record path blocks or enters the kernel. Queued writes
+ * are submitted in one batch by l2_capture_poll(), which the owner calls
+ * once per slot after the deadline work (with sqpoll, a kernel thread
+ * picks them up and poll only reaps completions). When the next buffer is
+ * still in flight the record is dropped and counted instead of waiting:
+ * capture loses data under backpressure, the slot never waits for disk.
+ *
+ * One writer has one owner thread; each data path core opens its own
+ * file. Buffers are written whole, so records may straddle two buffers;
+ * l2_capture_close() writes the padded tail and truncates the file to its
+ * exact length.
+ */
+#define L2_CAPTURE_ALIGN       4096           // O_DIRECT offset / length / address alignment
+#define L2_CAPTURE_BUF_SIZE    (1u << 20)     // Default bytes per write
+#define L2_CAPTURE_BUFS        16             // Default buffers in the ring
+#define L2_CAPTURE_SNAPLEN     9000           // Default PDU bytes kept per record
+#define L2_CAPTURE_UDP_PORT    9999
+
+typedef struct l2_capture_cfg {
+    uint32_t buf_size;         // Multiple of L2_CAPTURE_ALIGN, 0 = default
+    uint32_t n_bufs;           // 2..1024, 0 = default
+    uint32_t snaplen;          // 0 = default
+    int      sqpoll;           // Submission by a kernel polling thread
+    int      node;             // NUMA node of the buffers (l2_mem), L2_MEM_NODE_LOCAL
+    l2_stats_core_t *stats;    // Optional: drops also counted in L2_CTR_CAPTURE_DROP
+} l2_capture_cfg_t;
+
+typedef struct l2_capture_counters {
+    uint64_t records;
+    uint64_t bytes;            // Record bytes accepted into buffers
+    uint64_t dropped;          // Records refused: no free buffer
+    uint64_t dropped_bytes;
+    uint64_t truncated;        // Records cut to snaplen
+    uint64_t writes;           // Buffers submitted
+    uint64_t write_errors;     // Completions with an error
+    uint64_t short_writes;
+    uint32_t max_inflight;
+} l2_capture_counters_t;
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+typedef struct l2_capture {
+    int fd;
+    int ring_fd;
+    int direct;                // File opened with O_DIRECT
+    int fixed;                 // Buffers registered, WRITE_FIXED in use
+    l2_capture_cfg_t cfg;
+
+    // io_uring rings (mmapped)
+    void *sq_ring;
+    size_t sq_ring_len;
+    void *cq_ring;
+    size_t cq_ring_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+    uint32_t *sq_head, *sq_tail, *sq_mask, *sq_array, *sq_flags;
+    uint32_t *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    uint32_t sq_pending;       // Queued SQEs not yet submitted
+
+    // Buffer ring
+    uint8_t *mem;              // n_bufs * buf_size
+    uint8_t *busy;             // Per buffer: write in flight
+    uint32_t cur;              // Buffer being filled
+    uint32_t used;             // Bytes used in cur
+    uint64_t file_off;         // File offset of cur
+    uint32_t inflight;
+
+    l2_capture_counters_t ctr;
+} l2_capture_t;
+
+/**
+ * Create path and set up the ring. cfg may be NULL for defaults.
+ * Returns 0, -1 on error (io_uring unavailable, out of memory...).
+ */
+int  l2_capture_open(l2_capture_t *c, const char *path, const l2_capture_cfg_t *cfg);
+
+// Submit everything, wait for the writes and truncate the file to its length
+void l2_capture_close(l2_capture_t *c);
+
+/**
+ * Add one PDU. ts_ns is the wall clock capture time (CLOCK_REALTIME).
+ * Returns 0, -1 if the record was dropped.
+ */
+int l2_capture_mac(l2_capture_t *c, uint64_t ts_ns, const mac_nr_info_t *info,
+                   const uint8_t *pdu, size_t len);
+int l2_capture_rlc(l2_capture_t *c, uint64_t ts_ns, const rlc_nr_info_t *info,
+                   const uint8_t *pdu, size_t len);
+int l2_capture_pdcp(l2_capture_t *c, uint64_t ts_ns, const pdcp_nr_info_t *info,
+                    const uint8_t *pdu, size_t len);
+
+/**
+ * Reap completed writes and submit the queued ones with a single
+ * io_uring_enter (none with sqpoll unless the kernel thread sleeps).
+ * Call once per slot, outside the deadline critical section.
+ */
+void l2_capture_poll(l2_capture_t *c);
+
+void l2_capture_report(FILE *out, const l2_capture_t *c);
+
+#endif
@@ -0,0 +1,422 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "l2_colstore.h"
+
+#define L2_COL_PAD         8      // Slack after packed data for 8-byte loads
+#define L2_COL_COL_MAX     ((size_t)L2_COL_BLOCK_ROWS * 8 + L2_COL_PAD + 8)
+
+_Static_assert(sizeof(l2_col_file_hdr_t) <= L2_COL_HDR_SIZE, "file header must fit its page");
+
+struct l2_col_builder {
+    uint32_t n;
+    l2_col_row_t rows[L2_COL_BLOCK_ROWS];
+};
+
+static const char *const col_names[L2_COL_COUNT] = {
+    [L2_COL_TS]      = "ts",
+    [L2_COL_LCID]    = "lcid",
+    [L2_COL_DIR]     = "dir",
+    [L2_COL_FLAGS]   = "flags",
+    [L2_COL_LEN]     = "len",
+    [L2_COL_SI]      = "si",
+    [L2_COL_SN]      = "sn",
+    [L2_COL_SO]      = "so",
+    [L2_COL_PDCP_SN] = "pdcp_sn",
+    [L2_COL_QFI]     = "qfi",
+    [L2_COL_ACK_SN]  = "ack_sn",
+    [L2_COL_NACKS]   = "nacks",
+};
+
+const char *l2_col_name(l2_col_t c) {
+    return (unsigned)c < L2_COL_COUNT ? col_names[c] : "unknown";
+}
+
+/*----------------------------------------------------------------------------
+ * Bit packing (little-endian host)
+ *--------------------------------------------------------------------------*/
+
+static inline uint64_t zigzag(uint64_t d) {
+    return (d << 1) ^ (uint64_t)((int64_t)d >> 63);
+}
+
+static inline uint64_t unzigzag(uint64_t z) {
+    return (z >> 1) ^ (uint64_t)-(int64_t)(z & 1);
+}
+
+static inline uint8_t bits_for(uint64_t v) {
+    return v ? (uint8_t)(64 - __builtin_clzll(v)) : 0;
+}
+
+static size_t l2_col_pack(const uint64_t *v, uint32_t n, uint8_t w, uint8_t *out) {
+    if (!w) return 0;
+    size_t bytes = ((size_t)n * w + 7) / 8;
+    memset(out, 0, bytes + L2_COL_PAD + 1);
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t bit = (uint64_t)i * w;
+        size_t byte = (size_t)(bit >> 3);
+        uint32_t sh = (uint32_t)(bit & 7);
+        uint64_t word;
+        memcpy(&word, out + byte, 8);
+        word |= v[i] << sh;
+        memcpy(out + byte, &word, 8);
+        if (sh + w > 64) out[byte + 8] |= (uint8_t)(v[i] >> (64 - sh));
+    }
+    return bytes + L2_COL_PAD;
+}
+
+static void l2_col_unpack(const uint8_t *in, uint32_t n, uint8_t w, uint64_t *out) {
+    if (!w) {
+        memset(out, 0, (size_t)n * sizeof(*out));
+        return;
+    }
+    uint64_t mask = w == 64 ? ~0ull : (1ull << w) - 1;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t bit = (uint64_t)i * w;
+        size_t byte = (size_t)(bit >> 3);
+        uint32_t sh = (uint32_t)(bit & 7);
+        uint64_t word;
+        memcpy(&word, in + byte, 8);
+        word >>= sh;
+        if (sh + w > 64) word |= (uint64_t)in[byte + 8] << (64 - sh);
+        out[i] = word & mask;
+    }
+}
+
+// Encode one column with whichever of FOR / zigzag delta needs fewer bits
+static size_t l2_col_encode(uint64_t *v, uint32_t n, l2_col_enc_t *e, uint8_t *out) {
+    uint64_t mn = v[0], mx = v[0], dor = 0;
+    for (uint32_t i = 1; i < n; i++) {
+        if (v[i] < mn) mn = v[i];
+        if (v[i] > mx) mx = v[i];
+        dor |= zigzag(v[i] - v[i - 1]);
+    }
+    uint8_t w_for = bits_for(mx - mn), w_delta = bits_for(dor);
+
+    memset(e, 0, sizeof(*e));
+    if (w_delta < w_for) {
+        e->enc = L2_COL_ENC_DELTA;
+        e->base = v[0];
+        e->width = w_delta;
+        for (uint32_t i = n; i-- > 1;) v[i] = zigzag(v[i] - v[i - 1]);
+        v[0] = 0;
+    } else {
+        e->enc = L2_COL_ENC_FOR;
+        e->base = mn;
+        e->width = w_for;
+        for (uint32_t i = 0; i < n; i++) v[i] -= mn;
+    }
+    return l2_col_pack(v, n, e->width, out);
+}
+
+static void l2_col_decode(const uint8_t *data, const l2_col_enc_t *e, uint32_t n, uint64_t *out) {
+    l2_col_unpack(data, n, e->width, out);
+    if (e->enc == L2_COL_ENC_DELTA) {
+        uint64_t cur = e->base;
+        out[0] = cur;
+        for (uint32_t i = 1; i < n; i++) out[i] = cur += unzigzag(out[i]);
+    } else {
+        for (uint32_t i = 0; i < n; i++) out[i] += e->base;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Writer
+ *--------------------------------------------------------------------------*/
+
+int l2_col_writer_open(l2_col_writer_t *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    w->f = fopen(path, "wb");
+    if (!w->f) {
+        perror(path);
+        return -1;
+    }
+    w->ue = calloc(65536, sizeof(*w->ue));
+    w->scratch = malloc(L2_COL_COUNT * L2_COL_COL_MAX);
+    w->vals = malloc(L2_COL_BLOCK_ROWS * sizeof(*w->vals));
+    if (!w->ue || !w->scratch || !w->vals) goto fail;
+
+    // Header page, rewritten with the totals on close
+    static const uint8_t zero[L2_COL_HDR_SIZE];
+    if (fwrite(zero, 1, sizeof(zero), w->f) != sizeof(zero)) goto fail;
+    w->off = L2_COL_HDR_SIZE;
+    w->hdr.magic = L2_COL_MAGIC;
+    w->hdr.version = L2_COL_VERSION;
+    w->hdr.n_cols = L2_COL_COUNT;
+    w->hdr.ts_min = UINT64_MAX;
+    return 0;
+
+fail:
+    fclose(w->f);
+    free(w->ue);
+    free(w->scratch);
+    free(w->vals);
+    memset(w, 0, sizeof(*w));
+    return -1;
+}
+
+static int row_cmp(const void *a, const void *b) {
+    const l2_col_row_t *x = a, *y = b;
+    if (x->lcid != y->lcid) return x->lcid < y->lcid ? -1 : 1;
+    if (x->dir != y->dir) return x->dir < y->dir ? -1 : 1;
+    if (x->ts_ns != y->ts_ns) return x->ts_ns < y->ts_ns ? -1 : 1;
+    return (x->sn > y->sn) - (x->sn < y->sn);
+}
+
+// Value of column c in a row; SN-like fields a row lacks repeat prev
+static inline uint64_t row_value(const l2_col_row_t *r, l2_col_t c, uint64_t prev) {
+    switch (c) {
+    case L2_COL_TS:      return r->ts_ns;
+    case L2_COL_LCID:    return r->lcid;
+    case L2_COL_DIR:     return r->dir;
+    case L2_COL_FLAGS:   return r->flags;
+    case L2_COL_LEN:     return r->len;
+    case L2_COL_SI:      return r->si;
+    case L2_COL_SN:      return (r->flags & L2_ROW_DATA) ? r->sn : prev;
+    case L2_COL_SO:      return r->so;
+    case L2_COL_PDCP_SN: return (r->flags & L2_ROW_PDCP) ? r->pdcp_sn : prev;
+    case L2_COL_QFI:     return (r->flags & L2_ROW_SDAP) ? r->qfi : prev;
+    case L2_COL_ACK_SN:  return (r->flags & L2_ROW_STATUS) ? r->ack_sn : prev;
+    case L2_COL_NACKS:   return r->nacks;
+    default:             return 0;
+    }
+}
+
+static int l2_col_flush(l2_col_writer_t *w, l2_col_builder_t *b, uint16_t rnti) {
+    uint32_t n = b->n;
+    if (!n) return 0;
+
+    qsort(b->rows, n, sizeof(b->rows[0]), row_cmp);
+
+    if (w->hdr.n_blocks == w->cap_index) {
+        size_t cap = w->cap_index ? w->cap_index * 2 : 1024;
+        l2_col_block_t *idx = realloc(w->index, cap * sizeof(*idx));
+        if (!idx) return -1;
+        w->index = idx;
+        w->cap_index = cap;
+    }
+    l2_col_block_t *blk = &w->index[w->hdr.n_blocks];
+    memset(blk, 0, sizeof(*blk));
+    blk->off = w->off;
+    blk->rows = n;
+    blk->rnti = rnti;
+    blk->ts_min = UINT64_MAX;
+    for (uint32_t i = 0; i < n; i++) {
+        const l2_col_row_t *r = &b->rows[i];
+        if (r->ts_ns < blk->ts_min) blk->ts_min = r->ts_ns;
+        if (r->ts_ns > blk->ts_max) blk->ts_max = r->ts_ns;
+        blk->lcid_mask |= 1ull << (r->lcid & 63);
+        blk->dir_mask |= (uint8_t)(1u << (r->dir & 1));
+        blk->flags_mask |= r->flags;
+        blk->nacks += r->nacks;
+    }
+
+    size_t pos = 0;
+    for (int c = 0; c < L2_COL_COUNT; c++) {
+        uint64_t prev = 0;
+        for (uint32_t i = 0; i < n; i++) w->vals[i] = prev = row_value(&b->rows[i], (l2_col_t)c, prev);
+        pos = (pos + 7) & ~(size_t)7;
+        size_t len = l2_col_encode(w->vals, n, &blk->col[c], w->scratch + pos);
+        blk->col[c].off = (uint32_t)pos;
+        pos += len;
+    }
+    pos = (pos + 7) & ~(size_t)7;
+    if (fwrite(w->scratch, 1, pos, w->f) != pos) return -1;
+
+    blk->bytes = (uint32_t)pos;
+    w->off += pos;
+    w->hdr.n_blocks++;
+    w->hdr.n_rows += n;
+    if (blk->ts_min < w->hdr.ts_min) w->hdr.ts_min = blk->ts_min;
+    if (blk->ts_max > w->hdr.ts_max) w->hdr.ts_max = blk->ts_max;
+    b->n = 0;
+    return 0;
+}
+
+int l2_col_append(l2_col_writer_t *w, const l2_col_row_t *row) {
+    l2_col_builder_t *b = w->ue[row->rnti];
+    if (!b) {
+        b = w->ue[row->rnti] = malloc(sizeof(*b));
+        if (!b) return -1;
+        b->n = 0;
+    }
+    b->rows[b->n++] = *row;
+    return b->n == L2_COL_BLOCK_ROWS ? l2_col_flush(w, b, row->rnti) : 0;
+}
+
+int l2_col_writer_close(l2_col_writer_t *w) {
+    int ret = 0;
+    if (!w->f) return -1;
+
+    for (uint32_t rnti = 0; rnti < 65536; rnti++) {
+        if (!w->ue[rnti]) continue;
+        if (l2_col_flush(w, w->ue[rnti], (uint16_t)rnti) < 0) ret = -1;
+        free(w->ue[rnti]);
+    }
+
+    size_t index_bytes = w->hdr.n_blocks * sizeof(l2_col_block_t);
+    w->hdr.index_off = w->off;
+    if (fwrite(w->index, 1, index_bytes, w->f) != index_bytes) ret = -1;
+    if (!w->hdr.n_rows) w->hdr.ts_min = 0;
+    w->hdr.complete = ret == 0;
+    if (fseek(w->f, 0, SEEK_SET) < 0 || fwrite(&w->hdr, sizeof(w->hdr), 1, w->f) != 1) ret = -1;
+    if (fclose(w->f) != 0) ret = -1;
+
+    free(w->ue);
+    free(w->index);
+    free(w->scratch);
+    free(w->vals);
+    memset(w, 0, sizeof(*w));
+    return ret;
+}
+
+/*----------------------------------------------------------------------------
+ * Reader
+ *--------------------------------------------------------------------------*/
+
+int l2_col_reader_open(l2_col_reader_t *r, const char *path) {
+    struct stat st;
+
+    memset(r, 0, sizeof(*r));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < L2_COL_HDR_SIZE) {
+        fprintf(stderr, " %s is not an L2 column store.\n", path);
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    const l2_col_file_hdr_t *h = p;
+    size_t size = (size_t)st.st_size;
+    if (h->magic != L2_COL_MAGIC || h->version != L2_COL_VERSION || h->n_cols != L2_COL_COUNT ||
+        !h->complete || h->index_off > size ||
+        h->n_blocks > (size - h->index_off) / sizeof(l2_col_block_t)) {
+        fprintf(stderr, " %s is not a complete L2 column store.\n", path);
+        munmap(p, size);
+        return -1;
+    }
+    // Sequential block scans: let the kernel read ahead
+    madvise(p, size, MADV_SEQUENTIAL);
+
+    r->map = p;
+    r->size = size;
+    r->hdr = h;
+    r->index = (const l2_col_block_t *)((const uint8_t *)p + h->index_off);
+    return 0;
+}
+
+void l2_col_reader_close(l2_col_reader_t *r) {
+    if (r->map) munmap((void *)r->map, r->size);
+    memset(r, 0, sizeof(*r));
+}
+
+int l2_col_scan(const l2_col_reader_t *r, const l2_col_query_t *q, l2_col_scan_fn fn, void *arg,
+                l2_col_scan_stats_t *st) {
+    l2_col_scan_stats_t local;
+    if (!st) st = &local;
+    memset(st, 0, sizeof(*st));
+
+    l2_col_batch_t *b = malloc(sizeof(*b));
+    if (!b) return -1;
+
+    uint32_t cols = q->cols | L2_COL_BIT(L2_COL_TS) | (q->lcid_mask ? L2_COL_BIT(L2_COL_LCID) : 0);
+    int ret = 0;
+
+    for (uint64_t i = 0; i < r->hdr->n_blocks && !ret; i++) {
+        const l2_col_block_t *blk = &r->index[i];
+        st->blocks_total++;
+
+        // Index pruning
+        if (q->rnti >= 0 && blk->rnti != (uint16_t)q->rnti) continue;
+        if (blk->ts_max < q->ts_min || blk->ts_min > q->ts_max) continue;
+        if (q->lcid_mask && !(blk->lcid_mask & q->lcid_mask)) continue;
+        if (blk->off > r->size || blk->bytes > r->size - blk->off || blk->rows > L2_COL_BLOCK_ROWS)
+            continue;
+
+        st->blocks_scanned++;
+        st->rows_scanned += blk->rows;
+        const uint8_t *data = r->map + blk->off;
+        for (int c = 0; c < L2_COL_COUNT; c++) {
+            if (!(cols & L2_COL_BIT(c))) continue;
+            l2_col_decode(data + blk->col[c].off, &blk->col[c], blk->rows, b->v[c]);
+            st->bytes_decoded += ((size_t)blk->rows * blk->col[c].width + 7) / 8;
+        }
+
+        // Row filter, only when the block straddles the query bounds
+        uint32_t n = blk->rows;
+        int need_ts = blk->ts_min < q->ts_min || blk->ts_max > q->ts_max;
+        int need_lcid = q->lcid_mask && (blk->lcid_mask & ~q->lcid_mask);
+        if (need_ts || need_lcid) {
+            uint32_t k = 0;
+            for (uint32_t j = 0; j < n; j++) {
+                uint64_t ts = b->v[L2_COL_TS][j];
+                if (ts < q->ts_min || ts > q->ts_max) continue;
+                if (need_lcid && !(q->lcid_mask & (1ull << (b->v[L2_COL_LCID][j] & 63)))) continue;
+                if (k != j)
+                    for (int c = 0; c < L2_COL_COUNT; c++)
+                        if (cols & L2_COL_BIT(c)) b->v[c][k] = b->v[c][j];
+                k++;
+            }
+            n = k;
+        }
+        if (!n) continue;
+
+        b->rnti = blk->rnti;
+        b->n = n;
+        b->cols = cols;
+        st->rows_matched += n;
+        ret = fn(b, arg);
+    }
+    free(b);
+    return ret;
+}
+
+/*----------------------------------------------------------------------------
+ * Canned queries
+ *--------------------------------------------------------------------------*/
+
+static int nack_summary_fn(const l2_col_batch_t *b, void *arg) {
+    l2_col_lcid_summary_t *out = arg;
+    for (uint32_t i = 0; i < b->n; i++) {
+        uint32_t lcid = (uint32_t)b->v[L2_COL_LCID][i];
+        uint32_t dir = (uint32_t)b->v[L2_COL_DIR][i] & 1;
+        uint64_t flags = b->v[L2_COL_FLAGS][i];
+        if (lcid >= L2_COL_NUM_LCID) continue;
+        if (flags & L2_ROW_DATA) {
+            out[lcid].data_pdus[dir]++;
+            out[lcid].data_bytes[dir] += b->v[L2_COL_LEN][i];
+        } else if (flags & L2_ROW_STATUS) {
+            out[lcid].status_pdus[dir]++;
+            out[lcid].nacked_sns[dir] += b->v[L2_COL_NACKS][i];
+        }
+    }
+    return 0;
+}
+
+int l2_col_nack_summary(const l2_col_reader_t *r, uint16_t rnti, uint64_t ts_min, uint64_t ts_max,
+                        l2_col_lcid_summary_t out[L2_COL_NUM_LCID], l2_col_scan_stats_t *st) {
+    l2_col_query_t q = {
+        .ts_min = ts_min,
+        .ts_max = ts_max,
+        .rnti = rnti,
+        .cols = L2_COL_BIT(L2_COL_LCID) | L2_COL_BIT(L2_COL_DIR) | L2_COL_BIT(L2_COL_FLAGS) |
+                L2_COL_BIT(L2_COL_LEN) | L2_COL_BIT(L2_COL_NACKS),
+    };
+    memset(out, 0, L2_COL_NUM_LCID * sizeof(*out));
+    return l2_col_scan(r, &q, nack_summary_fn, out, st);
+}
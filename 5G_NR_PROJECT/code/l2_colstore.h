@@ -0,0 +1,222 @@
+// l2_colstore.h
+#ifndef _L2_COLSTORE_H_
+#define _L2_COLSTORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*============================================================================
+ * COLUMNAR, INDEXED TRACE STORE FOR DECODED L2 HEADERS
+ *==========================================================================*/
+
+/**
+ * L2 column store
+ *
+ * Description:
+ * Offline analysis keeps asking the same questions of multi-hour captures
+ * (per UE, per LCID, per time window), and re-parsing every MAC, RLC and
+ * PDCP header for each question dominates the run time. The store keeps
+ * the decoded header fields of 5g_nr_pdu_structures.h instead, one row
+ * per RLC PDU, in compressed columns:
+ *
+ *   time, LCID, direction, flags, length, SI, RLC SN, SO, PDCP SN, QFI,
+ *   ACK_SN and NACK count (STATUS PDUs)
+ *
+ * Rows are grouped per RNTI into blocks of up to L2_COL_BLOCK_ROWS and
+ * sorted by (LCID, direction, time) inside a block, so SN and COUNT
+ * columns advance by small steps. Each column of a block is bit-packed
+ * either frame-of-reference (value - min) or as zigzag deltas from the
+ * previous row, whichever needs fewer bits; a constant column takes no
+ * bytes at all. Fields a row does not have repeat the previous value,
+ * which keeps their deltas at zero.
+ *
+ * Every block has an index entry: RNTI, time min / max, a bitmap of the
+ * LCIDs and directions present and the encoding of each column. Readers
+ * mmap the file, test the query against the index and decode only the
+ * requested columns of the blocks that can match.
+ *
+ * File layout:
+ * +----------------------------+----------------+-----+--------------------+
+ * | l2_col_file_hdr_t (1 page) | block 0 columns| ... | l2_col_block_t[]   |
+ * +----------------------------+----------------+-----+--------------------+
+ */
+#define L2_COL_MAGIC          0x5343324Cu   // "L2CS"
+#define L2_COL_VERSION        1
+#define L2_COL_HDR_SIZE       4096
+#define L2_COL_BLOCK_ROWS     1024
+#define L2_COL_NUM_LCID       33
+
+typedef enum l2_col {
+    L2_COL_TS = 0,         // Capture time, ns
+    L2_COL_LCID,
+    L2_COL_DIR,            // mac_dir_t
+    L2_COL_FLAGS,          // L2_ROW_*
+    L2_COL_LEN,            // RLC PDU bytes
+    L2_COL_SI,
+    L2_COL_SN,             // RLC SN
+    L2_COL_SO,
+    L2_COL_PDCP_SN,
+    L2_COL_QFI,
+    L2_COL_ACK_SN,
+    L2_COL_NACKS,          // NACK count of a STATUS PDU (number of SNs, ranges expanded)
+    L2_COL_COUNT
+} l2_col_t;
+
+#define L2_COL_BIT(c)         (1u << (c))
+
+// Row flags
+#define L2_ROW_DATA           0x01   // RLC data PDU
+#define L2_ROW_STATUS         0x02   // RLC STATUS PDU: ACK_SN / NACKS valid
+#define L2_ROW_PDCP           0x04   // PDCP header decoded: PDCP_SN valid
+#define L2_ROW_PDCP_CONTROL   0x08
+#define L2_ROW_SDAP           0x10   // QFI valid
+#define L2_ROW_POLL           0x20
+
+// One decoded RLC PDU, as handed to the writer
+typedef struct l2_col_row {
+    uint64_t ts_ns;
+    uint32_t sn;
+    uint32_t pdcp_sn;
+    uint32_t ack_sn;
+    uint32_t nacks;
+    uint16_t rnti;
+    uint16_t len;
+    uint16_t so;
+    uint8_t  lcid;
+    uint8_t  dir;
+    uint8_t  flags;
+    uint8_t  si;
+    uint8_t  qfi;
+} l2_col_row_t;
+
+enum {
+    L2_COL_ENC_FOR = 0,
+    L2_COL_ENC_DELTA = 1,
+};
+
+typedef struct l2_col_enc {
+    uint64_t base;         // FOR: minimum, DELTA: first value
+    uint32_t off;          // Bytes from the block's off
+    uint8_t  enc;          // L2_COL_ENC_*
+    uint8_t  width;        // Bits per value, 0 = constant
+    uint16_t rsv;
+} l2_col_enc_t;
+
+typedef struct l2_col_block {
+    uint64_t off;          // File offset of the block's column data
+    uint64_t ts_min;
+    uint64_t ts_max;
+    uint64_t lcid_mask;    // Bit per LCID present
+    uint32_t rows;
+    uint32_t bytes;
+    uint16_t rnti;
+    uint8_t  dir_mask;     // Bit per mac_dir_t present
+    uint8_t  flags_mask;   // OR of the row flags
+    uint32_t nacks;        // Sum of NACKS, answers coarse questions from the index
+    l2_col_enc_t col[L2_COL_COUNT];
+} l2_col_block_t;
+
+typedef struct l2_col_file_hdr {
+    uint32_t magic;        // L2_COL_MAGIC
+    uint32_t version;      // L2_COL_VERSION
+    uint32_t n_cols;       // L2_COL_COUNT
+    uint32_t complete;     // Set when the index was written
+    uint64_t n_blocks;
+    uint64_t n_rows;
+    uint64_t index_off;
+    uint64_t ts_min;
+    uint64_t ts_max;
+} l2_col_file_hdr_t;
+
+/*----------------------------------------------------------------------------
+ * Writer
+ *--------------------------------------------------------------------------*/
+
+typedef struct l2_col_builder l2_col_builder_t;
+
+typedef struct l2_col_writer {
+    FILE *f;
+    uint64_t off;
+    l2_col_file_hdr_t hdr;
+    l2_col_block_t *index;
+    size_t cap_index;
+    l2_col_builder_t **ue;     // Open block per RNTI, 65536 entries
+    uint8_t *scratch;          // Encoded block
+    uint64_t *vals;            // One column of a block
+} l2_col_writer_t;
+
+int l2_col_writer_open(l2_col_writer_t *w, const char *path);
+
+// Add one row. Returns 0, -1 on a write error.
+int l2_col_append(l2_col_writer_t *w, const l2_col_row_t *row);
+
+// Flush the open blocks, write the index and header. Returns 0, -1 on error.
+int l2_col_writer_close(l2_col_writer_t *w);
+
+/*----------------------------------------------------------------------------
+ * Reader and queries
+ *--------------------------------------------------------------------------*/
+
+typedef struct l2_col_reader {
+    const uint8_t *map;
+    size_t size;
+    const l2_col_file_hdr_t *hdr;
+    const l2_col_block_t *index;
+} l2_col_reader_t;
+
+int  l2_col_reader_open(l2_col_reader_t *r, const char *path);
+void l2_col_reader_close(l2_col_reader_t *r);
+
+typedef struct l2_col_query {
+    uint64_t ts_min;       // Inclusive bounds, 0 / UINT64_MAX for all
+    uint64_t ts_max;
+    int32_t  rnti;         // -1 = any
+    uint64_t lcid_mask;    // 0 = any
+    uint32_t cols;         // L2_COL_BIT()s to decode
+} l2_col_query_t;
+
+// Matching rows of one block, column-wise
+typedef struct l2_col_batch {
+    uint16_t rnti;
+    uint32_t n;
+    uint32_t cols;         // Columns filled
+    uint64_t v[L2_COL_COUNT][L2_COL_BLOCK_ROWS];
+} l2_col_batch_t;
+
+typedef struct l2_col_scan_stats {
+    uint64_t blocks_total;
+    uint64_t blocks_scanned;   // Blocks the index could not rule out
+    uint64_t rows_scanned;
+    uint64_t rows_matched;
+    uint64_t bytes_decoded;
+} l2_col_scan_stats_t;
+
+// Return non-zero from the callback to stop the scan
+typedef int (*l2_col_scan_fn)(const l2_col_batch_t *b, void *arg);
+
+/**
+ * Call fn for the rows of every block that match q.
+ * Returns 0, or the non-zero value fn stopped with.
+ */
+int l2_col_scan(const l2_col_reader_t *r, const l2_col_query_t *q, l2_col_scan_fn fn, void *arg,
+                l2_col_scan_stats_t *st);
+
+// Per LCID and direction: what data went one way and what STATUS PDUs NACKed
+typedef struct l2_col_lcid_summary {
+    uint64_t data_pdus[2];     // [mac_dir_t]
+    uint64_t data_bytes[2];
+    uint64_t status_pdus[2];   // STATUS PDUs sent in this direction
+    uint64_t nacked_sns[2];    // SNs they NACK (data of the other direction)
+} l2_col_lcid_summary_t;
+
+/**
+ * NACK summary per LCID of one UE within [ts_min, ts_max]. The NACK rate
+ * of the data sent in direction d is nacked_sns[!d] / data_pdus[d].
+ */
+int l2_col_nack_summary(const l2_col_reader_t *r, uint16_t rnti, uint64_t ts_min, uint64_t ts_max,
+                        l2_col_lcid_summary_t out[L2_COL_NUM_LCID], l2_col_scan_stats_t *st);
+
+const char *l2_col_name(l2_col_t c);
+
+#endif
@@ -0,0 +1,368 @@
+/**
+ * L2 column store tool
+ *
+ * ingest: decodes the MAC, RLC, PDCP and SDAP headers of a mac-nr pcap
+ *         (see l2_pcap.h) once and writes them to a column store
+ * info:   block, row and per-column size statistics
+ * nack:   NACK rate per LCID for one UE, from the index and 5 columns
+ * scan:   rows of one UE / LCID / time window
+ *
+ * SRBs (LCID 1-3) are decoded as RLC AM 12-bit with PDCP 12-bit SNs,
+ * DRBs with the -r / -q configuration; -s means DRB PDCP SDUs start with
+ * an SDAP header. The store is keyed by RNTI: ingest one cell per store.
+ *
+ * Build:
+ *   gcc -O2 l2_colstore_tool.c l2_colstore.c l2_pcap.c mac_ce.c rlc_entity.c \
+ *       -o l2_colstore_tool
+ *
+ * Usage:
+ *   ./l2_colstore_tool ingest <capture.pcap> <store> [-r am18|am12|um12|um6] [-q 12|18] [-s]
+ *   ./l2_colstore_tool info <store>
+ *   ./l2_colstore_tool nack <store> -u rnti [-t from_ms to_ms]
+ *   ./l2_colstore_tool scan <store> [-u rnti] [-l lcid] [-t from_ms to_ms] [-n rows]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "l2_colstore.h"
+#include "l2_pcap.h"
+#include "mac_ce.h"
+#include "rlc_entity.h"
+
+#define TOOL_MAX_SUBPDU 256
+
+typedef struct ingest_cfg {
+    const rlc_entity_ops_t *srb;
+    const rlc_entity_ops_t *drb;
+    uint8_t pdcp_sn_bits;
+    int sdap;
+} ingest_cfg_t;
+
+typedef struct ingest_stats {
+    uint64_t tbs;
+    uint64_t skipped;          // Not mac-nr, or not C-RNTI
+    uint64_t malformed;
+    uint64_t rows;
+} ingest_stats_t;
+
+static inline uint64_t tool_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+ * Ingest
+ *--------------------------------------------------------------------------*/
+
+static void ingest_pdcp(const ingest_cfg_t *cfg, int srb, const uint8_t *p, size_t len,
+                        l2_col_row_t *row) {
+    if (srb) {
+        // SRB: R R R R SN(12), every PDU is data
+        if (len < 2) return;
+        row->pdcp_sn = (uint32_t)(p[0] & 0x0F) << 8 | p[1];
+        row->flags |= L2_ROW_PDCP;
+        return;
+    }
+    if (len < 1) return;
+    if (!(p[0] & 0x80)) {
+        row->flags |= L2_ROW_PDCP_CONTROL;
+        return;
+    }
+
+    size_t hdr = cfg->pdcp_sn_bits == 12 ? 2 : 3;
+    if (len < hdr) return;
+    row->pdcp_sn = cfg->pdcp_sn_bits == 12 ? (uint32_t)(p[0] & 0x0F) << 8 | p[1]
+                                           : (uint32_t)(p[0] & 0x03) << 16 | (uint32_t)p[1] << 8 | p[2];
+    row->flags |= L2_ROW_PDCP;
+
+    // SDAP header is not ciphered; QFI is the low 6 bits in both directions
+    if (cfg->sdap && len > hdr) {
+        row->qfi = p[hdr] & 0x3F;
+        row->flags |= L2_ROW_SDAP;
+    }
+}
+
+static int ingest_rlc(l2_col_writer_t *w, const ingest_cfg_t *cfg, l2_col_row_t *row,
+                      const uint8_t *p, size_t len, ingest_stats_t *st) {
+    int srb = row->lcid <= 3;
+    const rlc_entity_ops_t *ops = srb ? cfg->srb : cfg->drb;
+
+    if (ops->mode == RLC_MODE_AM && len && !(p[0] & 0x80)) {
+        rlc_status_info_t s;
+        if (rlc_status_parse(p, len, ops->sn_bits, &s) < 0) {
+            st->malformed++;
+            return 0;
+        }
+        row->flags = L2_ROW_STATUS;
+        row->ack_sn = s.ack_sn;
+        row->nacks = s.nacked_sns;
+    } else {
+        rlc_pdu_info_t info;
+        int h = ops->hdr_parse(p, len, &info);
+        if (h < 0) {
+            st->malformed++;
+            return 0;
+        }
+        row->flags = L2_ROW_DATA | (info.poll ? L2_ROW_POLL : 0);
+        row->sn = info.sn;
+        row->so = info.so;
+        row->si = info.si;
+        if (info.si == RLC_SI_COMPLETE || info.si == RLC_SI_FIRST)
+            ingest_pdcp(cfg, srb, p + h, len - (size_t)h, row);
+    }
+    st->rows++;
+    return l2_col_append(w, row);
+}
+
+static int cmd_ingest(const char *in, const char *out, const ingest_cfg_t *cfg) {
+    l2_pcap_reader_t pr;
+    l2_col_writer_t w;
+    ingest_stats_t st = { 0 };
+
+    if (l2_pcap_reader_open(&pr, in) < 0) return 1;
+    if (l2_col_writer_open(&w, out) < 0) {
+        l2_pcap_reader_close(&pr);
+        return 1;
+    }
+
+    uint64_t t0 = tool_now_ns(), ts;
+    mac_nr_info_t info;
+    const uint8_t *pdu;
+    size_t len;
+    uint16_t port;
+    mac_subpdu_t sub[TOOL_MAX_SUBPDU];
+    int err = 0;
+
+    while (!err && l2_pcap_next_mac(&pr, &ts, &info, &pdu, &len, &port, &st.skipped)) {
+        if (info.rnti_type != MAC_NR_RNTI_C && info.rnti_type != MAC_NR_RNTI_CS) {
+            st.skipped++;
+            continue;
+        }
+        mac_dir_t dir = info.direction == MAC_NR_DIR_UL ? MAC_DIR_UL : MAC_DIR_DL;
+        int n = mac_pdu_demux(pdu, len, dir, sub, TOOL_MAX_SUBPDU);
+        if (n < 0) {
+            st.malformed++;
+            continue;
+        }
+        st.tbs++;
+        for (int i = 0; i < n && !err; i++) {
+            if (sub[i].lcid == 0 || sub[i].lcid > MAC_LCID_MAX_SDU) continue;
+            l2_col_row_t row = {
+                .ts_ns = ts, .rnti = info.rnti, .lcid = sub[i].lcid, .dir = (uint8_t)dir,
+                .len = sub[i].len,
+            };
+            err = ingest_rlc(&w, cfg, &row, pdu + sub[i].offset, sub[i].len, &st) < 0;
+        }
+    }
+
+    if (l2_col_writer_close(&w) < 0) err = 1;
+    double secs = (double)(tool_now_ns() - t0) / 1e9;
+    printf("=== L2 Column Store Ingest ===\n");
+    printf("  %llu TB(s), %llu row(s), %llu skipped, %llu malformed, %.3f s (%.2f Mrows/s)\n",
+           (unsigned long long)st.tbs, (unsigned long long)st.rows, (unsigned long long)st.skipped,
+           (unsigned long long)st.malformed, secs, (double)st.rows / secs / 1e6);
+    printf("  capture %.1f MB\n", (double)pr.size / 1e6);
+    l2_pcap_reader_close(&pr);
+    if (err) fprintf(stderr, " %s: write failed.\n", out);
+    return err;
+}
+
+/*----------------------------------------------------------------------------
+ * Queries
+ *--------------------------------------------------------------------------*/
+
+static void print_scan_stats(const l2_col_scan_stats_t *st, uint64_t ns) {
+    printf("  %.3f ms, %llu of %llu block(s) scanned, %llu row(s) scanned, %llu matched, "
+           "%.1f KB decoded\n", (double)ns / 1e6, (unsigned long long)st->blocks_scanned,
+           (unsigned long long)st->blocks_total, (unsigned long long)st->rows_scanned,
+           (unsigned long long)st->rows_matched, (double)st->bytes_decoded / 1024);
+}
+
+static int cmd_info(const l2_col_reader_t *r) {
+    const l2_col_file_hdr_t *h = r->hdr;
+    uint64_t bits[L2_COL_COUNT] = { 0 };
+    uint64_t delta[L2_COL_COUNT] = { 0 };
+
+    for (uint64_t i = 0; i < h->n_blocks; i++) {
+        for (int c = 0; c < L2_COL_COUNT; c++) {
+            bits[c] += (uint64_t)r->index[i].rows * r->index[i].col[c].width;
+            delta[c] += r->index[i].col[c].enc == L2_COL_ENC_DELTA;
+        }
+    }
+
+    printf("=== L2 Column Store ===\n");
+    printf("  %llu row(s) in %llu block(s), %.1f MB, span %.3f s\n",
+           (unsigned long long)h->n_rows, (unsigned long long)h->n_blocks, (double)r->size / 1e6,
+           (double)(h->ts_max - h->ts_min) / 1e9);
+    printf("  %.1f bytes per row (%zu unpacked)\n",
+           h->n_rows ? (double)r->size / (double)h->n_rows : 0.0, sizeof(l2_col_row_t));
+    for (int c = 0; c < L2_COL_COUNT; c++)
+        printf("  %-8s %6.2f bits/row, delta in %5.1f%% of blocks\n", l2_col_name((l2_col_t)c),
+               h->n_rows ? (double)bits[c] / (double)h->n_rows : 0.0,
+               h->n_blocks ? 100.0 * (double)delta[c] / (double)h->n_blocks : 0.0);
+    return 0;
+}
+
+static int cmd_nack(const l2_col_reader_t *r, int rnti, uint64_t ts_min, uint64_t ts_max) {
+    l2_col_lcid_summary_t sum[L2_COL_NUM_LCID];
+    l2_col_scan_stats_t st;
+
+    if (rnti < 0) {
+        fprintf(stderr, " nack needs -u rnti.\n");
+        return 1;
+    }
+    uint64_t t0 = tool_now_ns();
+    l2_col_nack_summary(r, (uint16_t)rnti, ts_min, ts_max, sum, &st);
+    uint64_t ns = tool_now_ns() - t0;
+
+    static const char *const dir_name[2] = { "DL", "UL" };
+    printf("=== NACK rate per LCID, RNTI 0x%04x ===\n", rnti);
+    for (int l = 0; l < L2_COL_NUM_LCID; l++) {
+        for (int d = 0; d < 2; d++) {
+            const l2_col_lcid_summary_t *s = &sum[l];
+            if (!s->data_pdus[d] && !s->status_pdus[!d]) continue;
+            // Data sent in d is NACKed by STATUS PDUs travelling the other way
+            printf("  LCID %2d %s: %10llu data PDU(s) %10llu bytes, %8llu STATUS, %8llu NACKed SN(s), "
+                   "rate %.3f%%\n", l, dir_name[d], (unsigned long long)s->data_pdus[d],
+                   (unsigned long long)s->data_bytes[d], (unsigned long long)s->status_pdus[!d],
+                   (unsigned long long)s->nacked_sns[!d],
+                   s->data_pdus[d] ? 100.0 * (double)s->nacked_sns[!d] / (double)s->data_pdus[d] : 0.0);
+        }
+    }
+    print_scan_stats(&st, ns);
+    return 0;
+}
+
+typedef struct scan_print {
+    uint64_t ts0;
+    uint64_t left;
+} scan_print_t;
+
+static int scan_print_fn(const l2_col_batch_t *b, void *arg) {
+    scan_print_t *sp = arg;
+    for (uint32_t i = 0; i < b->n && sp->left; i++, sp->left--) {
+        uint64_t flags = b->v[L2_COL_FLAGS][i];
+        printf("  %12.6f 0x%04x %2llu %s %5llu ", (double)(b->v[L2_COL_TS][i] - sp->ts0) / 1e9,
+               b->rnti, (unsigned long long)b->v[L2_COL_LCID][i],
+               b->v[L2_COL_DIR][i] == MAC_DIR_UL ? "UL" : "DL",
+               (unsigned long long)b->v[L2_COL_LEN][i]);
+        if (flags & L2_ROW_STATUS) {
+            printf("STATUS ack_sn %llu nacks %llu\n", (unsigned long long)b->v[L2_COL_ACK_SN][i],
+                   (unsigned long long)b->v[L2_COL_NACKS][i]);
+            continue;
+        }
+        printf("sn %-7llu si %llu so %-5llu", (unsigned long long)b->v[L2_COL_SN][i],
+               (unsigned long long)b->v[L2_COL_SI][i], (unsigned long long)b->v[L2_COL_SO][i]);
+        if (flags & L2_ROW_PDCP) printf(" pdcp_sn %llu", (unsigned long long)b->v[L2_COL_PDCP_SN][i]);
+        if (flags & L2_ROW_PDCP_CONTROL) printf(" pdcp control");
+        if (flags & L2_ROW_SDAP) printf(" qfi %llu", (unsigned long long)b->v[L2_COL_QFI][i]);
+        printf("%s\n", (flags & L2_ROW_POLL) ? " poll" : "");
+    }
+    return sp->left == 0;
+}
+
+static int cmd_scan(const l2_col_reader_t *r, int rnti, int lcid, uint64_t ts_min, uint64_t ts_max,
+                    uint64_t rows) {
+    l2_col_query_t q = {
+        .ts_min = ts_min,
+        .ts_max = ts_max,
+        .rnti = rnti,
+        .lcid_mask = lcid >= 0 ? 1ull << (lcid & 63) : 0,
+        .cols = ~0u >> (32 - L2_COL_COUNT),
+    };
+    scan_print_t sp = { .ts0 = r->hdr->ts_min, .left = rows };
+    l2_col_scan_stats_t st;
+
+    printf("=== L2 Column Store Scan ===\n");
+    uint64_t t0 = tool_now_ns();
+    l2_col_scan(r, &q, scan_print_fn, &sp, &st);
+    print_scan_stats(&st, tool_now_ns() - t0);
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Main
+ *--------------------------------------------------------------------------*/
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s ingest <capture.pcap> <store> [-r am18|am12|um12|um6] [-q 12|18] [-s]\n"
+                    "       %s info <store>\n"
+                    "       %s nack <store> -u rnti [-t from_ms to_ms]\n"
+                    "       %s scan <store> [-u rnti] [-l lcid] [-t from_ms to_ms] [-n rows]\n",
+            prog, prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *cmd = argv[1];
+
+    if (!strcmp(cmd, "ingest")) {
+        ingest_cfg_t cfg = {
+            .srb = rlc_entity_ops_get(RLC_MODE_AM, 12),
+            .drb = rlc_entity_ops_get(RLC_MODE_AM, 18),
+            .pdcp_sn_bits = 18,
+        };
+        if (argc < 4) {
+            usage(argv[0]);
+            return 1;
+        }
+        for (int i = 4; i < argc; i++) {
+            if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+                const char *m = argv[++i];
+                int am = !strncmp(m, "am", 2), um = !strncmp(m, "um", 2);
+                cfg.drb = rlc_entity_ops_get(um ? RLC_MODE_UM : RLC_MODE_AM, (uint8_t)atoi(m + 2));
+                if ((!am && !um) || !cfg.drb) {
+                    fprintf(stderr, " %s is not a supported RLC configuration.\n", m);
+                    return 1;
+                }
+            }
+            else if (!strcmp(argv[i], "-q") && i + 1 < argc) cfg.pdcp_sn_bits = atoi(argv[++i]) == 12 ? 12 : 18;
+            else if (!strcmp(argv[i], "-s")) cfg.sdap = 1;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        return cmd_ingest(argv[2], argv[3], &cfg);
+    }
+
+    int rnti = -1, lcid = -1;
+    uint64_t from_ms = 0, to_ms = UINT64_MAX, rows = 20;
+    for (int i = 3; i < argc; i++) {
+        if (!strcmp(argv[i], "-u") && i + 1 < argc) rnti = (int)strtol(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc) lcid = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) rows = strtoull(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-t") && i + 2 < argc) {
+            from_ms = strtoull(argv[++i], NULL, 0);
+            to_ms = strtoull(argv[++i], NULL, 0);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    l2_col_reader_t r;
+    if (l2_col_reader_open(&r, argv[2]) < 0) return 1;
+
+    // Time bounds are milliseconds from the start of the store
+    uint64_t ts_min = r.hdr->ts_min + from_ms * 1000000ull;
+    uint64_t ts_max = to_ms == UINT64_MAX ? UINT64_MAX : r.hdr->ts_min + to_ms * 1000000ull;
+
+    int ret;
+    if (!strcmp(cmd, "info")) ret = cmd_info(&r);
+    else if (!strcmp(cmd, "nack")) ret = cmd_nack(&r, rnti, ts_min, ts_max);
+    else if (!strcmp(cmd, "scan")) ret = cmd_scan(&r, rnti, lcid, ts_min, ts_max, rows);
+    else {
+        usage(argv[0]);
+        ret = 1;
+    }
+    l2_col_reader_close(&r);
+    return ret;
+}
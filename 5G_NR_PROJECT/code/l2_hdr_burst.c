@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define L2_HDR_X86 1
+#endif
+
+#include "l2_hdr_burst.h"
+
+/**
+ * Per-format extraction parameters, applied to the first four header
+ * octets as one big-endian word W:
+ *
+ *   field = (W >> shift) & mask            dc, p, si, sn
+ *   so    = (W << so_lshift) >> 16         | octet 4 when so_b4
+ *
+ * sn_mask_si0 replaces sn_mask when SI = 00 (0 for UMD, which has no SN
+ * then). hdr_len is len_si0 / len_sn / len_so for SI = 00 / 01 / 1x.
+ *
+ * Validation: rsv / rsv_si0 are the R bits of a data PDU header with
+ * SI != 00 / SI = 00. Formats with a D/C bit may carry control PDUs
+ * (dc = 0): their 3-bit PDU type (W >> 28) must not exceed cpt_max and
+ * they must be at least ctrl_min[type] bytes (PDCP Status Report 5,
+ * ROHC / EHC feedback 2, RLC STATUS 3). UM has no D/C bit; dc_data = 1
+ * makes every UM PDU a data PDU. ctrl_min is 16 bytes so the SIMD
+ * kernels can look it up with one byte shuffle.
+ */
+typedef struct l2_hdr_layout {
+    uint32_t dc_shift, dc_mask;
+    uint32_t p_shift, p_mask;
+    uint32_t si_shift, si_mask;
+    uint32_t sn_shift, sn_mask, sn_mask_si0;
+    uint32_t so_lshift, so_b4;
+    uint32_t len_si0, len_sn, len_so;
+    uint32_t rsv, rsv_si0;
+    uint32_t dc_data, cpt_max;
+    uint8_t  ctrl_min[16];
+} l2_hdr_layout_t;
+
+static const l2_hdr_layout_t l2_hdr_layouts[L2_HDR_FMT_COUNT] = {
+    [L2_HDR_PDCP_SN12]   = { 31, 1, 0, 0, 0, 0, 16, 0xFFF, 0xFFF, 0, 0, 2, 2, 2,
+                             0x70000000, 0x70000000, 0, 2, { 5, 2, 2 } },
+    [L2_HDR_PDCP_SN18]   = { 31, 1, 0, 0, 0, 0, 8, 0x3FFFF, 0x3FFFF, 0, 0, 3, 3, 3,
+                             0x7C000000, 0x7C000000, 0, 2, { 5, 2, 2 } },
+    [L2_HDR_RLC_UM_SN6]  = { 0, 0, 0, 0, 30, 3, 24, 0x3F, 0, 8, 0, 1, 1, 3,
+                             0, 0x3F000000, 1, 0, { 0 } },
+    [L2_HDR_RLC_UM_SN12] = { 0, 0, 0, 0, 30, 3, 16, 0xFFF, 0, 16, 0, 1, 2, 4,
+                             0x30000000, 0x3F000000, 1, 0, { 0 } },
+    [L2_HDR_RLC_AM_SN12] = { 31, 1, 30, 1, 28, 3, 16, 0xFFF, 0xFFF, 16, 0, 2, 2, 4,
+                             0, 0, 0, 0, { 3 } },
+    [L2_HDR_RLC_AM_SN18] = { 31, 1, 30, 1, 28, 3, 8, 0x3FFFF, 0x3FFFF, 24, 1, 3, 3, 5,
+                             0x0C000000, 0x0C000000, 0, 0, { 3 } },
+};
+
+/*----------------------------------------------------------------------------
+ * Gather
+ *
+ * Copies the first four octets of every PDU (wire order) and, when the
+ * format needs it, the fifth. Short PDUs are zero filled; the length check
+ * in the kernels rejects them. Slots past n get length 0.
+ *--------------------------------------------------------------------------*/
+
+typedef struct l2_hdr_gather {
+    uint32_t w[L2_HDR_BURST];
+    uint16_t len[L2_HDR_BURST];
+    uint8_t  b4[L2_HDR_BURST];
+} l2_hdr_gather_t;
+
+static void l2_hdr_gather(const l2_hdr_layout_t *l, const uint8_t *const pdu[], const uint16_t len[],
+                          uint32_t n, l2_hdr_gather_t *g) {
+    for (uint32_t i = 0; i < n; i++) {
+        g->len[i] = len[i];
+        if (len[i] >= 4) {
+            memcpy(&g->w[i], pdu[i], 4);
+        } else {
+            g->w[i] = 0;
+            memcpy(&g->w[i], pdu[i], len[i]);
+        }
+        g->b4[i] = (l->so_b4 && len[i] >= 5) ? pdu[i][4] : 0;
+    }
+    for (uint32_t i = n; i < L2_HDR_BURST; i++) {
+        g->w[i] = 0;
+        g->len[i] = 0;
+        g->b4[i] = 0;
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Scalar kernel
+ *--------------------------------------------------------------------------*/
+
+static uint32_t l2_hdr_kernel_scalar(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g, l2_hdr_burst_t *out) {
+    uint32_t valid = 0;
+
+    for (int i = 0; i < L2_HDR_BURST; i++) {
+        const uint8_t *b = (const uint8_t *)&g->w[i];
+        uint32_t w = (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+        uint32_t si = (w >> l->si_shift) & l->si_mask;
+        uint32_t seg = si >= 2;
+
+        out->dc[i] = (uint8_t)((w >> l->dc_shift) & l->dc_mask);
+        out->p[i] = (uint8_t)((w >> l->p_shift) & l->p_mask);
+        out->si[i] = (uint8_t)si;
+        out->sn[i] = (w >> l->sn_shift) & (si ? l->sn_mask : l->sn_mask_si0);
+        out->so[i] = seg ? (uint16_t)(((w << l->so_lshift) >> 16) | g->b4[i]) : 0;
+        out->hdr_len[i] = (uint8_t)(seg ? l->len_so : si ? l->len_sn : l->len_si0);
+        valid |= (uint32_t)(out->hdr_len[i] <= g->len[i]) << i;
+    }
+    return valid;
+}
+
+/**
+ * Validation, per PDU (W = first four octets, big endian):
+ *
+ *   control PDU (D/C = 0):  PDU type <= cpt_max, len >= ctrl_min[type]
+ *   data PDU:               R bits clear, at least one payload byte,
+ *                           segments (SI = 1x) with SO > 0 and
+ *                           SO + payload within the 16-bit SO range
+ */
+static uint32_t l2_hdr_validate_scalar(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g) {
+    uint32_t ok = 0;
+
+    for (int i = 0; i < L2_HDR_BURST; i++) {
+        const uint8_t *b = (const uint8_t *)&g->w[i];
+        uint32_t w = (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+        uint32_t si = (w >> l->si_shift) & l->si_mask;
+        uint32_t len = g->len[i], good;
+
+        if (!(((w >> l->dc_shift) & l->dc_mask) | l->dc_data)) {
+            uint32_t type = w >> 28;
+            good = type <= l->cpt_max && len >= l->ctrl_min[type];
+        } else {
+            uint32_t hl = si >= 2 ? l->len_so : si ? l->len_sn : l->len_si0;
+            uint32_t so = ((w << l->so_lshift) >> 16) | g->b4[i];
+            good = !(w & (si ? l->rsv : l->rsv_si0)) && len > hl &&
+                   (si < 2 || (so && so + len - hl <= 0xFFFF));
+        }
+        ok |= good << i;
+    }
+    return ok;
+}
+
+#ifdef L2_HDR_X86
+
+/*----------------------------------------------------------------------------
+ * SSE4.1 kernel: 4 headers per step
+ *--------------------------------------------------------------------------*/
+
+__attribute__((target("sse4.1")))
+static uint32_t l2_hdr_kernel_sse41(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g, l2_hdr_burst_t *out) {
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i one = _mm_set1_epi32(1), zero = _mm_setzero_si128();
+    const __m128i dc_mask = _mm_set1_epi32((int)l->dc_mask), p_mask = _mm_set1_epi32((int)l->p_mask);
+    const __m128i si_mask = _mm_set1_epi32((int)l->si_mask);
+    const __m128i sn_mask = _mm_set1_epi32((int)l->sn_mask), sn_mask0 = _mm_set1_epi32((int)l->sn_mask_si0);
+    const __m128i len_si0 = _mm_set1_epi32((int)l->len_si0), len_sn = _mm_set1_epi32((int)l->len_sn);
+    const __m128i len_so = _mm_set1_epi32((int)l->len_so);
+    const __m128i dc_cnt = _mm_cvtsi32_si128((int)l->dc_shift), p_cnt = _mm_cvtsi32_si128((int)l->p_shift);
+    const __m128i si_cnt = _mm_cvtsi32_si128((int)l->si_shift), sn_cnt = _mm_cvtsi32_si128((int)l->sn_shift);
+    const __m128i so_cnt = _mm_cvtsi32_si128((int)l->so_lshift);
+    __m128i dc[8], p[8], si[8], hl[8], so[8];
+    uint32_t valid = 0;
+
+    for (int v = 0; v < 8; v++) {
+        __m128i w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(g->w + 4 * v)), bswap);
+        __m128i s = _mm_and_si128(_mm_srl_epi32(w, si_cnt), si_mask);
+        __m128i seg = _mm_cmpgt_epi32(s, one);
+        __m128i si0 = _mm_cmpeq_epi32(s, zero);
+
+        dc[v] = _mm_and_si128(_mm_srl_epi32(w, dc_cnt), dc_mask);
+        p[v] = _mm_and_si128(_mm_srl_epi32(w, p_cnt), p_mask);
+        si[v] = s;
+        _mm_storeu_si128((__m128i *)(out->sn + 4 * v),
+                         _mm_and_si128(_mm_srl_epi32(w, sn_cnt), _mm_blendv_epi8(sn_mask, sn_mask0, si0)));
+
+        uint32_t b4;
+        memcpy(&b4, g->b4 + 4 * v, 4);
+        __m128i o = _mm_srli_epi32(_mm_sll_epi32(w, so_cnt), 16);
+        o = _mm_or_si128(o, _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)b4)));
+        so[v] = _mm_and_si128(o, seg);
+
+        hl[v] = _mm_blendv_epi8(_mm_blendv_epi8(len_sn, len_si0, si0), len_so, seg);
+        __m128i len = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(g->len + 4 * v)));
+        uint32_t bad = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(hl[v], len)));
+        valid |= (~bad & 0xFu) << (4 * v);
+    }
+
+    for (int v = 0; v < 8; v += 2)
+        _mm_storeu_si128((__m128i *)(out->so + 4 * v), _mm_packus_epi32(so[v], so[v + 1]));
+
+    // 32 -> 16 -> 8 bit packs keep element order on 128-bit vectors
+#define L2_HDR_PACK8_SSE(dst, src)                                                          \
+    for (int v = 0; v < 8; v += 4)                                                          \
+        _mm_storeu_si128((__m128i *)((dst) + 4 * v),                                        \
+                         _mm_packus_epi16(_mm_packus_epi32((src)[v], (src)[v + 1]),         \
+                                          _mm_packus_epi32((src)[v + 2], (src)[v + 3])))
+    L2_HDR_PACK8_SSE(out->dc, dc);
+    L2_HDR_PACK8_SSE(out->p, p);
+    L2_HDR_PACK8_SSE(out->si, si);
+    L2_HDR_PACK8_SSE(out->hdr_len, hl);
+#undef L2_HDR_PACK8_SSE
+
+    return valid;
+}
+
+__attribute__((target("sse4.1")))
+static uint32_t l2_hdr_validate_sse41(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g) {
+    const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i one = _mm_set1_epi32(1), zero = _mm_setzero_si128(), so_max = _mm_set1_epi32(0xFFFF);
+    const __m128i dc_mask = _mm_set1_epi32((int)l->dc_mask), dc_data = _mm_set1_epi32((int)l->dc_data);
+    const __m128i si_mask = _mm_set1_epi32((int)l->si_mask);
+    const __m128i rsv = _mm_set1_epi32((int)l->rsv), rsv0 = _mm_set1_epi32((int)l->rsv_si0);
+    const __m128i len_si0 = _mm_set1_epi32((int)l->len_si0), len_sn = _mm_set1_epi32((int)l->len_sn);
+    const __m128i len_so = _mm_set1_epi32((int)l->len_so);
+    const __m128i cpt_max = _mm_set1_epi32((int)l->cpt_max);
+    const __m128i ctrl_min = _mm_loadu_si128((const __m128i *)l->ctrl_min);
+    const __m128i lane_hi = _mm_set1_epi32((int)0x80808000);   // Shuffle index 0x80 zeroes the byte
+    const __m128i dc_cnt = _mm_cvtsi32_si128((int)l->dc_shift), si_cnt = _mm_cvtsi32_si128((int)l->si_shift);
+    const __m128i so_cnt = _mm_cvtsi32_si128((int)l->so_lshift);
+    uint32_t ok = 0;
+
+    for (int v = 0; v < 8; v++) {
+        __m128i w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(g->w + 4 * v)), bswap);
+        __m128i len = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(g->len + 4 * v)));
+        __m128i s = _mm_and_si128(_mm_srl_epi32(w, si_cnt), si_mask);
+        __m128i seg = _mm_cmpgt_epi32(s, one);
+        __m128i si0 = _mm_cmpeq_epi32(s, zero);
+        __m128i ctrl = _mm_cmpeq_epi32(_mm_or_si128(_mm_and_si128(_mm_srl_epi32(w, dc_cnt), dc_mask), dc_data), zero);
+
+        // Data PDU: any of these lanes set rejects it
+        __m128i hl = _mm_blendv_epi8(_mm_blendv_epi8(len_sn, len_si0, si0), len_so, seg);
+        __m128i bad = _mm_cmpeq_epi32(_mm_cmpeq_epi32(_mm_and_si128(w, _mm_blendv_epi8(rsv, rsv0, si0)), zero), zero);
+        bad = _mm_or_si128(bad, _mm_cmpgt_epi32(_mm_add_epi32(hl, one), len));
+        uint32_t b4;
+        memcpy(&b4, g->b4 + 4 * v, 4);
+        __m128i so = _mm_or_si128(_mm_srli_epi32(_mm_sll_epi32(w, so_cnt), 16),
+                                  _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)b4)));
+        __m128i so_bad = _mm_or_si128(_mm_cmpeq_epi32(so, zero),
+                                      _mm_cmpgt_epi32(_mm_sub_epi32(_mm_add_epi32(so, len), hl), so_max));
+        bad = _mm_or_si128(bad, _mm_and_si128(seg, so_bad));
+
+        // Control PDU: minimum length looked up by PDU type
+        __m128i type = _mm_srli_epi32(w, 28);
+        __m128i min = _mm_shuffle_epi8(ctrl_min, _mm_or_si128(type, lane_hi));
+        __m128i cbad = _mm_or_si128(_mm_cmpgt_epi32(type, cpt_max), _mm_cmpgt_epi32(min, len));
+        bad = _mm_blendv_epi8(bad, cbad, ctrl);
+
+        ok |= (~(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(bad)) & 0xFu) << (4 * v);
+    }
+    return ok;
+}
+
+/*----------------------------------------------------------------------------
+ * AVX2 kernel: 8 headers per step
+ *--------------------------------------------------------------------------*/
+
+__attribute__((target("avx2")))
+static uint32_t l2_hdr_kernel_avx2(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g, l2_hdr_burst_t *out) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i one = _mm256_set1_epi32(1), zero = _mm256_setzero_si256();
+    const __m256i dc_mask = _mm256_set1_epi32((int)l->dc_mask), p_mask = _mm256_set1_epi32((int)l->p_mask);
+    const __m256i si_mask = _mm256_set1_epi32((int)l->si_mask);
+    const __m256i sn_mask = _mm256_set1_epi32((int)l->sn_mask);
+    const __m256i sn_mask0 = _mm256_set1_epi32((int)l->sn_mask_si0);
+    const __m256i len_si0 = _mm256_set1_epi32((int)l->len_si0), len_sn = _mm256_set1_epi32((int)l->len_sn);
+    const __m256i len_so = _mm256_set1_epi32((int)l->len_so);
+    const __m128i dc_cnt = _mm_cvtsi32_si128((int)l->dc_shift), p_cnt = _mm_cvtsi32_si128((int)l->p_shift);
+    const __m128i si_cnt = _mm_cvtsi32_si128((int)l->si_shift), sn_cnt = _mm_cvtsi32_si128((int)l->sn_shift);
+    const __m128i so_cnt = _mm_cvtsi32_si128((int)l->so_lshift);
+    __m256i dc[4], p[4], si[4], hl[4], so[4];
+    uint32_t valid = 0;
+
+    for (int v = 0; v < 4; v++) {
+        __m256i w = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(g->w + 8 * v)), bswap);
+        __m256i s = _mm256_and_si256(_mm256_srl_epi32(w, si_cnt), si_mask);
+        __m256i seg = _mm256_cmpgt_epi32(s, one);
+        __m256i si0 = _mm256_cmpeq_epi32(s, zero);
+
+        dc[v] = _mm256_and_si256(_mm256_srl_epi32(w, dc_cnt), dc_mask);
+        p[v] = _mm256_and_si256(_mm256_srl_epi32(w, p_cnt), p_mask);
+        si[v] = s;
+        _mm256_storeu_si256((__m256i *)(out->sn + 8 * v),
+                            _mm256_and_si256(_mm256_srl_epi32(w, sn_cnt),
+                                             _mm256_blendv_epi8(sn_mask, sn_mask0, si0)));
+
+        __m256i o = _mm256_srli_epi32(_mm256_sll_epi32(w, so_cnt), 16);
+        o = _mm256_or_si256(o, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(g->b4 + 8 * v))));
+        so[v] = _mm256_and_si256(o, seg);
+
+        hl[v] = _mm256_blendv_epi8(_mm256_blendv_epi8(len_sn, len_si0, si0), len_so, seg);
+        __m256i len = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(g->len + 8 * v)));
+        uint32_t bad = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(hl[v], len)));
+        valid |= (~bad & 0xFFu) << (8 * v);
+    }
+
+    // AVX2 packs work per 128-bit lane; permutes restore element order
+    for (int v = 0; v < 4; v += 2)
+        _mm256_storeu_si256((__m256i *)(out->so + 8 * v),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi32(so[v], so[v + 1]), 0xD8));
+
+    const __m256i order8 = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+#define L2_HDR_PACK8_AVX2(dst, src)                                                          \
+    _mm256_storeu_si256((__m256i *)(dst),                                                    \
+                        _mm256_permutevar8x32_epi32(                                         \
+                            _mm256_packus_epi16(_mm256_packus_epi32((src)[0], (src)[1]),     \
+                                                _mm256_packus_epi32((src)[2], (src)[3])),    \
+                            order8))
+    L2_HDR_PACK8_AVX2(out->dc, dc);
+    L2_HDR_PACK8_AVX2(out->p, p);
+    L2_HDR_PACK8_AVX2(out->si, si);
+    L2_HDR_PACK8_AVX2(out->hdr_len, hl);
+#undef L2_HDR_PACK8_AVX2
+
+    return valid;
+}
+
+__attribute__((target("avx2")))
+static uint32_t l2_hdr_validate_avx2(const l2_hdr_layout_t *l, const l2_hdr_gather_t *g) {
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i one = _mm256_set1_epi32(1), zero = _mm256_setzero_si256(), so_max = _mm256_set1_epi32(0xFFFF);
+    const __m256i dc_mask = _mm256_set1_epi32((int)l->dc_mask), dc_data = _mm256_set1_epi32((int)l->dc_data);
+    const __m256i si_mask = _mm256_set1_epi32((int)l->si_mask);
+    const __m256i rsv = _mm256_set1_epi32((int)l->rsv), rsv0 = _mm256_set1_epi32((int)l->rsv_si0);
+    const __m256i len_si0 = _mm256_set1_epi32((int)l->len_si0), len_sn = _mm256_set1_epi32((int)l->len_sn);
+    const __m256i len_so = _mm256_set1_epi32((int)l->len_so);
+    const __m256i cpt_max = _mm256_set1_epi32((int)l->cpt_max);
+    const __m256i ctrl_min = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)l->ctrl_min));
+    const __m256i lane_hi = _mm256_set1_epi32((int)0x80808000);
+    const __m128i dc_cnt = _mm_cvtsi32_si128((int)l->dc_shift), si_cnt = _mm_cvtsi32_si128((int)l->si_shift);
+    const __m128i so_cnt = _mm_cvtsi32_si128((int)l->so_lshift);
+    uint32_t ok = 0;
+
+    for (int v = 0; v < 4; v++) {
+        __m256i w = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(g->w + 8 * v)), bswap);
+        __m256i len = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(g->len + 8 * v)));
+        __m256i s = _mm256_and_si256(_mm256_srl_epi32(w, si_cnt), si_mask);
+        __m256i seg = _mm256_cmpgt_epi32(s, one);
+        __m256i si0 = _mm256_cmpeq_epi32(s, zero);
+        __m256i ctrl = _mm256_cmpeq_epi32(
+            _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(w, dc_cnt), dc_mask), dc_data), zero);
+
+        __m256i hl = _mm256_blendv_epi8(_mm256_blendv_epi8(len_sn, len_si0, si0), len_so, seg);
+        __m256i bad = _mm256_cmpeq_epi32(
+            _mm256_cmpeq_epi32(_mm256_and_si256(w, _mm256_blendv_epi8(rsv, rsv0, si0)), zero), zero);
+        bad = _mm256_or_si256(bad, _mm256_cmpgt_epi32(_mm256_add_epi32(hl, one), len));
+        __m256i so = _mm256_or_si256(_mm256_srli_epi32(_mm256_sll_epi32(w, so_cnt), 16),
+                                     _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(g->b4 + 8 * v))));
+        __m256i so_bad = _mm256_or_si256(_mm256_cmpeq_epi32(so, zero),
+                                         _mm256_cmpgt_epi32(_mm256_sub_epi32(_mm256_add_epi32(so, len), hl), so_max));
+        bad = _mm256_or_si256(bad, _mm256_and_si256(seg, so_bad));
+
+        __m256i type = _mm256_srli_epi32(w, 28);
+        __m256i min = _mm256_shuffle_epi8(ctrl_min, _mm256_or_si256(type, lane_hi));
+        __m256i cbad = _mm256_or_si256(_mm256_cmpgt_epi32(type, cpt_max), _mm256_cmpgt_epi32(min, len));
+        bad = _mm256_blendv_epi8(bad, cbad, ctrl);
+
+        ok |= (~(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(bad)) & 0xFFu) << (8 * v);
+    }
+    return ok;
+}
+
+#endif // L2_HDR_X86
+
+/*----------------------------------------------------------------------------
+ * Dispatch
+ *--------------------------------------------------------------------------*/
+
+typedef uint32_t (*l2_hdr_kernel_fn)(const l2_hdr_layout_t *, const l2_hdr_gather_t *, l2_hdr_burst_t *);
+typedef uint32_t (*l2_hdr_validate_fn)(const l2_hdr_layout_t *, const l2_hdr_gather_t *);
+
+static l2_hdr_kernel_fn l2_hdr_kernel = l2_hdr_kernel_scalar;
+static l2_hdr_validate_fn l2_hdr_validator = l2_hdr_validate_scalar;
+static const char *l2_hdr_kernel_name = "scalar";
+static pthread_once_t l2_hdr_once = PTHREAD_ONCE_INIT;
+
+static void l2_hdr_select(void) {
+#ifdef L2_HDR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        l2_hdr_kernel = l2_hdr_kernel_avx2;
+        l2_hdr_validator = l2_hdr_validate_avx2;
+        l2_hdr_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        l2_hdr_kernel = l2_hdr_kernel_sse41;
+        l2_hdr_validator = l2_hdr_validate_sse41;
+        l2_hdr_kernel_name = "sse4.1";
+    }
+#endif
+}
+
+const char *l2_hdr_burst_impl(void) {
+    pthread_once(&l2_hdr_once, l2_hdr_select);
+    return l2_hdr_kernel_name;
+}
+
+uint32_t l2_hdr_parse_burst(l2_hdr_fmt_t fmt, const uint8_t *const pdu[], const uint16_t len[],
+                            uint32_t n, l2_hdr_burst_t *out) {
+    if ((unsigned)fmt >= L2_HDR_FMT_COUNT || n > L2_HDR_BURST) return 0;
+    pthread_once(&l2_hdr_once, l2_hdr_select);
+
+    const l2_hdr_layout_t *l = &l2_hdr_layouts[fmt];
+    l2_hdr_gather_t g;
+    l2_hdr_gather(l, pdu, len, n, &g);
+
+    uint32_t valid = l2_hdr_kernel(l, &g, out);
+    return n == L2_HDR_BURST ? valid : valid & ((1u << n) - 1);
+}
+
+uint32_t l2_hdr_validate_burst(l2_hdr_fmt_t fmt, const uint8_t *const pdu[], const uint16_t len[], uint32_t n) {
+    if ((unsigned)fmt >= L2_HDR_FMT_COUNT || n > L2_HDR_BURST) return 0;
+    pthread_once(&l2_hdr_once, l2_hdr_select);
+
+    const l2_hdr_layout_t *l = &l2_hdr_layouts[fmt];
+    l2_hdr_gather_t g;
+    l2_hdr_gather(l, pdu, len, n, &g);
+
+    uint32_t ok = l2_hdr_validator(l, &g);
+    return n == L2_HDR_BURST ? ok : ok & ((1u << n) - 1);
+}
+
+/*----------------------------------------------------------------------------
+ * Self test
+ *
+ * Random bursts go through the scalar kernels and every SIMD kernel the
+ * CPU supports. Half of the first octets are masked towards valid
+ * headers and lengths cluster around the header sizes and the 16-bit SO
+ * limit, so both sides of every check are hit.
+ *--------------------------------------------------------------------------*/
+
+static uint32_t l2_hdr_rand(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return (uint32_t)(*s >> 32);
+}
+
+// Fields of the PDUs in mask must be identical
+static int l2_hdr_burst_same(const l2_hdr_burst_t *a, const l2_hdr_burst_t *b, uint32_t mask) {
+    for (int i = 0; i < L2_HDR_BURST; i++) {
+        if (!(mask >> i & 1)) continue;
+        if (a->sn[i] != b->sn[i] || a->so[i] != b->so[i] || a->dc[i] != b->dc[i] || a->p[i] != b->p[i] ||
+            a->si[i] != b->si[i] || a->hdr_len[i] != b->hdr_len[i])
+            return 0;
+    }
+    return 1;
+}
+
+int l2_hdr_burst_selftest(uint32_t iterations, uint64_t seed) {
+    struct {
+        const char *name;
+        l2_hdr_kernel_fn parse;
+        l2_hdr_validate_fn validate;
+    } k[2];
+    int nk = 0;
+
+#ifdef L2_HDR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        k[nk].name = "sse4.1";
+        k[nk].parse = l2_hdr_kernel_sse41;
+        k[nk++].validate = l2_hdr_validate_sse41;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        k[nk].name = "avx2";
+        k[nk].parse = l2_hdr_kernel_avx2;
+        k[nk++].validate = l2_hdr_validate_avx2;
+    }
+#endif
+
+    uint8_t buf[L2_HDR_BURST][8];
+    const uint8_t *pdu[L2_HDR_BURST];
+    uint16_t len[L2_HDR_BURST];
+    uint64_t s = seed ? seed : 1;
+
+    for (uint32_t it = 0; it < iterations; it++) {
+        l2_hdr_fmt_t fmt = (l2_hdr_fmt_t)(it % L2_HDR_FMT_COUNT);
+        uint32_t n = 1 + l2_hdr_rand(&s) % L2_HDR_BURST;
+
+        for (uint32_t i = 0; i < n; i++) {
+            for (int j = 0; j < 8; j++) buf[i][j] = (uint8_t)l2_hdr_rand(&s);
+            uint32_t r = l2_hdr_rand(&s);
+            if (r & 1) buf[i][0] &= 0x83;
+            len[i] = (r >> 1) & 3 ? (uint16_t)((r >> 3) % 8) : (uint16_t)(65535 - (r >> 3) % 8);
+            pdu[i] = buf[i];
+        }
+
+        const l2_hdr_layout_t *l = &l2_hdr_layouts[fmt];
+        l2_hdr_gather_t g;
+        l2_hdr_burst_t ref, out;
+        l2_hdr_gather(l, pdu, len, n, &g);
+        uint32_t valid = l2_hdr_kernel_scalar(l, &g, &ref);
+        uint32_t ok = l2_hdr_validate_scalar(l, &g);
+
+        for (int i = 0; i < nk; i++) {
+            uint32_t v = k[i].parse(l, &g, &out);
+            const char *what = v != valid || !l2_hdr_burst_same(&ref, &out, valid) ? "parse"
+                             : k[i].validate(l, &g) != ok ? "validate" : NULL;
+            if (what) {
+                fprintf(stderr, " l2_hdr_burst: %s %s kernel differs from scalar (format %d, iteration %u, seed %llu).\n",
+                        k[i].name, what, (int)fmt, it, (unsigned long long)seed);
+                return -1;
+            }
+        }
+    }
+    return nk;
+}
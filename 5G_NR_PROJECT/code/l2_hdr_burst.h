@@ -0,0 +1,102 @@
+// l2_hdr_burst.h
+#ifndef _L2_HDR_BURST_H_
+#define _L2_HDR_BURST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "5g_nr_pdu_structures.h"
+
+/*============================================================================
+ * BURST PDCP / RLC HEADER PARSER
+ * Reference: 3GPP TS 38.323 Section 6.2.2, TS 38.322 Section 6.2.2
+ *==========================================================================*/
+
+/**
+ * Burst header parser
+ *
+ * Description:
+ * Decodes the data PDU headers of up to L2_HDR_BURST PDUs of one bearer
+ * (same format) in one call. The first bytes of every PDU are gathered
+ * into a word array, then byte-swapped, shifted and masked in vector
+ * registers and written out struct-of-arrays, so the caller can walk one
+ * field across the whole burst.
+ *
+ * Kernels: AVX2 (8 headers per step), SSE4.1 (4 per step) and scalar.
+ * The best one the CPU supports is picked once at first use with
+ * __builtin_cpu_supports(); l2_hdr_burst_impl() reports which.
+ *
+ * Field layout per format (first header octets):
+ *
+ *   PDCP 12-bit SN:  | D/C | R R R | SN (4)  | SN (8) |
+ *   PDCP 18-bit SN:  | D/C | R R R R R | SN (2) | SN (8) | SN (8) |
+ *   RLC UM 6-bit:    | SI (2) | SN (6) | [SO (16)]
+ *   RLC UM 12-bit:   | SI (2) | R R | SN (4) | SN (8) | [SO (16)]
+ *   RLC AM 12-bit:   | D/C | P | SI (2) | SN (4) | SN (8) | [SO (16)]
+ *   RLC AM 18-bit:   | D/C | P | SI (2) | R R | SN (2) | SN (8) | SN (8) | [SO (16)]
+ *
+ * SO is present for SI = 10 (last) and 11 (middle segment). An UMD PDU
+ * with SI = 00 carries a whole SDU and has no SN (1 byte header), so sn
+ * is reported as 0. For AM, dc = 0 marks a STATUS PDU; only dc is
+ * meaningful then.
+ */
+#define L2_HDR_BURST  32
+
+typedef enum l2_hdr_fmt {
+    L2_HDR_PDCP_SN12,
+    L2_HDR_PDCP_SN18,
+    L2_HDR_RLC_UM_SN6,
+    L2_HDR_RLC_UM_SN12,
+    L2_HDR_RLC_AM_SN12,
+    L2_HDR_RLC_AM_SN18,
+    L2_HDR_FMT_COUNT
+} l2_hdr_fmt_t;
+
+// Parsed headers, index i = i-th PDU of the burst
+typedef struct l2_hdr_burst {
+    uint32_t sn[L2_HDR_BURST];
+    uint16_t so[L2_HDR_BURST];        // 0 when absent
+    uint8_t  dc[L2_HDR_BURST];        // 1 = data PDU (PDCP, RLC AM)
+    uint8_t  p[L2_HDR_BURST];         // Poll bit (RLC AM)
+    uint8_t  si[L2_HDR_BURST];        // Segmentation info (RLC)
+    uint8_t  hdr_len[L2_HDR_BURST];   // Header bytes, payload starts here
+} l2_hdr_burst_t;
+
+/**
+ * Parse n (<= L2_HDR_BURST) headers of format fmt.
+ *
+ * Returns a bitmask with bit i set when PDU i is at least hdr_len[i]
+ * bytes long. Fields of PDUs whose bit is clear are unspecified.
+ */
+uint32_t l2_hdr_parse_burst(l2_hdr_fmt_t fmt, const uint8_t *const pdu[], const uint16_t len[],
+                            uint32_t n, l2_hdr_burst_t *out);
+
+/**
+ * Fast-reject pass: check n (<= L2_HDR_BURST) PDUs of format fmt before
+ * any per-bearer state is looked at. Returns a bitmask with bit i set
+ * when PDU i passes:
+ *
+ * - data PDU: reserved bits clear, header complete with at least one
+ *   payload byte, and for SI = 10 / 11 segments SO > 0 and SO plus the
+ *   payload within the 16-bit SO range
+ * - control PDU (D/C = 0, PDCP and RLC AM): known PDU type (PDCP: status
+ *   report, ROHC / EHC feedback; RLC: STATUS) and that type's minimum
+ *   length (status report 5 bytes, feedback 2, STATUS 3)
+ *
+ * Uses the same kernels as l2_hdr_parse_burst() (one gather, then vector
+ * compares folded into the mask with movemask).
+ */
+uint32_t l2_hdr_validate_burst(l2_hdr_fmt_t fmt, const uint8_t *const pdu[], const uint16_t len[], uint32_t n);
+
+// Name of the kernel in use: "avx2", "sse4.1" or "scalar"
+const char *l2_hdr_burst_impl(void);
+
+/**
+ * Cross-check the kernels: iterations random bursts (all formats) are
+ * parsed and validated by the scalar kernels and by each SIMD kernel the
+ * CPU supports, and the results must agree. Returns the number of SIMD
+ * kernels checked, -1 on a mismatch (reported on stderr with the seed).
+ */
+int l2_hdr_burst_selftest(uint32_t iterations, uint64_t seed);
+
+#endif
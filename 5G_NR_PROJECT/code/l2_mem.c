@@ -0,0 +1,239 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "l2_mem.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define L2_MEM_MAP_HUGE_2MB  (21 << MAP_HUGE_SHIFT)
+#define L2_MEM_MAP_HUGE_1GB  (30 << MAP_HUGE_SHIFT)
+#define L2_MEM_2M            (2ull << 20)
+#define L2_MEM_1G            (1ull << 30)
+#define L2_MEM_MAX_NODES     64
+
+typedef struct l2_mem_rec {
+    void *addr;               // Mapping, also the pointer handed out
+    size_t map_len;
+    size_t size;
+    int8_t node_req;
+    uint8_t kind;
+    char label[L2_MEM_LABEL_LEN];
+} l2_mem_rec_t;
+
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+static l2_mem_rec_t mem_recs[L2_MEM_MAX_ALLOCS];
+
+static const char *const kind_names[L2_MEM_KIND_COUNT] = {
+    [L2_MEM_HUGE_1G] = "1G",
+    [L2_MEM_HUGE_2M] = "2M",
+    [L2_MEM_THP]     = "THP",
+    [L2_MEM_SMALL]   = "4K",
+};
+
+const char *l2_mem_kind_name(l2_mem_kind_t kind) {
+    return (unsigned)kind < L2_MEM_KIND_COUNT ? kind_names[kind] : "?";
+}
+
+/*----------------------------------------------------------------------------
+ * Topology
+ *--------------------------------------------------------------------------*/
+
+int l2_mem_cpu_node(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+
+    int node = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (!strncmp(de->d_name, "node", 4) && de->d_name[4] >= '0' && de->d_name[4] <= '9') {
+            node = atoi(de->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+int l2_mem_current_node(void) {
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) < 0) return 0;
+    return (int)node;
+}
+
+int l2_mem_node_of(const void *p) {
+    void *page = (void *)((uintptr_t)p & ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) < 0) return -1;
+    return status < 0 ? -1 : status;
+}
+
+/*----------------------------------------------------------------------------
+ * Allocation
+ *--------------------------------------------------------------------------*/
+
+static void *l2_mem_map_huge(size_t len, int flag) {
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flag, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+// Anonymous mapping of len bytes aligned to 2 MB so THP can back all of it
+static void *l2_mem_map_thp(size_t len, void **base, size_t *base_len) {
+    size_t map = len + L2_MEM_2M;
+    uint8_t *p = mmap(NULL, map, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)p + L2_MEM_2M - 1) & ~(uintptr_t)(L2_MEM_2M - 1));
+    if (aligned > p) munmap(p, (size_t)(aligned - p));
+    size_t tail = (size_t)(p + map - (aligned + len));
+    if (tail) munmap(aligned + len, tail);
+
+    *base = aligned;
+    *base_len = len;
+    return aligned;
+}
+
+static void l2_mem_bind(void *p, size_t len, int node) {
+    if (node < 0 || node >= L2_MEM_MAX_NODES) return;
+    unsigned long mask = 1UL << node;
+    // Best effort: without NUMA support the memory simply stays local
+    syscall(SYS_mbind, p, len, MPOL_PREFERRED, &mask, (unsigned long)L2_MEM_MAX_NODES + 1, 0);
+}
+
+static size_t round_up(size_t v, size_t a) {
+    return (v + a - 1) & ~(a - 1);
+}
+
+void *l2_mem_alloc(size_t size, int node, const char *label) {
+    if (!size) return NULL;
+    if (node == L2_MEM_NODE_LOCAL) node = l2_mem_current_node();
+
+    void *p = NULL;
+    size_t len = 0;
+    l2_mem_kind_t kind;
+
+    if (size >= L2_MEM_1G_MIN && (p = l2_mem_map_huge(len = round_up(size, L2_MEM_1G),
+                                                      L2_MEM_MAP_HUGE_1GB))) {
+        kind = L2_MEM_HUGE_1G;
+    } else if (size >= L2_MEM_2M_MIN && (p = l2_mem_map_huge(len = round_up(size, L2_MEM_2M),
+                                                             L2_MEM_MAP_HUGE_2MB))) {
+        kind = L2_MEM_HUGE_2M;
+    } else if (size >= L2_MEM_2M_MIN && l2_mem_map_thp(round_up(size, L2_MEM_2M), &p, &len)) {
+        madvise(p, len, MADV_HUGEPAGE);
+        kind = L2_MEM_THP;
+    } else {
+        len = round_up(size, (size_t)sysconf(_SC_PAGESIZE));
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return NULL;
+        kind = L2_MEM_SMALL;
+    }
+
+    // Bind before the first touch, then fault every page in on that node
+    l2_mem_bind(p, len, node);
+    size_t step = kind == L2_MEM_SMALL ? (size_t)sysconf(_SC_PAGESIZE) : L2_MEM_2M;
+    for (size_t off = 0; off < len; off += step) ((volatile uint8_t *)p)[off] = 0;
+
+    pthread_mutex_lock(&mem_lock);
+    l2_mem_rec_t *r = NULL;
+    for (int i = 0; i < L2_MEM_MAX_ALLOCS && !r; i++)
+        if (!mem_recs[i].addr) r = &mem_recs[i];
+    if (r) {
+        r->addr = p;
+        r->map_len = len;
+        r->size = size;
+        r->node_req = (int8_t)(node < 0 ? -1 : node);
+        r->kind = (uint8_t)kind;
+        snprintf(r->label, sizeof(r->label), "%s", label ? label : "");
+    }
+    pthread_mutex_unlock(&mem_lock);
+
+    if (!r) {
+        // Out of records: the mapping could never be freed, refuse it
+        munmap(p, len);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return p;
+}
+
+void *l2_mem_array(size_t n, size_t elem_size, int node, const char *label) {
+    if (elem_size && n > SIZE_MAX / elem_size) return NULL;
+    return l2_mem_alloc(n * elem_size, node, label);
+}
+
+void l2_mem_free(void *p) {
+    if (!p) return;
+    pthread_mutex_lock(&mem_lock);
+    for (int i = 0; i < L2_MEM_MAX_ALLOCS; i++) {
+        if (mem_recs[i].addr != p) continue;
+        munmap(mem_recs[i].addr, mem_recs[i].map_len);
+        memset(&mem_recs[i], 0, sizeof(mem_recs[i]));
+        break;
+    }
+    pthread_mutex_unlock(&mem_lock);
+}
+
+/*----------------------------------------------------------------------------
+ * Report
+ *--------------------------------------------------------------------------*/
+
+static long read_long(const char *path) {
+    FILE *f = fopen(path, "r");
+    long v = -1;
+    if (f) {
+        if (fscanf(f, "%ld", &v) != 1) v = -1;
+        fclose(f);
+    }
+    return v;
+}
+
+void l2_mem_report(FILE *out) {
+    char path[128];
+
+    fprintf(out, "=== L2 Memory Placement ===\n");
+    for (int n = 0; n < L2_MEM_MAX_NODES; n++) {
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%d/hugepages/hugepages-2048kB/free_hugepages", n);
+        long free2m = read_long(path);
+        if (free2m < 0) {
+            if (n == 0) fprintf(out, "  NUMA topology not exposed, single node assumed\n");
+            break;
+        }
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%d/hugepages/hugepages-1048576kB/free_hugepages", n);
+        long free1g = read_long(path);
+        fprintf(out, "  node %d: %ld free 2M page(s), %ld free 1G page(s)\n", n, free2m,
+                free1g < 0 ? 0 : free1g);
+    }
+
+    size_t bytes[L2_MEM_KIND_COUNT] = { 0 };
+    int off_node = 0;
+    pthread_mutex_lock(&mem_lock);
+    for (int i = 0; i < L2_MEM_MAX_ALLOCS; i++) {
+        const l2_mem_rec_t *r = &mem_recs[i];
+        if (!r->addr) continue;
+        int actual = l2_mem_node_of(r->addr);
+        if (r->node_req >= 0 && actual >= 0 && actual != r->node_req) off_node++;
+        bytes[r->kind] += r->map_len;
+        fprintf(out, "  %-24s %10zu bytes  %-3s  node %2d -> %2d\n", r->label, r->size,
+                kind_names[r->kind], r->node_req, actual);
+    }
+    pthread_mutex_unlock(&mem_lock);
+
+    fprintf(out, "  total: %zu MB 1G, %zu MB 2M, %zu MB THP, %zu KB 4K",
+            bytes[L2_MEM_HUGE_1G] >> 20, bytes[L2_MEM_HUGE_2M] >> 20, bytes[L2_MEM_THP] >> 20,
+            bytes[L2_MEM_SMALL] >> 10);
+    if (off_node) fprintf(out, ", %d allocation(s) off their node", off_node);
+    fprintf(out, "\n");
+}
@@ -0,0 +1,81 @@
+// l2_mem.h
+#ifndef _L2_MEM_H_
+#define _L2_MEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*============================================================================
+ * NUMA-LOCAL, HUGE-PAGE BACKED ALLOCATIONS
+ *==========================================================================*/
+
+/**
+ * Long-lived data path memory
+ *
+ * Description:
+ * Packet pools, UE / bearer context arrays and SN-indexed window arrays
+ * are allocated once at setup and then hit on every PDU. l2_mem_alloc()
+ * places them on the NUMA node of the worker that owns them and backs
+ * them with the largest page size that is available, so a worker neither
+ * crosses the socket interconnect nor burns TLB entries on them.
+ *
+ * Page size, tried in order:
+ *   1 GB hugetlb   allocations of at least L2_MEM_1G_MIN bytes
+ *   2 MB hugetlb   allocations of at least L2_MEM_2M_MIN bytes
+ *   THP            2 MB aligned anonymous memory with MADV_HUGEPAGE
+ *   4 KB           plain anonymous memory
+ * A missing or exhausted hugetlb pool just moves on to the next kind.
+ *
+ * Placement uses the raw mbind(2) syscall with MPOL_PREFERRED, so memory
+ * comes from the requested node while it has pages and from elsewhere
+ * when it does not, instead of failing. Pages are touched before return,
+ * so they are faulted in on the right node at setup rather than on the
+ * first packet. No libnuma dependency.
+ *
+ * Every live allocation is recorded with a label; l2_mem_report() prints
+ * the page kind and the node each one actually landed on.
+ */
+#define L2_MEM_NODE_LOCAL   (-1)          // Node of the calling thread
+#define L2_MEM_NODE_ANY     (-2)          // No placement
+#define L2_MEM_1G_MIN       (512ull << 20)
+#define L2_MEM_2M_MIN       (1ull << 20)
+#define L2_MEM_MAX_ALLOCS   256
+#define L2_MEM_LABEL_LEN    32
+
+typedef enum l2_mem_kind {
+    L2_MEM_HUGE_1G = 0,
+    L2_MEM_HUGE_2M,
+    L2_MEM_THP,
+    L2_MEM_SMALL,
+    L2_MEM_KIND_COUNT
+} l2_mem_kind_t;
+
+/**
+ * Allocate size zeroed bytes on node (>= 0, L2_MEM_NODE_LOCAL or
+ * L2_MEM_NODE_ANY). The result is at least 64-byte aligned.
+ * Returns NULL on failure.
+ */
+void *l2_mem_alloc(size_t size, int node, const char *label);
+
+// n elements of elem_size bytes, overflow checked
+void *l2_mem_array(size_t n, size_t elem_size, int node, const char *label);
+
+// Release memory from l2_mem_alloc(); NULL is ignored
+void l2_mem_free(void *p);
+
+// NUMA node of a CPU from sysfs, 0 on single-node systems or errors
+int l2_mem_cpu_node(int cpu);
+
+// Node of the CPU the calling thread runs on
+int l2_mem_current_node(void);
+
+// Node currently holding the page at p, -1 if unknown
+int l2_mem_node_of(const void *p);
+
+const char *l2_mem_kind_name(l2_mem_kind_t kind);
+
+// Live allocations and per-node free huge pages
+void l2_mem_report(FILE *out);
+
+#endif
@@ -0,0 +1,254 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "l2_pcap.h"
+
+/*----------------------------------------------------------------------------
+ * Reader
+ *--------------------------------------------------------------------------*/
+
+int l2_pcap_reader_open(l2_pcap_reader_t *r, const char *path) {
+    struct stat st;
+
+    memset(r, 0, sizeof(*r));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(l2_pcap_file_hdr_t)) {
+        fprintf(stderr, " %s is not a pcap file.\n", path);
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    const l2_pcap_file_hdr_t *fh = p;
+    if (fh->magic != L2_PCAP_MAGIC_US && fh->magic != L2_PCAP_MAGIC_NS) {
+        fprintf(stderr, " %s is not a pcap file in host byte order.\n", path);
+        munmap(p, (size_t)st.st_size);
+        return -1;
+    }
+    r->map = p;
+    r->size = (size_t)st.st_size;
+    r->linktype = fh->linktype;
+    r->frac_ns = fh->magic == L2_PCAP_MAGIC_NS ? 1 : 1000;
+    l2_pcap_reader_rewind(r);
+    return 0;
+}
+
+void l2_pcap_reader_close(l2_pcap_reader_t *r) {
+    if (r->map) munmap((void *)r->map, r->size);
+    memset(r, 0, sizeof(*r));
+}
+
+int l2_pcap_reader_next(l2_pcap_reader_t *r, uint64_t *ts_ns, const uint8_t **frame,
+                        uint32_t *caplen) {
+    l2_pcap_rec_hdr_t rh;
+
+    if (r->off + sizeof(rh) > r->size) return 0;
+    memcpy(&rh, r->map + r->off, sizeof(rh));
+    if (rh.incl_len > r->size - r->off - sizeof(rh)) return 0;
+
+    *ts_ns = (uint64_t)rh.ts_sec * 1000000000ull + (uint64_t)rh.ts_frac * r->frac_ns;
+    *frame = r->map + r->off + sizeof(rh);
+    *caplen = rh.incl_len;
+    r->off += sizeof(rh) + rh.incl_len;
+    return 1;
+}
+
+int l2_pcap_next_mac(l2_pcap_reader_t *r, uint64_t *ts_ns, mac_nr_info_t *info,
+                     const uint8_t **pdu, size_t *len, uint16_t *port, uint64_t *skipped) {
+    const uint8_t *frame;
+    uint32_t caplen;
+    size_t ulen;
+
+    while (l2_pcap_reader_next(r, ts_ns, &frame, &caplen)) {
+        int u = l2_pcap_udp_payload(r->linktype, frame, caplen, &ulen, port);
+        int p = u < 0 ? -1 : mac_nr_framing_parse(frame + u, ulen, info);
+        if (p < 0 || info->direction > MAC_NR_DIR_DL) {
+            if (skipped) (*skipped)++;
+            continue;
+        }
+        *pdu = frame + u + p;
+        *len = ulen - (size_t)p;
+        return 1;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Framing
+ *--------------------------------------------------------------------------*/
+
+int mac_nr_framing_parse(const uint8_t *udp, size_t len, mac_nr_info_t *info) {
+    if (len < MAC_NR_START_LEN + 4 || memcmp(udp, MAC_NR_START_STRING, MAC_NR_START_LEN)) return -1;
+
+    size_t p = MAC_NR_START_LEN;
+    memset(info, 0, sizeof(*info));
+    info->radio_type = udp[p++];
+    info->direction = udp[p++];
+    info->rnti_type = udp[p++];
+    info->harq_id = 0xFF;
+    info->sfn = 0xFFFF;
+
+    while (p < len) {
+        uint8_t tag = udp[p++];
+        switch (tag) {
+        case MAC_NR_PAYLOAD_TAG:
+            return (int)p;
+        case MAC_NR_RNTI_TAG:
+        case MAC_NR_UEID_TAG:
+            if (p + 2 > len) return -1;
+            if (tag == MAC_NR_RNTI_TAG)
+                info->rnti = (uint16_t)(udp[p] << 8 | udp[p + 1]);
+            else
+                info->ueid = (uint16_t)(udp[p] << 8 | udp[p + 1]);
+            p += 2;
+            break;
+        case MAC_NR_PHR_TYPE2_TAG:
+        case MAC_NR_HARQID_TAG:
+            if (p + 1 > len) return -1;
+            if (tag == MAC_NR_HARQID_TAG) info->harq_id = udp[p];
+            p += 1;
+            break;
+        case MAC_NR_FRAME_SLOT_TAG:
+            if (p + 4 > len) return -1;
+            info->sfn = (uint16_t)(udp[p] << 8 | udp[p + 1]);
+            info->slot = (uint16_t)(udp[p + 2] << 8 | udp[p + 3]);
+            p += 4;
+            break;
+        default:
+            return -1;   // Unknown tag: its length is unknown too
+        }
+    }
+    return -1;
+}
+
+int mac_nr_framing_write(uint8_t *buf, size_t size, const mac_nr_info_t *info) {
+    if (size < L2_PCAP_FRAMING_MAX) return -1;
+
+    uint8_t *p = buf;
+    memcpy(p, MAC_NR_START_STRING, MAC_NR_START_LEN);
+    p += MAC_NR_START_LEN;
+    *p++ = info->radio_type;
+    *p++ = info->direction;
+    *p++ = info->rnti_type;
+    *p++ = MAC_NR_RNTI_TAG;
+    *p++ = (uint8_t)(info->rnti >> 8);
+    *p++ = (uint8_t)info->rnti;
+    *p++ = MAC_NR_UEID_TAG;
+    *p++ = (uint8_t)(info->ueid >> 8);
+    *p++ = (uint8_t)info->ueid;
+    if (info->sfn != 0xFFFF) {
+        *p++ = MAC_NR_FRAME_SLOT_TAG;
+        *p++ = (uint8_t)(info->sfn >> 8);
+        *p++ = (uint8_t)info->sfn;
+        *p++ = (uint8_t)(info->slot >> 8);
+        *p++ = (uint8_t)info->slot;
+    }
+    if (info->harq_id != 0xFF) {
+        *p++ = MAC_NR_HARQID_TAG;
+        *p++ = info->harq_id;
+    }
+    *p++ = MAC_NR_PAYLOAD_TAG;
+    return (int)(p - buf);
+}
+
+int rlc_nr_framing_write(uint8_t *buf, size_t size, const rlc_nr_info_t *info) {
+    if (size < L2_PCAP_FRAMING_MAX) return -1;
+
+    uint8_t *p = buf;
+    memcpy(p, RLC_NR_START_STRING, RLC_NR_START_LEN);
+    p += RLC_NR_START_LEN;
+    *p++ = info->mode;
+    *p++ = info->sn_bits;
+    *p++ = RLC_NR_DIRECTION_TAG;
+    *p++ = info->direction;
+    *p++ = RLC_NR_UEID_TAG;
+    *p++ = (uint8_t)(info->ueid >> 8);
+    *p++ = (uint8_t)info->ueid;
+    *p++ = RLC_NR_BEARER_TYPE_TAG;
+    *p++ = info->bearer_type;
+    *p++ = RLC_NR_BEARER_ID_TAG;
+    *p++ = info->bearer_id;
+    *p++ = RLC_NR_PAYLOAD_TAG;
+    return (int)(p - buf);
+}
+
+int pdcp_nr_framing_write(uint8_t *buf, size_t size, const pdcp_nr_info_t *info) {
+    if (size < L2_PCAP_FRAMING_MAX) return -1;
+
+    uint8_t *p = buf;
+    memcpy(p, PDCP_NR_START_STRING, PDCP_NR_START_LEN);
+    p += PDCP_NR_START_LEN;
+    *p++ = info->plane;
+    *p++ = PDCP_NR_SEQNUM_LENGTH_TAG;
+    *p++ = info->sn_bits;
+    *p++ = PDCP_NR_DIRECTION_TAG;
+    *p++ = info->direction;
+    *p++ = PDCP_NR_BEARER_TYPE_TAG;
+    *p++ = info->bearer_type;
+    *p++ = PDCP_NR_BEARER_ID_TAG;
+    *p++ = info->bearer_id;
+    *p++ = PDCP_NR_UEID_TAG;
+    *p++ = (uint8_t)(info->ueid >> 8);
+    *p++ = (uint8_t)info->ueid;
+    if (info->maci_present) *p++ = PDCP_NR_MACI_PRESENT_TAG;
+    *p++ = PDCP_NR_PAYLOAD_TAG;
+    return (int)(p - buf);
+}
+
+int l2_pcap_udp_payload(uint32_t linktype, const uint8_t *frame, size_t caplen,
+                        size_t *len, uint16_t *dst_port) {
+    size_t off;
+
+    switch (linktype) {
+    case L2_PCAP_LINK_ETHERNET: {
+        if (caplen < 14) return -1;
+        uint16_t type = (uint16_t)(frame[12] << 8 | frame[13]);
+        off = 14;
+        while ((type == 0x8100 || type == 0x88A8) && off + 4 <= caplen) {
+            type = (uint16_t)(frame[off + 2] << 8 | frame[off + 3]);
+            off += 4;
+        }
+        if (type != 0x0800) return -1;
+        break;
+    }
+    case L2_PCAP_LINK_LINUX_SLL:
+        if (caplen < 16 || frame[14] != 0x08 || frame[15] != 0x00) return -1;
+        off = 16;
+        break;
+    case L2_PCAP_LINK_RAW:
+    case L2_PCAP_LINK_IPV4:
+        off = 0;
+        break;
+    default:
+        return -1;
+    }
+
+    // IPv4, UDP, not fragmented
+    if (off + 20 > caplen || frame[off] >> 4 != 4 || frame[off + 9] != 17) return -1;
+    if ((frame[off + 6] & 0x3F) || frame[off + 7]) return -1;
+    size_t ihl = (size_t)(frame[off] & 0x0F) * 4;
+    if (ihl < 20 || off + ihl + 8 > caplen) return -1;
+
+    const uint8_t *udp = frame + off + ihl;
+    size_t ulen = (size_t)(udp[4] << 8 | udp[5]);
+    if (ulen < 8) return -1;
+    if (off + ihl + ulen > caplen) ulen = caplen - off - ihl;   // Truncated capture
+
+    *dst_port = (uint16_t)(udp[2] << 8 | udp[3]);
+    *len = ulen - 8;
+    return (int)(off + ihl + 8);
+}
@@ -0,0 +1,208 @@
+// l2_pcap.h
+#ifndef _L2_PCAP_H_
+#define _L2_PCAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+ * PCAP FILES WITH WIRESHARK MAC-NR UDP FRAMING
+ *==========================================================================*/
+
+/**
+ * L2 captures
+ *
+ * Description:
+ * MAC PDUs are exchanged with Wireshark in its "mac-nr" UDP framing: an
+ * IPv4/UDP datagram whose payload starts with the ASCII string "mac-nr",
+ * three fixed context bytes and a list of tagged optional fields, ended
+ * by the payload tag after which the MAC PDU runs to the end:
+ *
+ * +----------+-------+-----+-----------+--------------------+------+-----+
+ * | "mac-nr" | radio | dir | rnti type | tag, value ...     | 0x01 | PDU |
+ * | 6 bytes  | 1     | 1   | 1         | (RNTI, UEID, slot) | 1    |     |
+ * +----------+-------+-----+-----------+--------------------+------+-----+
+ *
+ * RLC and PDCP PDUs use the same scheme with the "rlc-nr" / "pdcp-nr"
+ * start strings. Enable the mac_nr_udp / rlc_nr_udp / pdcp_nr_udp
+ * heuristics in Wireshark to dissect such files down to RRC.
+ *
+ * This header holds the on-disk pcap structures and the framing
+ * constants shared by the capture reader (replay) and writer.
+ */
+#define L2_PCAP_MAGIC_US       0xA1B2C3D4u
+#define L2_PCAP_MAGIC_NS       0xA1B23C4Du
+#define L2_PCAP_LINK_ETHERNET  1
+#define L2_PCAP_LINK_RAW       101
+#define L2_PCAP_LINK_LINUX_SLL 113
+#define L2_PCAP_LINK_IPV4      228
+
+#define MAC_NR_START_STRING    "mac-nr"
+#define MAC_NR_START_LEN       6
+
+// Fixed context fields
+#define MAC_NR_RADIO_FDD       1
+#define MAC_NR_RADIO_TDD       2
+#define MAC_NR_DIR_UL          0
+#define MAC_NR_DIR_DL          1
+#define MAC_NR_RNTI_NONE       0
+#define MAC_NR_RNTI_P          1
+#define MAC_NR_RNTI_RA         2
+#define MAC_NR_RNTI_C          3
+#define MAC_NR_RNTI_SI         4
+#define MAC_NR_RNTI_CS         5
+
+// Optional tags
+#define MAC_NR_PAYLOAD_TAG     0x01   // MAC PDU follows to the end
+#define MAC_NR_RNTI_TAG        0x02   // 2 bytes
+#define MAC_NR_UEID_TAG        0x03   // 2 bytes
+#define MAC_NR_PHR_TYPE2_TAG   0x05   // 1 byte
+#define MAC_NR_HARQID_TAG      0x06   // 1 byte
+#define MAC_NR_FRAME_SLOT_TAG  0x07   // SFN 2 bytes, slot 2 bytes
+
+/*--- rlc-nr: "rlc-nr", mode, SN length, tags, 0x01, RLC PDU ---*/
+#define RLC_NR_START_STRING    "rlc-nr"
+#define RLC_NR_START_LEN       6
+#define RLC_NR_MODE_TM         1
+#define RLC_NR_MODE_UM         2
+#define RLC_NR_MODE_AM         4
+#define RLC_NR_BEARER_CCCH     1
+#define RLC_NR_BEARER_BCCH_BCH 2
+#define RLC_NR_BEARER_PCCH     3
+#define RLC_NR_BEARER_SRB      4
+#define RLC_NR_BEARER_DRB      5
+#define RLC_NR_BEARER_BCCH_DL_SCH 6
+#define RLC_NR_PAYLOAD_TAG     0x01
+#define RLC_NR_DIRECTION_TAG   0x02   // 1 byte, MAC_NR_DIR_* values
+#define RLC_NR_UEID_TAG        0x03   // 2 bytes
+#define RLC_NR_BEARER_TYPE_TAG 0x04   // 1 byte
+#define RLC_NR_BEARER_ID_TAG   0x05   // 1 byte
+
+/*--- pdcp-nr: "pdcp-nr", plane, tags, 0x01, PDCP PDU ---*/
+#define PDCP_NR_START_STRING   "pdcp-nr"
+#define PDCP_NR_START_LEN      7
+#define PDCP_NR_PLANE_SIGNALING 1
+#define PDCP_NR_PLANE_USER     2
+#define PDCP_NR_BEARER_DCCH    1
+#define PDCP_NR_BEARER_BCCH_BCH 2
+#define PDCP_NR_BEARER_BCCH_DL_SCH 3
+#define PDCP_NR_BEARER_CCCH    4
+#define PDCP_NR_BEARER_PCCH    5
+#define PDCP_NR_PAYLOAD_TAG    0x01
+#define PDCP_NR_SEQNUM_LENGTH_TAG 0x02 // 1 byte, SN bits
+#define PDCP_NR_DIRECTION_TAG  0x03   // 1 byte, MAC_NR_DIR_* values
+#define PDCP_NR_BEARER_TYPE_TAG 0x04  // 1 byte
+#define PDCP_NR_BEARER_ID_TAG  0x05   // 1 byte
+#define PDCP_NR_UEID_TAG       0x06   // 2 bytes
+#define PDCP_NR_MACI_PRESENT_TAG 0x0F // no value
+
+// Longest framing any *_framing_write() produces
+#define L2_PCAP_FRAMING_MAX    32
+
+typedef struct l2_pcap_file_hdr {
+    uint32_t magic;
+    uint16_t version_major;    // 2
+    uint16_t version_minor;    // 4
+    int32_t  thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} l2_pcap_file_hdr_t;
+
+typedef struct l2_pcap_rec_hdr {
+    uint32_t ts_sec;
+    uint32_t ts_frac;          // us or ns depending on the file magic
+    uint32_t incl_len;
+    uint32_t orig_len;
+} l2_pcap_rec_hdr_t;
+
+// Context of one framed MAC PDU
+typedef struct mac_nr_info {
+    uint8_t  radio_type;
+    uint8_t  direction;        // MAC_NR_DIR_*
+    uint8_t  rnti_type;
+    uint8_t  harq_id;          // 0xFF if absent
+    uint16_t rnti;
+    uint16_t ueid;
+    uint16_t sfn;              // 0xFFFF if absent
+    uint16_t slot;
+} mac_nr_info_t;
+
+// Context of one RLC PDU
+typedef struct rlc_nr_info {
+    uint8_t  mode;             // RLC_NR_MODE_*
+    uint8_t  sn_bits;          // 0 (TM), 6, 12, 18
+    uint8_t  direction;        // MAC_NR_DIR_*
+    uint8_t  bearer_type;      // RLC_NR_BEARER_*
+    uint8_t  bearer_id;        // SRB / DRB identity
+    uint16_t ueid;
+} rlc_nr_info_t;
+
+/**
+ * Context of one PDCP PDU. RRC messages on SRBs are captured as
+ * signalling-plane PDUs; broadcast and CCCH RRC messages as signalling
+ * PDUs with sn_bits 0 on the matching PDCP_NR_BEARER_* type.
+ */
+typedef struct pdcp_nr_info {
+    uint8_t  plane;            // PDCP_NR_PLANE_*
+    uint8_t  sn_bits;          // 0, 12, 18
+    uint8_t  direction;        // MAC_NR_DIR_*
+    uint8_t  bearer_type;      // PDCP_NR_BEARER_*
+    uint8_t  bearer_id;
+    uint8_t  maci_present;
+    uint16_t ueid;
+} pdcp_nr_info_t;
+
+// Sequential reader over an mmapped pcap file
+typedef struct l2_pcap_reader {
+    const uint8_t *map;
+    size_t size;
+    size_t off;                // Next record header
+    uint32_t linktype;
+    uint32_t frac_ns;          // ns per timestamp fraction unit: 1 or 1000
+} l2_pcap_reader_t;
+
+// Map path and check its header. Returns 0, -1 with a message on stderr.
+int  l2_pcap_reader_open(l2_pcap_reader_t *r, const char *path);
+void l2_pcap_reader_close(l2_pcap_reader_t *r);
+
+static inline void l2_pcap_reader_rewind(l2_pcap_reader_t *r) {
+    r->off = sizeof(l2_pcap_file_hdr_t);
+}
+
+// Next record. Returns 1, 0 at the end (a truncated last record ends the file).
+int l2_pcap_reader_next(l2_pcap_reader_t *r, uint64_t *ts_ns, const uint8_t **frame,
+                        uint32_t *caplen);
+
+/**
+ * Next mac-nr framed MAC PDU, skipping (and counting in *skipped) frames
+ * that are not. *pdu points into the mapping. Returns 1, 0 at the end.
+ */
+int l2_pcap_next_mac(l2_pcap_reader_t *r, uint64_t *ts_ns, mac_nr_info_t *info,
+                     const uint8_t **pdu, size_t *len, uint16_t *port, uint64_t *skipped);
+
+/**
+ * Write the framing (start string through payload tag) for one PDU.
+ * Returns the bytes written, at most L2_PCAP_FRAMING_MAX, -1 if size is
+ * too small.
+ */
+int mac_nr_framing_write(uint8_t *buf, size_t size, const mac_nr_info_t *info);
+int rlc_nr_framing_write(uint8_t *buf, size_t size, const rlc_nr_info_t *info);
+int pdcp_nr_framing_write(uint8_t *buf, size_t size, const pdcp_nr_info_t *info);
+
+/**
+ * Parse the mac-nr framing of a UDP payload.
+ * Returns the offset of the MAC PDU in udp, -1 if it is not mac-nr framed
+ * or malformed.
+ */
+int mac_nr_framing_parse(const uint8_t *udp, size_t len, mac_nr_info_t *info);
+
+/**
+ * Locate the UDP payload of a link-layer frame (Ethernet with optional
+ * VLAN tags, Linux SLL or raw IPv4). Returns the payload offset and sets
+ * *len and *dst_port, -1 if the frame is not IPv4/UDP.
+ */
+int l2_pcap_udp_payload(uint32_t linktype, const uint8_t *frame, size_t caplen,
+                        size_t *len, uint16_t *dst_port);
+
+#endif
@@ -0,0 +1,36 @@
+#include <string.h>
+
+#include "l2_pool.h"
+#include "l2_mem.h"
+
+int l2_pool_init(l2_buf_pool_t *pool, uint32_t n_bufs, uint32_t buf_size) {
+    return l2_pool_init_node(pool, n_bufs, buf_size, L2_MEM_NODE_LOCAL);
+}
+
+int l2_pool_init_node(l2_buf_pool_t *pool, uint32_t n_bufs, uint32_t buf_size, int node) {
+    memset(pool, 0, sizeof(*pool));
+    if (!n_bufs || !buf_size) return -1;
+
+    // Cache-line sized buffers so two buffers never share a line
+    pool->buf_size = (buf_size + 63) & ~63u;
+    pool->n_bufs = n_bufs;
+    pool->mem = l2_mem_array(n_bufs, pool->buf_size, node, "l2_pool buffers");
+    pool->free_stack = l2_mem_array(n_bufs, sizeof(*pool->free_stack), node, "l2_pool free stack");
+    pool->refcnt = l2_mem_array(n_bufs, sizeof(*pool->refcnt), node, "l2_pool refcounts");
+    if (!pool->mem || !pool->free_stack || !pool->refcnt) {
+        l2_pool_destroy(pool);
+        return -1;
+    }
+
+    // Lowest indexes on top so a fresh pool hands out buffers in address order
+    for (uint32_t i = 0; i < n_bufs; i++) pool->free_stack[i] = n_bufs - 1 - i;
+    pool->free_top = n_bufs;
+    return 0;
+}
+
+void l2_pool_destroy(l2_buf_pool_t *pool) {
+    l2_mem_free(pool->mem);
+    l2_mem_free(pool->free_stack);
+    l2_mem_free(pool->refcnt);
+    memset(pool, 0, sizeof(*pool));
+}
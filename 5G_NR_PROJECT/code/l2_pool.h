@@ -0,0 +1,71 @@
+// l2_pool.h
+#ifndef _L2_POOL_H_
+#define _L2_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+ * PREALLOCATED PACKET BUFFER POOL
+ *==========================================================================*/
+
+/**
+ * Fixed-size, reference counted packet buffers
+ *
+ * Description:
+ * All buffers are carved out of one allocation at init time; alloc/free
+ * are a push/pop on an index stack, so nothing on the slot deadline path
+ * ever calls malloc. Buffers are handed around as 32-bit references
+ * (pool index) instead of pointers, which lets HARQ, RLC retransmission
+ * queues and capture hold the same MAC PDU without copying it: each holder
+ * takes a reference and the buffer returns to the pool when the last one
+ * is put.
+ *
+ * A pool is owned by one worker thread; it is not thread safe. Its memory
+ * comes from l2_mem: huge pages on the owning worker's NUMA node when
+ * available (l2_pool_init() uses the node of the calling thread).
+ */
+typedef uint32_t l2_buf_ref_t;
+
+#define L2_BUF_NONE UINT32_MAX
+
+typedef struct l2_buf_pool {
+    uint8_t *mem;              // n_bufs x buf_size bytes
+    uint32_t buf_size;         // Bytes per buffer (rounded to 64)
+    uint32_t n_bufs;
+    uint32_t *free_stack;      // Free buffer indexes
+    uint32_t free_top;         // Number of free buffers
+    uint16_t *refcnt;          // Per buffer reference count
+    uint64_t alloc_failures;
+} l2_buf_pool_t;
+
+int  l2_pool_init(l2_buf_pool_t *pool, uint32_t n_bufs, uint32_t buf_size);
+// node: NUMA node, or L2_MEM_NODE_LOCAL / L2_MEM_NODE_ANY (l2_mem.h)
+int  l2_pool_init_node(l2_buf_pool_t *pool, uint32_t n_bufs, uint32_t buf_size, int node);
+void l2_pool_destroy(l2_buf_pool_t *pool);
+
+// New buffer with one reference, L2_BUF_NONE when exhausted
+static inline l2_buf_ref_t l2_buf_alloc(l2_buf_pool_t *pool) {
+    if (!pool->free_top) {
+        pool->alloc_failures++;
+        return L2_BUF_NONE;
+    }
+    l2_buf_ref_t ref = pool->free_stack[--pool->free_top];
+    pool->refcnt[ref] = 1;
+    return ref;
+}
+
+static inline uint8_t *l2_buf_data(const l2_buf_pool_t *pool, l2_buf_ref_t ref) {
+    return pool->mem + (size_t)ref * pool->buf_size;
+}
+
+static inline void l2_buf_get(l2_buf_pool_t *pool, l2_buf_ref_t ref) {
+    pool->refcnt[ref]++;
+}
+
+// Drop one reference; the buffer goes back to the pool with the last one
+static inline void l2_buf_put(l2_buf_pool_t *pool, l2_buf_ref_t ref) {
+    if (--pool->refcnt[ref] == 0) pool->free_stack[pool->free_top++] = ref;
+}
+
+#endif
@@ -0,0 +1,781 @@
+/**
+ * L2 capture replay
+ *
+ * Replays recorded MAC transport blocks (pcap, Wireshark mac-nr UDP
+ * framing, see l2_pcap.h) and, when built with -DL2_REPLAY_RRC, frozen RRC
+ * messages from an rrc_history file, through the receive pipeline with
+ * the original timing:
+ *
+ *   MAC fast-reject and demux -> RLC fast-reject -> RLC rx_burst (per UE,
+ *   direction and LCID) -> PDCP header burst parse -> RRC decode (SRB1/2
+ *   DL-DCCH, SI-RNTI BCCH-DL-SCH)
+ *
+ * The fast-reject passes (mac_pdu_validate_burst, l2_hdr_validate_burst)
+ * run before the UE lookup, so malformed transport blocks and RLC PDUs
+ * are counted and dropped without creating or touching UE state.
+ *
+ * UEs are sharded over worker threads by a hash of (UDP port, UE id,
+ * RNTI) and virtual cell, so every UE's state lives on exactly one core
+ * and the workers share nothing but the start time. Each worker paces its own records:
+ * record i is due at start + (ts[i] - ts[0]) / speed. Lateness (how far
+ * past its due time a record was processed) goes into a per-worker HDR
+ * histogram; with -d, records later than the budget are dropped and
+ * counted instead of processed.
+ *
+ * -c N replays every record on N virtual cells (separate UE state per
+ * cell) to load the pipeline like N cells from a single-cell capture;
+ * -n loops the capture with fresh UE state on every pass. -x 0 removes
+ * the pacing, and the report's real-time factor then shows how many
+ * times faster than the air interface the workers keep up.
+ *
+ * -S publishes the counters live in an L2 statistics region (l2_stats.h),
+ * one block per worker, for l2_stats_export: MAC, RLC and PDCP PDUs and
+ * bytes, bytes per LCID, MAC PDU sizes, fast-reject failures and RRC
+ * decode errors. The region is left in place after the run for a final
+ * scrape; the next run replaces it.
+ *
+ * Build:
+ *   gcc -O2 -march=native -pthread -I../../5G l2_replay.c l2_pcap.c mac_ce.c \
+ *       rlc_entity.c l2_hdr_burst.c l2_mem.c l2_stats.c ../../5G/hdr_hist.c -o l2_replay
+ *   RRC decoding: add -DL2_REPLAY_RRC -I<asn1c output> ../../5G/rrc_decoder.c
+ *       ../../5G/rrc_freeze.c <asn1c objects>
+ *
+ * Usage:
+ *   ./l2_replay [-w workers] [-x speed] [-c cells] [-n loops] [-a first_cpu]
+ *               [-d drop_us] [-r am18|am12|um12|um6] [-q 12|18]
+ *               [-R rrc_history] [-S stats_name] [capture.pcap]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "l2_pcap.h"
+#include "mac_ce.h"
+#include "rlc_entity.h"
+#include "l2_hdr_burst.h"
+#include "l2_mem.h"
+#include "hdr_hist.h"
+#include "l2_stats.h"
+#ifdef L2_REPLAY_RRC
+#include "rrc_decoder.h"
+#include "rrc_freeze.h"
+#endif
+
+#define REPLAY_MAX_WORKERS   64
+#define REPLAY_MAX_SUBPDU    256
+#define REPLAY_UE_SLOTS      8192              // Per worker, power of two
+#define REPLAY_SPIN_NS       50000             // Busy-wait the last 50 us before a deadline
+#define REPLAY_LOOP_GAP_NS   1000000           // Gap between two passes over the capture
+#define REPLAY_START_DELAY   10000000          // Workers start 10 ms after setup
+#define REPLAY_PRECISION     7
+#define REPLAY_MAC_I_LEN     4                 // SRB PDCP PDUs end with MAC-I
+
+enum {
+    REPLAY_MAC = 0,
+    REPLAY_RRC = 1,
+};
+
+// One record, pointing into the mapped capture
+typedef struct replay_rec {
+    uint64_t ts_ns;            // Relative to the first record of its source
+    uint64_t key;              // UE key, shards the record
+    const uint8_t *data;       // MAC PDU or UPER bytes
+    uint32_t len;
+    uint8_t  kind;             // REPLAY_MAC / REPLAY_RRC
+    uint8_t  dir;              // mac_dir_t, rrc_channel_t for RRC records
+    uint8_t  rnti_type;        // MAC_NR_RNTI_*
+    uint8_t  rsv;
+} replay_rec_t;
+
+typedef struct replay_bearer {
+    rlc_entity_t rlc;
+    uint8_t pdcp_fmt;          // l2_hdr_fmt_t
+    uint8_t is_srb;
+} replay_bearer_t;
+
+typedef struct replay_ue {
+    uint64_t key;
+    uint8_t  used;
+    replay_bearer_t *rb[2][MAC_LCID_MAX_SDU + 1];   // [mac_dir_t][LCID]
+} replay_ue_t;
+
+typedef struct replay_stats {
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t dropped;          // Later than the drop budget
+    uint64_t malformed;        // MAC PDUs that failed the fast-reject pass
+    uint64_t tbs;
+    uint64_t subpdus;
+    uint64_t ces;
+    uint64_t ccch;
+    uint64_t broadcast;        // SI / P / RA-RNTI transport blocks
+    uint64_t rlc_pdus;
+    uint64_t rlc_rejected;     // RLC PDUs that failed the fast-reject pass
+    uint64_t rlc_accepted;
+    uint64_t segments;
+    uint64_t sdus;             // Complete SDUs handed to PDCP
+    uint64_t pdcp_data;
+    uint64_t pdcp_control;
+    uint64_t pdcp_short;
+    uint64_t rrc_ok;
+    uint64_t rrc_fail;
+    uint64_t ues;
+    uint64_t bearers;
+    uint64_t ue_full;          // Records lost to a full UE table
+} replay_stats_t;
+
+#define REPLAY_STAT_COUNT (sizeof(replay_stats_t) / sizeof(uint64_t))
+
+typedef struct replay_cfg {
+    double   speed;            // 0 = as fast as possible
+    uint32_t cells;
+    uint32_t loops;
+    uint64_t drop_ns;          // 0 = never drop
+    uint64_t period_ns;        // Capture span plus loop gap
+    rlc_mode_t drb_mode;
+    uint8_t  drb_sn_bits;
+    uint8_t  pdcp_fmt;
+    uint8_t  drb_rlc_fmt;      // l2_hdr_fmt_t of drb_mode / drb_sn_bits
+    uint64_t lcid_ok[2];       // mac_lcid_valid_mask(), [mac_dir_t]
+} replay_cfg_t;
+
+typedef struct replay_worker {
+    pthread_t thread;
+    int id;
+    int n_workers;
+    int cpu;                   // -1 if not pinned
+    const replay_cfg_t *cfg;
+    const uint64_t *start_ns;
+
+    replay_rec_t *recs;
+    size_t n_recs;
+    size_t cap_recs;
+
+    replay_ue_t *ues;          // REPLAY_UE_SLOTS entries
+    replay_stats_t st;
+    l2_stats_core_t *stats;    // Shared-memory block, NULL without -S
+    hdr_hist_t lateness;
+    uint64_t wall_ns;
+} replay_worker_t;
+
+static inline uint64_t replay_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t replay_mix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+// UE key of a record replayed on virtual cell c: a hash of (cell, key)
+static inline uint64_t replay_cell_key(uint64_t key, uint32_t c) {
+    return replay_mix(key ^ replay_mix((uint64_t)c + 0x9E3779B97F4A7C15ull));
+}
+
+/*----------------------------------------------------------------------------
+ * Per-worker UE state
+ *--------------------------------------------------------------------------*/
+
+static replay_ue_t *replay_ue_get(replay_worker_t *w, uint64_t key) {
+    uint32_t mask = REPLAY_UE_SLOTS - 1;
+    uint32_t i = (uint32_t)replay_mix(key) & mask;
+
+    for (uint32_t probe = 0; probe < REPLAY_UE_SLOTS; probe++, i = (i + 1) & mask) {
+        replay_ue_t *ue = &w->ues[i];
+        if (ue->used && ue->key == key) return ue;
+        if (!ue->used) {
+            ue->used = 1;
+            ue->key = key;
+            w->st.ues++;
+            return ue;
+        }
+    }
+    return NULL;
+}
+
+static replay_bearer_t *replay_bearer_get(replay_worker_t *w, replay_ue_t *ue, uint8_t dir,
+                                          uint8_t lcid) {
+    replay_bearer_t *b = ue->rb[dir][lcid];
+    if (b) return b;
+
+    // SRB1-3: RLC AM 12-bit, PDCP 12-bit; DRBs as configured
+    const replay_cfg_t *cfg = w->cfg;
+    int srb = lcid <= 3;
+    b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    if (rlc_entity_init(&b->rlc, srb ? RLC_MODE_AM : cfg->drb_mode, srb ? 12 : cfg->drb_sn_bits) < 0) {
+        free(b);
+        return NULL;
+    }
+    b->pdcp_fmt = srb ? L2_HDR_PDCP_SN12 : cfg->pdcp_fmt;
+    b->is_srb = (uint8_t)srb;
+    ue->rb[dir][lcid] = b;
+    w->st.bearers++;
+    return b;
+}
+
+// Drop all UE state, folding the RLC counters into the stats
+static void replay_ue_reset(replay_worker_t *w) {
+    for (uint32_t i = 0; i < REPLAY_UE_SLOTS; i++) {
+        replay_ue_t *ue = &w->ues[i];
+        if (!ue->used) continue;
+        for (int d = 0; d < 2; d++) {
+            for (int l = 0; l <= MAC_LCID_MAX_SDU; l++) {
+                replay_bearer_t *b = ue->rb[d][l];
+                if (!b) continue;
+                w->st.rlc_accepted += b->rlc.rx_accepted;
+                rlc_entity_destroy(&b->rlc);
+                free(b);
+            }
+        }
+        memset(ue, 0, sizeof(*ue));
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Pipeline
+ *--------------------------------------------------------------------------*/
+
+static inline l2_stats_dir_t replay_stats_dir(uint8_t dir) {
+    return dir == MAC_DIR_UL ? L2_STATS_UL : L2_STATS_DL;
+}
+
+static void replay_rrc_decode(replay_worker_t *w, int channel, const uint8_t *buf, size_t len) {
+#ifdef L2_REPLAY_RRC
+    void *msg = rrc_decode((rrc_channel_t)channel, buf, len);
+    if (msg) {
+        w->st.rrc_ok++;
+        ASN_STRUCT_FREE(*rrc_channel_descriptor((rrc_channel_t)channel), msg);
+    } else {
+        w->st.rrc_fail++;
+        // The message did not decode, so its type is unknown
+        if (w->stats) l2_stats_rrc_error(w->stats, (uint8_t)channel, 0);
+    }
+#else
+    (void)w; (void)channel; (void)buf; (void)len;
+#endif
+}
+
+static void replay_rlc_burst(replay_worker_t *w, replay_bearer_t *b, uint8_t dir,
+                             const uint8_t *const pdu[], const uint16_t len[], uint32_t n) {
+    rlc_pdu_info_t info[RLC_RX_BURST_MAX];
+    const uint8_t *sdu[RLC_RX_BURST_MAX];
+    uint16_t sdu_len[RLC_RX_BURST_MAX];
+    uint32_t m = 0;
+
+    uint32_t acc = b->rlc.ops->rx_burst(&b->rlc, pdu, len, n, info);
+    w->st.rlc_pdus += n;
+    for (; acc; acc &= acc - 1) {
+        uint32_t j = (uint32_t)__builtin_ctz(acc);
+        if (info[j].si != RLC_SI_COMPLETE) {
+            w->st.segments++;   // Reassembly is out of scope here
+            continue;
+        }
+        sdu[m] = pdu[j] + info[j].hdr_len;
+        sdu_len[m++] = (uint16_t)(len[j] - info[j].hdr_len);
+    }
+    if (!m) return;
+
+    l2_hdr_burst_t hb;
+    uint32_t ok = l2_hdr_parse_burst((l2_hdr_fmt_t)b->pdcp_fmt, sdu, sdu_len, m, &hb);
+    w->st.sdus += m;
+    w->st.pdcp_short += m - (uint32_t)__builtin_popcount(ok);
+    for (; ok; ok &= ok - 1) {
+        uint32_t j = (uint32_t)__builtin_ctz(ok);
+        // SRB headers have no D/C bit: every SRB PDU is data
+        if (!b->is_srb && !hb.dc[j]) {
+            w->st.pdcp_control++;
+            continue;
+        }
+        w->st.pdcp_data++;
+        if (w->stats) l2_stats_pdu(w->stats, L2_STATS_PDCP, replay_stats_dir(dir), sdu_len[j]);
+#ifdef L2_REPLAY_RRC
+        if (b->is_srb && dir == MAC_DIR_DL && sdu_len[j] > hb.hdr_len[j] + REPLAY_MAC_I_LEN)
+            replay_rrc_decode(w, RRC_CHANNEL_DL_DCCH, sdu[j] + hb.hdr_len[j],
+                              sdu_len[j] - hb.hdr_len[j] - REPLAY_MAC_I_LEN);
+#else
+        (void)dir;
+#endif
+    }
+}
+
+static void replay_mac(replay_worker_t *w, const replay_rec_t *r, uint64_t key) {
+    replay_stats_t *st = &w->st;
+
+    // Transparent MAC (BCCH / PCCH) and RAR carry no subheaders
+    if (r->rnti_type != MAC_NR_RNTI_C && r->rnti_type != MAC_NR_RNTI_CS) {
+        st->broadcast++;
+#ifdef L2_REPLAY_RRC
+        if (r->rnti_type == MAC_NR_RNTI_SI)
+            replay_rrc_decode(w, RRC_CHANNEL_BCCH_DL_SCH, r->data, r->len);
+#endif
+        return;
+    }
+
+    // Garbage is dropped here, before it can reach any UE or bearer state
+    const mac_dir_t dir = (mac_dir_t)r->dir;
+    const uint8_t *tb = r->data;
+    uint32_t tb_len = r->len;
+    mac_subpdu_t sub[REPLAY_MAX_SUBPDU];
+    int n = -1;
+    if (mac_pdu_validate_burst(&tb, &tb_len, 1, dir, w->cfg->lcid_ok[dir]))
+        n = mac_pdu_demux(r->data, r->len, dir, sub, REPLAY_MAX_SUBPDU);
+    if (n < 0) {
+        st->malformed++;
+        if (w->stats) l2_stats_inc(w->stats, L2_CTR_MAC_BAD_SUBHDR);
+        return;
+    }
+    st->tbs++;
+    st->subpdus += (uint64_t)n;
+    if (w->stats) {
+        l2_stats_pdu(w->stats, L2_STATS_MAC, replay_stats_dir(r->dir), r->len);
+        l2_stats_record(w->stats, L2_HIST_PDU_BYTES, r->len);
+    }
+
+    replay_ue_t *ue = NULL;
+    for (int i = 0; i < n;) {
+        uint8_t lcid = sub[i].lcid;
+        if (lcid == 0 || lcid > MAC_LCID_MAX_SDU) {
+            if (lcid == 0) st->ccch++; else st->ces++;
+            i++;
+            continue;
+        }
+
+        // Consecutive subPDUs of one logical channel form one RLC burst
+        const uint8_t *pdu[RLC_RX_BURST_MAX];
+        uint16_t len[RLC_RX_BURST_MAX];
+        uint32_t k = 0;
+        while (i < n && sub[i].lcid == lcid && k < RLC_RX_BURST_MAX) {
+            pdu[k] = r->data + sub[i].offset;
+            len[k++] = (uint16_t)sub[i].len;   // 16-bit L field
+            i++;
+        }
+
+        l2_hdr_fmt_t fmt = lcid <= 3 ? L2_HDR_RLC_AM_SN12 : (l2_hdr_fmt_t)w->cfg->drb_rlc_fmt;
+        uint32_t ok = l2_hdr_validate_burst(fmt, pdu, len, k), m = 0;
+        st->rlc_rejected += k - (uint32_t)__builtin_popcount(ok);
+        for (; ok; ok &= ok - 1) {
+            uint32_t j = (uint32_t)__builtin_ctz(ok);
+            pdu[m] = pdu[j];
+            len[m++] = len[j];
+        }
+        if (!m) continue;
+        if (w->stats) {
+            for (uint32_t j = 0; j < m; j++) {
+                l2_stats_pdu(w->stats, L2_STATS_RLC, replay_stats_dir(r->dir), len[j]);
+                l2_stats_lcid(w->stats, lcid, replay_stats_dir(r->dir), len[j]);
+            }
+        }
+
+        if (!ue && !(ue = replay_ue_get(w, key))) {
+            st->ue_full++;
+            return;
+        }
+        replay_bearer_t *b = replay_bearer_get(w, ue, r->dir, lcid);
+        if (b) replay_rlc_burst(w, b, r->dir, pdu, len, m);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * Workers
+ *--------------------------------------------------------------------------*/
+
+static void replay_wait_until(uint64_t deadline) {
+    uint64_t now = replay_now_ns();
+    if (now + REPLAY_SPIN_NS < deadline) {
+        struct timespec ts = {
+            .tv_sec = (time_t)((deadline - REPLAY_SPIN_NS) / 1000000000ull),
+            .tv_nsec = (long)((deadline - REPLAY_SPIN_NS) % 1000000000ull),
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+    }
+    while (replay_now_ns() < deadline) {}
+}
+
+// First virtual cell of the UE that this worker owns, see replay_add()
+static inline uint32_t replay_first_cell(const replay_worker_t *w, uint64_t key) {
+    uint32_t h = (uint32_t)(replay_mix(key) % (uint64_t)w->n_workers);
+    return ((uint32_t)w->id + (uint32_t)w->n_workers - h) % (uint32_t)w->n_workers;
+}
+
+static void *replay_worker_run(void *arg) {
+    replay_worker_t *w = arg;
+    const replay_cfg_t *cfg = w->cfg;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    uint32_t n_workers = (uint32_t)w->n_workers;
+    uint64_t start = *w->start_ns;
+    replay_wait_until(start);
+
+    for (uint32_t loop = 0; loop < cfg->loops; loop++) {
+        uint64_t base = loop * cfg->period_ns;
+        for (size_t i = 0; i < w->n_recs; i++) {
+            const replay_rec_t *r = &w->recs[i];
+
+            if (cfg->speed > 0) {
+                uint64_t deadline = start + (uint64_t)((double)(base + r->ts_ns) / cfg->speed);
+                uint64_t now = replay_now_ns();
+                if (now < deadline) {
+                    replay_wait_until(deadline);
+                    now = deadline;
+                }
+                hdr_hist_record(&w->lateness, now - deadline);
+                if (cfg->drop_ns && now - deadline > cfg->drop_ns) {
+                    w->st.dropped++;
+                    continue;
+                }
+            }
+
+            for (uint32_t c = replay_first_cell(w, r->key); c < cfg->cells; c += n_workers) {
+                w->st.records++;
+                w->st.bytes += r->len;
+                if (r->kind == REPLAY_RRC)
+                    replay_rrc_decode(w, r->dir, r->data, r->len);
+                else
+                    replay_mac(w, r, replay_cell_key(r->key, c));
+            }
+        }
+        // Every pass starts over from a fresh attach
+        replay_ue_reset(w);
+    }
+    w->wall_ns = replay_now_ns() - start;
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * Loading
+ *--------------------------------------------------------------------------*/
+
+typedef struct replay_loader {
+    replay_worker_t *workers;
+    int n_workers;
+    uint32_t cells;
+    int fill;                  // 0 = count pass, 1 = fill pass
+    uint64_t ts0;              // First pcap timestamp, found by the count pass
+    uint64_t ts_max;           // Largest relative timestamp seen
+    uint64_t n_mac;
+    uint64_t n_rrc;
+    uint64_t n_skipped;        // Frames that are not mac-nr framed
+} replay_loader_t;
+
+// Virtual cell c of a UE runs on worker (mix(key) + c) % n_workers
+static void replay_add(replay_loader_t *ld, const replay_rec_t *r) {
+    uint32_t n = ld->cells < (uint32_t)ld->n_workers ? ld->cells : (uint32_t)ld->n_workers;
+    uint64_t h = replay_mix(r->key);
+
+    for (uint32_t c = 0; c < n; c++) {
+        replay_worker_t *w = &ld->workers[(h + c) % (uint64_t)ld->n_workers];
+        if (!ld->fill) {
+            w->cap_recs++;
+            continue;
+        }
+        w->recs[w->n_recs++] = *r;
+    }
+    if (ld->fill && r->ts_ns > ld->ts_max) ld->ts_max = r->ts_ns;
+}
+
+static void *replay_map(const char *path, size_t *len) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || !st.st_size) {
+        fprintf(stderr, " %s is empty.\n", path);
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror(path);
+        return NULL;
+    }
+    *len = (size_t)st.st_size;
+    return p;
+}
+
+static void replay_scan_pcap(replay_loader_t *ld, l2_pcap_reader_t *pr) {
+    uint64_t ts;
+    mac_nr_info_t info;
+    const uint8_t *pdu;
+    size_t len;
+    uint16_t port;
+
+    l2_pcap_reader_rewind(pr);
+    while (l2_pcap_next_mac(pr, &ts, &info, &pdu, &len, &port, ld->fill ? NULL : &ld->n_skipped)) {
+        if (!ld->fill && ts < ld->ts0) ld->ts0 = ts;
+        replay_rec_t r = {
+            .ts_ns = ts > ld->ts0 ? ts - ld->ts0 : 0,
+            .key = (uint64_t)port << 32 | (uint64_t)info.ueid << 16 | info.rnti,
+            .data = pdu,
+            .len = (uint32_t)len,
+            .kind = REPLAY_MAC,
+            // mac-nr uses UL = 0, DL = 1
+            .dir = info.direction == MAC_NR_DIR_UL ? MAC_DIR_UL : MAC_DIR_DL,
+            .rnti_type = info.rnti_type,
+        };
+        if (!ld->fill) ld->n_mac++;
+        replay_add(ld, &r);
+    }
+}
+
+#ifdef L2_REPLAY_RRC
+static int replay_scan_rrc(replay_loader_t *ld, uint8_t *map, size_t size) {
+    rrc_history_t h = { .hdr = (rrc_history_hdr_t *)map, .fd = -1 };
+    if (size < sizeof(rrc_history_hdr_t) || h.hdr->magic != RRC_HISTORY_MAGIC ||
+        h.hdr->version != RRC_HISTORY_VERSION || h.hdr->used > size) {
+        fprintf(stderr, " RRC history is not a valid rrc_history file.\n");
+        return -1;
+    }
+
+    uint64_t ts0 = UINT64_MAX;
+    for (uint64_t off = rrc_history_first(&h); off; off = rrc_history_next(&h, off)) {
+        const rrc_frozen_msg_t *m = rrc_history_at(&h, off);
+        if (m && m->timestamp < ts0) ts0 = m->timestamp;
+    }
+    for (uint64_t off = rrc_history_first(&h); off; off = rrc_history_next(&h, off)) {
+        const rrc_frozen_msg_t *m = rrc_history_at(&h, off);
+        if (!m || m->channel >= RRC_CHANNEL_COUNT) continue;
+        replay_rec_t r = {
+            .ts_ns = m->timestamp - ts0,
+            .key = 1ull << 48 | m->ue_id,
+            .data = m->per,
+            .len = (m->per_bits + 7) / 8,
+            .kind = REPLAY_RRC,
+            .dir = m->channel,
+        };
+        if (!ld->fill) ld->n_rrc++;
+        replay_add(ld, &r);
+    }
+    return 0;
+}
+#endif
+
+static int replay_rec_cmp(const void *a, const void *b) {
+    const replay_rec_t *x = a, *y = b;
+    if (x->ts_ns != y->ts_ns) return x->ts_ns < y->ts_ns ? -1 : 1;
+    return x->data < y->data ? -1 : x->data > y->data;
+}
+
+/*----------------------------------------------------------------------------
+ * Report
+ *--------------------------------------------------------------------------*/
+
+static void replay_print_stats(const char *label, const replay_stats_t *st) {
+    printf("  %-8s records %llu (%.1f MB), TBs %llu, subPDUs %llu (CE %llu, CCCH %llu), "
+           "broadcast %llu, malformed %llu, dropped %llu\n",
+           label, (unsigned long long)st->records, (double)st->bytes / 1e6,
+           (unsigned long long)st->tbs, (unsigned long long)st->subpdus,
+           (unsigned long long)st->ces, (unsigned long long)st->ccch,
+           (unsigned long long)st->broadcast, (unsigned long long)st->malformed,
+           (unsigned long long)st->dropped);
+    printf("  %-8s RLC PDUs %llu rejected %llu accepted %llu segments %llu, PDCP SDUs %llu "
+           "(data %llu, control %llu, short %llu), RRC ok %llu fail %llu, "
+           "UEs %llu, bearers %llu, UE table full %llu\n",
+           "", (unsigned long long)st->rlc_pdus, (unsigned long long)st->rlc_rejected,
+           (unsigned long long)st->rlc_accepted,
+           (unsigned long long)st->segments, (unsigned long long)st->sdus,
+           (unsigned long long)st->pdcp_data, (unsigned long long)st->pdcp_control,
+           (unsigned long long)st->pdcp_short, (unsigned long long)st->rrc_ok,
+           (unsigned long long)st->rrc_fail, (unsigned long long)st->ues,
+           (unsigned long long)st->bearers, (unsigned long long)st->ue_full);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-w workers] [-x speed] [-c cells] [-n loops] [-a first_cpu]\n"
+                    "          [-d drop_us] [-r am18|am12|um12|um6] [-q 12|18]\n"
+                    "          [-R rrc_history] [-S stats_name] [capture.pcap]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    replay_cfg_t cfg = {
+        .speed = 1.0, .cells = 1, .loops = 1,
+        .drb_mode = RLC_MODE_AM, .drb_sn_bits = 18, .pdcp_fmt = L2_HDR_PDCP_SN18,
+    };
+    int n_workers = 1, first_cpu = -1;
+    const char *pcap_path = NULL, *rrc_path = NULL, *stats_name = NULL;
+    l2_stats_shm_t stats = { 0 };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-w") && i + 1 < argc) n_workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-x") && i + 1 < argc) cfg.speed = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) cfg.cells = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) cfg.loops = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) first_cpu = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc) cfg.drop_ns = strtoull(argv[++i], NULL, 0) * 1000;
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+            const char *m = argv[++i];
+            int am = !strncmp(m, "am", 2), um = !strncmp(m, "um", 2);
+            cfg.drb_mode = um ? RLC_MODE_UM : RLC_MODE_AM;
+            cfg.drb_sn_bits = (uint8_t)atoi(m + 2);
+            if ((!am && !um) || !rlc_entity_ops_get(cfg.drb_mode, cfg.drb_sn_bits)) {
+                fprintf(stderr, " %s is not a supported RLC configuration.\n", m);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "-q") && i + 1 < argc)
+            cfg.pdcp_fmt = atoi(argv[++i]) == 12 ? L2_HDR_PDCP_SN12 : L2_HDR_PDCP_SN18;
+        else if (!strcmp(argv[i], "-R") && i + 1 < argc) rrc_path = argv[++i];
+        else if (!strcmp(argv[i], "-S") && i + 1 < argc) stats_name = argv[++i];
+        else if (argv[i][0] != '-' && !pcap_path) pcap_path = argv[i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((!pcap_path && !rrc_path) || n_workers < 1 || n_workers > REPLAY_MAX_WORKERS ||
+        cfg.speed < 0 || !cfg.cells || !cfg.loops) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (cfg.drb_mode == RLC_MODE_AM)
+        cfg.drb_rlc_fmt = cfg.drb_sn_bits == 12 ? L2_HDR_RLC_AM_SN12 : L2_HDR_RLC_AM_SN18;
+    else
+        cfg.drb_rlc_fmt = cfg.drb_sn_bits == 6 ? L2_HDR_RLC_UM_SN6 : L2_HDR_RLC_UM_SN12;
+    cfg.lcid_ok[MAC_DIR_DL] = mac_lcid_valid_mask(MAC_DIR_DL);
+    cfg.lcid_ok[MAC_DIR_UL] = mac_lcid_valid_mask(MAC_DIR_UL);
+#ifndef L2_REPLAY_RRC
+    if (rrc_path) {
+        fprintf(stderr, " -R needs a build with -DL2_REPLAY_RRC.\n");
+        return 1;
+    }
+#endif
+
+    l2_pcap_reader_t pr = { 0 };
+    size_t rrc_size = 0;
+    uint8_t *rrc_map = NULL;
+    if (pcap_path && l2_pcap_reader_open(&pr, pcap_path) < 0) return 1;
+    if (rrc_path && !(rrc_map = replay_map(rrc_path, &rrc_size))) return 1;
+
+    replay_worker_t *workers = calloc((size_t)n_workers, sizeof(*workers));
+    if (!workers) return 1;
+    replay_loader_t ld = { .workers = workers, .n_workers = n_workers,
+                          .cells = cfg.cells, .ts0 = UINT64_MAX };
+
+    // Two passes: count per worker, then fill arrays placed on the worker's node
+    for (ld.fill = 0; ld.fill < 2; ld.fill++) {
+        if (pcap_path) replay_scan_pcap(&ld, &pr);
+#ifdef L2_REPLAY_RRC
+        if (rrc_map && replay_scan_rrc(&ld, rrc_map, rrc_size) < 0) return 1;
+#endif
+        if (ld.fill) break;
+
+        for (int i = 0; i < n_workers; i++) {
+            replay_worker_t *w = &workers[i];
+            w->id = i;
+            w->n_workers = n_workers;
+            w->cpu = first_cpu < 0 ? -1 : first_cpu + i;
+            int node = w->cpu < 0 ? L2_MEM_NODE_ANY : l2_mem_cpu_node(w->cpu);
+            w->recs = l2_mem_array(w->cap_recs ? w->cap_recs : 1, sizeof(replay_rec_t), node,
+                                   "replay records");
+            w->ues = l2_mem_array(REPLAY_UE_SLOTS, sizeof(replay_ue_t), node, "replay UE table");
+            if (!w->recs || !w->ues || hdr_hist_init(&w->lateness, REPLAY_PRECISION) < 0) {
+                fprintf(stderr, " worker %d: out of memory.\n", i);
+                return 1;
+            }
+        }
+    }
+    if (!ld.n_mac && !ld.n_rrc) {
+        fprintf(stderr, " no replayable records found.\n");
+        return 1;
+    }
+    cfg.period_ns = ld.ts_max + REPLAY_LOOP_GAP_NS;
+
+    if (stats_name) {
+        if (l2_stats_create(&stats, stats_name, (uint32_t)n_workers) < 0) {
+            fprintf(stderr, " %s: %s.\n", stats_name, strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < n_workers; i++) workers[i].stats = l2_stats_core(&stats, (uint32_t)i);
+    }
+
+    // Captures are not strictly time ordered once two sources are merged
+    for (int i = 0; i < n_workers; i++)
+        qsort(workers[i].recs, workers[i].n_recs, sizeof(replay_rec_t), replay_rec_cmp);
+
+    printf("=== L2 Replay ===\n");
+    printf("  %llu MAC record(s), %llu RRC record(s), %llu frame(s) skipped, span %.3f ms\n",
+           (unsigned long long)ld.n_mac, (unsigned long long)ld.n_rrc,
+           (unsigned long long)ld.n_skipped, (double)ld.ts_max / 1e6);
+    printf("  %d worker(s), %u cell(s), %u loop(s), speed %s%.2f, drop budget %llu us, "
+           "burst parser: %s\n", n_workers, cfg.cells, cfg.loops, cfg.speed > 0 ? "x" : "unpaced ",
+           cfg.speed, (unsigned long long)(cfg.drop_ns / 1000), l2_hdr_burst_impl());
+
+    uint64_t start_ns = replay_now_ns() + REPLAY_START_DELAY;
+    for (int i = 0; i < n_workers; i++) {
+        workers[i].cfg = &cfg;
+        workers[i].start_ns = &start_ns;
+        if (pthread_create(&workers[i].thread, NULL, replay_worker_run, &workers[i]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    replay_stats_t total = { 0 };
+    hdr_hist_t lateness;
+    uint64_t wall_ns = 0;
+    if (hdr_hist_init(&lateness, REPLAY_PRECISION) < 0) {
+        fprintf(stderr, " out of memory.\n");
+        return 1;
+    }
+    for (int i = 0; i < n_workers; i++) {
+        replay_worker_t *w = &workers[i];
+        pthread_join(w->thread, NULL);
+
+        char label[32];
+        snprintf(label, sizeof(label), "w%d", i);
+        replay_print_stats(label, &w->st);
+        snprintf(label, sizeof(label), "w%d lateness (ns)", i);
+        if (cfg.speed > 0) hdr_hist_print(stdout, label, &w->lateness);
+
+        const uint64_t *src = (const uint64_t *)&w->st;
+        uint64_t *dst = (uint64_t *)&total;
+        for (size_t k = 0; k < REPLAY_STAT_COUNT; k++) dst[k] += src[k];
+        hdr_hist_merge(&lateness, &w->lateness);
+        if (w->wall_ns > wall_ns) wall_ns = w->wall_ns;
+    }
+
+    replay_print_stats("total", &total);
+    if (cfg.speed > 0) hdr_hist_print(stdout, "lateness (ns)", &lateness);
+    double wall_s = (double)wall_ns / 1e9;
+    double air_s = (double)(cfg.period_ns * cfg.loops - REPLAY_LOOP_GAP_NS) / 1e9;
+    printf("  wall %.3f s, %.2f Mrecords/s, %.2f Gbit/s, real-time factor %.2f over %u cell(s)\n",
+           wall_s, (double)total.records / wall_s / 1e6, (double)total.bytes * 8 / wall_s / 1e9,
+           air_s / wall_s, cfg.cells);
+    l2_mem_report(stdout);
+
+    hdr_hist_free(&lateness);
+    for (int i = 0; i < n_workers; i++) {
+        hdr_hist_free(&workers[i].lateness);
+        l2_mem_free(workers[i].recs);
+        l2_mem_free(workers[i].ues);
+    }
+    free(workers);
+    if (stats_name) l2_stats_close(&stats);
+    l2_pcap_reader_close(&pr);
+    if (rrc_map) munmap(rrc_map, rrc_size);
+    return 0;
+}
@@ -0,0 +1,654 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "l2_sim.h"
+#include "mac_ce.h"
+#include "l2_trace.h"
+
+enum {
+    L2_SIM_EV_SLOT = 0,        // arg: cell
+    L2_SIM_EV_ARRIVAL,         // arg: UE << 1 | direction
+    L2_SIM_EV_HARQ_FB,         // arg: UE, direction and process from the node's position
+};
+
+#define L2_SIM_QFI          9
+#define L2_SIM_PDCP_SN_MASK 0x3FFFFu
+#define L2_SIM_MAC_OVERHEAD 16      // Subheaders and BSR allowance when sizing a TB
+
+static inline uint64_t l2_sim_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// xorshift64*, seeded through splitmix64
+static inline uint64_t l2_sim_rand(l2_sim_t *s) {
+    s->rng ^= s->rng >> 12;
+    s->rng ^= s->rng << 25;
+    s->rng ^= s->rng >> 27;
+    return s->rng * 0x2545F4914F6CDD1Dull;
+}
+
+static inline double l2_sim_uniform(l2_sim_t *s) {
+    return (double)(l2_sim_rand(s) >> 11) * 0x1.0p-53;
+}
+
+void l2_sim_cfg_default(l2_sim_cfg_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->mu = 1;
+    strcpy(cfg->pattern, "DDDSU");
+    cfg->n_cells = 20;
+    cfg->ues_per_cell = 50;
+    cfg->n_prb = 106;
+    cfg->ues_per_slot = 8;
+    cfg->k1 = 4;
+    cfg->max_retx = 3;
+    cfg->se_min = 0.5;
+    cfg->se_max = 5.5;
+    cfg->chan = L2_SIM_CHAN_BLER;
+    cfg->bler = 0.1;
+    cfg->bler_bad = 0.9;
+    cfg->p_gb = 0.01;
+    cfg->p_bg = 0.2;
+    cfg->traffic = L2_SIM_TRAFFIC_POISSON;
+    cfg->mbps[MAC_DIR_DL] = 1.0;
+    cfg->mbps[MAC_DIR_UL] = 0.25;
+    cfg->sdu_bytes = 1400;
+    cfg->queue_sdus = 32;
+    cfg->seed = 1;
+}
+
+/*----------------------------------------------------------------------------
+ * Rings
+ *--------------------------------------------------------------------------*/
+
+static int l2_sim_ring_init(l2_sim_ring_t *r, uint32_t n) {
+    uint32_t cap = 1;
+    while (cap < n) cap <<= 1;
+    r->v = malloc((size_t)cap * sizeof(*r->v));
+    r->mask = cap - 1;
+    r->head = r->tail = 0;
+    return r->v ? 0 : -1;
+}
+
+static inline uint32_t l2_sim_ring_len(const l2_sim_ring_t *r) { return r->tail - r->head; }
+static inline void l2_sim_ring_push(l2_sim_ring_t *r, uint32_t v) { r->v[r->tail++ & r->mask] = v; }
+static inline uint32_t l2_sim_ring_pop(l2_sim_ring_t *r) { return r->v[r->head++ & r->mask]; }
+
+/*----------------------------------------------------------------------------
+ * Transmit side: RLC UM segmentation under LCP
+ *--------------------------------------------------------------------------*/
+
+typedef struct l2_sim_tx {
+    l2_sim_t *s;
+    l2_sim_bearer_t *b;
+    uint64_t now;
+    uint16_t rnti;
+} l2_sim_tx_t;
+
+static inline int l2_sim_backlogged(const l2_sim_bearer_t *b) {
+    return b->cur != L2_BUF_NONE || sdu_queue_pkts(&b->q);
+}
+
+// lcp_rlc_ops_t.pending: queued data volume plus the SDU being segmented
+static uint32_t l2_sim_pending(void *ctx, uint8_t lcid) {
+    const l2_sim_tx_t *t = ctx;
+    uint32_t n = bs_lc_bytes(&t->b->bs, lcid);
+    if (t->b->cur != L2_BUF_NONE) n += t->b->cur_len + t->s->rlc->hdr_len_so;
+    return n;
+}
+
+/**
+ * lcp_rlc_ops_t.build_pdu: one UMD PDU of at most max bytes. A new SDU is
+ * taken from the queue (running CoDel) and kept in cur until its last
+ * segment has gone; a first segment must carry L2_SIM_MIN_FIRST_SEG bytes.
+ */
+static uint32_t l2_sim_build_pdu(void *ctx, uint8_t lcid, uint8_t *buf, uint32_t max) {
+    l2_sim_tx_t *t = ctx;
+    l2_sim_bearer_t *b = t->b;
+    const rlc_entity_ops_t *ops = t->s->rlc;
+
+    if (b->cur == L2_BUF_NONE) {
+        uint32_t len, off;
+        b->cur = sdu_queue_dequeue(&b->q, t->now, &len, &off);
+        bs_lc_sync_queue(&b->bs, lcid, &b->q);
+        if (b->cur == L2_BUF_NONE) return 0;
+        b->cur_len = len;
+        b->cur_off = off;
+    }
+
+    rlc_pdu_info_t info = { .sn = b->tx_sn, .so = (uint16_t)b->cur_off, .si = RLC_SI_COMPLETE };
+    if (b->cur_off || b->cur_len + 1 > max) {
+        uint32_t hdr = b->cur_off ? ops->hdr_len_so : ops->hdr_len;
+        uint32_t min = b->cur_off ? 1 : L2_SIM_MIN_FIRST_SEG;
+        if (max < hdr + min) return 0;
+        info.si = !b->cur_off ? RLC_SI_FIRST : b->cur_len <= max - hdr ? RLC_SI_LAST : RLC_SI_MIDDLE;
+    }
+
+    int h = ops->hdr_write(buf, max, &info);
+    if (h < 0) return 0;
+    uint32_t take = b->cur_len < max - (uint32_t)h ? b->cur_len : max - (uint32_t)h;
+    memcpy(buf + h, l2_buf_data(&t->s->sdu_pool, b->cur) + b->cur_off, take);
+    b->cur_off += take;
+    b->cur_len -= take;
+    L2_TRACE_MARK(L2_STAGE_RLC_TX, t->rnti, lcid, info.sn);
+
+    if (!b->cur_len) {
+        l2_buf_put(&t->s->sdu_pool, b->cur);
+        b->cur = L2_BUF_NONE;
+        // UM: SNs are only used by segmented SDUs (TS 38.322 Section 5.2.2.1)
+        if (info.si != RLC_SI_COMPLETE) b->tx_sn = (b->tx_sn + 1) & ((1u << ops->sn_bits) - 1);
+    }
+    return (uint32_t)h + take;
+}
+
+static const lcp_rlc_ops_t l2_sim_rlc_ops = {
+    .pending = l2_sim_pending,
+    .build_pdu = l2_sim_build_pdu,
+};
+
+/*----------------------------------------------------------------------------
+ * Receive side: RLC UM reassembly, PDCP
+ *--------------------------------------------------------------------------*/
+
+// PDCP 18-bit data PDU: SN, and the arrival stamp behind the SDAP header
+static int l2_sim_pdcp_parse(const uint8_t *p, uint32_t len, uint32_t *sn, uint64_t *ts) {
+    if (len < 12 || !(p[0] & 0x80)) return -1;
+    *sn = (uint32_t)(p[0] & 0x03) << 16 | (uint32_t)p[1] << 8 | p[2];
+    memcpy(ts, p + 4, sizeof(*ts));
+    return 0;
+}
+
+static void l2_sim_sdu_rx(l2_sim_t *s, l2_sim_ue_t *ue, int d, uint32_t pdcp_sn, uint64_t ts,
+                          uint32_t bytes, uint64_t now) {
+    l2_sim_bearer_t *b = &ue->b[d];
+    l2_sim_dir_stats_t *st = &s->st[d];
+    L2_TRACE_MARK(L2_STAGE_PDCP_RX, ue->rnti, L2_SIM_LCID_DRB, pdcp_sn);
+    st->sdus_delivered++;
+    st->bytes_delivered += bytes;
+    if (((pdcp_sn - b->pdcp_rx_next) & L2_SIM_PDCP_SN_MASK) > L2_SIM_PDCP_SN_MASK / 2)
+        st->out_of_order++;
+    else
+        b->pdcp_rx_next = (pdcp_sn + 1) & L2_SIM_PDCP_SN_MASK;
+    hdr_hist_record(&s->latency[d], (now - ts) / 1000);
+}
+
+static void l2_sim_rlc_rx(l2_sim_t *s, l2_sim_ue_t *ue, int d, const uint8_t *const pdu[],
+                          const uint16_t len[], uint32_t n, uint64_t now) {
+    l2_sim_bearer_t *b = &ue->b[d];
+    rlc_pdu_info_t info[RLC_RX_BURST_MAX];
+
+    L2_TRACE_BEGIN(L2_STAGE_RLC_RX, ue->rnti, L2_SIM_LCID_DRB, 0);
+    uint32_t acc = s->rlc->rx_burst(&b->rx, pdu, len, n, info);
+
+    for (; acc; acc &= acc - 1) {
+        int i = __builtin_ctz(acc);
+        const rlc_pdu_info_t *x = &info[i];
+        const uint8_t *p = pdu[i] + x->hdr_len;
+        uint32_t l = len[i] - x->hdr_len, psn;
+        uint64_t ts;
+
+        if (x->si == RLC_SI_COMPLETE) {
+            if (!l2_sim_pdcp_parse(p, l, &psn, &ts)) l2_sim_sdu_rx(s, ue, d, psn, ts, l, now);
+            continue;
+        }
+
+        l2_sim_rx_seg_t *g = &b->seg[x->sn & (L2_SIM_SEG_SLOTS - 1)];
+        if (!g->used || g->sn != x->sn) {
+            memset(g, 0, sizeof(*g));
+            g->used = 1;
+            g->sn = x->sn;
+        }
+        g->got += l;
+        if (x->si == RLC_SI_FIRST && !l2_sim_pdcp_parse(p, l, &g->pdcp_sn, &g->ts_ns)) g->have_first = 1;
+        if (x->si == RLC_SI_LAST) g->total = x->so + l;
+
+        if (g->total && g->got == g->total) {
+            s->rlc->rx_sdu_done(&b->rx, x->sn);
+            if (g->have_first) l2_sim_sdu_rx(s, ue, d, g->pdcp_sn, g->ts_ns, g->total, now);
+            g->used = 0;
+        }
+    }
+    L2_TRACE_END(L2_STAGE_RLC_RX, ue->rnti, L2_SIM_LCID_DRB, 0);
+}
+
+// An ACKed TB reaches the peer: MAC demux, DRB subPDUs to RLC in bursts
+static void l2_sim_deliver(l2_sim_t *s, l2_sim_ue_t *ue, int d, const uint8_t *tb, uint32_t tb_len,
+                           uint64_t now) {
+    mac_subpdu_t sub[LCP_MAX_SDUS + 4];
+    const uint8_t *pdu[RLC_RX_BURST_MAX];
+    uint16_t len[RLC_RX_BURST_MAX];
+    uint32_t n = 0;
+
+    L2_TRACE_BEGIN(L2_STAGE_MAC_RX, ue->rnti, 0, 0);
+    int n_sub = mac_pdu_demux(tb, tb_len, (mac_dir_t)d, sub, LCP_MAX_SDUS + 4);
+    L2_TRACE_END(L2_STAGE_MAC_RX, ue->rnti, 0, 0);
+    for (int i = 0; i < n_sub; i++) {
+        if (sub[i].lcid != L2_SIM_LCID_DRB) continue;
+        pdu[n] = tb + sub[i].offset;
+        len[n] = (uint16_t)sub[i].len;
+        if (++n == RLC_RX_BURST_MAX) {
+            l2_sim_rlc_rx(s, ue, d, pdu, len, n, now);
+            n = 0;
+        }
+    }
+    if (n) l2_sim_rlc_rx(s, ue, d, pdu, len, n, now);
+}
+
+/*----------------------------------------------------------------------------
+ * Events
+ *--------------------------------------------------------------------------*/
+
+static void l2_sim_activate(l2_sim_t *s, uint32_t idx, int d) {
+    l2_sim_ue_t *ue = &s->ues[idx];
+    if (ue->b[d].active) return;
+    ue->b[d].active = 1;
+    l2_sim_ring_push(&s->cells[ue->cell].active[d], idx);
+}
+
+static void l2_sim_arrival(l2_sim_t *s, uint32_t idx, int d, uint64_t now) {
+    l2_sim_bearer_t *b = &s->ues[idx].b[d];
+    l2_sim_dir_stats_t *st = &s->st[d];
+    uint32_t len = s->cfg.sdu_bytes;
+
+    st->sdus_offered++;
+    st->bytes_offered += len;
+
+    l2_buf_ref_t ref = l2_buf_alloc(&s->sdu_pool);
+    if (ref == L2_BUF_NONE) {
+        st->pool_drops++;
+    } else {
+        // PDCP data PDU, 18-bit SN | SDAP header | arrival time
+        uint8_t *p = l2_buf_data(&s->sdu_pool, ref);
+        uint32_t sn = b->pdcp_tx_next++ & L2_SIM_PDCP_SN_MASK;
+        p[0] = (uint8_t)(0x80 | sn >> 16);
+        p[1] = (uint8_t)(sn >> 8);
+        p[2] = (uint8_t)sn;
+        p[3] = (uint8_t)((d == MAC_DIR_UL ? 0x80 : 0) | L2_SIM_QFI);
+        memcpy(p + 4, &now, sizeof(now));
+        L2_TRACE_MARK(L2_STAGE_PDCP_TX, s->ues[idx].rnti, L2_SIM_LCID_DRB, sn);
+
+        sdu_queue_enqueue(&b->q, ref, len, now);
+        L2_TRACE_MARK(L2_STAGE_SDU_QUEUE, s->ues[idx].rnti, L2_SIM_LCID_DRB, sn);
+        bs_lc_sync_queue(&b->bs, L2_SIM_LCID_DRB, &b->q);
+        if (l2_sim_backlogged(b)) l2_sim_activate(s, idx, d);
+    }
+
+    double gap = s->arrival_ns[d];
+    if (s->cfg.traffic == L2_SIM_TRAFFIC_POISSON) gap *= -log(1.0 - l2_sim_uniform(s));
+    cq_insert(&s->cq, &b->arrival, now + 1 + (uint64_t)gap);
+}
+
+static inline uint32_t l2_sim_bytes_per_prb(const l2_sim_ue_t *ue, int symbols) {
+    uint32_t n = (uint32_t)(12.0 * symbols * ue->se / 8.0);
+    return n ? n : 1;
+}
+
+static void l2_sim_schedule(l2_sim_t *s, uint32_t c, int d, int symbols, uint64_t now) {
+    l2_sim_cell_t *cell = &s->cells[c];
+    l2_sim_dir_stats_t *st = &s->st[d];
+    uint32_t prb_left = s->cfg.n_prb, n_tx = 0;
+    uint64_t fb_time = now + s->cfg.k1 * s->slot_ns;
+
+    st->slots++;
+    st->prbs_avail += s->cfg.n_prb;
+
+    // Retransmissions first, with the TB size of the first transmission
+    while (cell->retx_head[d] != cell->retx_tail[d] && n_tx < s->cfg.ues_per_slot) {
+        const harq_retx_t *r = &cell->retx[d][cell->retx_head[d] & cell->retx_mask];
+        l2_sim_ue_t *ue = &s->ues[c * s->cfg.ues_per_cell + (r->rnti - L2_SIM_RNTI_BASE)];
+        uint32_t bpp = l2_sim_bytes_per_prb(ue, symbols);
+        uint32_t prbs = (r->tb_len + bpp - 1) / bpp;
+        if (prbs > s->cfg.n_prb) prbs = s->cfg.n_prb;
+        if (prbs > prb_left) break;
+
+        prb_left -= prbs;
+        n_tx++;
+        st->tbs_retx++;
+        cq_insert(&s->cq, &ue->harq_fb[d][r->pid], fb_time);
+        cell->retx_head[d]++;
+    }
+
+    // New TBs: round robin over the backlogged UEs, equal PRB shares
+    l2_sim_ring_t *ring = &cell->active[d];
+    uint32_t want = l2_sim_ring_len(ring);
+    if (want > s->cfg.ues_per_slot - n_tx) want = s->cfg.ues_per_slot - n_tx;
+    uint32_t share = want ? prb_left / want : 0, extra = want ? prb_left % want : 0;
+
+    for (uint32_t k = 0; k < want && prb_left; k++) {
+        uint32_t idx = l2_sim_ring_pop(ring);
+        l2_sim_ue_t *ue = &s->ues[idx];
+        l2_sim_bearer_t *b = &ue->b[d];
+        uint32_t quota = share + (k < extra);
+
+        if (!l2_sim_backlogged(b)) {
+            b->active = 0;
+            continue;
+        }
+        int pid = harq_free_pid(&cell->harq[d], ue->rnti, 0);
+        if (pid < 0 || !quota) {
+            st->harq_stall += pid < 0;
+            l2_sim_ring_push(ring, idx);
+            continue;
+        }
+        l2_buf_ref_t ref = l2_buf_alloc(&s->tb_pool);
+        if (ref == L2_BUF_NONE) {
+            st->tb_alloc_fail++;
+            l2_sim_ring_push(ring, idx);
+            continue;
+        }
+
+        l2_sim_tx_t tx = { s, b, now, ue->rnti };
+        uint32_t bpp = l2_sim_bytes_per_prb(ue, symbols);
+        uint32_t need = l2_sim_pending(&tx, L2_SIM_LCID_DRB) + L2_SIM_MAC_OVERHEAD;
+        uint32_t prbs = (need + bpp - 1) / bpp;
+        if (prbs > quota) prbs = quota;
+        uint32_t tb_len = prbs * bpp;
+        if (tb_len > s->tb_pool.buf_size) tb_len = s->tb_pool.buf_size;
+
+        uint8_t *tb = l2_buf_data(&s->tb_pool, ref);
+        uint32_t used = 0;
+        if (d == MAC_DIR_UL) {
+            int n = bs_build_bsr(&b->bs, tb, tb_len);
+            if (n > 0) used = (uint32_t)n;
+        }
+        lcp_tick(&b->lcp, (uint32_t)(cell->slot - b->lcp_slot));
+        b->lcp_slot = cell->slot;
+
+        lcp_result_t res;
+        L2_TRACE_BEGIN(L2_STAGE_MAC_MUX, ue->rnti, 0, 0);
+        lcp_build_tb(&b->lcp, &l2_sim_rlc_ops, &tx, tb, tb_len, used, &res);
+        L2_TRACE_END(L2_STAGE_MAC_MUX, ue->rnti, 0, 0);
+        harq_new_tx(&cell->harq[d], ue->rnti, 0, (uint8_t)pid, ref, tb_len);
+        L2_TRACE_MARK(L2_STAGE_MAC_TB_OUT, ue->rnti, 0, 0);
+        l2_buf_put(&s->tb_pool, ref);
+        cq_insert(&s->cq, &ue->harq_fb[d][pid], fb_time);
+
+        st->tbs_new++;
+        st->tb_bytes += tb_len;
+        st->padding_bytes += res.padding;
+        prb_left -= prbs;
+
+        if (l2_sim_backlogged(b))
+            l2_sim_ring_push(ring, idx);
+        else
+            b->active = 0;
+    }
+    st->prbs_used += s->cfg.n_prb - prb_left;
+}
+
+static void l2_sim_slot(l2_sim_t *s, uint32_t c, uint64_t now) {
+    l2_sim_cell_t *cell = &s->cells[c];
+    char t = s->cfg.pattern[cell->slot % s->pattern_len];
+
+    // The trace UE field carries the cell index, the SN field the slot number
+    L2_TRACE_BEGIN(L2_STAGE_SLOT, (uint16_t)c, 0, (uint32_t)cell->slot);
+    cell->slot++;
+    if (t == 'D' || t == 'F') l2_sim_schedule(s, c, MAC_DIR_DL, L2_SIM_DATA_SYMBOLS, now);
+    else if (t == 'S') l2_sim_schedule(s, c, MAC_DIR_DL, L2_SIM_S_SYMBOLS, now);
+    if (t == 'U' || t == 'F') l2_sim_schedule(s, c, MAC_DIR_UL, L2_SIM_DATA_SYMBOLS, now);
+    L2_TRACE_END(L2_STAGE_SLOT, (uint16_t)c, 0, (uint32_t)(cell->slot - 1));
+
+    cq_insert(&s->cq, &cell->slot_ev, cell->slot * s->slot_ns);
+}
+
+// Decode outcome of one transmission
+static int l2_sim_channel_ok(l2_sim_t *s, l2_sim_ue_t *ue) {
+    double bler = s->cfg.bler;
+    if (s->cfg.chan == L2_SIM_CHAN_GE) {
+        double u = l2_sim_uniform(s);
+        if (ue->ge_bad) {
+            if (u < s->cfg.p_bg) ue->ge_bad = 0;
+        } else if (u < s->cfg.p_gb) {
+            ue->ge_bad = 1;
+        }
+        if (ue->ge_bad) bler = s->cfg.bler_bad;
+    }
+    return l2_sim_uniform(s) >= bler;
+}
+
+static void l2_sim_harq_fb(l2_sim_t *s, cq_event_t *ev, uint64_t now) {
+    l2_sim_ue_t *ue = &s->ues[ev->arg];
+    size_t k = (size_t)(ev - &ue->harq_fb[0][0]);
+    int d = (int)(k / HARQ_NUM_PROCESSES);
+    uint8_t pid = (uint8_t)(k % HARQ_NUM_PROCESSES);
+    l2_sim_cell_t *cell = &s->cells[ue->cell];
+    harq_mgr_t *m = &cell->harq[d];
+    harq_feedback_t fb = { .rnti = ue->rnti, .carrier = 0, .pid = pid, .ack = (uint8_t)l2_sim_channel_ok(s, ue) };
+
+    if (fb.ack) {
+        const harq_proc_t *p = &harq_entity(m, ue->rnti, 0)->proc[pid];
+        l2_sim_deliver(s, ue, d, l2_buf_data(&s->tb_pool, p->buf), p->tb_len, now);
+    }
+
+    harq_retx_t r;
+    if (harq_feedback_batch(m, &fb, 1, &r, 1, NULL))
+        cell->retx[d][cell->retx_tail[d]++ & cell->retx_mask] = r;
+}
+
+void l2_sim_run(l2_sim_t *s, uint64_t end_ns) {
+    uint64_t t0 = l2_sim_now_ns();
+    cq_event_t *e;
+
+    while ((e = cq_pop(&s->cq))) {
+        uint64_t now = e->time;
+        if (now > end_ns) {
+            // Leave it for the next run
+            cq_insert(&s->cq, e, now);
+            break;
+        }
+        s->events++;
+        switch (e->kind) {
+        case L2_SIM_EV_SLOT:
+            l2_sim_slot(s, e->arg, now);
+            break;
+        case L2_SIM_EV_ARRIVAL:
+            l2_sim_arrival(s, e->arg >> 1, (int)(e->arg & 1), now);
+            break;
+        case L2_SIM_EV_HARQ_FB:
+            l2_sim_harq_fb(s, e, now);
+            break;
+        }
+    }
+    if (end_ns > s->sim_ns) s->sim_ns = end_ns;
+    s->wall_ns += l2_sim_now_ns() - t0;
+}
+
+/*----------------------------------------------------------------------------
+ * Setup
+ *--------------------------------------------------------------------------*/
+
+static int l2_sim_cfg_check(const l2_sim_cfg_t *c) {
+    size_t plen = strlen(c->pattern);
+    if (!plen || strspn(c->pattern, "DUSF") != plen) return -1;
+    if (c->mu > L2_SIM_MAX_MU || !c->n_cells || !c->ues_per_cell) return -1;
+    if (c->ues_per_cell > HARQ_NO_UE - L2_SIM_RNTI_BASE - 16) return -1;
+    if (!c->n_prb || c->n_prb > 275 || !c->ues_per_slot || !c->k1) return -1;
+    if (!(c->se_min > 0) || c->se_max < c->se_min) return -1;
+    if (c->bler < 0 || c->bler > 1 || c->bler_bad < 0 || c->bler_bad > 1) return -1;
+    if (c->sdu_bytes < L2_SIM_MIN_FIRST_SEG || c->sdu_bytes > 9000 || !c->queue_sdus) return -1;
+    if (c->mbps[0] < 0 || c->mbps[1] < 0) return -1;
+    return 0;
+}
+
+static int l2_sim_ue_init(l2_sim_t *s, uint32_t idx) {
+    l2_sim_ue_t *ue = &s->ues[idx];
+    const l2_sim_cfg_t *cfg = &s->cfg;
+
+    ue->cell = (uint16_t)(idx / cfg->ues_per_cell);
+    ue->rnti = (uint16_t)(L2_SIM_RNTI_BASE + idx % cfg->ues_per_cell);
+    ue->se = cfg->se_min + l2_sim_uniform(s) * (cfg->se_max - cfg->se_min);
+
+    for (int d = 0; d < 2; d++) {
+        l2_sim_bearer_t *b = &ue->b[d];
+        uint64_t limit = (uint64_t)cfg->queue_sdus * cfg->sdu_bytes;
+
+        b->cur = L2_BUF_NONE;
+        if (sdu_queue_init(&b->q, &s->sdu_pool, cfg->queue_sdus, limit, limit, limit / 2, 0, 0) < 0)
+            return -1;
+        bs_ue_init(&b->bs);
+        bs_lc_config(&b->bs, L2_SIM_LCID_DRB, 1, 18, 0, s->rlc);
+        lcp_ue_init(&b->lcp);
+        lcp_config_lc(&b->lcp, L2_SIM_LCID_DRB, 1, LCP_PBR_INFINITY, 1000, (uint32_t)(s->slot_ns / 1000));
+        if (rlc_entity_init(&b->rx, RLC_MODE_UM, 12) < 0) return -1;
+        if (harq_ue_add(&s->cells[ue->cell].harq[d], ue->rnti) < 0) return -1;
+
+        for (int p = 0; p < HARQ_NUM_PROCESSES; p++) cq_event_init(&ue->harq_fb[d][p], L2_SIM_EV_HARQ_FB, idx);
+        cq_event_init(&b->arrival, L2_SIM_EV_ARRIVAL, idx << 1 | (uint32_t)d);
+        // First arrival at a random phase, so UEs do not arrive in lockstep
+        if (s->arrival_ns[d] > 0)
+            cq_insert(&s->cq, &b->arrival, (uint64_t)(l2_sim_uniform(s) * s->arrival_ns[d]));
+    }
+    return 0;
+}
+
+int l2_sim_init(l2_sim_t *s, const l2_sim_cfg_t *cfg) {
+    memset(s, 0, sizeof(*s));
+    if (l2_sim_cfg_check(cfg) < 0) {
+        fprintf(stderr, " invalid simulator configuration.\n");
+        return -1;
+    }
+    s->cfg = *cfg;
+    s->slot_ns = 1000000ull >> cfg->mu;
+    s->pattern_len = (uint32_t)strlen(cfg->pattern);
+    s->n_ues = cfg->n_cells * cfg->ues_per_cell;
+    s->rlc = rlc_entity_ops_get(RLC_MODE_UM, 12);
+
+    uint64_t z = cfg->seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    s->rng = (z ^ (z >> 31)) | 1;
+
+    for (int d = 0; d < 2; d++) {
+        // bits / Mbps = us per SDU
+        if (cfg->mbps[d] > 0) s->arrival_ns[d] = cfg->sdu_bytes * 8.0 * 1000.0 / cfg->mbps[d];
+        if (hdr_hist_init(&s->latency[d], 7) < 0) goto fail;
+    }
+
+    // Largest TB: every PRB at the best spectral efficiency
+    uint32_t tb_max = (uint32_t)(cfg->n_prb * 12.0 * L2_SIM_DATA_SYMBOLS * cfg->se_max / 8.0) + 64;
+    if (tb_max > UINT16_MAX) tb_max = UINT16_MAX;
+    uint32_t n_tb = cfg->n_cells * 2 * cfg->ues_per_slot * (cfg->k1 + 2u) * (cfg->max_retx + 1u);
+    uint32_t n_sdu = s->n_ues * 2 * (cfg->queue_sdus + 1);
+
+    if (cq_init(&s->cq, s->slot_ns, 0) < 0) goto fail;
+    if (l2_pool_init(&s->sdu_pool, n_sdu, cfg->sdu_bytes) < 0) goto fail;
+    if (l2_pool_init(&s->tb_pool, n_tb, tb_max) < 0) goto fail;
+
+    s->cells = calloc(cfg->n_cells, sizeof(*s->cells));
+    s->ues = calloc(s->n_ues, sizeof(*s->ues));
+    if (!s->cells || !s->ues) goto fail;
+
+    for (uint32_t c = 0; c < cfg->n_cells; c++) {
+        l2_sim_cell_t *cell = &s->cells[c];
+        uint32_t n_retx = 1;
+        while (n_retx < cfg->ues_per_cell * HARQ_NUM_PROCESSES) n_retx <<= 1;
+        cell->retx_mask = n_retx - 1;
+        for (int d = 0; d < 2; d++) {
+            cell->retx[d] = malloc(n_retx * sizeof(*cell->retx[d]));
+            if (!cell->retx[d] || l2_sim_ring_init(&cell->active[d], cfg->ues_per_cell) < 0) goto fail;
+            if (harq_mgr_init(&cell->harq[d], &s->tb_pool, (uint16_t)cfg->ues_per_cell, 1, cfg->max_retx) < 0)
+                goto fail;
+        }
+        cq_event_init(&cell->slot_ev, L2_SIM_EV_SLOT, c);
+        cq_insert(&s->cq, &cell->slot_ev, 0);
+    }
+
+    for (uint32_t i = 0; i < s->n_ues; i++)
+        if (l2_sim_ue_init(s, i) < 0) goto fail;
+    return 0;
+
+fail:
+    fprintf(stderr, " simulator setup failed (%u UEs).\n", s->n_ues);
+    l2_sim_destroy(s);
+    return -1;
+}
+
+void l2_sim_destroy(l2_sim_t *s) {
+    if (s->ues) {
+        for (uint32_t i = 0; i < s->n_ues; i++) {
+            for (int d = 0; d < 2; d++) {
+                l2_sim_bearer_t *b = &s->ues[i].b[d];
+                if (b->q.ring) sdu_queue_destroy(&b->q);
+                if (b->rx.ops) rlc_entity_destroy(&b->rx);
+            }
+        }
+    }
+    if (s->cells) {
+        for (uint32_t c = 0; c < s->cfg.n_cells; c++) {
+            for (int d = 0; d < 2; d++) {
+                if (s->cells[c].harq[d].rnti_map) harq_mgr_destroy(&s->cells[c].harq[d]);
+                free(s->cells[c].retx[d]);
+                free(s->cells[c].active[d].v);
+            }
+        }
+    }
+    free(s->ues);
+    free(s->cells);
+    if (s->tb_pool.mem) l2_pool_destroy(&s->tb_pool);
+    if (s->sdu_pool.mem) l2_pool_destroy(&s->sdu_pool);
+    if (s->cq.buckets) cq_destroy(&s->cq);
+    for (int d = 0; d < 2; d++)
+        if (s->latency[d].counts) hdr_hist_free(&s->latency[d]);
+    memset(s, 0, sizeof(*s));
+}
+
+/*----------------------------------------------------------------------------
+ * Report
+ *--------------------------------------------------------------------------*/
+
+void l2_sim_report(FILE *out, const l2_sim_t *s) {
+    static const char *const dir_name[2] = { "DL", "UL" };
+    const l2_sim_cfg_t *c = &s->cfg;
+    double sim_s = (double)s->sim_ns / 1e9, wall_s = (double)s->wall_ns / 1e9;
+
+    fprintf(out, "=== L2 Slot Simulator ===\n");
+    fprintf(out, "  mu %u (%u kHz, %llu us slots), pattern %s, %u cell(s) x %u UE(s), %u PRBs\n",
+            c->mu, 15u << c->mu, (unsigned long long)(s->slot_ns / 1000), c->pattern, c->n_cells,
+            c->ues_per_cell, c->n_prb);
+    fprintf(out, "  simulated %.3f s in %.3f s: %.2fx real time\n", sim_s, wall_s,
+            wall_s > 0 ? sim_s / wall_s : 0.0);
+    fprintf(out, "  %llu event(s), %.2f M events/s, calendar queue %u buckets of %llu ns, "
+                 "%llu resize(s), %llu direct search(es)\n",
+            (unsigned long long)s->events, wall_s > 0 ? (double)s->events / wall_s / 1e6 : 0.0,
+            s->cq.n_buckets, 1ull << s->cq.shift, (unsigned long long)s->cq.resizes,
+            (unsigned long long)s->cq.direct_searches);
+
+    for (int d = 0; d < 2; d++) {
+        const l2_sim_dir_stats_t *st = &s->st[d];
+        const harq_mgr_t *m;
+        uint64_t tail = 0, codel = 0, acks = 0, nacks = 0, drops = 0;
+
+        for (uint32_t i = 0; i < s->n_ues; i++) {
+            tail += s->ues[i].b[d].q.stats.tail_drops;
+            codel += s->ues[i].b[d].q.stats.codel_drops;
+        }
+        for (uint32_t i = 0; i < c->n_cells; i++) {
+            m = &s->cells[i].harq[d];
+            acks += m->acks;
+            nacks += m->nacks;
+            drops += m->drops;
+        }
+
+        fprintf(out, "  %s: offered %.1f Mbps (%llu SDUs), delivered %.1f Mbps (%llu SDUs, %llu out of order)\n",
+                dir_name[d], sim_s > 0 ? (double)st->bytes_offered * 8 / sim_s / 1e6 : 0.0,
+                (unsigned long long)st->sdus_offered,
+                sim_s > 0 ? (double)st->bytes_delivered * 8 / sim_s / 1e6 : 0.0,
+                (unsigned long long)st->sdus_delivered, (unsigned long long)st->out_of_order);
+        fprintf(out, "      drops: %llu tail, %llu CoDel, %llu no buffer; %llu HARQ failure(s)\n",
+                (unsigned long long)tail, (unsigned long long)codel, (unsigned long long)st->pool_drops,
+                (unsigned long long)drops);
+        fprintf(out, "      %llu slot(s), PRB use %.1f%%, %llu new + %llu retx TB(s), padding %.1f%%, "
+                     "HARQ %llu ACK / %llu NACK, %llu stall(s), %llu TB buffer shortage(s)\n",
+                (unsigned long long)st->slots,
+                st->prbs_avail ? 100.0 * (double)st->prbs_used / (double)st->prbs_avail : 0.0,
+                (unsigned long long)st->tbs_new, (unsigned long long)st->tbs_retx,
+                st->tb_bytes ? 100.0 * (double)st->padding_bytes / (double)st->tb_bytes : 0.0,
+                (unsigned long long)acks, (unsigned long long)nacks, (unsigned long long)st->harq_stall,
+                (unsigned long long)st->tb_alloc_fail);
+        hdr_hist_print(out, d == MAC_DIR_DL ? "DL latency (us)" : "UL latency (us)", &s->latency[d]);
+    }
+}
@@ -0,0 +1,208 @@
+// l2_sim.h
+#ifndef _L2_SIM_H_
+#define _L2_SIM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "cal_queue.h"
+#include "l2_pool.h"
+#include "sdu_queue.h"
+#include "buf_status.h"
+#include "lcp.h"
+#include "harq.h"
+#include "rlc_entity.h"
+#include "hdr_hist.h"
+
+/*============================================================================
+ * DISCRETE-EVENT SLOT SIMULATOR FOR THE L2 STACK
+ * Reference: 3GPP TS 38.211 Section 4.2, 4.3 (numerology, slots)
+ *            TS 38.213 Section 11.1 (TDD slot configuration)
+ *==========================================================================*/
+
+/**
+ * L2 slot simulator
+ *
+ * Description:
+ * Runs cells and UEs in simulated time for capacity planning. All state
+ * changes are events on one calendar queue (cal_queue.h): per-cell slot
+ * ticks, per-UE SDU arrivals and HARQ feedback. Nothing waits for the
+ * wall clock, so simulated time advances as fast as the events can be
+ * processed, and a run is fully determined by its configuration and seed.
+ *
+ * Each UE has one DRB (LCID 4) per direction, carried end to end through
+ * the real data path code:
+ *
+ *   arrival:   PDCP 18-bit + SDAP header written into a pool buffer,
+ *              sdu_queue (tail drop, CoDel), buf_status update
+ *   slot:      per cell and direction, pending HARQ retransmissions
+ *              first, then new TBs for up to ues_per_slot backlogged UEs
+ *              in round-robin order, PRBs shared equally; the TB is
+ *              filled by lcp_build_tb() with RLC UM 12-bit PDUs
+ *              (segmenting as needed, plus a BSR in UL) and handed to
+ *              the HARQ manager
+ *   feedback:  k1 slots later the channel model decides ACK / NACK; an
+ *              ACKed TB is demultiplexed (mac_pdu_demux), received by the
+ *              peer's RLC entity, reassembled, and each SDU's latency from
+ *              arrival is recorded
+ *
+ * The TDD pattern repeats per slot: D (downlink), U (uplink), S (special,
+ * downlink on 8 of 12 data symbols) or F (both directions, FDD). The TB
+ * size is n_prb x 12 subcarriers x data symbols x the UE's spectral
+ * efficiency, drawn per UE from [se_min, se_max] bits per RE.
+ *
+ * Channel loss per transmission is either i.i.d. with probability bler,
+ * or a two-state Gilbert-Elliott chain per UE (good -> bad with p_gb,
+ * bad -> good with p_bg, BLER bler in good and bler_bad in bad), which
+ * produces the loss bursts that exhaust HARQ.
+ *
+ * Simplifications: the gNB sees UL buffer status without BSR delay; UL
+ * grants need no PDCCH; there is no RLC ARQ (TBs past max_retx are lost).
+ */
+#define L2_SIM_LCID_DRB       4
+#define L2_SIM_RNTI_BASE      0x4601
+#define L2_SIM_MAX_MU         4
+#define L2_SIM_MAX_PATTERN    20
+#define L2_SIM_SEG_SLOTS      64        // UM reassemblies in progress per bearer
+#define L2_SIM_MIN_FIRST_SEG  16        // First segment carries PDCP + SDAP + timestamp
+#define L2_SIM_DATA_SYMBOLS   12        // PDSCH / PUSCH symbols per slot (14 - DMRS)
+#define L2_SIM_S_SYMBOLS      8         // Downlink data symbols of a special slot
+
+typedef enum l2_sim_chan {
+    L2_SIM_CHAN_BLER = 0,      // i.i.d. loss
+    L2_SIM_CHAN_GE   = 1,      // Gilbert-Elliott
+} l2_sim_chan_t;
+
+typedef enum l2_sim_traffic {
+    L2_SIM_TRAFFIC_POISSON = 0,
+    L2_SIM_TRAFFIC_CBR     = 1,
+} l2_sim_traffic_t;
+
+typedef struct l2_sim_cfg {
+    uint8_t  mu;                       // Numerology: 15 x 2^mu kHz, 1 ms >> mu slots
+    char     pattern[L2_SIM_MAX_PATTERN + 1];
+    uint32_t n_cells;
+    uint32_t ues_per_cell;
+    uint16_t n_prb;
+    uint8_t  ues_per_slot;             // New TBs per slot, cell and direction
+    uint8_t  k1;                       // Slots from transmission to HARQ feedback
+    uint8_t  max_retx;
+    double   se_min, se_max;           // Spectral efficiency, bits per RE
+
+    l2_sim_chan_t chan;
+    double   bler;                     // BLER (Gilbert-Elliott: good state)
+    double   bler_bad;
+    double   p_gb, p_bg;
+
+    l2_sim_traffic_t traffic;
+    double   mbps[2];                  // Offered load per UE, [mac_dir_t]
+    uint16_t sdu_bytes;                // PDCP PDU size
+    uint32_t queue_sdus;               // SDU queue limit per bearer
+    uint64_t seed;
+} l2_sim_cfg_t;
+
+// Defaults: 30 kHz, DDDSU, 20 cells x 50 UEs, 106 PRBs (40 MHz)
+void l2_sim_cfg_default(l2_sim_cfg_t *cfg);
+
+typedef struct l2_sim_rx_seg {
+    uint32_t sn;
+    uint32_t got;              // Bytes received
+    uint32_t total;            // SDU length, known once the last segment arrived
+    uint32_t pdcp_sn;
+    uint64_t ts_ns;            // Arrival time, from the first segment
+    uint8_t  used;
+    uint8_t  have_first;
+} l2_sim_rx_seg_t;
+
+// One direction of a UE's DRB: transmitter and the peer's receiver
+typedef struct l2_sim_bearer {
+    // Transmitter
+    sdu_queue_t q;
+    bs_ue_t bs;
+    lcp_ue_t lcp;
+    l2_buf_ref_t cur;          // SDU being segmented, L2_BUF_NONE if none
+    uint32_t cur_len;          // Bytes left
+    uint32_t cur_off;
+    uint32_t tx_sn;            // RLC TX_Next
+    uint32_t pdcp_tx_next;
+    uint64_t lcp_slot;         // Cell slot of the last lcp_tick()
+    cq_event_t arrival;
+    uint8_t  active;           // In the cell's round-robin ring
+
+    // Receiver
+    rlc_entity_t rx;
+    uint32_t pdcp_rx_next;
+    l2_sim_rx_seg_t seg[L2_SIM_SEG_SLOTS];
+} l2_sim_bearer_t;
+
+typedef struct l2_sim_ue {
+    l2_sim_bearer_t b[2];                      // [mac_dir_t]
+    cq_event_t harq_fb[2][HARQ_NUM_PROCESSES];
+    double   se;
+    uint16_t rnti;
+    uint16_t cell;
+    uint8_t  ge_bad;                           // Gilbert-Elliott state
+} l2_sim_ue_t;
+
+typedef struct l2_sim_ring {
+    uint32_t *v;
+    uint32_t mask;
+    uint32_t head, tail;
+} l2_sim_ring_t;
+
+typedef struct l2_sim_cell {
+    harq_mgr_t harq[2];
+    l2_sim_ring_t active[2];                   // Backlogged UEs (global index)
+    harq_retx_t *retx[2];                      // Retransmissions due
+    uint32_t retx_mask;
+    uint32_t retx_head[2], retx_tail[2];
+    cq_event_t slot_ev;
+    uint64_t slot;
+} l2_sim_cell_t;
+
+typedef struct l2_sim_dir_stats {
+    uint64_t sdus_offered, bytes_offered;
+    uint64_t pool_drops;                       // No SDU buffer
+    uint64_t sdus_delivered, bytes_delivered;
+    uint64_t out_of_order;                     // PDCP SN behind the expected one
+    uint64_t slots;                            // Slots carrying this direction
+    uint64_t prbs_avail, prbs_used;
+    uint64_t tbs_new, tbs_retx;
+    uint64_t tb_bytes, padding_bytes;
+    uint64_t tb_alloc_fail;
+    uint64_t harq_stall;                       // UE skipped, all 16 processes busy
+} l2_sim_dir_stats_t;
+
+typedef struct l2_sim {
+    l2_sim_cfg_t cfg;
+    uint64_t slot_ns;
+    uint32_t pattern_len;
+    uint32_t n_ues;
+    uint64_t rng;
+    double   arrival_ns[2];                    // Mean SDU interarrival per UE
+
+    cal_queue_t cq;
+    l2_buf_pool_t sdu_pool;
+    l2_buf_pool_t tb_pool;
+    l2_sim_cell_t *cells;
+    l2_sim_ue_t *ues;
+    const rlc_entity_ops_t *rlc;
+
+    uint64_t events;
+    uint64_t sim_ns;                           // Simulated time run so far
+    uint64_t wall_ns;
+    l2_sim_dir_stats_t st[2];
+    hdr_hist_t latency[2];                     // SDU arrival -> delivery, us
+} l2_sim_t;
+
+// Returns 0, -1 on a bad configuration or allocation failure
+int  l2_sim_init(l2_sim_t *s, const l2_sim_cfg_t *cfg);
+void l2_sim_destroy(l2_sim_t *s);
+
+// Process events until simulated time reaches end_ns
+void l2_sim_run(l2_sim_t *s, uint64_t end_ns);
+
+void l2_sim_report(FILE *out, const l2_sim_t *s);
+
+#endif
@@ -0,0 +1,218 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "l2_stats.h"
+
+_Static_assert(sizeof(l2_stats_region_t) % L2_STATS_CACHELINE == 0, "region header padding");
+_Static_assert(sizeof(l2_stats_core_t) % L2_STATS_CACHELINE == 0, "core block padding");
+
+static size_t l2_stats_region_size(uint32_t n_cores) {
+    return sizeof(l2_stats_region_t) + (size_t)n_cores * sizeof(l2_stats_core_t);
+}
+
+int l2_stats_create(l2_stats_shm_t *s, const char *name, uint32_t n_cores) {
+    memset(s, 0, sizeof(*s));
+    if (!n_cores || n_cores > L2_STATS_MAX_CORES) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // A fresh object every run: exporters holding the old one see it unlinked
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    size_t size = l2_stats_region_size(n_cores);
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name);
+        return -1;
+    }
+
+    // ftruncate zero-filled the counters; publish the header last
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    l2_stats_region_t *r = p;
+    r->version = L2_STATS_VERSION;
+    r->n_cores = n_cores;
+    r->core_bytes = sizeof(l2_stats_core_t);
+    r->region_bytes = size;
+    r->start_unix_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    r->owner_pid = (int32_t)getpid();
+    atomic_thread_fence(memory_order_release);
+    r->magic = L2_STATS_MAGIC;
+
+    s->region = r;
+    s->size = size;
+    s->writable = 1;
+    return 0;
+}
+
+int l2_stats_open(l2_stats_shm_t *s, const char *name) {
+    memset(s, 0, sizeof(*s));
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(l2_stats_region_t)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -1;
+
+    const l2_stats_region_t *r = p;
+    if (r->magic != L2_STATS_MAGIC || r->version != L2_STATS_VERSION ||
+        r->core_bytes != sizeof(l2_stats_core_t) || r->n_cores > L2_STATS_MAX_CORES ||
+        l2_stats_region_size(r->n_cores) > (size_t)st.st_size) {
+        munmap(p, (size_t)st.st_size);
+        errno = EPROTO;
+        return -1;
+    }
+
+    s->region = p;
+    s->size = (size_t)st.st_size;
+    return 0;
+}
+
+void l2_stats_close(l2_stats_shm_t *s) {
+    if (s->region) munmap(s->region, s->size);
+    memset(s, 0, sizeof(*s));
+}
+
+int l2_stats_unlink(const char *name) {
+    return shm_unlink(name);
+}
+
+/*----------------------------------------------------------------------------
+ * Aggregation
+ *--------------------------------------------------------------------------*/
+
+// Sum n counters of every core into out
+static void l2_stats_sum(const l2_stats_shm_t *s, size_t offset, size_t n, uint64_t *out) {
+    for (uint32_t core = 0; core < s->region->n_cores; core++) {
+        const _Atomic uint64_t *c =
+            (const _Atomic uint64_t *)((const uint8_t *)l2_stats_core(s, core) + offset);
+        for (size_t i = 0; i < n; i++) out[i] += atomic_load_explicit(&c[i], memory_order_relaxed);
+    }
+}
+
+#define L2_STATS_SUM(s, out, field) \
+    l2_stats_sum(s, offsetof(l2_stats_core_t, field), \
+                 sizeof((out)->field) / sizeof(uint64_t), (uint64_t *)(out)->field)
+
+void l2_stats_aggregate(const l2_stats_shm_t *s, l2_stats_snapshot_t *out) {
+    memset(out, 0, sizeof(*out));
+    L2_STATS_SUM(s, out, pdus);
+    L2_STATS_SUM(s, out, bytes);
+    L2_STATS_SUM(s, out, lcid_bytes);
+    L2_STATS_SUM(s, out, ctr);
+    L2_STATS_SUM(s, out, rrc_decode_err);
+    L2_STATS_SUM(s, out, hist);
+    L2_STATS_SUM(s, out, hist_sum);
+}
+
+/*----------------------------------------------------------------------------
+ * Export
+ *--------------------------------------------------------------------------*/
+
+static const char *const layer_names[L2_STATS_LAYER_COUNT] = { "sdap", "pdcp", "rlc", "mac" };
+static const char *const dir_names[L2_STATS_DIR_COUNT] = { "ul", "dl" };
+
+static const char *const ctr_names[L2_CTR_COUNT] = {
+    [L2_CTR_RLC_REASM_FAIL]      = "rlc_reassembly_failures",
+    [L2_CTR_RLC_NACK_RX]         = "rlc_nack_received",
+    [L2_CTR_RLC_NACK_TX]         = "rlc_nack_sent",
+    [L2_CTR_RLC_RETX]            = "rlc_retransmissions",
+    [L2_CTR_RLC_DUPLICATE]       = "rlc_duplicates",
+    [L2_CTR_PDCP_DISCARD]        = "pdcp_discards",
+    [L2_CTR_PDCP_INTEGRITY_FAIL] = "pdcp_integrity_failures",
+    [L2_CTR_CRYPTO_CIPHER]       = "crypto_cipher_ops",
+    [L2_CTR_CRYPTO_DECIPHER]     = "crypto_decipher_ops",
+    [L2_CTR_CRYPTO_INTEGRITY]    = "crypto_integrity_ops",
+    [L2_CTR_MAC_HARQ_NACK]       = "mac_harq_nacks",
+    [L2_CTR_MAC_BAD_SUBHDR]      = "mac_bad_subheaders",
+    [L2_CTR_SDU_QUEUE_DROP]      = "sdu_queue_drops",
+    [L2_CTR_CAPTURE_DROP]        = "capture_drops",
+};
+
+static const char *const hist_names[L2_HIST_COUNT] = {
+    [L2_HIST_PDU_BYTES]  = "mac_pdu_bytes",
+    [L2_HIST_SLOT_NS]    = "slot_processing_ns",
+    [L2_HIST_SOJOURN_NS] = "sdu_sojourn_ns",
+};
+
+const char *l2_stats_layer_name(l2_stats_layer_t layer) {
+    return (unsigned)layer < L2_STATS_LAYER_COUNT ? layer_names[layer] : "unknown";
+}
+
+const char *l2_stats_ctr_name(l2_stats_ctr_t ctr) {
+    return (unsigned)ctr < L2_CTR_COUNT ? ctr_names[ctr] : "unknown";
+}
+
+const char *l2_stats_hist_name(l2_stats_hist_t h) {
+    return (unsigned)h < L2_HIST_COUNT ? hist_names[h] : "unknown";
+}
+
+void l2_stats_write_prometheus(FILE *out, const l2_stats_snapshot_t *snap) {
+    fprintf(out, "# TYPE l2_pdus_total counter\n");
+    for (int l = 0; l < L2_STATS_LAYER_COUNT; l++)
+        for (int d = 0; d < L2_STATS_DIR_COUNT; d++)
+            fprintf(out, "l2_pdus_total{layer=\"%s\",dir=\"%s\"} %llu\n", layer_names[l],
+                    dir_names[d], (unsigned long long)snap->pdus[l][d]);
+
+    fprintf(out, "# TYPE l2_bytes_total counter\n");
+    for (int l = 0; l < L2_STATS_LAYER_COUNT; l++)
+        for (int d = 0; d < L2_STATS_DIR_COUNT; d++)
+            fprintf(out, "l2_bytes_total{layer=\"%s\",dir=\"%s\"} %llu\n", layer_names[l],
+                    dir_names[d], (unsigned long long)snap->bytes[l][d]);
+
+    fprintf(out, "# TYPE l2_lcid_bytes_total counter\n");
+    for (int i = 0; i < L2_STATS_NUM_LCID; i++)
+        for (int d = 0; d < L2_STATS_DIR_COUNT; d++)
+            if (snap->lcid_bytes[i][d])
+                fprintf(out, "l2_lcid_bytes_total{lcid=\"%d\",dir=\"%s\"} %llu\n", i, dir_names[d],
+                        (unsigned long long)snap->lcid_bytes[i][d]);
+
+    for (int c = 0; c < L2_CTR_COUNT; c++)
+        fprintf(out, "# TYPE l2_%s_total counter\nl2_%s_total %llu\n", ctr_names[c], ctr_names[c],
+                (unsigned long long)snap->ctr[c]);
+
+    fprintf(out, "# TYPE l2_rrc_decode_errors_total counter\n");
+    for (int ch = 0; ch < L2_STATS_RRC_CHANNELS; ch++)
+        for (int m = 0; m < L2_STATS_RRC_MSG_TYPES; m++)
+            if (snap->rrc_decode_err[ch][m])
+                fprintf(out, "l2_rrc_decode_errors_total{channel=\"%d\",msg_type=\"%d\"} %llu\n",
+                        ch, m, (unsigned long long)snap->rrc_decode_err[ch][m]);
+
+    // Power-of-two buckets map onto cumulative le="2^b - 1" buckets. Every
+    // bucket is written, empty or not: the bucket set of a series must not
+    // change between scrapes, or histogram_quantile() mixes layouts.
+    for (int h = 0; h < L2_HIST_COUNT; h++) {
+        uint64_t cum = 0;
+        fprintf(out, "# TYPE l2_%s histogram\n", hist_names[h]);
+        for (int b = 0; b < L2_STATS_HIST_BUCKETS - 1; b++) {
+            cum += snap->hist[h][b];
+            fprintf(out, "l2_%s_bucket{le=\"%llu\"} %llu\n", hist_names[h],
+                    (unsigned long long)(b ? (1ull << b) - 1 : 0), (unsigned long long)cum);
+        }
+        cum += snap->hist[h][L2_STATS_HIST_BUCKETS - 1];
+        fprintf(out, "l2_%s_bucket{le=\"+Inf\"} %llu\n", hist_names[h], (unsigned long long)cum);
+        fprintf(out, "l2_%s_sum %llu\nl2_%s_count %llu\n", hist_names[h],
+                (unsigned long long)snap->hist_sum[h], hist_names[h], (unsigned long long)cum);
+    }
+}
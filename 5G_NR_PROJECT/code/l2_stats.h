@@ -0,0 +1,195 @@
+// l2_stats.h
+#ifndef _L2_STATS_H_
+#define _L2_STATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "rrc_channel.h"
+
+/*============================================================================
+ * PER-CORE L2 STATISTICS IN SHARED MEMORY
+ *==========================================================================*/
+
+/**
+ * L2 statistics region
+ *
+ * Description:
+ * Every worker core owns one cache-line aligned l2_stats_core_t block and
+ * is its only writer. Updates are relaxed load + store pairs on that block
+ * (no lock prefix, no shared lines), so counting costs about as much as a
+ * plain increment.
+ *
+ * The blocks live in a POSIX shared-memory object created by the data
+ * path process. An exporter in another process maps it read-only and sums
+ * the blocks whenever it is scraped; nothing is aggregated on the data
+ * path. 64-bit loads of an aligned counter never tear, so the exporter
+ * reads consistent per-counter values without any handshake; counters of
+ * one block may be a few updates apart, which monitoring tolerates.
+ *
+ * Layout (all offsets multiples of L2_STATS_CACHELINE):
+ * +--------------------+-------------------+-------------------+-----+
+ * | l2_stats_region_t  | l2_stats_core_t 0 | l2_stats_core_t 1 | ... |
+ * +--------------------+-------------------+-------------------+-----+
+ */
+#define L2_STATS_MAGIC         0x5453324Cu   // "L2ST"
+#define L2_STATS_VERSION       3
+#define L2_STATS_CACHELINE     64
+#define L2_STATS_MAX_CORES     256
+#define L2_STATS_DEFAULT_NAME  "/l2-stats"
+
+#define L2_STATS_NUM_LCID      33            // LCID 0..32 (TS 38.321 Table 6.2.1-1)
+#define L2_STATS_RRC_CHANNELS  RRC_CHANNEL_COUNT
+#define L2_STATS_RRC_MSG_TYPES 16            // c1 "present" values
+#define L2_STATS_HIST_BUCKETS  65            // Bucket b: 2^(b-1) <= v < 2^b, bucket 0: v = 0
+
+typedef enum l2_stats_layer {
+    L2_STATS_SDAP = 0,
+    L2_STATS_PDCP,
+    L2_STATS_RLC,
+    L2_STATS_MAC,
+    L2_STATS_LAYER_COUNT
+} l2_stats_layer_t;
+
+typedef enum l2_stats_dir {
+    L2_STATS_UL = 0,
+    L2_STATS_DL,
+    L2_STATS_DIR_COUNT
+} l2_stats_dir_t;
+
+typedef enum l2_stats_ctr {
+    L2_CTR_RLC_REASM_FAIL = 0,     // SDU reassembly abandoned (t-Reassembly, bad SO)
+    L2_CTR_RLC_NACK_RX,            // NACK_SNs received in STATUS PDUs
+    L2_CTR_RLC_NACK_TX,            // NACK_SNs sent in STATUS PDUs
+    L2_CTR_RLC_RETX,               // AMD PDUs retransmitted
+    L2_CTR_RLC_DUPLICATE,          // Received PDUs already in the window
+    L2_CTR_PDCP_DISCARD,           // discardTimer expiries
+    L2_CTR_PDCP_INTEGRITY_FAIL,    // MAC-I mismatches
+    L2_CTR_CRYPTO_CIPHER,          // Ciphering operations
+    L2_CTR_CRYPTO_DECIPHER,        // Deciphering operations
+    L2_CTR_CRYPTO_INTEGRITY,       // MAC-I computations (protect + verify)
+    L2_CTR_MAC_HARQ_NACK,          // HARQ NACKs
+    L2_CTR_MAC_BAD_SUBHDR,         // Undecodable MAC subheaders
+    L2_CTR_SDU_QUEUE_DROP,         // Tail and CoDel drops
+    L2_CTR_CAPTURE_DROP,           // pcap records dropped on writer backpressure
+    L2_CTR_COUNT
+} l2_stats_ctr_t;
+
+typedef enum l2_stats_hist {
+    L2_HIST_PDU_BYTES = 0,         // MAC PDU sizes
+    L2_HIST_SLOT_NS,               // Per-slot processing time
+    L2_HIST_SOJOURN_NS,            // SDU queue sojourn
+    L2_HIST_COUNT
+} l2_stats_hist_t;
+
+typedef struct l2_stats_region {
+    uint32_t magic;                // L2_STATS_MAGIC, written last on create
+    uint32_t version;              // L2_STATS_VERSION
+    uint32_t n_cores;
+    uint32_t core_bytes;           // sizeof(l2_stats_core_t)
+    uint64_t region_bytes;
+    uint64_t start_unix_ns;
+    int32_t  owner_pid;
+} __attribute__((aligned(L2_STATS_CACHELINE))) l2_stats_region_t;
+
+typedef struct l2_stats_core {
+    _Atomic uint64_t pdus[L2_STATS_LAYER_COUNT][L2_STATS_DIR_COUNT];
+    _Atomic uint64_t bytes[L2_STATS_LAYER_COUNT][L2_STATS_DIR_COUNT];
+    _Atomic uint64_t lcid_bytes[L2_STATS_NUM_LCID][L2_STATS_DIR_COUNT];
+    _Atomic uint64_t ctr[L2_CTR_COUNT];
+    _Atomic uint64_t rrc_decode_err[L2_STATS_RRC_CHANNELS][L2_STATS_RRC_MSG_TYPES];
+    _Atomic uint64_t hist[L2_HIST_COUNT][L2_STATS_HIST_BUCKETS];
+    _Atomic uint64_t hist_sum[L2_HIST_COUNT];
+} __attribute__((aligned(L2_STATS_CACHELINE))) l2_stats_core_t;
+
+// Mapping handle; writers and readers each hold one
+typedef struct l2_stats_shm {
+    l2_stats_region_t *region;
+    size_t size;
+    int writable;
+} l2_stats_shm_t;
+
+/**
+ * Data path side: create (or replace) the shared-memory object name with
+ * n_cores zeroed blocks. The object is mode 0644 so exporters can only
+ * open it read-only. Returns 0, -1 with errno set.
+ */
+int l2_stats_create(l2_stats_shm_t *s, const char *name, uint32_t n_cores);
+
+// Exporter side: map an existing object read-only and validate its header
+int l2_stats_open(l2_stats_shm_t *s, const char *name);
+
+void l2_stats_close(l2_stats_shm_t *s);
+int  l2_stats_unlink(const char *name);
+
+static inline l2_stats_core_t *l2_stats_core(const l2_stats_shm_t *s, uint32_t core) {
+    return (l2_stats_core_t *)(s->region + 1) + core;
+}
+
+/*----------------------------------------------------------------------------
+ * Data path updates (owning core only)
+ *--------------------------------------------------------------------------*/
+
+static inline void l2_stats_add(_Atomic uint64_t *c, uint64_t v) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v,
+                          memory_order_relaxed);
+}
+
+static inline void l2_stats_inc(l2_stats_core_t *c, l2_stats_ctr_t ctr) {
+    l2_stats_add(&c->ctr[ctr], 1);
+}
+
+static inline void l2_stats_pdu(l2_stats_core_t *c, l2_stats_layer_t layer, l2_stats_dir_t dir,
+                                uint32_t bytes) {
+    l2_stats_add(&c->pdus[layer][dir], 1);
+    l2_stats_add(&c->bytes[layer][dir], bytes);
+}
+
+static inline void l2_stats_lcid(l2_stats_core_t *c, uint8_t lcid, l2_stats_dir_t dir,
+                                 uint32_t bytes) {
+    if (lcid < L2_STATS_NUM_LCID) l2_stats_add(&c->lcid_bytes[lcid][dir], bytes);
+}
+
+// channel: rrc_channel_t, msg_type: rrc_summarize() msg_type (0 if unknown)
+static inline void l2_stats_rrc_error(l2_stats_core_t *c, uint8_t channel, uint8_t msg_type) {
+    if (channel >= L2_STATS_RRC_CHANNELS) return;
+    if (msg_type >= L2_STATS_RRC_MSG_TYPES) msg_type = 0;
+    l2_stats_add(&c->rrc_decode_err[channel][msg_type], 1);
+}
+
+static inline uint32_t l2_stats_hist_bucket(uint64_t v) {
+    return v ? 64 - (uint32_t)__builtin_clzll(v) : 0;
+}
+
+static inline void l2_stats_record(l2_stats_core_t *c, l2_stats_hist_t h, uint64_t v) {
+    l2_stats_add(&c->hist[h][l2_stats_hist_bucket(v)], 1);
+    l2_stats_add(&c->hist_sum[h], v);
+}
+
+/*----------------------------------------------------------------------------
+ * Reader side
+ *--------------------------------------------------------------------------*/
+
+// Plain totals over all cores
+typedef struct l2_stats_snapshot {
+    uint64_t pdus[L2_STATS_LAYER_COUNT][L2_STATS_DIR_COUNT];
+    uint64_t bytes[L2_STATS_LAYER_COUNT][L2_STATS_DIR_COUNT];
+    uint64_t lcid_bytes[L2_STATS_NUM_LCID][L2_STATS_DIR_COUNT];
+    uint64_t ctr[L2_CTR_COUNT];
+    uint64_t rrc_decode_err[L2_STATS_RRC_CHANNELS][L2_STATS_RRC_MSG_TYPES];
+    uint64_t hist[L2_HIST_COUNT][L2_STATS_HIST_BUCKETS];
+    uint64_t hist_sum[L2_HIST_COUNT];
+} l2_stats_snapshot_t;
+
+void l2_stats_aggregate(const l2_stats_shm_t *s, l2_stats_snapshot_t *out);
+
+const char *l2_stats_layer_name(l2_stats_layer_t layer);
+const char *l2_stats_ctr_name(l2_stats_ctr_t ctr);
+const char *l2_stats_hist_name(l2_stats_hist_t h);
+
+// Prometheus text exposition format; idle LCID / RRC error series are omitted
+void l2_stats_write_prometheus(FILE *out, const l2_stats_snapshot_t *snap);
+
+#endif
@@ -0,0 +1,72 @@
+// l2_stats_export.c
+//
+// Out-of-process exporter for the L2 statistics region. Maps the
+// shared-memory object read-only, sums the per-core blocks and writes
+// Prometheus text format, either once to stdout or periodically to a file
+// (replaced atomically, for a node exporter textfile collector).
+//
+// usage: l2_stats_export [-n name] [-o file] [-i interval_ms]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "l2_stats.h"
+
+// Map, aggregate and unmap; reopening every scrape follows data path restarts
+static int export_once(const char *name, FILE *out) {
+    l2_stats_shm_t s;
+    l2_stats_snapshot_t snap;
+
+    if (l2_stats_open(&s, name) < 0) {
+        fprintf(stderr, "l2_stats_export: %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    l2_stats_aggregate(&s, &snap);
+    fprintf(out, "# l2 stats: %u core(s), owner pid %d\n", s.region->n_cores,
+            (int)s.region->owner_pid);
+    l2_stats_close(&s);
+
+    l2_stats_write_prometheus(out, &snap);
+    return 0;
+}
+
+static int export_file(const char *name, const char *path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    int ret = export_once(name, f);
+    if (fclose(f) != 0) ret = -1;
+    if (ret == 0 && rename(tmp, path) < 0) ret = -1;
+    if (ret < 0) remove(tmp);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    const char *name = L2_STATS_DEFAULT_NAME, *path = NULL;
+    long interval_ms = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) name = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) path = argv[++i];
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) interval_ms = atol(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [-n name] [-o file] [-i interval_ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!path) return export_once(name, stdout) < 0;
+    if (interval_ms <= 0) return export_file(name, path) < 0;
+
+    struct timespec ts = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+    for (;;) {
+        export_file(name, path);
+        nanosleep(&ts, NULL);
+    }
+}
@@ -0,0 +1,145 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "l2_trace.h"
+
+_Static_assert(sizeof(l2_trace_event_t) == 16, "trace event must stay 16 bytes");
+
+_Atomic int l2_trace_on;
+_Thread_local l2_trace_ring_t *l2_trace_ring;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static l2_trace_ring_t *trace_rings;
+static uint32_t trace_ring_events = L2_TRACE_DEFAULT_EVENTS;
+static uint64_t trace_tsc_hz = 1000000000ull;
+
+static const char *const stage_names[L2_STAGE_COUNT] = {
+    [L2_STAGE_SDAP_RX]    = "sdap_rx",
+    [L2_STAGE_PDCP_TX]    = "pdcp_tx",
+    [L2_STAGE_SDU_QUEUE]  = "sdu_queue",
+    [L2_STAGE_RLC_TX]     = "rlc_tx",
+    [L2_STAGE_MAC_MUX]    = "mac_mux",
+    [L2_STAGE_MAC_TB_OUT] = "mac_tb_out",
+    [L2_STAGE_MAC_RX]     = "mac_rx",
+    [L2_STAGE_RLC_RX]     = "rlc_rx",
+    [L2_STAGE_PDCP_RX]    = "pdcp_rx",
+    [L2_STAGE_SDAP_TX]    = "sdap_tx",
+    [L2_STAGE_USER]       = "user",
+    [L2_STAGE_SLOT]       = "slot",
+};
+
+const char *l2_trace_stage_name(uint8_t stage) {
+    stage &= (uint8_t)~(L2_STAGE_END | L2_STAGE_MARK);
+    return stage < L2_STAGE_COUNT ? stage_names[stage] : "unknown";
+}
+
+static uint64_t trace_mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// TSC ticks per second over a 20 ms window; exact 1 GHz without a TSC
+static uint64_t trace_calibrate(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec d = { 0, 20000000L };
+    uint64_t t0 = trace_mono_ns(), c0 = l2_trace_tsc();
+    nanosleep(&d, NULL);
+    uint64_t t1 = trace_mono_ns(), c1 = l2_trace_tsc();
+    return t1 > t0 ? (uint64_t)((double)(c1 - c0) * 1e9 / (double)(t1 - t0)) : 1000000000ull;
+#else
+    return 1000000000ull;
+#endif
+}
+
+int l2_trace_init(uint32_t ring_events) {
+    if (!ring_events) ring_events = L2_TRACE_DEFAULT_EVENTS;
+    if (ring_events & (ring_events - 1)) return -1;
+
+    pthread_mutex_lock(&trace_lock);
+    trace_ring_events = ring_events;
+    pthread_mutex_unlock(&trace_lock);
+    trace_tsc_hz = trace_calibrate();
+    return 0;
+}
+
+void l2_trace_enable(int on) {
+    atomic_store_explicit(&l2_trace_on, on ? 1 : 0, memory_order_relaxed);
+}
+
+uint64_t l2_trace_tsc_hz(void) {
+    return trace_tsc_hz;
+}
+
+l2_trace_ring_t *l2_trace_ring_attach(void) {
+    pthread_mutex_lock(&trace_lock);
+    uint32_t n = trace_ring_events;
+    l2_trace_ring_t *r = calloc(1, sizeof(*r) + (size_t)n * sizeof(l2_trace_event_t));
+    if (r) {
+        r->mask = n - 1;
+        r->tid = (int32_t)syscall(SYS_gettid);
+        snprintf(r->name, sizeof(r->name), "tid-%d", (int)r->tid);
+        r->next = trace_rings;
+        trace_rings = r;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    l2_trace_ring = r;
+    return r;
+}
+
+void l2_trace_thread_name(const char *name) {
+    l2_trace_ring_t *r = l2_trace_ring ? l2_trace_ring : l2_trace_ring_attach();
+    if (!r) return;
+    pthread_mutex_lock(&trace_lock);
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    pthread_mutex_unlock(&trace_lock);
+}
+
+int l2_trace_dump(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    pthread_mutex_lock(&trace_lock);
+    l2_trace_file_hdr_t hdr = { L2_TRACE_MAGIC, L2_TRACE_VERSION, trace_tsc_hz, 0, 0 };
+    for (l2_trace_ring_t *r = trace_rings; r; r = r->next) hdr.n_rings++;
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+    for (l2_trace_ring_t *r = trace_rings; r && ok; r = r->next) {
+        uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        uint64_t size = (uint64_t)r->mask + 1;
+        uint64_t count = head < size ? head : size;
+
+        l2_trace_file_ring_t fr = { r->tid, (uint32_t)count, head - count, { 0 } };
+        memcpy(fr.name, r->name, sizeof(fr.name));
+        ok = fwrite(&fr, sizeof(fr), 1, f) == 1;
+
+        // Oldest first: [head - count, head) may wrap around the ring end
+        uint64_t start = (head - count) & r->mask;
+        uint64_t first = size - start < count ? size - start : count;
+        if (ok && first) ok = fwrite(&r->ev[start], sizeof(l2_trace_event_t), first, f) == first;
+        if (ok && count > first)
+            ok = fwrite(r->ev, sizeof(l2_trace_event_t), count - first, f) == count - first;
+    }
+    pthread_mutex_unlock(&trace_lock);
+
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+void l2_trace_shutdown(void) {
+    l2_trace_enable(0);
+    pthread_mutex_lock(&trace_lock);
+    while (trace_rings) {
+        l2_trace_ring_t *next = trace_rings->next;
+        free(trace_rings);
+        trace_rings = next;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    l2_trace_ring = NULL;
+}
@@ -0,0 +1,165 @@
+// l2_trace.h
+#ifndef _L2_TRACE_H_
+#define _L2_TRACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/*============================================================================
+ * TSC-TIMESTAMPED L2 STAGE TRACER
+ *==========================================================================*/
+
+/**
+ * L2 event tracer
+ *
+ * Description:
+ * Trace points along the SDAP -> PDCP -> RLC -> MAC path record 16-byte
+ * events (TSC, stage, UE, LCID, SN) into a ring owned by the calling
+ * thread. Rings are flight recorders: they wrap and keep the newest
+ * events, and are never shared, so recording is a TSC read and four
+ * stores.
+ *
+ * The tracer is always compiled in. While disabled, L2_TRACE() costs one
+ * relaxed load of l2_trace_on and a branch predicted not taken; enabling
+ * it at runtime needs no rebuild or restart.
+ *
+ * l2_trace_dump() writes every ring to a binary file together with the
+ * TSC frequency measured at init; l2_trace_conv turns that into Chrome
+ * trace / Perfetto JSON. L2_TRACE_BEGIN / L2_TRACE_END bracket the time
+ * spent in a stage on one thread; L2_TRACE_MARK records a point event
+ * (an SDU entering a queue, a TB leaving).
+ */
+#define L2_TRACE_MAGIC          0x5254324Cu   // "L2TR"
+#define L2_TRACE_VERSION        1
+#define L2_TRACE_DEFAULT_EVENTS (1u << 16)    // Per thread, 1 MB
+#define L2_STAGE_END            0x80          // Stage flag: span end
+#define L2_STAGE_MARK           0x40          // Stage flag: instant event
+#define L2_TRACE_NAME_LEN       16
+
+typedef enum l2_trace_stage {
+    L2_STAGE_SDAP_RX = 0,      // SDU in from the core network
+    L2_STAGE_PDCP_TX,          // Header, ROHC, ciphering
+    L2_STAGE_SDU_QUEUE,        // Waiting for a grant
+    L2_STAGE_RLC_TX,           // Segmentation, header write
+    L2_STAGE_MAC_MUX,          // LCP and subheader build
+    L2_STAGE_MAC_TB_OUT,       // Transport block handed to PHY
+    L2_STAGE_MAC_RX,           // Demultiplexing
+    L2_STAGE_RLC_RX,           // Window update, reassembly
+    L2_STAGE_PDCP_RX,          // Deciphering, reordering
+    L2_STAGE_SDAP_TX,          // SDU out to the core network
+    L2_STAGE_USER,             // Free for ad-hoc instrumentation
+    L2_STAGE_SLOT,             // One cell's slot: scheduling and TB building
+    L2_STAGE_COUNT
+} l2_trace_stage_t;
+
+typedef struct l2_trace_event {
+    uint64_t tsc;
+    uint32_t sn;
+    uint16_t ue;               // RNTI or UE index
+    uint8_t  lcid;
+    uint8_t  stage;            // l2_trace_stage_t | L2_STAGE_END / MARK
+} l2_trace_event_t;
+
+typedef struct l2_trace_ring {
+    _Atomic uint64_t head;     // Events ever written; only the owner writes it
+    uint32_t mask;             // Entries - 1
+    int32_t  tid;
+    char     name[L2_TRACE_NAME_LEN];
+    struct l2_trace_ring *next;
+    l2_trace_event_t ev[];
+} l2_trace_ring_t;
+
+/**
+ * Dump file:
+ * +---------------------+--------------------------+--------+-----+
+ * | l2_trace_file_hdr_t | l2_trace_file_ring_t     | events | ... |
+ * |                     | (count events follow)    |        |     |
+ * +---------------------+--------------------------+--------+-----+
+ * Events of a ring are oldest first. Host byte order.
+ */
+typedef struct l2_trace_file_hdr {
+    uint32_t magic;            // L2_TRACE_MAGIC
+    uint32_t version;          // L2_TRACE_VERSION
+    uint64_t tsc_hz;
+    uint32_t n_rings;
+    uint32_t rsv;
+} l2_trace_file_hdr_t;
+
+typedef struct l2_trace_file_ring {
+    int32_t  tid;
+    uint32_t count;
+    uint64_t lost;             // Overwritten before the dump
+    char     name[L2_TRACE_NAME_LEN];
+} l2_trace_file_ring_t;
+
+extern _Atomic int l2_trace_on;
+extern _Thread_local l2_trace_ring_t *l2_trace_ring;
+
+/**
+ * Allocate nothing yet, just fix the per-thread ring size (power of two,
+ * 0 = default) and calibrate the TSC. Rings are created on a thread's
+ * first event. Returns 0, -1 on bad size.
+ */
+int  l2_trace_init(uint32_t ring_events);
+void l2_trace_enable(int on);
+
+// Label the calling thread's ring in dumps ("mac-dl-0", ...)
+void l2_trace_thread_name(const char *name);
+
+/**
+ * Write all rings to path. Disable tracing first for an exact snapshot;
+ * while enabled, events written during the dump may be torn.
+ * Returns 0, -1 on I/O error.
+ */
+int  l2_trace_dump(const char *path);
+
+// Free every ring; only when no thread traces any more
+void l2_trace_shutdown(void);
+
+uint64_t l2_trace_tsc_hz(void);
+const char *l2_trace_stage_name(uint8_t stage);
+
+// Slow path: create and register the calling thread's ring
+l2_trace_ring_t *l2_trace_ring_attach(void);
+
+static inline uint64_t l2_trace_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline void l2_trace_emit(uint8_t stage, uint16_t ue, uint8_t lcid, uint32_t sn) {
+    l2_trace_ring_t *r = l2_trace_ring;
+    if (!r && !(r = l2_trace_ring_attach())) return;
+
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    l2_trace_event_t *e = &r->ev[head & r->mask];
+    e->tsc = l2_trace_tsc();
+    e->sn = sn;
+    e->ue = ue;
+    e->lcid = lcid;
+    e->stage = stage;
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+#define L2_TRACE(stage, ue, lcid, sn) do { \
+    if (__builtin_expect(atomic_load_explicit(&l2_trace_on, memory_order_relaxed), 0)) \
+        l2_trace_emit((uint8_t)(stage), (ue), (lcid), (sn)); \
+} while (0)
+
+#define L2_TRACE_BEGIN(stage, ue, lcid, sn) L2_TRACE(stage, ue, lcid, sn)
+#define L2_TRACE_END(stage, ue, lcid, sn)   L2_TRACE((stage) | L2_STAGE_END, ue, lcid, sn)
+#define L2_TRACE_MARK(stage, ue, lcid, sn)  L2_TRACE((stage) | L2_STAGE_MARK, ue, lcid, sn)
+
+#endif
@@ -0,0 +1,121 @@
+// l2_trace_conv.c
+//
+// Convert an l2_trace_dump() file to Chrome trace event JSON, which loads
+// in chrome://tracing and ui.perfetto.dev. One track per traced thread;
+// timestamps are microseconds from the earliest event in the dump.
+//
+// Build:
+//   gcc -O2 -pthread l2_trace_conv.c l2_trace.c -o l2_trace_conv
+//
+// usage: l2_trace_conv <dump> [out.json]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "l2_trace.h"
+
+typedef struct conv_ring {
+    l2_trace_file_ring_t hdr;
+    l2_trace_event_t *ev;
+} conv_ring_t;
+
+static int conv_load(FILE *f, l2_trace_file_hdr_t *hdr, conv_ring_t **rings) {
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1 || hdr->magic != L2_TRACE_MAGIC ||
+        hdr->version != L2_TRACE_VERSION || !hdr->tsc_hz)
+        return -1;
+
+    *rings = calloc(hdr->n_rings ? hdr->n_rings : 1, sizeof(conv_ring_t));
+    if (!*rings) return -1;
+    for (uint32_t i = 0; i < hdr->n_rings; i++) {
+        conv_ring_t *r = &(*rings)[i];
+        if (fread(&r->hdr, sizeof(r->hdr), 1, f) != 1) return -1;
+        r->ev = malloc((size_t)(r->hdr.count ? r->hdr.count : 1) * sizeof(l2_trace_event_t));
+        if (!r->ev || fread(r->ev, sizeof(l2_trace_event_t), r->hdr.count, f) != r->hdr.count)
+            return -1;
+    }
+    return 0;
+}
+
+// Quoted JSON string; thread names come from the traced process as is
+static void conv_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dump> [out.json]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    l2_trace_file_hdr_t hdr;
+    conv_ring_t *rings = NULL;
+    int ret = conv_load(in, &hdr, &rings);
+    fclose(in);
+    if (ret < 0) {
+        fprintf(stderr, "%s: not a valid L2 trace dump\n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    uint64_t t0 = UINT64_MAX, lost = 0, total = 0;
+    for (uint32_t i = 0; i < hdr.n_rings; i++)
+        if (rings[i].hdr.count && rings[i].ev[0].tsc < t0) t0 = rings[i].ev[0].tsc;
+    double us_per_tick = 1e6 / (double)hdr.tsc_hz;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    const char *sep = "";
+    for (uint32_t i = 0; i < hdr.n_rings; i++) {
+        conv_ring_t *r = &rings[i];
+        char name[L2_TRACE_NAME_LEN + 1] = { 0 };
+        memcpy(name, r->hdr.name, L2_TRACE_NAME_LEN);
+
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                sep, (int)r->hdr.tid);
+        conv_json_string(out, name);
+        fprintf(out, "}}");
+        sep = ",\n";
+
+        for (uint32_t j = 0; j < r->hdr.count; j++) {
+            const l2_trace_event_t *e = &r->ev[j];
+            const char *ph = (e->stage & L2_STAGE_END) ? "E" : (e->stage & L2_STAGE_MARK) ? "i" : "B";
+            fprintf(out, "%s{\"name\":", sep);
+            conv_json_string(out, l2_trace_stage_name(e->stage));
+            fprintf(out, ",\"cat\":\"l2\",\"ph\":\"%s\",%s\"ts\":%.3f,"
+                         "\"pid\":1,\"tid\":%d,\"args\":{\"ue\":%u,\"lcid\":%u,\"sn\":%u}}",
+                    ph, *ph == 'i' ? "\"s\":\"t\"," : "",
+                    (double)(e->tsc - t0) * us_per_tick, (int)r->hdr.tid, e->ue, e->lcid, e->sn);
+        }
+        lost += r->hdr.lost;
+        total += r->hdr.count;
+        free(r->ev);
+    }
+    fprintf(out, "\n]}\n");
+    free(rings);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "%" PRIu64 " event(s) from %u thread(s), %" PRIu64 " overwritten, %.3f GHz TSC\n",
+            total, hdr.n_rings, lost, (double)hdr.tsc_hz / 1e9);
+    return 0;
+}
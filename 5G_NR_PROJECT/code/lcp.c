@@ -0,0 +1,136 @@
+#include <string.h>
+
+#include "lcp.h"
+
+void lcp_ue_init(lcp_ue_t *ue) {
+    memset(ue, 0, sizeof(*ue));
+}
+
+int lcp_config_lc(lcp_ue_t *ue, uint8_t lcid, uint8_t priority, uint32_t pbr_kbps,
+                  uint32_t bsd_ms, uint32_t tick_us) {
+    int slot = -1;
+
+    for (int i = 0; i < ue->n_lc; i++)
+        if (ue->lcid[i] == lcid) slot = i;
+    if (slot < 0) {
+        if (ue->n_lc == LCP_MAX_LC) return -1;
+        slot = ue->n_lc++;
+    }
+
+    ue->lcid[slot] = lcid;
+    ue->priority[slot] = priority;
+    ue->bj[slot] = 0;
+    if (pbr_kbps == LCP_PBR_INFINITY) {
+        ue->pbr_inc[slot] = LCP_BUCKET_INFINITY;
+        ue->bucket_max[slot] = LCP_BUCKET_INFINITY;
+    } else {
+        // kB/s x us / 1000 = bytes per tick; kB/s x ms = bytes per BSD
+        uint64_t inc = (uint64_t)pbr_kbps * tick_us / 1000;
+        uint64_t max = (uint64_t)pbr_kbps * bsd_ms;
+        ue->pbr_inc[slot] = (int32_t)(inc < LCP_BUCKET_INFINITY ? inc : LCP_BUCKET_INFINITY);
+        ue->bucket_max[slot] = (int32_t)(max < LCP_BUCKET_INFINITY ? max : LCP_BUCKET_INFINITY);
+    }
+
+    // Re-sort the priority order; insertion sort, n_lc <= 32 and rarely changes
+    for (int i = 0; i < ue->n_lc; i++) ue->order[i] = (uint8_t)i;
+    for (int i = 1; i < ue->n_lc; i++) {
+        uint8_t s = ue->order[i];
+        int j = i - 1;
+        while (j >= 0 && ue->priority[ue->order[j]] > ue->priority[s]) {
+            ue->order[j + 1] = ue->order[j];
+            j--;
+        }
+        ue->order[j + 1] = s;
+    }
+    return 0;
+}
+
+void lcp_tick_all(lcp_ue_t *ues, uint32_t n_ues, uint32_t ticks) {
+    for (uint32_t u = 0; u < n_ues; u++) lcp_tick(&ues[u], ticks);
+}
+
+typedef struct lcp_mux {
+    uint8_t *tb;
+    uint32_t size;
+    uint32_t pos;
+    lcp_result_t *res;
+} lcp_mux_t;
+
+/**
+ * Ask RLC for one PDU of at most limit bytes and prepend its MAC subheader.
+ * The 16-bit L format is reserved whenever the PDU could reach 256 bytes,
+ * so the payload never has to move once RLC wrote it.
+ */
+static uint32_t lcp_mux_one(lcp_mux_t *m, const lcp_rlc_ops_t *rlc, void *ctx, uint8_t lcid, uint32_t limit) {
+    uint32_t avail = m->size - m->pos;
+    if (avail < 3 || m->res->n_sdu == LCP_MAX_SDUS) return 0;
+
+    uint32_t max = avail - 2;
+    if (max > limit) max = limit;
+    uint32_t hdr = max > 255 ? 3 : 2;
+    if (hdr == 3) max = avail - 3 < max ? avail - 3 : max;
+    if (max > UINT16_MAX) max = UINT16_MAX;
+
+    uint8_t *p = m->tb + m->pos;
+    uint32_t n = rlc->build_pdu(ctx, lcid, p + hdr, max);
+    if (!n) return 0;
+
+    if (hdr == 2) {
+        p[0] = lcid & 0x3F;
+        p[1] = (uint8_t)n;
+    } else {
+        p[0] = (uint8_t)(0x40 | (lcid & 0x3F));
+        p[1] = (uint8_t)(n >> 8);
+        p[2] = (uint8_t)n;
+    }
+
+    lcp_result_t *res = m->res;
+    res->sdu[res->n_sdu].lcid = lcid;
+    res->sdu[res->n_sdu].offset = m->pos + hdr;
+    res->sdu[res->n_sdu].len = n;
+    res->n_sdu++;
+    m->pos += hdr + n;
+    return n;
+}
+
+// Serve lcid until limit SDU bytes, no more data or no more room
+static uint32_t lcp_serve(lcp_mux_t *m, const lcp_rlc_ops_t *rlc, void *ctx, uint8_t lcid, uint32_t limit) {
+    uint32_t served = 0;
+
+    while (served < limit && rlc->pending(ctx, lcid)) {
+        uint32_t n = lcp_mux_one(m, rlc, ctx, lcid, limit - served);
+        if (!n) break;
+        served += n;
+    }
+    return served;
+}
+
+int lcp_build_tb(lcp_ue_t *ue, const lcp_rlc_ops_t *rlc, void *rlc_ctx,
+                 uint8_t *tb, uint32_t tb_size, uint32_t tb_used, lcp_result_t *res) {
+    lcp_mux_t m = { tb, tb_size, tb_used, res };
+
+    if (tb_used > tb_size) return -1;
+    res->n_sdu = 0;
+
+    // Steps 1 and 2: PBR guaranteed part, Bj > 0 in priority order
+    for (int i = 0; i < ue->n_lc; i++) {
+        uint8_t s = ue->order[i];
+        if (ue->bj[s] <= 0) continue;
+
+        uint32_t limit = ue->bj[s] == LCP_BUCKET_INFINITY ? UINT32_MAX : (uint32_t)ue->bj[s];
+        uint32_t served = lcp_serve(&m, rlc, rlc_ctx, ue->lcid[s], limit);
+        if (ue->bj[s] != LCP_BUCKET_INFINITY) ue->bj[s] -= (int32_t)served;
+    }
+
+    // Step 3: whatever is left, strict priority
+    for (int i = 0; i < ue->n_lc && tb_size - m.pos >= 3; i++)
+        lcp_serve(&m, rlc, rlc_ctx, ue->lcid[ue->order[i]], UINT32_MAX);
+
+    res->used = m.pos - tb_used;
+    res->padding = tb_size - m.pos;
+    if (res->padding) {
+        tb[m.pos] = MAC_LCID_PADDING;
+        memset(tb + m.pos + 1, 0, res->padding - 1);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// lcp.h
+#ifndef _LCP_H_
+#define _LCP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mac_ce.h"
+
+/*============================================================================
+ * LOGICAL CHANNEL PRIORITIZATION (UL)
+ * Reference: 3GPP TS 38.321 Section 5.4.3.1
+ *==========================================================================*/
+
+/**
+ * Per-UE LCP state
+ *
+ * Description:
+ * Every logical channel j has a priority, a Prioritised Bit Rate (PBR) and
+ * a Bucket Size Duration (BSD). The token bucket Bj grows by PBR x T every
+ * tick and is capped at PBR x BSD. For each UL grant:
+ *
+ * 1. Channels with Bj > 0 are served in decreasing priority, each up to Bj
+ * 2. Bj is decremented by the bytes of MAC SDUs served (it may go negative)
+ * 3. Remaining space goes to channels in strict priority order until the
+ *    grant or the data runs out
+ *
+ * Layout:
+ * State is kept struct-of-arrays, indexed by a dense channel slot (0..n_lc-1),
+ * so the per-tick bucket update is one straight loop of adds and mins over
+ * contiguous int32 arrays with no branches. Priority order is sorted once
+ * at configuration time and stored in order[].
+ *
+ * Units: bytes and ticks; lcp_config_lc() converts PBR (kB/s) and BSD (ms)
+ * using the tick length.
+ */
+#define LCP_MAX_LC            32
+#define LCP_PBR_INFINITY      UINT32_MAX   // prioritisedBitRate = infinity
+#define LCP_BUCKET_INFINITY   INT32_MAX
+
+typedef struct lcp_ue {
+    uint8_t n_lc;                           // Configured channels
+    uint8_t order[LCP_MAX_LC];              // Slots sorted by priority (highest first)
+    uint8_t lcid[LCP_MAX_LC];               // Slot -> LCID
+    uint8_t priority[LCP_MAX_LC];           // 1 = highest (TS 38.331 LogicalChannelConfig)
+    int32_t bj[LCP_MAX_LC];                 // Token bucket Bj (bytes)
+    int32_t pbr_inc[LCP_MAX_LC];            // Bytes added per tick
+    int32_t bucket_max[LCP_MAX_LC];         // PBR x BSD (bytes)
+} lcp_ue_t;
+
+/**
+ * RLC interface used by LCP
+ *
+ * - pending: bytes RLC could send on lcid right now (data + header estimate)
+ * - build_pdu: build one RLC PDU of at most max bytes into buf, segmenting
+ *   the head SDU if needed. Returns bytes written, 0 if nothing fits.
+ */
+typedef struct lcp_rlc_ops {
+    uint32_t (*pending)(void *ctx, uint8_t lcid);
+    uint32_t (*build_pdu)(void *ctx, uint8_t lcid, uint8_t *buf, uint32_t max);
+} lcp_rlc_ops_t;
+
+#define LCP_MAX_SDUS 64
+
+typedef struct lcp_result {
+    uint32_t used;                 // Bytes of the TB filled by LCP (SDUs + subheaders)
+    uint32_t padding;              // Bytes filled with padding
+    uint16_t n_sdu;
+    struct {
+        uint8_t lcid;
+        uint32_t offset;           // SDU offset in the TB
+        uint32_t len;              // SDU length
+    } sdu[LCP_MAX_SDUS];
+} lcp_result_t;
+
+void lcp_ue_init(lcp_ue_t *ue);
+
+/**
+ * Add or reconfigure a logical channel.
+ *
+ * pbr_kbps: prioritisedBitRate in kBytes/s (LCP_PBR_INFINITY for infinity)
+ * bsd_ms: bucketSizeDuration in ms
+ * tick_us: interval between lcp_tick() calls (normally one slot)
+ *
+ * Returns 0 on success, -1 when the table is full.
+ */
+int lcp_config_lc(lcp_ue_t *ue, uint8_t lcid, uint8_t priority, uint32_t pbr_kbps,
+                  uint32_t bsd_ms, uint32_t tick_us);
+
+// Advance all buckets of one UE by ticks: Bj = min(Bj + PBR x T, PBR x BSD)
+static inline void lcp_tick(lcp_ue_t *ue, uint32_t ticks) {
+    for (int i = 0; i < LCP_MAX_LC; i++) {
+        int64_t v = (int64_t)ue->bj[i] + (int64_t)ue->pbr_inc[i] * ticks;
+        ue->bj[i] = (int32_t)(v < ue->bucket_max[i] ? v : ue->bucket_max[i]);
+    }
+}
+
+// Advance a contiguous array of UEs, the per-slot entry point of the emulator
+void lcp_tick_all(lcp_ue_t *ues, uint32_t n_ues, uint32_t ticks);
+
+/**
+ * Run LCP for one UL grant and multiplex the result into tb.
+ *
+ * tb[0..tb_used) is already taken (e.g. C-RNTI / BSR CEs built by the
+ * caller). SDUs are appended as MAC subPDUs, and any remainder of at
+ * least one byte becomes a padding subPDU.
+ *
+ * Returns 0, or -1 if tb_used > tb_size.
+ */
+int lcp_build_tb(lcp_ue_t *ue, const lcp_rlc_ops_t *rlc, void *rlc_ctx,
+                 uint8_t *tb, uint32_t tb_size, uint32_t tb_used, lcp_result_t *res);
+
+#endif
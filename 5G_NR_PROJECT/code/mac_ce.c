@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "mac_ce.h"
+
+/*----------------------------------------------------------------------------
+ * Buffer size tables (TS 38.321 Table 6.1.3.1-1 / 6.1.3.1-2)
+ *--------------------------------------------------------------------------*/
+
+const uint32_t mac_bsr_5bit_table[MAC_BSR_5BIT_LEVELS] = {
+    0, 10, 14, 20, 28, 38, 53, 74, 102, 142, 198, 276, 384, 535, 745, 1038, 1446,
+    2014, 2806, 3909, 5446, 7587, 10570, 14726, 20516, 28581, 39818, 55474, 77284,
+    107669, 150000, UINT32_MAX,
+};
+
+const uint32_t mac_bsr_8bit_table[MAC_BSR_8BIT_LEVELS] = {
+    0, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 22, 23, 25, 26, 28, 30, 32, 34,
+    36, 38, 40, 43, 46, 49, 52, 55, 59, 62, 66, 71, 75, 80, 85, 91, 97, 103, 110,
+    117, 124, 132, 141, 150, 160, 170, 181, 193, 205, 218, 233, 248, 264, 281, 299,
+    318, 339, 361, 384, 409, 436, 464, 494, 526, 560, 597, 635, 677, 720, 767, 817,
+    870, 926, 987, 1051, 1119, 1191, 1269, 1351, 1439, 1532, 1631, 1737, 1850, 1970,
+    2098, 2234, 2379, 2533, 2698, 2873, 3059, 3258, 3469, 3694, 3934, 4189, 4461,
+    4751, 5059, 5387, 5737, 6109, 6506, 6928, 7378, 7857, 8367, 8910, 9488, 10104,
+    10760, 11458, 12202, 12994, 13838, 14736, 15692, 16711, 17795, 18951, 20181,
+    21491, 22885, 24371, 25953, 27638, 29431, 31342, 33376, 35543, 37850, 40307,
+    42923, 45709, 48676, 51836, 55200, 58784, 62599, 66663, 70990, 75598, 80505,
+    85730, 91295, 97221, 103532, 110252, 117409, 125030, 133146, 141789, 150992,
+    160793, 171231, 182345, 194182, 206786, 220209, 234503, 249725, 265935, 283197,
+    301579, 321155, 342002, 364202, 387842, 413018, 439827, 468377, 498780, 531156,
+    565634, 602350, 641449, 683087, 727427, 774645, 824928, 878475, 935498, 996222,
+    1060888, 1129752, 1203085, 1281179, 1364342, 1452903, 1547213, 1647644, 1754595,
+    1868488, 1989774, 2118933, 2256475, 2402946, 2558924, 2725027, 2901912, 3090279,
+    3290873, 3504487, 3731968, 3974215, 4232186, 4506902, 4799451, 5110989, 5442750,
+    5796046, 6172275, 6572925, 6999582, 7453933, 7937777, 8453028, 9001725, 9586039,
+    10208280, 10870913, 11576557, 12328006, 13128233, 13980403, 14887889, 15854280,
+    16883401, 17979324, 19146385, 20389201, 21712690, 23122088, 24622972, 26221280,
+    27923336, 29735875, 31666069, 33721553, 35910462, 38241455, 40723756, 43367187,
+    46182206, 49179951, 52372284, 55771835, 59392055, 63247269, 67352729, 71724679,
+    76380419, 81338368, UINT32_MAX,
+};
+
+// First index whose level is >= bytes; the tables end in UINT32_MAX so it always exists
+static inline uint8_t mac_bsr_lower_bound(const uint32_t *table, uint32_t n, uint32_t bytes) {
+    const uint32_t *base = table;
+    while (n > 1) {
+        uint32_t half = n / 2;
+        base = (base[half - 1] < bytes) ? base + half : base;
+        n -= half;
+    }
+    return (uint8_t)(base - table + (*base < bytes));
+}
+
+uint8_t mac_bsr_index_5bit(uint32_t bytes) {
+    return mac_bsr_lower_bound(mac_bsr_5bit_table, MAC_BSR_5BIT_LEVELS, bytes);
+}
+
+uint8_t mac_bsr_index_8bit(uint32_t bytes) {
+    return mac_bsr_lower_bound(mac_bsr_8bit_table, MAC_BSR_8BIT_LEVELS, bytes);
+}
+
+/*----------------------------------------------------------------------------
+ * Payload decoders
+ *--------------------------------------------------------------------------*/
+
+// Short / Short Truncated BSR: | LCG ID (3) | Buffer Size (5) |
+static int mac_ce_decode_short_bsr(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)len;
+    uint8_t lcg = p[0] >> 5;
+
+    ce->u.bsr.format = ce->lcid == MAC_LCID_UL_SHORT_BSR ? MAC_BSR_SHORT : MAC_BSR_SHORT_TRUNCATED;
+    ce->u.bsr.lcg_bitmap = (uint8_t)(1u << lcg);
+    ce->u.bsr.reported = ce->u.bsr.lcg_bitmap;
+    memset(ce->u.bsr.bs_index, 0, sizeof(ce->u.bsr.bs_index));
+    ce->u.bsr.bs_index[lcg] = p[0] & 0x1F;
+    return 0;
+}
+
+/**
+ * Long / Long Truncated BSR: | LCG7 ... LCG0 | Buffer Size 1 | ... |
+ *
+ * Buffer sizes follow in ascending LCG order. For Long BSR there is one
+ * per set bit, so the length is checked against popcount; for the
+ * truncated format the payload holds as many as fit.
+ */
+static int mac_ce_decode_long_bsr(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    if (len < 1) return -1;
+
+    uint8_t bitmap = p[0];
+    int n = __builtin_popcount(bitmap);
+    int truncated = ce->lcid == MAC_LCID_UL_LONG_TRUNC_BSR;
+
+    if (!truncated && len != 1 + n) return -1;
+    if (truncated && len - 1 > n) return -1;
+    if (truncated && len - 1 < n) n = len - 1;
+
+    ce->u.bsr.format = truncated ? MAC_BSR_LONG_TRUNCATED : MAC_BSR_LONG;
+    ce->u.bsr.lcg_bitmap = bitmap;
+    ce->u.bsr.reported = 0;
+    memset(ce->u.bsr.bs_index, 0, sizeof(ce->u.bsr.bs_index));
+
+    const uint8_t *bs = p + 1;
+    for (unsigned m = bitmap; n > 0; m &= m - 1, n--) {
+        unsigned lcg = (unsigned)__builtin_ctz(m);
+        ce->u.bsr.bs_index[lcg] = *bs++;
+        ce->u.bsr.reported |= (uint8_t)(1u << lcg);
+    }
+    return 0;
+}
+
+static int mac_ce_decode_single_phr(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)len;
+    ce->u.phr.ph = p[0] & 0x3F;
+    ce->u.phr.pcmax = p[1] & 0x3F;
+    return 0;
+}
+
+static int mac_ce_decode_multi_phr(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    mac_ce_phr_multi_t *phr = &ce->u.phr_multi;
+    uint16_t bitmap_len = ce->lcid == MAC_LCID_UL_MULTI_PHR_4OCT ? 4 : 1;
+
+    if (len < bitmap_len) return -1;
+
+    // Octet 1 is C7..C1 R (bit 0 reserved), octets 2-4 are C15..C8, C23..C16, C31..C24
+    uint32_t bitmap = 0;
+    for (uint16_t i = 0; i < bitmap_len; i++) bitmap |= (uint32_t)p[i] << (8 * i);
+    phr->cell_bitmap = bitmap & ~1u;
+    phr->n_entries = 0;
+
+    const uint8_t *q = p + bitmap_len, *end = p + len;
+    uint32_t cells = phr->cell_bitmap | 1u;   // SpCell entry comes first
+    while (cells) {
+        if (q >= end) return -1;
+        unsigned cell = (unsigned)__builtin_ctz(cells);
+        cells &= cells - 1;
+
+        mac_phr_entry_t *e = &phr->entries[phr->n_entries++];
+        e->cell = (uint8_t)cell;
+        e->p = (q[0] >> 7) & 1;
+        e->v = (q[0] >> 6) & 1;
+        e->ph = q[0] & 0x3F;
+        e->pcmax = 0;
+        q++;
+        if (!e->v) {
+            if (q >= end) return -1;
+            e->pcmax = *q++ & 0x3F;
+        }
+    }
+    return q == end ? 0 : -1;
+}
+
+static int mac_ce_decode_c_rnti(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)len;
+    ce->u.c_rnti = (uint16_t)((p[0] << 8) | p[1]);
+    return 0;
+}
+
+// Timing Advance Command: | TAG ID (2) | Timing Advance Command (6) |
+static int mac_ce_decode_ta_cmd(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)len;
+    ce->u.ta.tag_id = p[0] >> 6;
+    ce->u.ta.ta = p[0] & 0x3F;
+    return 0;
+}
+
+static int mac_ce_decode_contention_res(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)len;
+    memcpy(ce->u.contention_id, p, sizeof(ce->u.contention_id));
+    return 0;
+}
+
+// DRX / Long DRX Command: zero-length CE, the LCID is the whole message
+static int mac_ce_decode_empty(const uint8_t *p, uint16_t len, mac_ce_t *ce) {
+    (void)p;
+    (void)len;
+    (void)ce;
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * LCID dispatch tables
+ *
+ * Zero entries (LCID 1-32 logical channels, LCID 0 in DL, unhandled CEs)
+ * mean "F/L present, no decoder". UL LCID 0 is the fixed 64-bit CCCH.
+ *--------------------------------------------------------------------------*/
+
+const mac_lcid_desc_t mac_lcid_table_ul[MAC_LCID_COUNT] = {
+    [MAC_LCID_UL_CCCH_64]          = { 1, 8, NULL },
+    [MAC_LCID_UL_CCCH_48]          = { 1, 6, NULL },
+    [MAC_LCID_UL_MULTI_PHR_4OCT]   = { 0, 0, mac_ce_decode_multi_phr },
+    [MAC_LCID_UL_CG_CONFIRM]       = { 1, 0, mac_ce_decode_empty },
+    [MAC_LCID_UL_MULTI_PHR_1OCT]   = { 0, 0, mac_ce_decode_multi_phr },
+    [MAC_LCID_UL_SINGLE_PHR]       = { 1, 2, mac_ce_decode_single_phr },
+    [MAC_LCID_UL_C_RNTI]           = { 1, 2, mac_ce_decode_c_rnti },
+    [MAC_LCID_UL_SHORT_TRUNC_BSR]  = { 1, 1, mac_ce_decode_short_bsr },
+    [MAC_LCID_UL_LONG_TRUNC_BSR]   = { 0, 0, mac_ce_decode_long_bsr },
+    [MAC_LCID_UL_SHORT_BSR]        = { 1, 1, mac_ce_decode_short_bsr },
+    [MAC_LCID_UL_LONG_BSR]         = { 0, 0, mac_ce_decode_long_bsr },
+    [MAC_LCID_PADDING]             = { 1, 0, NULL },
+};
+
+const mac_lcid_desc_t mac_lcid_table_dl[MAC_LCID_COUNT] = {
+    [MAC_LCID_DL_LONG_DRX_CMD]     = { 1, 0, mac_ce_decode_empty },
+    [MAC_LCID_DL_DRX_CMD]          = { 1, 0, mac_ce_decode_empty },
+    [MAC_LCID_DL_TA_CMD]           = { 1, 1, mac_ce_decode_ta_cmd },
+    [MAC_LCID_DL_CONTENTION_RES]   = { 1, 6, mac_ce_decode_contention_res },
+    [MAC_LCID_PADDING]             = { 1, 0, NULL },
+};
+
+/*----------------------------------------------------------------------------
+ * Demultiplexing
+ *--------------------------------------------------------------------------*/
+
+int mac_pdu_demux(const uint8_t *pdu, size_t len, mac_dir_t dir, mac_subpdu_t *out, int max) {
+    const mac_lcid_desc_t *table = mac_lcid_table(dir);
+    size_t off = 0;
+    int n = 0;
+
+    while (off < len) {
+        uint8_t b0 = pdu[off];
+        uint8_t lcid = MAC_SUBHDR_LCID(b0);
+        if (lcid == MAC_LCID_PADDING) break;
+        if (n == max) return -1;
+
+        mac_subpdu_t *s = &out[n];
+        s->lcid = lcid;
+        if (table[lcid].fixed) {
+            s->hdr_len = 1;
+            s->len = table[lcid].len;
+        } else if (MAC_SUBHDR_F(b0)) {
+            if (off + 3 > len) return -1;
+            s->hdr_len = 3;
+            s->len = (uint32_t)((pdu[off + 1] << 8) | pdu[off + 2]);
+        } else {
+            if (off + 2 > len) return -1;
+            s->hdr_len = 2;
+            s->len = pdu[off + 1];
+        }
+
+        s->offset = (uint32_t)(off + s->hdr_len);
+        off += s->hdr_len + (size_t)s->len;
+        if (off > len) return -1;
+        n++;
+    }
+    return n;
+}
+
+uint64_t mac_lcid_valid_mask(mac_dir_t dir) {
+    const mac_lcid_desc_t *table = mac_lcid_table(dir);
+    uint64_t mask = (2ull << MAC_LCID_MAX_SDU) - 1;
+
+    for (int lcid = MAC_LCID_MAX_SDU + 1; lcid < MAC_LCID_COUNT; lcid++)
+        if (table[lcid].fixed || table[lcid].decode) mask |= 1ull << lcid;
+    return mask;
+}
+
+/**
+ * One subheader per step. The LCID check is a single bit test; fixed
+ * CE lengths come from the LCID table as in mac_pdu_demux().
+ */
+static int mac_pdu_valid(const uint8_t *pdu, size_t len, const mac_lcid_desc_t *table, uint64_t lcid_ok) {
+    size_t off = 0;
+
+    if (!len) return 0;
+    while (off < len) {
+        uint8_t b0 = pdu[off];
+        uint8_t lcid = MAC_SUBHDR_LCID(b0);
+        if (MAC_SUBHDR_R(b0)) return 0;
+        if (lcid == MAC_LCID_PADDING) return 1;
+        if (!((lcid_ok >> lcid) & 1)) return 0;
+
+        size_t l;
+        if (table[lcid].fixed) {
+            l = 1 + (size_t)table[lcid].len;
+        } else if (MAC_SUBHDR_F(b0)) {
+            if (off + 3 > len) return 0;
+            l = 3 + (size_t)((pdu[off + 1] << 8) | pdu[off + 2]);
+            if (l == 3) return 0;
+        } else {
+            if (off + 2 > len) return 0;
+            l = 2 + (size_t)pdu[off + 1];
+            if (l == 2) return 0;
+        }
+        off += l;
+    }
+    return off == len;
+}
+
+uint32_t mac_pdu_validate_burst(const uint8_t *const pdu[], const uint32_t len[], uint32_t n,
+                                mac_dir_t dir, uint64_t lcid_ok) {
+    const mac_lcid_desc_t *table = mac_lcid_table(dir);
+    uint32_t ok = 0;
+
+    if (n > 32) n = 32;
+    lcid_ok |= 1ull << MAC_LCID_PADDING;
+    for (uint32_t i = 0; i < n; i++) ok |= (uint32_t)mac_pdu_valid(pdu[i], len[i], table, lcid_ok) << i;
+    return ok;
+}
+
+int mac_ce_decode(mac_dir_t dir, const uint8_t *pdu, const mac_subpdu_t *sub, mac_ce_t *ce) {
+    const mac_lcid_desc_t *desc = &mac_lcid_table(dir)[sub->lcid];
+    if (!desc->decode) return -1;
+
+    ce->lcid = sub->lcid;
+    return desc->decode(pdu + sub->offset, sub->len, ce);
+}
+
+int mac_ce_parse_ul(const uint8_t *pdu, size_t len, mac_ce_ul_report_t *report) {
+    mac_subpdu_t subs[64];
+    mac_ce_t ce;
+    int n_ce = 0;
+
+    int n = mac_pdu_demux(pdu, len, MAC_DIR_UL, subs, 64);
+    if (n < 0) return -1;
+
+    report->present = 0;
+    for (int i = 0; i < n; i++) {
+        if (!mac_lcid_table_ul[subs[i].lcid].decode) continue;
+        if (mac_ce_decode(MAC_DIR_UL, pdu, &subs[i], &ce) < 0) return -1;
+        n_ce++;
+
+        switch (ce.lcid) {
+            case MAC_LCID_UL_SHORT_BSR:
+            case MAC_LCID_UL_SHORT_TRUNC_BSR:
+            case MAC_LCID_UL_LONG_BSR:
+            case MAC_LCID_UL_LONG_TRUNC_BSR:
+                report->bsr = ce.u.bsr;
+                report->present |= MAC_CE_UL_HAS_BSR;
+                break;
+            case MAC_LCID_UL_SINGLE_PHR:
+                report->phr = ce.u.phr;
+                report->present |= MAC_CE_UL_HAS_PHR;
+                break;
+            case MAC_LCID_UL_MULTI_PHR_1OCT:
+            case MAC_LCID_UL_MULTI_PHR_4OCT:
+                report->phr_multi = ce.u.phr_multi;
+                report->present |= MAC_CE_UL_HAS_PHR_MULTI;
+                break;
+            case MAC_LCID_UL_C_RNTI:
+                report->c_rnti = ce.u.c_rnti;
+                report->present |= MAC_CE_UL_HAS_C_RNTI;
+                break;
+            default:
+                break;
+        }
+    }
+    return n_ce;
+}
+
+/*----------------------------------------------------------------------------
+ * Encoders
+ *--------------------------------------------------------------------------*/
+
+int mac_subhdr_write(uint8_t *buf, size_t size, uint8_t lcid, int has_len, uint16_t len) {
+    if (!has_len) {
+        if (size < 1) return -1;
+        buf[0] = lcid & 0x3F;
+        return 1;
+    }
+    if (len < 256) {
+        if (size < 2) return -1;
+        buf[0] = lcid & 0x3F;
+        buf[1] = (uint8_t)len;
+        return 2;
+    }
+    if (size < 3) return -1;
+    buf[0] = (uint8_t)(0x40 | (lcid & 0x3F));
+    buf[1] = (uint8_t)(len >> 8);
+    buf[2] = (uint8_t)len;
+    return 3;
+}
+
+int mac_ce_build_short_bsr(uint8_t *buf, size_t size, int truncated, uint8_t lcg, uint32_t bytes) {
+    if (size < 2 || lcg >= MAC_NUM_LCG) return -1;
+    buf[0] = truncated ? MAC_LCID_UL_SHORT_TRUNC_BSR : MAC_LCID_UL_SHORT_BSR;
+    buf[1] = (uint8_t)((lcg << 5) | mac_bsr_index_5bit(bytes));
+    return 2;
+}
+
+int mac_ce_build_long_bsr(uint8_t *buf, size_t size, int truncated, const uint32_t bytes[MAC_NUM_LCG],
+                          uint16_t max_len) {
+    uint8_t payload[1 + MAC_NUM_LCG];
+    uint16_t plen = 1;
+
+    payload[0] = 0;
+    for (int lcg = 0; lcg < MAC_NUM_LCG; lcg++) {
+        if (!bytes[lcg]) continue;
+        payload[0] |= (uint8_t)(1u << lcg);
+        if (!truncated || plen < max_len) payload[plen++] = mac_bsr_index_8bit(bytes[lcg]);
+    }
+
+    uint8_t lcid = truncated ? MAC_LCID_UL_LONG_TRUNC_BSR : MAC_LCID_UL_LONG_BSR;
+    int h = mac_subhdr_write(buf, size, lcid, 1, plen);
+    if (h < 0 || (size_t)h + plen > size) return -1;
+    memcpy(buf + h, payload, plen);
+    return h + plen;
+}
+
+int mac_ce_build_single_phr(uint8_t *buf, size_t size, uint8_t ph, uint8_t pcmax) {
+    if (size < 3) return -1;
+    buf[0] = MAC_LCID_UL_SINGLE_PHR;
+    buf[1] = ph & 0x3F;
+    buf[2] = pcmax & 0x3F;
+    return 3;
+}
+
+int mac_ce_build_multi_phr(uint8_t *buf, size_t size, const mac_ce_phr_multi_t *phr) {
+    uint8_t payload[4 + 2 * MAC_PHR_MAX_CELLS];
+    int four = (phr->cell_bitmap >> 8) != 0;
+    uint16_t plen = 0;
+
+    for (int i = 0; i <= (four ? 3 : 0); i++) payload[plen++] = (uint8_t)(phr->cell_bitmap >> (8 * i)) & (i ? 0xFF : 0xFE);
+
+    for (int i = 0; i < phr->n_entries; i++) {
+        const mac_phr_entry_t *e = &phr->entries[i];
+        payload[plen++] = (uint8_t)((e->p << 7) | (e->v << 6) | (e->ph & 0x3F));
+        if (!e->v) payload[plen++] = e->pcmax & 0x3F;
+    }
+
+    uint8_t lcid = four ? MAC_LCID_UL_MULTI_PHR_4OCT : MAC_LCID_UL_MULTI_PHR_1OCT;
+    int h = mac_subhdr_write(buf, size, lcid, 1, plen);
+    if (h < 0 || (size_t)h + plen > size) return -1;
+    memcpy(buf + h, payload, plen);
+    return h + plen;
+}
+
+int mac_ce_build_c_rnti(uint8_t *buf, size_t size, uint16_t c_rnti) {
+    if (size < 3) return -1;
+    buf[0] = MAC_LCID_UL_C_RNTI;
+    buf[1] = (uint8_t)(c_rnti >> 8);
+    buf[2] = (uint8_t)c_rnti;
+    return 3;
+}
+
+int mac_ce_build_ta_cmd(uint8_t *buf, size_t size, uint8_t tag_id, uint8_t ta) {
+    if (size < 2) return -1;
+    buf[0] = MAC_LCID_DL_TA_CMD;
+    buf[1] = (uint8_t)(((tag_id & 0x3) << 6) | (ta & 0x3F));
+    return 2;
+}
+
+int mac_ce_build_drx_cmd(uint8_t *buf, size_t size, int long_drx) {
+    if (size < 1) return -1;
+    buf[0] = long_drx ? MAC_LCID_DL_LONG_DRX_CMD : MAC_LCID_DL_DRX_CMD;
+    return 1;
+}
+
+/*----------------------------------------------------------------------------
+ * Self test
+ *--------------------------------------------------------------------------*/
+
+/*
+ * Multiple Entry PHR vectors laid out by hand from TS 38.321 Figure
+ * 6.1.3.9-1/-2: subheader, Ci octets, then the SpCell entry and one entry
+ * per set Ci in ascending order.
+ */
+static const struct {
+    uint32_t cell_bitmap;
+    uint8_t n_entries;
+    uint8_t len;
+    uint8_t pdu[16];
+} mac_phr_vectors[] = {
+    // One octet: C1 and C3. SpCell PH 18 PCMAX 32, C1 virtual PH 5, C3 P=1 PH 7 PCMAX 42
+    { 0x0000000A, 3, 8, { 0x38, 0x06, 0x0A, 0x12, 0x20, 0x45, 0x87, 0x2A } },
+    // Four octets: C1 and C24. SpCell PH 37 PCMAX 48, C1 virtual PH 1, C24 PH 10 PCMAX 63
+    { 0x01000002, 3, 11, { 0x36, 0x09, 0x02, 0x00, 0x00, 0x01, 0x25, 0x30, 0x41, 0x0A, 0x3F } },
+};
+
+int mac_ce_selftest(void) {
+    for (size_t v = 0; v < sizeof(mac_phr_vectors) / sizeof(mac_phr_vectors[0]); v++) {
+        const uint8_t *pdu = mac_phr_vectors[v].pdu;
+        uint8_t len = mac_phr_vectors[v].len;
+        mac_subpdu_t sub;
+        mac_ce_t ce;
+        uint8_t out[16];
+
+        if (mac_pdu_demux(pdu, len, MAC_DIR_UL, &sub, 1) != 1 || mac_ce_decode(MAC_DIR_UL, pdu, &sub, &ce) < 0 ||
+            ce.u.phr_multi.cell_bitmap != mac_phr_vectors[v].cell_bitmap ||
+            ce.u.phr_multi.n_entries != mac_phr_vectors[v].n_entries ||
+            ce.u.phr_multi.entries[ce.u.phr_multi.n_entries - 1].cell != 31 - __builtin_clz(mac_phr_vectors[v].cell_bitmap)) {
+            fprintf(stderr, " mac_ce: PHR vector %zu decoded wrong.\n", v);
+            return -1;
+        }
+        int n = mac_ce_build_multi_phr(out, sizeof(out), &ce.u.phr_multi);
+        if (n != len || memcmp(out, pdu, len)) {
+            fprintf(stderr, " mac_ce: PHR vector %zu rebuilt differently.\n", v);
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,283 @@
+// mac_ce.h
+#ifndef _MAC_CE_H_
+#define _MAC_CE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "5g_nr_pdu_structures.h"
+
+/*============================================================================
+ * MAC CONTROL ELEMENT CODEC
+ * Reference: 3GPP TS 38.321 Section 6.1.2, 6.1.3, 6.2.1
+ *==========================================================================*/
+
+/**
+ * Wire access
+ *
+ * The bit-field structs in 5g_nr_pdu_structures.h document the layout but
+ * their in-memory bit order is compiler dependent (see IMPLEMENTATION
+ * NOTES), so the codec reads and writes octets with explicit shifts:
+ *
+ *   Byte 0: | R | F | LCID (6) |      F/L absent for fixed-size CEs
+ *   Byte 1: | L (8) or L high  |
+ *   Byte 2: | L low (F = 1)    |
+ */
+#define MAC_SUBHDR_R(b)     (((b) >> 7) & 0x1)
+#define MAC_SUBHDR_F(b)     (((b) >> 6) & 0x1)
+#define MAC_SUBHDR_LCID(b)  ((b) & 0x3F)
+
+#define MAC_LCID_COUNT      64
+#define MAC_LCID_MAX_SDU    32      // LCID 0-32: logical channels
+#define MAC_NUM_LCG         8
+
+typedef enum mac_dir {
+    MAC_DIR_DL = 0,   // DL-SCH, gNB -> UE
+    MAC_DIR_UL = 1,   // UL-SCH, UE -> gNB
+} mac_dir_t;
+
+/**
+ * LCID values for UL-SCH (TS 38.321 Table 6.2.1-2)
+ */
+enum {
+    MAC_LCID_UL_CCCH_64          = 0,    // CCCH of size 64 bits
+    MAC_LCID_UL_CCCH_48          = 52,   // CCCH of size 48 bits
+    MAC_LCID_UL_MULTI_PHR_4OCT   = 54,   // Multiple Entry PHR (four octets Ci)
+    MAC_LCID_UL_CG_CONFIRM       = 55,   // Configured Grant Confirmation
+    MAC_LCID_UL_MULTI_PHR_1OCT   = 56,   // Multiple Entry PHR (one octet Ci)
+    MAC_LCID_UL_SINGLE_PHR       = 57,   // Single Entry PHR
+    MAC_LCID_UL_C_RNTI           = 58,   // C-RNTI
+    MAC_LCID_UL_SHORT_TRUNC_BSR  = 59,   // Short Truncated BSR
+    MAC_LCID_UL_LONG_TRUNC_BSR   = 60,   // Long Truncated BSR
+    MAC_LCID_UL_SHORT_BSR        = 61,   // Short BSR
+    MAC_LCID_UL_LONG_BSR         = 62,   // Long BSR
+    MAC_LCID_PADDING             = 63,   // Padding (both directions)
+};
+
+/**
+ * LCID values for DL-SCH (TS 38.321 Table 6.2.1-1)
+ */
+enum {
+    MAC_LCID_DL_LONG_DRX_CMD     = 59,   // Long DRX Command
+    MAC_LCID_DL_DRX_CMD          = 60,   // DRX Command
+    MAC_LCID_DL_TA_CMD           = 61,   // Timing Advance Command
+    MAC_LCID_DL_CONTENTION_RES   = 62,   // UE Contention Resolution Identity
+};
+
+/*----------------------------------------------------------------------------
+ * Buffer Status Report
+ *--------------------------------------------------------------------------*/
+
+/**
+ * Buffer size index tables
+ *
+ * Reference: TS 38.321 Table 6.1.3.1-1 (5-bit, Short BSR) and
+ *            Table 6.1.3.1-2 (8-bit, Long BSR)
+ *
+ * Entry i holds the largest buffer size (bytes) reported by index i. The
+ * last 5-bit index (31) and the 8-bit index 254 mean "more than the
+ * previous entry"; 8-bit index 255 is reserved.
+ */
+#define MAC_BSR_5BIT_LEVELS  32
+#define MAC_BSR_8BIT_LEVELS  255
+
+extern const uint32_t mac_bsr_5bit_table[MAC_BSR_5BIT_LEVELS];
+extern const uint32_t mac_bsr_8bit_table[MAC_BSR_8BIT_LEVELS];
+
+// Smallest index whose level covers bytes (saturates at the top index)
+uint8_t mac_bsr_index_5bit(uint32_t bytes);
+uint8_t mac_bsr_index_8bit(uint32_t bytes);
+
+typedef enum mac_bsr_format {
+    MAC_BSR_SHORT,
+    MAC_BSR_SHORT_TRUNCATED,
+    MAC_BSR_LONG,
+    MAC_BSR_LONG_TRUNCATED,
+} mac_bsr_format_t;
+
+/**
+ * Decoded BSR
+ *
+ * - lcg_bitmap: LCGs reported (Short: the one LCG, Long: LCGi field)
+ * - bs_index: per LCG buffer size index (5-bit for Short, 8-bit for Long)
+ * - reported: bitmap of LCGs whose bs_index is present; differs from
+ *   lcg_bitmap only for Long Truncated BSR
+ */
+typedef struct mac_ce_bsr {
+    uint8_t format;                     // mac_bsr_format_t
+    uint8_t lcg_bitmap;
+    uint8_t reported;
+    uint8_t bs_index[MAC_NUM_LCG];
+} mac_ce_bsr_t;
+
+/*----------------------------------------------------------------------------
+ * Power Headroom Report
+ *--------------------------------------------------------------------------*/
+
+#define MAC_PHR_MAX_CELLS 32
+
+// Single Entry PHR (TS 38.321 Section 6.1.3.8): | R R PH (6) | R R PCMAX,f,c (6) |
+typedef struct mac_ce_phr_single {
+    uint8_t ph;          // Power headroom level index (0-63)
+    uint8_t pcmax;       // P_CMAX,f,c level index (0-63)
+} mac_ce_phr_single_t;
+
+typedef struct mac_phr_entry {
+    uint8_t cell;        // ServCellIndex (0 = SpCell)
+    uint8_t p;           // P bit: power backoff due to power management
+    uint8_t v;           // V bit: 1 = virtual PH, no PCMAX octet
+    uint8_t ph;          // PH level index
+    uint8_t pcmax;       // PCMAX level index (valid if v == 0)
+} mac_phr_entry_t;
+
+/**
+ * Multiple Entry PHR (TS 38.321 Section 6.1.3.9)
+ *
+ * Ci bitmap (1 or 4 octets, bit 0 reserved), then one entry for the SpCell
+ * followed by one entry per set Ci in ascending order.
+ */
+typedef struct mac_ce_phr_multi {
+    uint32_t cell_bitmap;                    // Ci bits, bit i = ServCellIndex i
+    uint8_t n_entries;
+    mac_phr_entry_t entries[MAC_PHR_MAX_CELLS];
+} mac_ce_phr_multi_t;
+
+/*----------------------------------------------------------------------------
+ * Decoded CE container and LCID dispatch
+ *--------------------------------------------------------------------------*/
+
+typedef struct mac_ce {
+    uint8_t lcid;
+    union {
+        mac_ce_bsr_t bsr;
+        mac_ce_phr_single_t phr;
+        mac_ce_phr_multi_t phr_multi;
+        uint16_t c_rnti;
+        struct {
+            uint8_t tag_id;     // Timing Advance Group (0-3)
+            uint8_t ta;         // TA command (0-63)
+        } ta;
+        uint8_t contention_id[6];
+    } u;
+} mac_ce_t;
+
+/**
+ * One entry of the 64-entry LCID dispatch tables.
+ *
+ * - fixed: 1 for fixed-size CEs (1-byte subheader, no F/L), 0 when the
+ *   subheader carries F/L
+ * - len: payload length of a fixed-size CE
+ * - decode: payload decoder, NULL for LCIDs that are SDUs, padding or not
+ *   handled by the codec
+ */
+typedef int (*mac_ce_decode_fn)(const uint8_t *p, uint16_t len, mac_ce_t *ce);
+
+typedef struct mac_lcid_desc {
+    uint8_t fixed;
+    uint8_t len;
+    mac_ce_decode_fn decode;
+} mac_lcid_desc_t;
+
+extern const mac_lcid_desc_t mac_lcid_table_ul[MAC_LCID_COUNT];
+extern const mac_lcid_desc_t mac_lcid_table_dl[MAC_LCID_COUNT];
+
+static inline const mac_lcid_desc_t *mac_lcid_table(mac_dir_t dir) {
+    return dir == MAC_DIR_UL ? mac_lcid_table_ul : mac_lcid_table_dl;
+}
+
+/*----------------------------------------------------------------------------
+ * MAC PDU demultiplexing
+ *--------------------------------------------------------------------------*/
+
+// One MAC subPDU: subheader plus SDU / CE payload
+typedef struct mac_subpdu {
+    uint8_t  lcid;
+    uint8_t  hdr_len;    // 1, 2 or 3 bytes
+    uint32_t offset;     // Payload offset in the MAC PDU
+    uint32_t len;        // Payload length
+} mac_subpdu_t;
+
+/**
+ * Split a MAC PDU into subPDUs using the LCID table of dir.
+ *
+ * Padding (LCID 63) ends the walk and is not returned. Returns the number
+ * of subPDUs written to out, -1 if the PDU is malformed or has more than
+ * max subPDUs.
+ */
+int mac_pdu_demux(const uint8_t *pdu, size_t len, mac_dir_t dir, mac_subpdu_t *out, int max);
+
+/**
+ * Fast-reject pass over up to 32 MAC PDUs, before any per-UE lookup.
+ * Returns a bitmask with bit i set when PDU i is well formed: every
+ * subheader has R = 0 and an LCID in lcid_ok (padding is always
+ * accepted and ends the PDU), every L field is non-zero, and the
+ * subPDUs fit the TB length exactly or up to padding. Stricter than
+ * mac_pdu_demux(), which ignores R and unknown LCIDs.
+ *
+ * lcid_ok: mac_lcid_valid_mask(dir), or a subset of it such as only the
+ * logical channels configured in the cell.
+ */
+uint32_t mac_pdu_validate_burst(const uint8_t *const pdu[], const uint32_t len[], uint32_t n,
+                                mac_dir_t dir, uint64_t lcid_ok);
+
+// LCIDs defined in dir: logical channels 0-32 and the CEs of its LCID table
+uint64_t mac_lcid_valid_mask(mac_dir_t dir);
+
+// Decode one CE subPDU. Returns 0 on success, -1 if malformed or unsupported.
+int mac_ce_decode(mac_dir_t dir, const uint8_t *pdu, const mac_subpdu_t *sub, mac_ce_t *ce);
+
+/**
+ * Summary of all CEs in a UL MAC PDU, the per-UE per-slot scheduler input.
+ *
+ * present is a bitmask of MAC_CE_UL_HAS_* flags.
+ */
+#define MAC_CE_UL_HAS_BSR        (1u << 0)
+#define MAC_CE_UL_HAS_PHR        (1u << 1)
+#define MAC_CE_UL_HAS_PHR_MULTI  (1u << 2)
+#define MAC_CE_UL_HAS_C_RNTI     (1u << 3)
+
+typedef struct mac_ce_ul_report {
+    uint32_t present;
+    mac_ce_bsr_t bsr;
+    mac_ce_phr_single_t phr;
+    mac_ce_phr_multi_t phr_multi;
+    uint16_t c_rnti;
+} mac_ce_ul_report_t;
+
+// Returns number of CEs decoded, -1 if the PDU is malformed
+int mac_ce_parse_ul(const uint8_t *pdu, size_t len, mac_ce_ul_report_t *report);
+
+/*----------------------------------------------------------------------------
+ * Encoders
+ *
+ * Each builder writes subheader + payload at buf and returns the number of
+ * bytes written, or -1 if it does not fit in size.
+ *--------------------------------------------------------------------------*/
+
+int mac_ce_build_short_bsr(uint8_t *buf, size_t size, int truncated, uint8_t lcg, uint32_t bytes);
+
+/**
+ * Long / Long Truncated BSR from per-LCG byte counts. LCGs with zero bytes
+ * are left out of the bitmap. For the truncated format, max_len caps the
+ * payload and the highest-priority LCGs (lowest index) are reported first.
+ */
+int mac_ce_build_long_bsr(uint8_t *buf, size_t size, int truncated, const uint32_t bytes[MAC_NUM_LCG],
+                          uint16_t max_len);
+
+int mac_ce_build_single_phr(uint8_t *buf, size_t size, uint8_t ph, uint8_t pcmax);
+int mac_ce_build_multi_phr(uint8_t *buf, size_t size, const mac_ce_phr_multi_t *phr);
+int mac_ce_build_c_rnti(uint8_t *buf, size_t size, uint16_t c_rnti);
+int mac_ce_build_ta_cmd(uint8_t *buf, size_t size, uint8_t tag_id, uint8_t ta);
+int mac_ce_build_drx_cmd(uint8_t *buf, size_t size, int long_drx);
+
+// Generic subheader writer used by the builders and MAC multiplexing
+int mac_subhdr_write(uint8_t *buf, size_t size, uint8_t lcid, int has_len, uint16_t len);
+
+/**
+ * Decode and rebuild known Multiple Entry PHR byte vectors (one and four
+ * Ci octets). Returns 0 when every vector round-trips, -1 otherwise
+ * (reported on stderr).
+ */
+int mac_ce_selftest(void);
+
+#endif
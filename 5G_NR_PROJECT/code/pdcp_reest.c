@@ -0,0 +1,282 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "pdcp_reest.h"
+
+static uint64_t pdcp_reest_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*----------------------------------------------------------------------------
+ * Transmit buffer
+ *--------------------------------------------------------------------------*/
+
+int pdcp_tx_bearer_init(pdcp_tx_bearer_t *b, pdcp_rb_type_t type, uint8_t sn_bits, uint8_t bearer_id,
+                        uint8_t dir, uint32_t window, l2_buf_pool_t *pool, sdu_queue_t *rlc_q, uint16_t worker) {
+    memset(b, 0, sizeof(*b));
+    if ((sn_bits != 12 && sn_bits != 18) || !window || (window & (window - 1)) ||
+        window > (1u << (sn_bits - 1)) || !pool || !rlc_q || bearer_id > 31)
+        return -1;
+
+    b->sdu = malloc(window * sizeof(*b->sdu));
+    if (!b->sdu) return -1;
+    for (uint32_t i = 0; i < window; i++) b->sdu[i].buf = L2_BUF_NONE;
+    b->type = type;
+    b->sn_bits = sn_bits;
+    b->bearer_id = bearer_id;
+    b->dir = dir;
+    b->worker = worker;
+    b->mask = window - 1;
+    b->pool = pool;
+    b->rlc_q = rlc_q;
+    return 0;
+}
+
+// Drop every stored SDU
+static uint32_t pdcp_tx_release_all(pdcp_tx_bearer_t *b) {
+    uint32_t n = 0;
+    for (uint32_t c = b->tx_unacked; c != b->tx_next; c++) {
+        pdcp_tx_sdu_t *e = &b->sdu[c & b->mask];
+        if (e->buf == L2_BUF_NONE) continue;
+        l2_buf_put(b->pool, e->buf);
+        e->buf = L2_BUF_NONE;
+        n++;
+    }
+    b->tx_unacked = b->tx_next;
+    return n;
+}
+
+void pdcp_tx_bearer_destroy(pdcp_tx_bearer_t *b) {
+    if (b->sdu) pdcp_tx_release_all(b);
+    free(b->sdu);
+    memset(b, 0, sizeof(*b));
+}
+
+int64_t pdcp_tx_store(pdcp_tx_bearer_t *b, l2_buf_ref_t sdu, uint32_t len) {
+    if (b->tx_next - b->tx_unacked > b->mask) return -1;
+    pdcp_tx_sdu_t *e = &b->sdu[b->tx_next & b->mask];
+    l2_buf_get(b->pool, sdu);
+    e->buf = sdu;
+    e->len = len;
+    return b->tx_next++;
+}
+
+static void pdcp_tx_advance(pdcp_tx_bearer_t *b) {
+    while (b->tx_unacked != b->tx_next && b->sdu[b->tx_unacked & b->mask].buf == L2_BUF_NONE) b->tx_unacked++;
+}
+
+// Release COUNT if stored; returns 1 if it was
+static int pdcp_tx_release(pdcp_tx_bearer_t *b, uint32_t count) {
+    if (count - b->tx_unacked >= b->tx_next - b->tx_unacked) return 0;
+    pdcp_tx_sdu_t *e = &b->sdu[count & b->mask];
+    if (e->buf == L2_BUF_NONE) return 0;
+    l2_buf_put(b->pool, e->buf);
+    e->buf = L2_BUF_NONE;
+    b->acked++;
+    return 1;
+}
+
+void pdcp_tx_ack(pdcp_tx_bearer_t *b, uint32_t count) {
+    if (pdcp_tx_release(b, count)) pdcp_tx_advance(b);
+}
+
+/**
+ * Status Report: D/C = 0, PDU Type 000, then the 32-bit FMC (6.2.3.1;
+ * pdcp_control_pdu_status_report_t shows only 24 bits of it) and a
+ * bitmap whose MSB first bits stand for FMC + 1, FMC + 2, ...; 1 means
+ * received.
+ */
+int pdcp_tx_status_report(pdcp_tx_bearer_t *b, const uint8_t *pdu, size_t len) {
+    if (len < 5 || (pdu[0] & 0xF0) != 0x00) return -1;
+
+    uint32_t fmc = ((uint32_t)pdu[1] << 24) | ((uint32_t)pdu[2] << 16) | ((uint32_t)pdu[3] << 8) | pdu[4];
+    int n = 0;
+
+    // Everything below FMC; a stale report (FMC behind) releases nothing
+    if ((int32_t)(fmc - b->tx_unacked) > 0) {
+        uint32_t end = (int32_t)(fmc - b->tx_next) > 0 ? b->tx_next : fmc;
+        for (uint32_t c = b->tx_unacked; c != end; c++) n += pdcp_tx_release(b, c);
+    }
+    for (size_t i = 5; i < len; i++) {
+        for (uint8_t m = pdu[i], bit = 0; m; m = (uint8_t)(m << 1), bit++) {
+            if (m & 0x80) n += pdcp_tx_release(b, fmc + 1 + (uint32_t)(i - 5) * 8 + bit);
+        }
+    }
+    pdcp_tx_advance(b);
+    return n;
+}
+
+void pdcp_cipher_nea0_burst(void *ctx, pdcp_cipher_op_t *ops, uint32_t n) {
+    (void)ctx;
+    (void)ops;
+    (void)n;
+}
+
+/*----------------------------------------------------------------------------
+ * Batched re-establishment
+ *--------------------------------------------------------------------------*/
+
+typedef struct pdcp_reest_burst {
+    pdcp_cipher_op_t op[PDCP_REEST_BURST];
+    pdcp_tx_bearer_t *b[PDCP_REEST_BURST];
+    l2_buf_ref_t pdu[PDCP_REEST_BURST];
+    uint32_t len[PDCP_REEST_BURST];
+    uint32_t n;
+    pdcp_tx_bearer_t *stalled;         // Last bearer whose RLC queue refused a PDU
+} pdcp_reest_burst_t;
+
+/**
+ * Cipher the burst and queue it; PDUs of one bearer keep their COUNT order.
+ * The first PDU a bearer's RLC queue drops stalls that bearer: its later
+ * PDUs are not queued (they would overtake the dropped COUNT), their SDUs
+ * stay in the window for a later recovery, and bu->stalled is set.
+ */
+static void pdcp_reest_flush(const pdcp_reest_job_t *job, pdcp_reest_burst_t *bu, pdcp_reest_stats_t *st) {
+    if (!bu->n) return;
+    job->cipher(job->cipher_ctx, bu->op, bu->n);
+    for (uint32_t i = 0; i < bu->n; i++) {
+        pdcp_tx_bearer_t *b = bu->b[i];
+        if (b == bu->stalled) {
+            l2_buf_put(b->pool, bu->pdu[i]);
+            st->queue_held++;
+            continue;
+        }
+        if (sdu_queue_enqueue(b->rlc_q, bu->pdu[i], bu->len[i], job->now_ns) < 0) {
+            st->queue_drops++;
+            bu->stalled = b;
+            continue;
+        }
+        b->retx_pdus++;
+        b->retx_bytes += bu->len[i];
+        st->retx_pdus++;
+        st->retx_bytes += bu->len[i];
+    }
+    st->bursts++;
+    bu->n = 0;
+}
+
+// Rebuild the PDUs of every unconfirmed SDU of an AM DRB into the burst
+static void pdcp_reest_am(const pdcp_reest_job_t *job, pdcp_tx_bearer_t *b, pdcp_reest_burst_t *bu,
+                          pdcp_reest_stats_t *st) {
+    uint32_t hdr = b->sn_bits == 12 ? 2 : 3;
+
+    for (uint32_t c = b->tx_unacked; c != b->tx_next; c++) {
+        const pdcp_tx_sdu_t *e = &b->sdu[c & b->mask];
+        if (e->buf == L2_BUF_NONE) continue;
+
+        l2_buf_ref_t ref = hdr + e->len <= b->pool->buf_size ? l2_buf_alloc(b->pool) : L2_BUF_NONE;
+        if (ref == L2_BUF_NONE) {
+            // Later COUNTs must not overtake this one: stop here
+            st->alloc_fail++;
+            return;
+        }
+        uint8_t *p = l2_buf_data(b->pool, ref);
+        if (hdr == 2) {
+            p[0] = (uint8_t)(0x80 | ((c >> 8) & 0x0F));
+            p[1] = (uint8_t)c;
+        } else {
+            p[0] = (uint8_t)(0x80 | ((c >> 16) & 0x03));
+            p[1] = (uint8_t)(c >> 8);
+            p[2] = (uint8_t)c;
+        }
+        memcpy(p + hdr, l2_buf_data(b->pool, e->buf), e->len);
+
+        uint32_t i = bu->n++;
+        bu->op[i] = (pdcp_cipher_op_t){ .key = b->key, .count = c, .bearer = b->bearer_id, .dir = b->dir,
+                                        .data = p + hdr, .len = e->len };
+        bu->b[i] = b;
+        bu->pdu[i] = ref;
+        bu->len[i] = hdr + e->len;
+        if (bu->n == PDCP_REEST_BURST) {
+            pdcp_reest_flush(job, bu, st);
+            if (bu->stalled == b) return;
+        }
+    }
+}
+
+void pdcp_reest_worker(const pdcp_reest_job_t *job, uint16_t worker, pdcp_reest_stats_t *st) {
+    pdcp_reest_burst_t bu;
+    bu.n = 0;
+    bu.stalled = NULL;
+
+    for (uint32_t i = 0; i < job->n_bearers; i++) {
+        pdcp_tx_bearer_t *b = job->bearers[i];
+        if (b->worker != worker) continue;
+        if (b->type != PDCP_RB_DRB_AM && job->kind == PDCP_REEST_RECOVERY) continue;
+
+        st->bearers++;
+        st->rlc_purged += sdu_queue_purge(b->rlc_q);
+        if (b->type == PDCP_RB_DRB_AM) {
+            pdcp_reest_am(job, b, &bu, st);
+        } else {
+            uint32_t n = pdcp_tx_release_all(b);
+            b->reest_discards += n;
+            st->discarded += n;
+            b->tx_next = b->tx_unacked = 0;
+        }
+    }
+    pdcp_reest_flush(job, &bu, st);
+}
+
+typedef struct pdcp_reest_thread {
+    pthread_t thread;
+    const pdcp_reest_job_t *job;
+    uint16_t worker;
+    pdcp_reest_stats_t st;
+} pdcp_reest_thread_t;
+
+static void *pdcp_reest_thread_run(void *arg) {
+    pdcp_reest_thread_t *t = arg;
+    pdcp_reest_worker(t->job, t->worker, &t->st);
+    return NULL;
+}
+
+static void pdcp_reest_sum(pdcp_reest_stats_t *st, const pdcp_reest_stats_t *s) {
+    st->bearers += s->bearers;
+    st->rlc_purged += s->rlc_purged;
+    st->retx_pdus += s->retx_pdus;
+    st->retx_bytes += s->retx_bytes;
+    st->discarded += s->discarded;
+    st->bursts += s->bursts;
+    st->alloc_fail += s->alloc_fail;
+    st->queue_drops += s->queue_drops;
+    st->queue_held += s->queue_held;
+}
+
+int pdcp_reest_run(const pdcp_reest_job_t *job, pdcp_reest_stats_t *st) {
+    uint64_t t0 = pdcp_reest_now_ns();
+    uint16_t n = job->n_workers ? job->n_workers : 1;
+    int rc = 0;
+
+    memset(st, 0, sizeof(*st));
+    pdcp_reest_thread_t *t = calloc(n, sizeof(*t));
+    if (!t) {
+        for (uint16_t w = 0; w < n; w++) pdcp_reest_worker(job, w, st);
+        st->elapsed_ns = pdcp_reest_now_ns() - t0;
+        return -1;
+    }
+
+    // Shard 0 runs on the calling thread
+    uint16_t started = 1;
+    for (; started < n; started++) {
+        t[started].job = job;
+        t[started].worker = started;
+        if (pthread_create(&t[started].thread, NULL, pdcp_reest_thread_run, &t[started]) != 0) break;
+    }
+    pdcp_reest_worker(job, 0, &t[0].st);
+    if (started < n) {
+        rc = -1;
+        for (uint16_t w = started; w < n; w++) pdcp_reest_worker(job, w, &t[w].st);
+    }
+    for (uint16_t w = 1; w < started; w++) pthread_join(t[w].thread, NULL);
+
+    for (uint16_t w = 0; w < n; w++) pdcp_reest_sum(st, &t[w].st);
+    free(t);
+    st->elapsed_ns = pdcp_reest_now_ns() - t0;
+    return rc;
+}
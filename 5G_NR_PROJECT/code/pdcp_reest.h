@@ -0,0 +1,184 @@
+// pdcp_reest.h
+#ifndef _PDCP_REEST_H_
+#define _PDCP_REEST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "l2_pool.h"
+#include "sdu_queue.h"
+
+/*============================================================================
+ * PDCP RE-ESTABLISHMENT AND DATA RECOVERY, BATCHED PER CELL
+ * Reference: 3GPP TS 38.323 Section 5.1.2 (re-establishment),
+ *            5.4 (status reporting), 5.5 (data recovery),
+ *            6.2.3.1 (Status Report), 5.8 (ciphering)
+ *            TS 33.501 Annex D (NEA input: KEY, COUNT, BEARER, DIRECTION)
+ *==========================================================================*/
+
+/**
+ * PDCP transmit buffer and batched recovery
+ *
+ * Description:
+ * A transmitting PDCP entity keeps every SDU it has assigned a COUNT to
+ * until lower layers confirm its delivery (pdcp_tx_bearer_t: a
+ * power-of-two window of pool buffer references indexed by COUNT). The
+ * confirmations come from RLC AM (pdcp_tx_ack) or from a PDCP Status
+ * Report sent by the peer (pdcp_tx_status_report).
+ *
+ * On handover or RRC re-establishment every bearer of the UE re-establishes
+ * PDCP, and after a cell outage that is every bearer of every UE of the
+ * cell at once. pdcp_reest_run() handles such a batch:
+ *
+ *   1. The bearer's RLC SDU queue is purged; those PDUs were ciphered
+ *      with the old keys (or go to a released RLC entity).
+ *   2. AM DRBs: every stored SDU from the first unconfirmed COUNT up to
+ *      TX_NEXT is rebuilt into a new PDU (header + SDU), in ascending
+ *      COUNT order. UM DRBs and SRBs drop their stored SDUs and restart
+ *      at COUNT 0 (5.1.2).
+ *   3. The PDUs are ciphered in bursts of PDCP_REEST_BURST through a
+ *      pdcp_cipher_burst_fn with each bearer's current key; a burst
+ *      gathers PDUs across bearers so that a batch cipher engine sees
+ *      full bursts even when each bearer has only a few SDUs left.
+ *   4. Each burst is queued to the bearers' RLC SDU queues in order.
+ *
+ * Data recovery (5.5, PDCP_REEST_RECOVERY) is the same on AM DRBs with
+ * the keys unchanged; other bearers are left alone.
+ *
+ * Bearers are sharded by worker: a pool and an SDU queue belong to one
+ * thread (l2_pool and sdu_queue are not thread safe), so each bearer names
+ * the worker that owns its pool and queue, and pdcp_reest_worker() only
+ * touches the bearers of one worker. Either every worker calls
+ * pdcp_reest_worker() for its own shard, or, with the data path stopped
+ * for the handover, pdcp_reest_run() runs all shards on threads of its
+ * own. Bearers of different workers never share a burst.
+ *
+ * New keys are installed with pdcp_tx_bearer_rekey() before the run.
+ * Header compression is not re-initialized here (SDUs are stored
+ * uncompressed) and DRB integrity protection is not covered.
+ */
+#define PDCP_REEST_BURST   32
+#define PDCP_KEY_LEN       16
+
+typedef enum pdcp_rb_type {
+    PDCP_RB_SRB    = 0,
+    PDCP_RB_DRB_AM = 1,
+    PDCP_RB_DRB_UM = 2,
+} pdcp_rb_type_t;
+
+typedef enum pdcp_reest_kind {
+    PDCP_REEST_REESTABLISH = 0,   // 5.1.2, usually with new keys
+    PDCP_REEST_RECOVERY    = 1,   // 5.5, AM DRBs only, same keys
+} pdcp_reest_kind_t;
+
+typedef struct pdcp_tx_sdu {
+    l2_buf_ref_t buf;          // L2_BUF_NONE: free or delivery confirmed
+    uint32_t len;
+} pdcp_tx_sdu_t;
+
+typedef struct pdcp_tx_bearer {
+    pdcp_rb_type_t type;
+    uint8_t  sn_bits;          // 12 / 18
+    uint8_t  bearer_id;        // BEARER input to ciphering (5 bits)
+    uint8_t  dir;              // DIRECTION input: 0 uplink, 1 downlink
+    uint16_t worker;           // Thread owning pool and rlc_q
+    uint8_t  key[PDCP_KEY_LEN];
+
+    uint32_t tx_next;          // TX_NEXT
+    uint32_t tx_unacked;       // Lowest COUNT whose delivery is not confirmed
+    uint32_t mask;             // Window - 1
+    pdcp_tx_sdu_t *sdu;        // [window], by COUNT
+
+    l2_buf_pool_t *pool;       // Stored SDUs and rebuilt PDUs
+    sdu_queue_t *rlc_q;        // PDCP -> RLC
+
+    uint64_t acked;
+    uint64_t retx_pdus, retx_bytes;
+    uint64_t reest_discards;   // Stored SDUs dropped by re-establishment (UM / SRB)
+} pdcp_tx_bearer_t;
+
+/**
+ * window: SDUs kept for retransmission (power of two, at most half the
+ * SN space). Returns 0, -1 on bad arguments or allocation failure.
+ */
+int  pdcp_tx_bearer_init(pdcp_tx_bearer_t *b, pdcp_rb_type_t type, uint8_t sn_bits, uint8_t bearer_id,
+                         uint8_t dir, uint32_t window, l2_buf_pool_t *pool, sdu_queue_t *rlc_q, uint16_t worker);
+void pdcp_tx_bearer_destroy(pdcp_tx_bearer_t *b);
+
+static inline void pdcp_tx_bearer_rekey(pdcp_tx_bearer_t *b, const uint8_t key[PDCP_KEY_LEN]) {
+    for (int i = 0; i < PDCP_KEY_LEN; i++) b->key[i] = key[i];
+}
+
+/**
+ * Assign TX_NEXT to an SDU and take a reference to it for retransmission
+ * (the caller keeps its own). Returns the COUNT, or -1 when the window
+ * is full of unconfirmed SDUs.
+ */
+int64_t pdcp_tx_store(pdcp_tx_bearer_t *b, l2_buf_ref_t sdu, uint32_t len);
+
+// Lower layers confirmed delivery of COUNT
+void pdcp_tx_ack(pdcp_tx_bearer_t *b, uint32_t count);
+
+/**
+ * Apply a PDCP Status Report (6.2.3.1): COUNTs below FMC, and those with
+ * their bitmap bit set, were received by the peer. Returns the SDUs
+ * released, -1 if the PDU is not a well-formed Status Report.
+ */
+int pdcp_tx_status_report(pdcp_tx_bearer_t *b, const uint8_t *pdu, size_t len);
+
+/**
+ * Batched ciphering (NEA). Each op transforms data[0..len) in place with
+ * the keystream for (key, count, bearer, dir). A burst may mix bearers.
+ */
+typedef struct pdcp_cipher_op {
+    const uint8_t *key;
+    uint32_t count;
+    uint8_t  bearer;
+    uint8_t  dir;
+    uint8_t *data;
+    uint32_t len;
+} pdcp_cipher_op_t;
+
+typedef void (*pdcp_cipher_burst_fn)(void *ctx, pdcp_cipher_op_t *ops, uint32_t n);
+
+// NEA0 (null ciphering)
+void pdcp_cipher_nea0_burst(void *ctx, pdcp_cipher_op_t *ops, uint32_t n);
+
+typedef struct pdcp_reest_stats {
+    uint64_t bearers;
+    uint64_t rlc_purged;       // PDUs dropped from RLC SDU queues
+    uint64_t retx_pdus, retx_bytes;
+    uint64_t discarded;        // Stored SDUs dropped (UM DRB, SRB)
+    uint64_t bursts;           // Cipher bursts
+    uint64_t alloc_fail;       // No buffer for a PDU (SDU kept for a later recovery)
+    uint64_t queue_drops;      // RLC SDU queue full: the bearer stopped there (SDUs kept for a later recovery)
+    uint64_t queue_held;       // PDUs built behind such a drop and not queued
+    uint64_t elapsed_ns;       // pdcp_reest_run() wall time
+} pdcp_reest_stats_t;
+
+typedef struct pdcp_reest_job {
+    pdcp_reest_kind_t kind;
+    pdcp_tx_bearer_t *const *bearers;
+    uint32_t n_bearers;
+    uint16_t n_workers;        // Bearer worker indexes are < n_workers
+    pdcp_cipher_burst_fn cipher;
+    void *cipher_ctx;          // Shared by all workers: must be thread safe
+    uint64_t now_ns;           // Enqueue stamp for the RLC SDU queues
+} pdcp_reest_job_t;
+
+/**
+ * Run the job on the bearers of one worker, on that worker's thread.
+ * Adds to *st.
+ */
+void pdcp_reest_worker(const pdcp_reest_job_t *job, uint16_t worker, pdcp_reest_stats_t *st);
+
+/**
+ * Run every shard in parallel, shard 0 on the calling thread and the
+ * others on threads started here, and wait for them. The bearers' workers
+ * must not touch their pools or queues meanwhile.
+ * st gets the totals. Returns 0, -1 if threads could not be started (the
+ * remaining shards then run on the calling thread).
+ */
+int pdcp_reest_run(const pdcp_reest_job_t *job, pdcp_reest_stats_t *st);
+
+#endif
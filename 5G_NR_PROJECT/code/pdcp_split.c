@@ -0,0 +1,413 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pdcp_split.h"
+
+#define PDCP_SPLIT_CHUNK 64            // PDUs staged on the stack per push
+
+static uint32_t pdcp_pow2(uint32_t v) {
+    uint32_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static int pdcp_ring_init(pdcp_ring_t *r, uint32_t slots) {
+    memset(r, 0, sizeof(*r));
+    r->slots = calloc(slots, sizeof(*r->slots));
+    if (!r->slots) return -1;
+    r->mask = slots - 1;
+    return 0;
+}
+
+static void pdcp_ring_free(pdcp_ring_t *r) {
+    free(r->slots);
+    r->slots = NULL;
+}
+
+int pdcp_split_init(pdcp_split_t *sp, const pdcp_split_cfg_t *cfg, l2_buf_pool_t *pool,
+                    const l2_buf_pool_t *const rx_pool[PDCP_SPLIT_LEGS], pdcp_deliver_fn deliver, void *ctx) {
+    memset(sp, 0, sizeof(*sp));
+    if ((cfg->sn_bits != 12 && cfg->sn_bits != 18) || cfg->primary >= PDCP_SPLIT_LEGS ||
+        cfg->mode > PDCP_SPLIT_DUPLICATE || !pool || !deliver || !rx_pool || !rx_pool[0] || !rx_pool[1])
+        return -1;
+
+    sp->cfg = *cfg;
+    sp->cfg.ring_size = pdcp_pow2(cfg->ring_size ? cfg->ring_size : 1024);
+    sp->cfg.reorder_slots = pdcp_pow2(cfg->reorder_slots ? cfg->reorder_slots : 4096);
+    // The receive window must not cover more than half the SN space
+    if (sp->cfg.reorder_slots > (1u << (cfg->sn_bits - 1))) sp->cfg.reorder_slots = 1u << (cfg->sn_bits - 1);
+    sp->pool = pool;
+    sp->deliver = deliver;
+    sp->deliver_ctx = ctx;
+
+    sp->leg = aligned_alloc(PDCP_SPLIT_CACHELINE, PDCP_SPLIT_LEGS * sizeof(*sp->leg));
+    sp->rx_buf = malloc(sp->cfg.reorder_slots * sizeof(*sp->rx_buf));
+    if (!sp->leg || !sp->rx_buf) goto fail;
+    memset(sp->leg, 0, PDCP_SPLIT_LEGS * sizeof(*sp->leg));
+    for (uint32_t i = 0; i < sp->cfg.reorder_slots; i++) sp->rx_buf[i].buf = L2_BUF_NONE;
+
+    for (int i = 0; i < PDCP_SPLIT_LEGS; i++) {
+        pdcp_leg_t *l = &sp->leg[i];
+        // A return ring holds every buffer of its pool twice over: never full
+        if (pdcp_ring_init(&l->tx, sp->cfg.ring_size) < 0 ||
+            pdcp_ring_init(&l->tx_ret, pdcp_pow2(2 * pool->n_bufs)) < 0 ||
+            pdcp_ring_init(&l->rx, sp->cfg.ring_size) < 0 ||
+            pdcp_ring_init(&l->rx_ret, pdcp_pow2(2 * rx_pool[i]->n_bufs)) < 0)
+            goto fail;
+        l->rx_pool = rx_pool[i];
+        atomic_store_explicit(&l->st.rate, cfg->init_rate[i] ? cfg->init_rate[i] : 1, memory_order_relaxed);
+    }
+    tw_timer_init(&sp->t_reordering, TW_PDCP_T_REORDERING, 0);
+    return 0;
+
+fail:
+    pdcp_split_destroy(sp);
+    return -1;
+}
+
+void pdcp_split_destroy(pdcp_split_t *sp) {
+    if (sp->leg) {
+        for (int i = 0; i < PDCP_SPLIT_LEGS; i++) {
+            pdcp_ring_free(&sp->leg[i].tx);
+            pdcp_ring_free(&sp->leg[i].tx_ret);
+            pdcp_ring_free(&sp->leg[i].rx);
+            pdcp_ring_free(&sp->leg[i].rx_ret);
+        }
+    }
+    free(sp->leg);
+    free(sp->rx_buf);
+    memset(sp, 0, sizeof(*sp));
+}
+
+/*----------------------------------------------------------------------------
+ * Transmit (PDCP thread)
+ *--------------------------------------------------------------------------*/
+
+static uint32_t pdcp_tx_push(pdcp_split_t *sp, int leg, const pdcp_split_pdu_t *pdu, uint32_t n) {
+    pdcp_leg_t *l = &sp->leg[leg];
+    uint32_t k = pdcp_ring_push(&l->tx, pdu, n);
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < k; i++) bytes += pdu[i].len;
+    l->pushed_bytes += bytes;
+    l->tx_pdus += k;
+    l->tx_bytes += bytes;
+    return k;
+}
+
+// Bytes queued towards a leg: its RLC backlog plus what it has not yet taken
+static uint64_t pdcp_leg_queued(const pdcp_leg_t *l) {
+    return atomic_load_explicit(&l->st.backlog_bytes, memory_order_relaxed) + l->pushed_bytes -
+           atomic_load_explicit(&l->st.taken_bytes, memory_order_relaxed);
+}
+
+/**
+ * Bytes of a burst of S bytes to put on leg 0 so that both legs finish
+ * at the same time: d0 + (B0 + x) / R0 = d1 + (B1 + S - x) / R1, solved
+ * for x and clamped to [0, S].
+ */
+static uint64_t pdcp_split_point(const pdcp_split_t *sp, uint64_t S) {
+    double B0 = (double)pdcp_leg_queued(&sp->leg[0]), B1 = (double)pdcp_leg_queued(&sp->leg[1]);
+    double R0 = (double)atomic_load_explicit(&sp->leg[0].st.rate, memory_order_relaxed);
+    double R1 = (double)atomic_load_explicit(&sp->leg[1].st.rate, memory_order_relaxed);
+    double dd = ((double)sp->cfg.extra_delay_ns[1] - (double)sp->cfg.extra_delay_ns[0]) * 1e-9;
+
+    double x = (R0 * (B1 + (double)S) - R1 * B0 + R0 * R1 * dd) / (R0 + R1);
+    if (x <= 0) return 0;
+    if (x >= (double)S) return S;
+    return (uint64_t)x;
+}
+
+static uint32_t pdcp_tx_dup(pdcp_split_t *sp, const pdcp_split_pdu_t *pdu, uint32_t n) {
+    pdcp_split_pdu_t v[PDCP_SPLIT_CHUNK];
+    uint32_t done = 0;
+
+    while (done < n) {
+        uint32_t room0 = pdcp_ring_room(&sp->leg[0].tx), room1 = pdcp_ring_room(&sp->leg[1].tx);
+        uint32_t m = n - done;
+        if (m > PDCP_SPLIT_CHUNK) m = PDCP_SPLIT_CHUNK;
+
+        // Both copies while both rings have room
+        uint32_t both = m < room0 ? m : room0;
+        if (both > room1) both = room1;
+        for (uint32_t i = 0; i < both; i++) {
+            v[i] = pdu[done + i];
+            v[i].flags |= PDCP_SPLIT_F_DUP;
+            l2_buf_get(sp->pool, v[i].buf);
+        }
+        pdcp_tx_push(sp, 0, v, both);
+        pdcp_tx_push(sp, 1, v, both);
+        done += both;
+        if (both == m) continue;
+
+        /*
+         * One ring is full: send the rest of the chunk once, on the other
+         * leg, without the duplicate flag, since there is no copy whose
+         * delivery could make it obsolete.
+         */
+        int leg = room0 > room1 ? 0 : 1;
+        uint32_t one = m - both;
+        for (uint32_t i = 0; i < one; i++) {
+            v[i] = pdu[done + i];
+            v[i].flags &= ~PDCP_SPLIT_F_DUP;
+        }
+        uint32_t k = pdcp_tx_push(sp, leg, v, one);
+        sp->dup_single += k;
+        done += k;
+        if (k < one) break;
+    }
+    return done;
+}
+
+uint32_t pdcp_split_tx_burst(pdcp_split_t *sp, const pdcp_split_pdu_t *pdu, uint32_t n) {
+    if (!n) return 0;
+    int p = sp->cfg.primary;
+
+    if (sp->cfg.mode == PDCP_SPLIT_DUPLICATE) {
+        uint32_t k = pdcp_tx_dup(sp, pdu, n);
+        sp->tx_ring_full += n - k;
+        return k;
+    }
+    if (sp->cfg.mode == PDCP_SPLIT_PRIMARY) {
+        uint32_t k = pdcp_tx_push(sp, p, pdu, n);
+        sp->tx_ring_full += n - k;
+        return k;
+    }
+
+    uint64_t S = 0;
+    for (uint32_t i = 0; i < n; i++) S += pdu[i].len;
+
+    // Below ul-DataSplitThreshold the primary leg carries everything
+    uint32_t first;
+    int leg;
+    if (pdcp_leg_queued(&sp->leg[0]) + pdcp_leg_queued(&sp->leg[1]) + S < sp->cfg.split_threshold) {
+        sp->threshold_bursts++;
+        leg = p;
+        first = n;
+    } else {
+        // Leading PDUs up to x bytes (rounded at PDU midpoints) to leg 0
+        uint64_t x = pdcp_split_point(sp, S), cum = 0;
+        leg = 0;
+        for (first = 0; first < n && 2 * cum + pdu[first].len <= 2 * x; first++) cum += pdu[first].len;
+        if (!first) {
+            leg = 1;
+            first = n;
+        }
+    }
+
+    /*
+     * Chosen leg first, then the rest (or its overflow) to the other leg,
+     * then the other leg's overflow back to the first. The accepted PDUs
+     * are always a prefix of the burst.
+     */
+    uint32_t k = pdcp_tx_push(sp, leg, pdu, first);
+    k += pdcp_tx_push(sp, !leg, pdu + k, n - k);
+    if (k < n) k += pdcp_tx_push(sp, leg, pdu + k, n - k);
+    sp->tx_ring_full += n - k;
+    return k;
+}
+
+uint32_t pdcp_split_tx_reclaim(pdcp_split_t *sp) {
+    pdcp_split_pdu_t v[PDCP_SPLIT_CHUNK];
+    uint32_t total = 0, k;
+
+    for (int i = 0; i < PDCP_SPLIT_LEGS; i++) {
+        while ((k = pdcp_ring_pop(&sp->leg[i].tx_ret, v, PDCP_SPLIT_CHUNK))) {
+            for (uint32_t j = 0; j < k; j++) l2_buf_put(sp->pool, v[j].buf);
+            total += k;
+        }
+    }
+    return total;
+}
+
+/*----------------------------------------------------------------------------
+ * Receive (PDCP thread), TS 38.323 Section 5.2.2
+ *--------------------------------------------------------------------------*/
+
+static void pdcp_rx_release(pdcp_split_t *sp, const pdcp_split_pdu_t *pdu) {
+    pdcp_leg_t *l = &sp->leg[(pdu->flags & PDCP_SPLIT_F_LEG1) ? 1 : 0];
+    pdcp_ring_push(&l->rx_ret, pdu, 1);
+}
+
+/**
+ * Deliver the stored PDUs with COUNT below limit, skipping missing ones,
+ * then the consecutive ones after; RX_DELIV becomes the first COUNT not
+ * received.
+ */
+static uint32_t pdcp_rx_deliver(pdcp_split_t *sp, uint32_t limit) {
+    uint32_t mask = sp->cfg.reorder_slots - 1, n = 0;
+
+    for (;;) {
+        pdcp_split_pdu_t *e = &sp->rx_buf[sp->rx_deliv & mask];
+        if (e->buf == L2_BUF_NONE) {
+            if ((int32_t)(sp->rx_deliv - limit) >= 0) break;
+            sp->rx_gaps++;
+        } else {
+            const pdcp_leg_t *l = &sp->leg[(e->flags & PDCP_SPLIT_F_LEG1) ? 1 : 0];
+            sp->deliver(sp->deliver_ctx, l2_buf_data(l->rx_pool, e->buf), e->len, sp->rx_deliv);
+            pdcp_rx_release(sp, e);
+            e->buf = L2_BUF_NONE;
+            n++;
+        }
+        sp->rx_deliv++;
+    }
+    sp->rx_delivered += n;
+    return n;
+}
+
+// Start t-Reordering if a gap remains; a zero timer gives up on it at once
+static void pdcp_rx_reorder_check(pdcp_split_t *sp, tw_wheel_t *tw) {
+    if (tw_timer_running(&sp->t_reordering) && (int32_t)(sp->rx_deliv - sp->rx_reord) >= 0)
+        tw_stop(tw, &sp->t_reordering);
+    while (!tw_timer_running(&sp->t_reordering) && (int32_t)(sp->rx_deliv - sp->rx_next) < 0) {
+        sp->rx_reord = sp->rx_next;
+        if (sp->cfg.t_reordering) {
+            tw_start(tw, &sp->t_reordering, sp->cfg.t_reordering);
+        } else {
+            sp->t_reordering_expiries++;
+            pdcp_rx_deliver(sp, sp->rx_reord);
+        }
+    }
+}
+
+static uint32_t pdcp_rx_one(pdcp_split_t *sp, pdcp_split_pdu_t *pdu) {
+    const pdcp_leg_t *l = &sp->leg[(pdu->flags & PDCP_SPLIT_F_LEG1) ? 1 : 0];
+    const uint8_t *p = l2_buf_data(l->rx_pool, pdu->buf);
+    uint32_t hdr = sp->cfg.sn_bits == 12 ? 2 : 3;
+
+    if (pdu->len < 1 || !(p[0] & 0x80)) {
+        sp->rx_control++;
+        pdcp_rx_release(sp, pdu);
+        return 0;
+    }
+    if (pdu->len < hdr) {
+        sp->rx_malformed++;
+        pdcp_rx_release(sp, pdu);
+        return 0;
+    }
+
+    // RCVD_COUNT from RCVD_SN and RX_DELIV (5.2.2.1)
+    uint32_t bits = sp->cfg.sn_bits, win = 1u << (bits - 1), sn_mask = (1u << bits) - 1;
+    uint32_t sn = hdr == 2 ? ((uint32_t)(p[0] & 0x0F) << 8) | p[1]
+                           : ((uint32_t)(p[0] & 0x03) << 16) | ((uint32_t)p[1] << 8) | p[2];
+    uint32_t deliv_sn = sp->rx_deliv & sn_mask, hfn = sp->rx_deliv >> bits;
+    int stale = 0;
+    if ((int64_t)sn < (int64_t)deliv_sn - win) {
+        hfn++;
+    } else if (sn >= deliv_sn + win) {
+        if (!hfn) stale = 1;
+        hfn--;
+    }
+    uint32_t count = (hfn << bits) | sn;
+
+    uint32_t mask = sp->cfg.reorder_slots - 1;
+    if (stale || (int32_t)(count - sp->rx_deliv) < 0) {
+        sp->rx_duplicates++;
+        pdcp_rx_release(sp, pdu);
+        return 0;
+    }
+
+    // Beyond the buffer: give up on the oldest COUNTs to make room. Only
+    // then does the slot belong to this COUNT (the window is wider than
+    // the buffer), so the duplicate test compares the stored COUNT.
+    uint32_t n = 0;
+    if (count - sp->rx_deliv >= sp->cfg.reorder_slots) n += pdcp_rx_deliver(sp, count - mask);
+
+    const pdcp_split_pdu_t *e = &sp->rx_buf[count & mask];
+    if (e->buf != L2_BUF_NONE && e->count == count) {
+        sp->rx_duplicates++;
+        pdcp_rx_release(sp, pdu);
+        return n;
+    }
+
+    pdu->count = count;
+    sp->rx_buf[count & mask] = *pdu;
+    if ((int32_t)(count - sp->rx_next) >= 0) sp->rx_next = count + 1;
+    if (count == sp->rx_deliv) n += pdcp_rx_deliver(sp, count);
+    return n;
+}
+
+uint32_t pdcp_split_rx_poll(pdcp_split_t *sp, tw_wheel_t *tw) {
+    pdcp_split_pdu_t v[PDCP_SPLIT_CHUNK];
+    uint32_t n = 0, k;
+
+    for (int i = 0; i < PDCP_SPLIT_LEGS; i++) {
+        uint32_t budget = sp->cfg.ring_size;
+        while (budget && (k = pdcp_ring_pop(&sp->leg[i].rx, v, budget < PDCP_SPLIT_CHUNK ? budget : PDCP_SPLIT_CHUNK))) {
+            for (uint32_t j = 0; j < k; j++) n += pdcp_rx_one(sp, &v[j]);
+            budget -= k;
+        }
+    }
+    pdcp_rx_reorder_check(sp, tw);
+    return n;
+}
+
+void pdcp_split_t_reordering_expired(pdcp_split_t *sp, tw_wheel_t *tw) {
+    sp->t_reordering_expiries++;
+    pdcp_rx_deliver(sp, sp->rx_reord);
+    pdcp_rx_reorder_check(sp, tw);
+}
+
+/*----------------------------------------------------------------------------
+ * Leg worker
+ *--------------------------------------------------------------------------*/
+
+uint32_t pdcp_leg_tx_pop(pdcp_split_t *sp, int leg, pdcp_split_pdu_t *out, uint32_t max) {
+    pdcp_leg_t *l = &sp->leg[leg];
+    uint32_t k = pdcp_ring_pop(&l->tx, out, max);
+    if (k) {
+        uint64_t bytes = 0;
+        for (uint32_t i = 0; i < k; i++) bytes += out[i].len;
+        atomic_store_explicit(&l->st.taken_bytes,
+                              atomic_load_explicit(&l->st.taken_bytes, memory_order_relaxed) + bytes,
+                              memory_order_relaxed);
+    }
+    return k;
+}
+
+void pdcp_leg_tx_done(pdcp_split_t *sp, int leg, const pdcp_split_pdu_t *pdu, uint32_t n) {
+    pdcp_ring_push(&sp->leg[leg].tx_ret, pdu, n);
+}
+
+void pdcp_leg_report(pdcp_split_t *sp, int leg, uint64_t backlog_bytes, uint64_t sent_bytes,
+                     uint32_t delivered_count, uint64_t now_ns) {
+    pdcp_leg_t *l = &sp->leg[leg];
+
+    atomic_store_explicit(&l->st.backlog_bytes, backlog_bytes, memory_order_relaxed);
+    atomic_store_explicit(&l->st.delivered_count, delivered_count, memory_order_release);
+
+    if (!l->rate_ns) {
+        l->rate_ns = now_ns;
+        l->rate_sent = sent_bytes;
+        l->rate_backlog = backlog_bytes;
+        return;
+    }
+    uint64_t dt = now_ns - l->rate_ns;
+    if (dt < PDCP_SPLIT_RATE_MIN_NS) return;
+
+    // Only a period that started backlogged measures what the leg can drain
+    if (l->rate_backlog) {
+        int64_t sample = (int64_t)((double)(sent_bytes - l->rate_sent) * 1e9 / (double)dt);
+        int64_t rate = (int64_t)atomic_load_explicit(&l->st.rate, memory_order_relaxed);
+        rate += (sample - rate) / (1 << PDCP_SPLIT_RATE_SHIFT);
+        atomic_store_explicit(&l->st.rate, rate > 0 ? (uint64_t)rate : 1, memory_order_relaxed);
+    }
+    l->rate_ns = now_ns;
+    l->rate_sent = sent_bytes;
+    l->rate_backlog = backlog_bytes;
+}
+
+int pdcp_leg_rx_push(pdcp_split_t *sp, int leg, l2_buf_ref_t buf, uint32_t len) {
+    pdcp_split_pdu_t pdu = { .buf = buf, .len = len, .count = 0, .flags = leg ? PDCP_SPLIT_F_LEG1 : 0 };
+    return pdcp_ring_push(&sp->leg[leg].rx, &pdu, 1) ? 0 : -1;
+}
+
+uint32_t pdcp_leg_rx_reclaim(pdcp_split_t *sp, int leg, l2_buf_pool_t *pool) {
+    pdcp_split_pdu_t v[PDCP_SPLIT_CHUNK];
+    uint32_t total = 0, k;
+
+    while ((k = pdcp_ring_pop(&sp->leg[leg].rx_ret, v, PDCP_SPLIT_CHUNK))) {
+        for (uint32_t j = 0; j < k; j++) l2_buf_put(pool, v[j].buf);
+        total += k;
+    }
+    return total;
+}
@@ -0,0 +1,261 @@
+// pdcp_split.h
+#ifndef _PDCP_SPLIT_H_
+#define _PDCP_SPLIT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "l2_pool.h"
+#include "timer_wheel.h"
+
+/*============================================================================
+ * PDCP SPLIT BEARER AND DUPLICATION OVER TWO RLC LEGS
+ * Reference: 3GPP TS 38.323 Section 5.2.1 (transmit, ul-DataSplitThreshold),
+ *            5.2.2 (receive, reordering), 5.11 (PDCP duplication)
+ *            TS 37.340 Section 4.2.2 (split bearers in MR-DC)
+ *==========================================================================*/
+
+/**
+ * Split / duplicated PDCP bearer
+ *
+ * Description:
+ * One PDCP entity on its own thread serves two RLC entities ("legs",
+ * e.g. the MCG and SCG RLC in dual connectivity), each running on its
+ * leg worker. PDCP and a leg only share single-producer / single-consumer
+ * rings and single-writer status words, so neither side ever takes a
+ * lock or waits for the other:
+ *
+ *   tx      PDCP -> leg   PDCP PDUs to send (PDCP pool buffers)
+ *   tx_ret  leg -> PDCP   those buffers, once the leg is done with them
+ *   rx      leg -> PDCP   received PDCP PDUs (leg pool buffers)
+ *   rx_ret  PDCP -> leg   those buffers, once delivered or discarded
+ *
+ * l2_pool is single threaded, so a buffer is only ever allocated, shared
+ * (l2_buf_get) or released on the thread owning its pool; the other side
+ * reads it and hands the reference back on the return ring. Return rings
+ * hold at least twice the pool size, so they cannot overflow.
+ *
+ * Routing (PDCP_SPLIT_DYNAMIC) is decided once per burst. Every leg
+ * publishes its RLC backlog and an EWMA of its drain rate; PDCP adds the
+ * bytes still sitting in the leg's tx ring and the leg's fixed extra
+ * delay (e.g. Xn backhaul). It then picks the byte split x of the burst
+ * S that equalizes the predicted delay of the two legs:
+ *
+ *   d0 + (B0 + x) / R0 = d1 + (B1 + S - x) / R1
+ *
+ * and sends the first x bytes of the burst to leg 0 and the rest to leg 1,
+ * keeping runs of consecutive COUNTs on one leg. While the total backlog
+ * stays below split_threshold (ul-DataSplitThreshold), everything goes
+ * to the primary leg. PDCP_SPLIT_DUPLICATE sends every PDU on both legs;
+ * a leg drops its copy when the other leg has already had it delivered
+ * (5.11.2).
+ *
+ * Receive side: PDUs from both legs go through one reordering window
+ * (5.2.2.2): COUNT from SN and RX_DELIV, duplicates (from duplication or
+ * split retransmission) discarded by COUNT, in-order delivery, and
+ * t-Reordering on the PDCP thread's timer wheel. Integrity and ciphering
+ * are outside this module.
+ */
+#define PDCP_SPLIT_LEGS        2
+#define PDCP_SPLIT_CACHELINE   64
+#define PDCP_SPLIT_RATE_SHIFT  3          // EWMA weight 1/8
+#define PDCP_SPLIT_RATE_MIN_NS 1000000    // Rate sample period
+
+typedef enum pdcp_split_mode {
+    PDCP_SPLIT_PRIMARY   = 0,     // Primary leg only
+    PDCP_SPLIT_DYNAMIC   = 1,     // Delay-equalizing split
+    PDCP_SPLIT_DUPLICATE = 2,     // Every PDU on both legs
+} pdcp_split_mode_t;
+
+#define PDCP_SPLIT_F_DUP       0x1        // Copy of a PDU also sent on the other leg
+#define PDCP_SPLIT_F_LEG1      0x2        // Receive side: buffer belongs to leg 1
+
+typedef struct pdcp_split_pdu {
+    l2_buf_ref_t buf;
+    uint32_t len;
+    uint32_t count;            // PDCP COUNT (transmit side)
+    uint32_t flags;            // PDCP_SPLIT_F_*
+} pdcp_split_pdu_t;
+
+/**
+ * Single-producer / single-consumer PDU ring. head and tail are free
+ * running and live on separate cache lines; each side also caches the
+ * other's index so that a burst touches the shared line once.
+ */
+typedef struct pdcp_ring {
+    _Alignas(PDCP_SPLIT_CACHELINE) _Atomic uint32_t head;   // Next slot the producer writes
+    uint32_t tail_cache;                                    // Producer's view of tail
+    _Alignas(PDCP_SPLIT_CACHELINE) _Atomic uint32_t tail;   // Next slot the consumer reads
+    uint32_t head_cache;                                    // Consumer's view of head
+    _Alignas(PDCP_SPLIT_CACHELINE) uint32_t mask;
+    pdcp_split_pdu_t *slots;
+} pdcp_ring_t;
+
+static inline uint32_t pdcp_ring_push(pdcp_ring_t *r, const pdcp_split_pdu_t *pdu, uint32_t n) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - r->tail_cache + n > r->mask + 1)
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t room = r->mask + 1 - (head - r->tail_cache);
+    if (n > room) n = room;
+    for (uint32_t i = 0; i < n; i++) r->slots[(head + i) & r->mask] = pdu[i];
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+// Free slots, as seen by the producer
+static inline uint32_t pdcp_ring_room(pdcp_ring_t *r) {
+    r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+    return r->mask + 1 - (atomic_load_explicit(&r->head, memory_order_relaxed) - r->tail_cache);
+}
+
+static inline uint32_t pdcp_ring_pop(pdcp_ring_t *r, pdcp_split_pdu_t *out, uint32_t max) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (r->head_cache == tail) r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t n = r->head_cache - tail;
+    if (n > max) n = max;
+    for (uint32_t i = 0; i < n; i++) out[i] = r->slots[(tail + i) & r->mask];
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    return n;
+}
+
+// Written by the leg worker only, read by PDCP and the other leg
+typedef struct pdcp_leg_status {
+    _Alignas(PDCP_SPLIT_CACHELINE) _Atomic uint64_t taken_bytes;   // Bytes popped from tx
+    _Atomic uint64_t backlog_bytes;     // RLC queue of the leg
+    _Atomic uint64_t rate;              // Drain rate estimate, bytes/s
+    _Atomic uint32_t delivered_count;   // Every COUNT below this was delivered by the leg
+} pdcp_leg_status_t;
+
+typedef struct pdcp_leg {
+    pdcp_ring_t tx;
+    pdcp_ring_t tx_ret;
+    pdcp_ring_t rx;
+    pdcp_ring_t rx_ret;
+    pdcp_leg_status_t st;
+
+    // Leg worker private
+    uint64_t rate_ns;          // Time of the last rate sample
+    uint64_t rate_sent;        // sent_bytes at the last rate sample
+    uint64_t rate_backlog;     // Backlog at the last rate sample
+
+    // PDCP private
+    _Alignas(PDCP_SPLIT_CACHELINE) uint64_t pushed_bytes;
+    const l2_buf_pool_t *rx_pool;   // The leg's pool, read only
+    uint64_t tx_pdus, tx_bytes;
+    uint64_t dup_discards;          // Duplicates the leg dropped (peer delivered first)
+} pdcp_leg_t;
+
+typedef struct pdcp_split_cfg {
+    pdcp_split_mode_t mode;
+    uint8_t  primary;                   // Leg used below split_threshold
+    uint8_t  sn_bits;                   // 12 / 18
+    uint32_t split_threshold;           // ul-DataSplitThreshold, bytes (0 = always split)
+    uint32_t ring_size;                 // tx / rx ring slots (power of two)
+    uint32_t reorder_slots;             // Receive buffer, COUNTs (power of two)
+    uint32_t t_reordering;              // Ticks of the timer wheel, 0 = deliver gaps at once
+    uint64_t extra_delay_ns[PDCP_SPLIT_LEGS];
+    uint64_t init_rate[PDCP_SPLIT_LEGS];       // bytes/s, until measured
+} pdcp_split_cfg_t;
+
+// In-order delivery of one PDCP PDU (header included) to the upper layer
+typedef void (*pdcp_deliver_fn)(void *ctx, const uint8_t *pdu, uint32_t len, uint32_t count);
+
+typedef struct pdcp_split {
+    pdcp_split_cfg_t cfg;
+    l2_buf_pool_t *pool;                // PDCP thread's pool: tx buffers
+    pdcp_leg_t *leg;                    // [PDCP_SPLIT_LEGS], cache line aligned
+
+    // Transmit
+    uint64_t tx_ring_full;              // PDUs refused: both legs' rings full
+    uint64_t dup_single;                // Duplicates sent on one leg only (ring full)
+    uint64_t threshold_bursts;          // Bursts kept on the primary leg
+
+    // Receive (TS 38.323 Section 7.1 state variables)
+    uint32_t rx_next;
+    uint32_t rx_deliv;
+    uint32_t rx_reord;
+    pdcp_split_pdu_t *rx_buf;           // [reorder_slots], by COUNT; buf L2_BUF_NONE if empty
+    tw_timer_t t_reordering;            // kind TW_PDCP_T_REORDERING
+    pdcp_deliver_fn deliver;
+    void *deliver_ctx;
+    uint64_t rx_delivered;
+    uint64_t rx_duplicates;
+    uint64_t rx_control;                // Control PDUs, not handled here
+    uint64_t rx_malformed;
+    uint64_t rx_gaps;                   // COUNTs given up on
+    uint64_t t_reordering_expiries;
+} pdcp_split_t;
+
+/**
+ * pool: PDCP thread's pool for transmit buffers; rx_pool: each leg's
+ * pool (receive buffers). cfg ring sizes of 0 select 1024 / 4096.
+ * Returns 0, -1 on bad arguments or allocation failure.
+ */
+int  pdcp_split_init(pdcp_split_t *sp, const pdcp_split_cfg_t *cfg, l2_buf_pool_t *pool,
+                     const l2_buf_pool_t *const rx_pool[PDCP_SPLIT_LEGS], pdcp_deliver_fn deliver, void *ctx);
+void pdcp_split_destroy(pdcp_split_t *sp);
+
+/*----------------------------------------------------------------------------
+ * PDCP thread
+ *--------------------------------------------------------------------------*/
+
+/**
+ * Route a burst of PDCP PDUs (COUNT order). The bearer takes over the
+ * references of the accepted PDUs. Returns how many were accepted: a
+ * shorter count means both legs' rings are full, and the caller keeps
+ * the rest.
+ */
+uint32_t pdcp_split_tx_burst(pdcp_split_t *sp, const pdcp_split_pdu_t *pdu, uint32_t n);
+
+// Release the transmit buffers the legs have returned
+uint32_t pdcp_split_tx_reclaim(pdcp_split_t *sp);
+
+/**
+ * Receive what both legs have queued: reorder, discard duplicates,
+ * deliver in order, (re)start t-Reordering on tw. Returns PDUs delivered.
+ */
+uint32_t pdcp_split_rx_poll(pdcp_split_t *sp, tw_wheel_t *tw);
+
+// t-Reordering expiry; call from the wheel callback for TW_PDCP_T_REORDERING
+void pdcp_split_t_reordering_expired(pdcp_split_t *sp, tw_wheel_t *tw);
+
+static inline pdcp_split_t *pdcp_split_from_timer(tw_timer_t *t) {
+    return TW_CONTAINER_OF(t, pdcp_split_t, t_reordering);
+}
+
+/*----------------------------------------------------------------------------
+ * Leg worker
+ *--------------------------------------------------------------------------*/
+
+// PDUs to transmit; data is read with l2_buf_data(sp->pool, pdu->buf)
+uint32_t pdcp_leg_tx_pop(pdcp_split_t *sp, int leg, pdcp_split_pdu_t *out, uint32_t max);
+
+// Hand transmit buffers back to PDCP (sent, copied or dropped)
+void pdcp_leg_tx_done(pdcp_split_t *sp, int leg, const pdcp_split_pdu_t *pdu, uint32_t n);
+
+// Duplication: the other leg has already delivered this COUNT, drop the copy
+static inline int pdcp_leg_dup_obsolete(pdcp_split_t *sp, int leg, const pdcp_split_pdu_t *pdu) {
+    if (!(pdu->flags & PDCP_SPLIT_F_DUP)) return 0;
+    const pdcp_leg_t *peer = &sp->leg[!leg];
+    return (int32_t)(pdu->count - atomic_load_explicit(&peer->st.delivered_count, memory_order_acquire)) < 0;
+}
+
+/**
+ * Publish the leg's state, typically once per slot: RLC backlog, total
+ * bytes sent so far (drives the rate EWMA), and the COUNT below which
+ * everything was delivered (RLC ACKed), for duplicate discard.
+ */
+void pdcp_leg_report(pdcp_split_t *sp, int leg, uint64_t backlog_bytes, uint64_t sent_bytes,
+                     uint32_t delivered_count, uint64_t now_ns);
+
+/**
+ * Queue a received PDCP PDU (a buffer of the leg's pool) for PDCP.
+ * Returns 0, -1 if the ring is full (the leg keeps the buffer).
+ */
+int pdcp_leg_rx_push(pdcp_split_t *sp, int leg, l2_buf_ref_t buf, uint32_t len);
+
+// Release the receive buffers PDCP has returned into the leg's pool
+uint32_t pdcp_leg_rx_reclaim(pdcp_split_t *sp, int leg, l2_buf_pool_t *pool);
+
+#endif
@@ -0,0 +1,128 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perf_counters.h"
+
+#define PERF_CACHE_CONFIG(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+    const char *name;
+} perf_events[PERF_CTR_COUNT] = {
+    [PERF_CTR_CYCLES]        = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles" },
+    [PERF_CTR_INSTRUCTIONS]  = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions" },
+    [PERF_CTR_L1D_MISSES]    = { PERF_TYPE_HW_CACHE,
+                                 PERF_CACHE_CONFIG(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                                   PERF_COUNT_HW_CACHE_RESULT_MISS), "l1d_misses" },
+    [PERF_CTR_LLC_MISSES]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc_misses" },
+    [PERF_CTR_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses" },
+    [PERF_CTR_DTLB_MISSES]   = { PERF_TYPE_HW_CACHE,
+                                 PERF_CACHE_CONFIG(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                                   PERF_COUNT_HW_CACHE_RESULT_MISS), "dtlb_misses" },
+};
+
+// Leader first; the memory group falls back to its next counter that opens
+static const perf_ctr_t perf_members[PERF_GRP_COUNT][3] = {
+    [PERF_GRP_CORE]   = { PERF_CTR_CYCLES, PERF_CTR_INSTRUCTIONS, PERF_CTR_BRANCH_MISSES },
+    [PERF_GRP_MEMORY] = { PERF_CTR_L1D_MISSES, PERF_CTR_LLC_MISSES, PERF_CTR_DTLB_MISSES },
+};
+
+#define PERF_GRP_MAX_MEMBERS (sizeof(perf_members[0]) / sizeof(perf_members[0][0]))
+
+const char *perf_ctr_name(perf_ctr_t c) {
+    return (unsigned)c < PERF_CTR_COUNT ? perf_events[c].name : "unknown";
+}
+
+static int perf_event_open(struct perf_event_attr *attr, int group_fd) {
+    return (int)syscall(SYS_perf_event_open, attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void perf_group_reset(perf_group_t *g) {
+    memset(g, 0, sizeof(*g));
+    for (int c = 0; c < PERF_CTR_COUNT; c++) g->fd[c] = -1;
+    for (int k = 0; k < PERF_GRP_COUNT; k++) g->leader[k] = -1;
+}
+
+int perf_group_open(perf_group_t *g) {
+    int total = 0;
+
+    perf_group_reset(g);
+    for (int k = 0; k < PERF_GRP_COUNT; k++) {
+        for (size_t m = 0; m < PERF_GRP_MAX_MEMBERS; m++) {
+            perf_ctr_t c = perf_members[k][m];
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = perf_events[c].type;
+            attr.config = perf_events[c].config;
+            attr.disabled = g->leader[k] < 0;        // Members follow the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = perf_event_open(&attr, g->leader[k]);
+            if (fd < 0) {
+                if (c == PERF_CTR_CYCLES) return -1;
+                continue;
+            }
+            if (g->leader[k] < 0) g->leader[k] = fd;
+            g->fd[c] = fd;
+            g->slot[c] = (uint8_t)g->n_open[k]++;
+            total++;
+        }
+    }
+    return total;
+}
+
+void perf_group_close(perf_group_t *g) {
+    for (int c = 0; c < PERF_CTR_COUNT; c++)
+        if (g->fd[c] >= 0) close(g->fd[c]);
+    perf_group_reset(g);
+}
+
+void perf_group_start(perf_group_t *g) {
+    for (int k = 0; k < PERF_GRP_COUNT; k++) {
+        if (g->leader[k] < 0) continue;
+        ioctl(g->leader[k], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(g->leader[k], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+int perf_group_stop(perf_group_t *g) {
+    if (g->leader[PERF_GRP_CORE] < 0) return -1;
+    for (int k = 0; k < PERF_GRP_COUNT; k++)
+        if (g->leader[k] >= 0) ioctl(g->leader[k], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    g->counted = 0;
+    memset(g->value, 0, sizeof(g->value));
+    for (int k = 0; k < PERF_GRP_COUNT; k++) {
+        g->scale[k] = 0.0;
+        if (g->leader[k] < 0) continue;
+
+        // { nr, time_enabled, time_running, value[nr] }
+        uint64_t buf[3 + PERF_GRP_MAX_MEMBERS];
+        ssize_t n = read(g->leader[k], buf, sizeof(buf));
+        if (n < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] != g->n_open[k]) {
+            if (n >= 0) errno = EIO;
+            return -1;
+        }
+        if (!buf[2]) continue;
+
+        g->scale[k] = (double)buf[1] / (double)buf[2];
+        for (size_t m = 0; m < PERF_GRP_MAX_MEMBERS; m++) {
+            perf_ctr_t c = perf_members[k][m];
+            if (g->fd[c] < 0) continue;
+            g->value[c] = (uint64_t)((double)buf[3 + g->slot[c]] * g->scale[k]);
+            g->counted |= 1u << c;
+        }
+    }
+    return 0;
+}
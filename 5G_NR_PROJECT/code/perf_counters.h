@@ -0,0 +1,95 @@
+// perf_counters.h
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include <stdint.h>
+
+/*============================================================================
+ * HARDWARE PERFORMANCE COUNTERS (perf_event_open)
+ *==========================================================================*/
+
+/**
+ * Counter groups
+ *
+ * Description:
+ * Opens the counters below on the calling thread (user space only) as two
+ * perf_event groups:
+ *
+ *   core:   cycles (leader), instructions, branch misses
+ *   memory: L1D misses (leader), LLC misses, dTLB misses
+ *
+ * Members of a group are scheduled onto the PMU together and read with a
+ * single read() that returns all values for the same interval, so IPC
+ * compares cycles and instructions of one interval. Counters the CPU or
+ * kernel does not offer are skipped and reported as unavailable; the
+ * memory group is led by its first counter that opens, and everything
+ * works as long as the cycles leader opens.
+ *
+ * A group is scheduled all or nothing, and all six events in one group
+ * do not fit the PMU of most cores, so such a group was never scheduled.
+ * Three events per group fit next to the fixed counters. A group that
+ * still never runs (PMU taken by other users) leaves time_running at 0;
+ * perf_group_stop() then leaves its counters out of counted so the values
+ * are not mistaken for zero events. A group that shares the PMU is
+ * time-sliced; its values are scaled by its own time_enabled /
+ * time_running.
+ *
+ * Needs perf_event_paranoid <= 2 (or CAP_PERFMON) for user-space counting.
+ */
+typedef enum perf_ctr {
+    PERF_CTR_CYCLES = 0,          // Core group leader
+    PERF_CTR_INSTRUCTIONS,
+    PERF_CTR_L1D_MISSES,          // L1D read misses, memory group leader
+    PERF_CTR_LLC_MISSES,
+    PERF_CTR_BRANCH_MISSES,
+    PERF_CTR_DTLB_MISSES,         // dTLB read misses
+    PERF_CTR_COUNT
+} perf_ctr_t;
+
+typedef enum perf_grp {
+    PERF_GRP_CORE = 0,
+    PERF_GRP_MEMORY,
+    PERF_GRP_COUNT
+} perf_grp_t;
+
+typedef struct perf_group {
+    int fd[PERF_CTR_COUNT];       // -1 when unavailable
+    uint8_t slot[PERF_CTR_COUNT]; // Position in its group's read buffer
+    int leader[PERF_GRP_COUNT];   // -1 when no counter of the group opened
+    uint32_t n_open[PERF_GRP_COUNT];
+    uint64_t value[PERF_CTR_COUNT];
+    double scale[PERF_GRP_COUNT]; // time_enabled / time_running of the last read
+    uint32_t counted;             // Bit c: counter c ran during the last interval
+} perf_group_t;
+
+/**
+ * Open both groups for the calling thread, initially disabled.
+ * Returns the number of counters opened, -1 (errno set) if not even the
+ * cycles leader could be opened.
+ */
+int  perf_group_open(perf_group_t *g);
+void perf_group_close(perf_group_t *g);
+
+// Reset and enable all counters of both groups
+void perf_group_start(perf_group_t *g);
+
+/**
+ * Disable the groups and read them into value[]. Returns 0, -1 on read
+ * failure. Counters of a group that was not scheduled read 0 and are
+ * left out of counted.
+ */
+int  perf_group_stop(perf_group_t *g);
+
+static inline int perf_group_has(const perf_group_t *g, perf_ctr_t c) {
+    return g->fd[c] >= 0;
+}
+
+// Opened, and its group was scheduled during the last interval
+static inline int perf_group_counted(const perf_group_t *g, perf_ctr_t c) {
+    return (g->counted >> c) & 1;
+}
+
+// JSON-friendly counter name ("cycles", "l1d_misses", ...)
+const char *perf_ctr_name(perf_ctr_t c);
+
+#endif
@@ -0,0 +1,144 @@
+// rlc_entity.h
+#ifndef _RLC_ENTITY_H_
+#define _RLC_ENTITY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "5g_nr_pdu_structures.h"
+
+/*============================================================================
+ * RLC UM / AM ENTITIES, SPECIALIZED PER MODE AND SN LENGTH
+ * Reference: 3GPP TS 38.322 Section 5.2, 6.2.2
+ *==========================================================================*/
+
+/**
+ * Specialized RLC entities
+ *
+ * Description:
+ * 5g_nr_pdu_structures.h has one header layout per mode and SN length.
+ * Instead of branching on that configuration for every PDU, each
+ * supported (mode, SN length) pair gets its own copy of the header and
+ * window code, generated from rlc_entity_impl.h with the mode and SN
+ * length as compile-time constants. Masks, window size and header
+ * lengths are folded by the compiler and the per-burst loops contain
+ * no configuration tests.
+ *
+ * A bearer binds once, at setup, to the matching rlc_entity_ops_t from
+ * the dispatch table; the data path then calls through e->ops.
+ *
+ * Instantiations:
+ *   UM 6-bit, UM 12-bit  (UM_Window_Size 32 / 2048)
+ *   AM 12-bit, AM 18-bit (AM_Window_Size 2048 / 131072)
+ *
+ * Receive side scope: window and duplicate handling (5.2.2.2, 5.2.3.2).
+ * Complete SDUs are marked received by rx_burst(); SDUs rebuilt from
+ * segments are marked by the reassembly code with rx_sdu_done().
+ */
+typedef enum rlc_mode {
+    RLC_MODE_UM = 0,
+    RLC_MODE_AM = 1,
+    RLC_MODE_COUNT
+} rlc_mode_t;
+
+// Segmentation Info (TS 38.322 Section 6.2.3.4)
+enum {
+    RLC_SI_COMPLETE = 0,
+    RLC_SI_FIRST    = 1,
+    RLC_SI_LAST     = 2,
+    RLC_SI_MIDDLE   = 3,
+};
+
+// Decoded data PDU header
+typedef struct rlc_pdu_info {
+    uint32_t sn;
+    uint16_t so;          // Segment offset (SI = last / middle)
+    uint8_t  si;
+    uint8_t  poll;        // AM only
+    uint8_t  dc;          // AM only: 0 = STATUS PDU
+    uint8_t  hdr_len;
+} rlc_pdu_info_t;
+
+typedef struct rlc_entity rlc_entity_t;
+
+typedef struct rlc_entity_ops {
+    uint8_t  mode;        // rlc_mode_t
+    uint8_t  sn_bits;
+    uint8_t  hdr_len;     // Without SO
+    uint8_t  hdr_len_so;  // With SO
+    uint32_t window;      // UM_Window_Size / AM_Window_Size
+
+    // Returns header bytes written, -1 if size is too small
+    int (*hdr_write)(uint8_t *buf, size_t size, const rlc_pdu_info_t *info);
+    // Returns header length, -1 if the PDU is shorter than its header
+    int (*hdr_parse)(const uint8_t *buf, size_t len, rlc_pdu_info_t *info);
+
+    /**
+     * Receive a burst of n data PDUs: parse headers into info[], drop
+     * PDUs outside the receive window and duplicates of complete SDUs,
+     * and move the window. Returns a bitmask of accepted PDUs. At most
+     * RLC_RX_BURST_MAX PDUs are processed; the rest are ignored.
+     */
+    uint32_t (*rx_burst)(rlc_entity_t *e, const uint8_t *const pdu[], const uint16_t len[],
+                         uint32_t n, rlc_pdu_info_t *info);
+
+    // Mark an SDU rebuilt from segments as received
+    void (*rx_sdu_done)(rlc_entity_t *e, uint32_t sn);
+} rlc_entity_ops_t;
+
+#define RLC_RX_BURST_MAX 32
+
+struct rlc_entity {
+    const rlc_entity_ops_t *ops;
+    uint32_t tx_next;           // TX_Next
+    uint32_t rx_next;           // AM: RX_Next, UM: RX_Next_Reassembly
+    uint32_t rx_next_highest;   // RX_Next_Highest
+    uint64_t *rx_bitmap;        // One bit per SN: SDU received in full
+    uint8_t  owns_bitmap;       // rx_bitmap allocated by rlc_entity_init()
+    uint64_t rx_accepted;
+    uint64_t rx_outside_window;
+    uint64_t rx_duplicate;
+    uint64_t rx_malformed;
+};
+
+// Dispatch table, NULL where a combination does not exist
+extern const rlc_entity_ops_t *const rlc_entity_ops_table[RLC_MODE_COUNT][19];
+
+static inline const rlc_entity_ops_t *rlc_entity_ops_get(rlc_mode_t mode, uint8_t sn_bits) {
+    return (mode < RLC_MODE_COUNT && sn_bits < 19) ? rlc_entity_ops_table[mode][sn_bits] : NULL;
+}
+
+// Bind e to the (mode, sn_bits) instantiation. Returns 0, -1 if unsupported.
+int  rlc_entity_init(rlc_entity_t *e, rlc_mode_t mode, uint8_t sn_bits);
+
+// Bytes of the receive window bitmap for an SN length (32 KB for 18 bits)
+size_t rlc_entity_window_bytes(uint8_t sn_bits);
+
+/**
+ * As rlc_entity_init(), with the window bitmap supplied by the caller,
+ * typically a slice of one l2_mem_array() per worker holding the windows
+ * of all its bearers on huge pages. The bitmap is cleared here and not
+ * freed by rlc_entity_destroy().
+ */
+int  rlc_entity_init_window(rlc_entity_t *e, rlc_mode_t mode, uint8_t sn_bits, uint64_t *bitmap);
+void rlc_entity_destroy(rlc_entity_t *e);
+
+/*----------------------------------------------------------------------------
+ * STATUS PDU (TS 38.322 Section 6.2.2.5)
+ *--------------------------------------------------------------------------*/
+
+// Summary of a STATUS PDU: ACK_SN and how much it NACKs
+typedef struct rlc_status_info {
+    uint32_t ack_sn;
+    uint16_t nack_entries;     // NACK_SN fields
+    uint16_t nack_segments;    // Entries with SOstart / SOend
+    uint32_t nacked_sns;       // SNs covered, NACK ranges expanded
+} rlc_status_info_t;
+
+/**
+ * Walk a STATUS PDU with sn_bits (12 / 18) SNs.
+ * Returns the bytes consumed, -1 if it is truncated or not a STATUS PDU.
+ */
+int rlc_status_parse(const uint8_t *buf, size_t len, uint8_t sn_bits, rlc_status_info_t *st);
+
+#endif
@@ -0,0 +1,252 @@
+// rlc_entity_impl.h
+/**
+ * RLC entity template body, included by rlc_entity.c once per
+ * instantiation. Not a public header and has no include guard.
+ *
+ * Parameters (undefined again at the end):
+ *   RLC_T_NAME     function name prefix, e.g. rlc_am18
+ *   RLC_T_AM       1 for AM, 0 for UM
+ *   RLC_T_SN_BITS  6, 12 or 18
+ */
+#if !defined(RLC_T_NAME) || !defined(RLC_T_AM) || !defined(RLC_T_SN_BITS)
+#error "define RLC_T_NAME, RLC_T_AM and RLC_T_SN_BITS before including rlc_entity_impl.h"
+#endif
+
+#define RLC_T_CAT2(a, b)   a##_##b
+#define RLC_T_CAT(a, b)    RLC_T_CAT2(a, b)
+#define RLC_T_FN(f)        RLC_T_CAT(RLC_T_NAME, f)
+
+#define RLC_T_MOD          (1u << RLC_T_SN_BITS)
+#define RLC_T_SN_MASK      (RLC_T_MOD - 1)
+#define RLC_T_WINDOW       (RLC_T_MOD >> 1)
+#define RLC_T_HDR_LEN      (RLC_T_SN_BITS <= 6 ? 1 : RLC_T_SN_BITS <= 12 ? 2 : 3)
+#define RLC_T_HDR_LEN_SO   (RLC_T_HDR_LEN + 2)
+// SN bits carried in octet 0 (the rest follow in whole octets)
+#define RLC_T_SN_OCT0      (RLC_T_SN_BITS % 8 ? RLC_T_SN_BITS % 8 : 8)
+
+static inline uint32_t RLC_T_FN(mod)(uint32_t sn, uint32_t base) {
+    return (sn - base) & RLC_T_SN_MASK;
+}
+
+static inline void RLC_T_FN(mark)(rlc_entity_t *e, uint32_t sn) {
+    e->rx_bitmap[sn >> 6] |= 1ull << (sn & 63);
+}
+
+static inline int RLC_T_FN(marked)(const rlc_entity_t *e, uint32_t sn) {
+    return (int)((e->rx_bitmap[sn >> 6] >> (sn & 63)) & 1);
+}
+
+static int RLC_T_FN(hdr_write)(uint8_t *buf, size_t size, const rlc_pdu_info_t *info) {
+    uint32_t sn = info->sn & RLC_T_SN_MASK;
+    int seg = info->si >= RLC_SI_LAST;
+#if RLC_T_AM
+    int len = seg ? RLC_T_HDR_LEN_SO : RLC_T_HDR_LEN;
+    if (size < (size_t)len) return -1;
+    buf[0] = (uint8_t)(0x80 | (info->poll & 1) << 6 | (info->si & 3) << 4 | sn >> (RLC_T_SN_BITS - RLC_T_SN_OCT0));
+#else
+    // UMD PDU with a complete SDU: | SI = 00 | R R R R R R |
+    if (info->si == RLC_SI_COMPLETE) {
+        if (size < 1) return -1;
+        buf[0] = 0;
+        return 1;
+    }
+    int len = seg ? RLC_T_HDR_LEN_SO : RLC_T_HDR_LEN;
+    if (size < (size_t)len) return -1;
+    buf[0] = (uint8_t)((info->si & 3) << 6 | sn >> (RLC_T_SN_BITS - RLC_T_SN_OCT0));
+#endif
+#if RLC_T_SN_BITS > 8
+    for (int i = 1, shift = RLC_T_SN_BITS - RLC_T_SN_OCT0 - 8; shift >= 0; i++, shift -= 8)
+        buf[i] = (uint8_t)(sn >> shift);
+#endif
+    if (seg) {
+        buf[RLC_T_HDR_LEN] = (uint8_t)(info->so >> 8);
+        buf[RLC_T_HDR_LEN + 1] = (uint8_t)info->so;
+    }
+    return len;
+}
+
+static inline int RLC_T_FN(hdr_parse_inline)(const uint8_t *buf, size_t len, rlc_pdu_info_t *info) {
+    if (len < 1) return -1;
+    uint8_t b0 = buf[0];
+#if RLC_T_AM
+    info->dc = b0 >> 7;
+    info->poll = (b0 >> 6) & 1;
+    info->si = (b0 >> 4) & 3;
+    if (!info->dc) {
+        // STATUS PDU: handled by the control path
+        info->hdr_len = 1;
+        info->sn = 0;
+        info->so = 0;
+        return 1;
+    }
+#else
+    info->dc = 1;
+    info->poll = 0;
+    info->si = b0 >> 6;
+    if (info->si == RLC_SI_COMPLETE) {
+        info->sn = 0;
+        info->so = 0;
+        info->hdr_len = 1;
+        return 1;
+    }
+#endif
+    int seg = info->si >= RLC_SI_LAST;
+    int hdr_len = seg ? RLC_T_HDR_LEN_SO : RLC_T_HDR_LEN;
+    if (len < (size_t)hdr_len) return -1;
+
+    uint32_t sn = b0 & ((1u << RLC_T_SN_OCT0) - 1);
+#if RLC_T_SN_BITS > 8
+    for (int i = 1; i < RLC_T_HDR_LEN; i++) sn = sn << 8 | buf[i];
+#endif
+    info->sn = sn;
+    info->so = seg ? (uint16_t)(buf[RLC_T_HDR_LEN] << 8 | buf[RLC_T_HDR_LEN + 1]) : 0;
+    info->hdr_len = (uint8_t)hdr_len;
+    return hdr_len;
+}
+
+static int RLC_T_FN(hdr_parse)(const uint8_t *buf, size_t len, rlc_pdu_info_t *info) {
+    return RLC_T_FN(hdr_parse_inline)(buf, len, info);
+}
+
+#if RLC_T_AM
+
+// TS 38.322 Section 5.2.3.2.3: advance RX_Next past SDUs received in full
+static inline void RLC_T_FN(sdu_done_inline)(rlc_entity_t *e, uint32_t sn) {
+    if (RLC_T_FN(mod)(sn, e->rx_next) >= RLC_T_WINDOW) return;
+    RLC_T_FN(mark)(e, sn);
+    if (RLC_T_FN(mod)(sn, e->rx_next) >= RLC_T_FN(mod)(e->rx_next_highest, e->rx_next))
+        e->rx_next_highest = (sn + 1) & RLC_T_SN_MASK;
+    while (e->rx_next != e->rx_next_highest && RLC_T_FN(marked)(e, e->rx_next)) {
+        // Clear the bit so the SN is free again one wrap later
+        e->rx_bitmap[e->rx_next >> 6] &= ~(1ull << (e->rx_next & 63));
+        e->rx_next = (e->rx_next + 1) & RLC_T_SN_MASK;
+    }
+}
+
+static uint32_t RLC_T_FN(rx_burst)(rlc_entity_t *e, const uint8_t *const pdu[], const uint16_t len[],
+                                   uint32_t n, rlc_pdu_info_t *info) {
+    uint32_t accepted = 0;
+
+    if (n > RLC_RX_BURST_MAX) n = RLC_RX_BURST_MAX;
+    for (uint32_t i = 0; i < n; i++) {
+        rlc_pdu_info_t *x = &info[i];
+        if (RLC_T_FN(hdr_parse_inline)(pdu[i], len[i], x) < 0) {
+            e->rx_malformed++;
+            continue;
+        }
+        if (!x->dc) continue;   // STATUS PDUs are not data
+        // 5.2.3.2.2: discard outside RX_Next <= SN < RX_Next + AM_Window_Size
+        if (RLC_T_FN(mod)(x->sn, e->rx_next) >= RLC_T_WINDOW) {
+            e->rx_outside_window++;
+            continue;
+        }
+        if (RLC_T_FN(marked)(e, x->sn)) {
+            e->rx_duplicate++;
+            continue;
+        }
+        if (x->si == RLC_SI_COMPLETE) {
+            RLC_T_FN(sdu_done_inline)(e, x->sn);
+        } else if (RLC_T_FN(mod)(x->sn, e->rx_next) >= RLC_T_FN(mod)(e->rx_next_highest, e->rx_next)) {
+            e->rx_next_highest = (x->sn + 1) & RLC_T_SN_MASK;
+        }
+        accepted |= 1u << i;
+    }
+    e->rx_accepted += (uint64_t)__builtin_popcount(accepted);
+    return accepted;
+}
+
+#else
+
+/**
+ * UM reception (TS 38.322 Section 5.2.2.2). Complete SDUs bypass the
+ * window. Segments below RX_Next_Reassembly are discarded; a segment at
+ * or above RX_Next_Highest slides the window, pulling RX_Next_Reassembly
+ * up to RX_Next_Highest - UM_Window_Size.
+ */
+static inline void RLC_T_FN(advance)(rlc_entity_t *e) {
+    while (e->rx_next != e->rx_next_highest && RLC_T_FN(marked)(e, e->rx_next)) {
+        e->rx_bitmap[e->rx_next >> 6] &= ~(1ull << (e->rx_next & 63));
+        e->rx_next = (e->rx_next + 1) & RLC_T_SN_MASK;
+    }
+}
+
+static inline void RLC_T_FN(sdu_done_inline)(rlc_entity_t *e, uint32_t sn) {
+    uint32_t base = (e->rx_next_highest - RLC_T_WINDOW) & RLC_T_SN_MASK;
+    if (RLC_T_FN(mod)(sn, base) < RLC_T_FN(mod)(e->rx_next, base)) return;
+    RLC_T_FN(mark)(e, sn);
+    RLC_T_FN(advance)(e);
+}
+
+static uint32_t RLC_T_FN(rx_burst)(rlc_entity_t *e, const uint8_t *const pdu[], const uint16_t len[],
+                                   uint32_t n, rlc_pdu_info_t *info) {
+    uint32_t accepted = 0;
+
+    if (n > RLC_RX_BURST_MAX) n = RLC_RX_BURST_MAX;
+    for (uint32_t i = 0; i < n; i++) {
+        rlc_pdu_info_t *x = &info[i];
+        if (RLC_T_FN(hdr_parse_inline)(pdu[i], len[i], x) < 0) {
+            e->rx_malformed++;
+            continue;
+        }
+        if (x->si != RLC_SI_COMPLETE) {
+            uint32_t base = (e->rx_next_highest - RLC_T_WINDOW) & RLC_T_SN_MASK;
+            uint32_t off = RLC_T_FN(mod)(x->sn, base);
+            if (off < RLC_T_WINDOW) {
+                if (off < RLC_T_FN(mod)(e->rx_next, base)) {
+                    e->rx_outside_window++;
+                    continue;
+                }
+                if (RLC_T_FN(marked)(e, x->sn)) {
+                    e->rx_duplicate++;
+                    continue;
+                }
+            } else {
+                // Above the window: slide it so SN becomes its top
+                e->rx_next_highest = (x->sn + 1) & RLC_T_SN_MASK;
+                base = (e->rx_next_highest - RLC_T_WINDOW) & RLC_T_SN_MASK;
+                if (RLC_T_FN(mod)(e->rx_next, base) >= RLC_T_WINDOW) {
+                    // Segments of SDUs that fell out of the window are lost
+                    while (e->rx_next != base) {
+                        e->rx_bitmap[e->rx_next >> 6] &= ~(1ull << (e->rx_next & 63));
+                        e->rx_next = (e->rx_next + 1) & RLC_T_SN_MASK;
+                    }
+                    RLC_T_FN(advance)(e);
+                }
+            }
+        }
+        accepted |= 1u << i;
+    }
+    e->rx_accepted += (uint64_t)__builtin_popcount(accepted);
+    return accepted;
+}
+
+#endif
+
+static void RLC_T_FN(rx_sdu_done)(rlc_entity_t *e, uint32_t sn) {
+    RLC_T_FN(sdu_done_inline)(e, sn & RLC_T_SN_MASK);
+}
+
+static const rlc_entity_ops_t RLC_T_FN(ops) = {
+    .mode = RLC_T_AM ? RLC_MODE_AM : RLC_MODE_UM,
+    .sn_bits = RLC_T_SN_BITS,
+    .hdr_len = RLC_T_HDR_LEN,
+    .hdr_len_so = RLC_T_HDR_LEN_SO,
+    .window = RLC_T_WINDOW,
+    .hdr_write = RLC_T_FN(hdr_write),
+    .hdr_parse = RLC_T_FN(hdr_parse),
+    .rx_burst = RLC_T_FN(rx_burst),
+    .rx_sdu_done = RLC_T_FN(rx_sdu_done),
+};
+
+#undef RLC_T_CAT2
+#undef RLC_T_CAT
+#undef RLC_T_FN
+#undef RLC_T_MOD
+#undef RLC_T_SN_MASK
+#undef RLC_T_WINDOW
+#undef RLC_T_HDR_LEN
+#undef RLC_T_HDR_LEN_SO
+#undef RLC_T_SN_OCT0
+#undef RLC_T_NAME
+#undef RLC_T_AM
+#undef RLC_T_SN_BITS
@@ -0,0 +1,855 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rohc.h"
+
+/*----------------------------------------------------------------------------
+ * CRC (RFC 3095 Section 5.9), slicing-by-8
+ *
+ * All three ROHC CRCs are bit-reflected and at most 8 bits wide, so one
+ * byte-indexed table per step is enough: crc_t[0] is the classic byte
+ * table and crc_t[k][i] = crc_t[0][crc_t[k - 1][i]] advances a value over
+ * k more bytes. Eight input bytes are folded per iteration.
+ *--------------------------------------------------------------------------*/
+
+#define ROHC_CRC3_POLY  0x06   // 1 + x + x^3, reflected
+#define ROHC_CRC7_POLY  0x79   // 1 + x + x^2 + x^3 + x^6 + x^7, reflected
+#define ROHC_CRC8_POLY  0xE0   // 1 + x + x^2 + x^8, reflected
+
+#define ROHC_CRC3_INIT  0x07
+#define ROHC_CRC7_INIT  0x7F
+#define ROHC_CRC8_INIT  0xFF
+
+static uint8_t rohc_crc3_t[8][256];
+static uint8_t rohc_crc7_t[8][256];
+static uint8_t rohc_crc8_t[8][256];
+static pthread_once_t rohc_crc_once = PTHREAD_ONCE_INIT;
+
+static void rohc_crc_table(uint8_t t[8][256], uint8_t poly) {
+    for (int i = 0; i < 256; i++) {
+        uint8_t c = (uint8_t)i;
+        for (int b = 0; b < 8; b++) c = (c & 1) ? (uint8_t)((c >> 1) ^ poly) : (uint8_t)(c >> 1);
+        t[0][i] = c;
+    }
+    for (int k = 1; k < 8; k++)
+        for (int i = 0; i < 256; i++) t[k][i] = t[0][t[k - 1][i]];
+}
+
+static void rohc_crc_init(void) {
+    rohc_crc_table(rohc_crc3_t, ROHC_CRC3_POLY);
+    rohc_crc_table(rohc_crc7_t, ROHC_CRC7_POLY);
+    rohc_crc_table(rohc_crc8_t, ROHC_CRC8_POLY);
+}
+
+static uint8_t rohc_crc(uint8_t t[8][256], uint8_t crc, const uint8_t *p, size_t n) {
+    while (n >= 8) {
+        crc = t[7][p[0] ^ crc] ^ t[6][p[1]] ^ t[5][p[2]] ^ t[4][p[3]] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) crc = t[0][*p++ ^ crc];
+    return crc;
+}
+
+/*----------------------------------------------------------------------------
+ * Uncompressed headers
+ *--------------------------------------------------------------------------*/
+
+#define ROHC_IPV4_LEN   20
+#define ROHC_UDP_LEN    8
+#define ROHC_RTP_LEN    12
+#define ROHC_IP_DF      0x4000
+#define ROHC_IP_MF      0x2000
+#define ROHC_IP_OFFSET  0x1FFF
+#define ROHC_IP_UDP     17
+
+// Header fields of one IPv4/UDP[/RTP] packet
+typedef struct rohc_hdr {
+    uint32_t saddr, daddr;
+    uint16_t sport, dport;
+    uint32_t ssrc;
+    uint16_t profile;
+    uint8_t  hdr_len;
+    uint8_t  tos, ttl, df;
+    uint16_t ip_id;
+    uint16_t udp_csum;
+    uint8_t  rtp_b0, rtp_b1;     // V/P/X/CC, M/PT
+    uint16_t sn;
+    uint32_t ts;
+} rohc_hdr_t;
+
+static inline uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static inline uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+static inline void wr16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)(v >> 8); p[1] = (uint8_t)v; }
+static inline void wr32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+}
+
+static int rohc_hdr_parse(const rohc_comp_t *c, const uint8_t *p, size_t len, rohc_hdr_t *h) {
+    if (len < ROHC_IPV4_LEN + ROHC_UDP_LEN || p[0] != 0x45 || p[9] != ROHC_IP_UDP) return -1;
+    if (rd16(p + 2) != len || rd16(p + 24) != len - ROHC_IPV4_LEN) return -1;
+
+    uint16_t frag = rd16(p + 6);
+    if (frag & (ROHC_IP_MF | ROHC_IP_OFFSET)) return -1;
+
+    h->tos = p[1];
+    h->ip_id = rd16(p + 4);
+    h->df = (frag & ROHC_IP_DF) != 0;
+    h->ttl = p[8];
+    h->saddr = rd32(p + 12);
+    h->daddr = rd32(p + 16);
+    h->sport = rd16(p + 20);
+    h->dport = rd16(p + 22);
+    h->udp_csum = rd16(p + 26);
+
+    const uint8_t *rtp = p + ROHC_IPV4_LEN + ROHC_UDP_LEN;
+    if (h->dport >= c->rtp_port_min && h->dport <= c->rtp_port_max &&
+        len >= ROHC_IPV4_LEN + ROHC_UDP_LEN + ROHC_RTP_LEN && (rtp[0] >> 6) == 2 && (rtp[0] & 0x0F) == 0) {
+        h->profile = ROHC_PROFILE_RTP;
+        h->hdr_len = ROHC_IPV4_LEN + ROHC_UDP_LEN + ROHC_RTP_LEN;
+        h->rtp_b0 = rtp[0];
+        h->rtp_b1 = rtp[1];
+        h->sn = rd16(rtp + 2);
+        h->ts = rd32(rtp + 4);
+        h->ssrc = rd32(rtp + 8);
+    } else {
+        h->profile = ROHC_PROFILE_UDP;
+        h->hdr_len = ROHC_IPV4_LEN + ROHC_UDP_LEN;
+        h->rtp_b0 = h->rtp_b1 = 0;
+        h->ts = h->ssrc = 0;
+    }
+    return 0;
+}
+
+/**
+ * Write the uncompressed header for payload_len bytes of payload. Both the
+ * decompressor output and the CRC input of both sides come from here, so
+ * the lengths and IP checksum are always the ones the decompressor infers.
+ */
+static void rohc_hdr_build(const rohc_hdr_t *h, size_t payload_len, uint8_t *p) {
+    uint16_t total = (uint16_t)(h->hdr_len + payload_len);
+
+    p[0] = 0x45;
+    p[1] = h->tos;
+    wr16(p + 2, total);
+    wr16(p + 4, h->ip_id);
+    wr16(p + 6, h->df ? ROHC_IP_DF : 0);
+    p[8] = h->ttl;
+    p[9] = ROHC_IP_UDP;
+    wr16(p + 10, 0);
+    wr32(p + 12, h->saddr);
+    wr32(p + 16, h->daddr);
+
+    uint32_t sum = 0;
+    for (int i = 0; i < ROHC_IPV4_LEN; i += 2) sum += rd16(p + i);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    wr16(p + 10, (uint16_t)~sum);
+
+    wr16(p + 20, h->sport);
+    wr16(p + 22, h->dport);
+    wr16(p + 24, (uint16_t)(total - ROHC_IPV4_LEN));
+    wr16(p + 26, h->udp_csum);
+
+    if (h->profile == ROHC_PROFILE_RTP) {
+        uint8_t *rtp = p + ROHC_IPV4_LEN + ROHC_UDP_LEN;
+        rtp[0] = h->rtp_b0;
+        rtp[1] = h->rtp_b1;
+        wr16(rtp + 2, h->sn);
+        wr32(rtp + 4, h->ts);
+        wr32(rtp + 8, h->ssrc);
+    }
+}
+
+/*----------------------------------------------------------------------------
+ * W-LSB (RFC 3095 Section 4.5.1)
+ *
+ * The k LSBs of v are sent; the receiver picks the value with those LSBs
+ * in [ref - p, ref - p + 2^k - 1].
+ *--------------------------------------------------------------------------*/
+
+#define ROHC_SN_P        (-1)   // SN only moves forward
+#define ROHC_TS_P(k)     ((1 << ((k) - 2)) - 1)
+
+static inline uint32_t rohc_lsb_decode(uint32_t ref, uint32_t lsb, unsigned k, int32_t p) {
+    uint32_t lo = ref - (uint32_t)p;
+    return lo + ((lsb - lo) & ((1u << k) - 1));
+}
+
+static inline uint16_t rohc_sn_decode(uint16_t ref, uint32_t lsb, unsigned k) {
+    return (uint16_t)rohc_lsb_decode(ref, lsb, k, ROHC_SN_P);
+}
+
+// RTP TS from its scaled LSBs: TS = TS_SCALED x stride + TS_OFFSET
+static inline uint32_t rohc_ts_decode(uint32_t ref_ts, uint32_t stride, uint32_t lsb, unsigned k) {
+    if (!stride) return ref_ts;
+    return rohc_lsb_decode(ref_ts / stride, lsb, k, ROHC_TS_P(k)) * stride + ref_ts % stride;
+}
+
+/*----------------------------------------------------------------------------
+ * CID coding (RFC 3095 Section 5.1.1, 4.5.6)
+ *--------------------------------------------------------------------------*/
+
+#define ROHC_ADD_CID      0xE0
+#define ROHC_PKT_IR       0xFD   // IR with dynamic chain (D = 1)
+#define ROHC_PKT_UOR2     0xC0
+#define ROHC_FEEDBACK     0xF0
+
+// Write [Add-CID] first-octet [large CID], returns bytes written (max 3)
+static size_t rohc_put_cid(uint8_t *out, int large_cid, uint16_t cid, uint8_t first) {
+    size_t n = 0;
+    if (!large_cid) {
+        if (cid) out[n++] = (uint8_t)(ROHC_ADD_CID | cid);
+        out[n++] = first;
+    } else {
+        out[n++] = first;
+        if (cid < 128) {
+            out[n++] = (uint8_t)cid;
+        } else {
+            out[n++] = (uint8_t)(0x80 | cid >> 8);
+            out[n++] = (uint8_t)cid;
+        }
+    }
+    return n;
+}
+
+// Parse [Add-CID] first-octet [large CID]; returns bytes consumed, 0 if malformed
+static size_t rohc_get_cid(const uint8_t *in, size_t len, int large_cid, uint16_t *cid, uint8_t *first) {
+    size_t n = 0;
+    *cid = 0;
+    if (!large_cid) {
+        if (len && (in[0] & 0xF0) == ROHC_ADD_CID) *cid = in[n++] & 0x0F;
+        if (n >= len) return 0;
+        *first = in[n++];
+        return n;
+    }
+    if (len < 2) return 0;
+    *first = in[n++];
+    if (!(in[n] & 0x80)) {
+        *cid = in[n++];
+    } else {
+        if (len < 3 || (in[n] & 0xC0) != 0x80) return 0;
+        *cid = (uint16_t)((in[n] & 0x3F) << 8 | in[n + 1]);
+        n += 2;
+    }
+    return n;
+}
+
+/*----------------------------------------------------------------------------
+ * Compressor
+ *--------------------------------------------------------------------------*/
+
+static inline uint32_t rohc_flow_hash(uint32_t saddr, uint32_t daddr, uint16_t sport, uint16_t dport,
+                                      uint32_t ssrc, uint16_t profile) {
+    uint64_t k = ((uint64_t)saddr << 32 | daddr) ^ ((uint64_t)sport << 48 | (uint64_t)dport << 32 | ssrc);
+    k ^= (uint64_t)profile << 16;
+    k *= 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(k >> 32);
+}
+
+static inline uint32_t rohc_ctx_hash(const rohc_comp_ctx_t *x) {
+    return rohc_flow_hash(x->saddr, x->daddr, x->sport, x->dport, x->ssrc, x->profile);
+}
+
+int rohc_comp_init(rohc_comp_t *c, uint16_t max_cid, int large_cid,
+                   uint16_t rtp_port_min, uint16_t rtp_port_max) {
+    memset(c, 0, sizeof(*c));
+    if (max_cid > (large_cid ? ROHC_LARGE_CID_MAX : ROHC_SMALL_CID_MAX)) return -1;
+    pthread_once(&rohc_crc_once, rohc_crc_init);
+
+    // Keep the flow table at most half full
+    uint32_t slots = 2;
+    while (slots < 2u * (max_cid + 1u)) slots <<= 1;
+
+    c->ctx = calloc(max_cid + 1u, sizeof(*c->ctx));
+    c->hash = calloc(slots, sizeof(*c->hash));
+    if (!c->ctx || !c->hash) {
+        rohc_comp_destroy(c);
+        return -1;
+    }
+    c->hash_mask = slots - 1;
+    c->max_cid = max_cid;
+    c->large_cid = (uint8_t)(large_cid != 0);
+    c->rtp_port_min = rtp_port_min;
+    c->rtp_port_max = rtp_port_max;
+    return 0;
+}
+
+void rohc_comp_destroy(rohc_comp_t *c) {
+    free(c->ctx);
+    free(c->hash);
+    memset(c, 0, sizeof(*c));
+}
+
+// Remove cid from the flow table (linear probing, backward-shift deletion)
+static void rohc_flow_remove(rohc_comp_t *c, uint16_t cid) {
+    uint32_t i = rohc_ctx_hash(&c->ctx[cid]) & c->hash_mask;
+    while (c->hash[i] != cid + 1u) i = (i + 1) & c->hash_mask;
+
+    for (uint32_t j = i;;) {
+        j = (j + 1) & c->hash_mask;
+        if (!c->hash[j]) break;
+        uint32_t home = rohc_ctx_hash(&c->ctx[c->hash[j] - 1]) & c->hash_mask;
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        if (((j - home) & c->hash_mask) >= ((j - i) & c->hash_mask)) {
+            c->hash[i] = c->hash[j];
+            i = j;
+        }
+    }
+    c->hash[i] = 0;
+}
+
+/**
+ * Find the context of a flow, creating one if needed. When all CIDs are in
+ * use the oldest context is recycled (CIDs are handed out round robin).
+ */
+static rohc_comp_ctx_t *rohc_flow_get(rohc_comp_t *c, const rohc_hdr_t *h, uint16_t *cid_out) {
+    uint32_t i = rohc_flow_hash(h->saddr, h->daddr, h->sport, h->dport, h->ssrc, h->profile) & c->hash_mask;
+
+    for (; c->hash[i]; i = (i + 1) & c->hash_mask) {
+        uint16_t cid = (uint16_t)(c->hash[i] - 1);
+        rohc_comp_ctx_t *x = &c->ctx[cid];
+        if (x->saddr == h->saddr && x->daddr == h->daddr && x->sport == h->sport &&
+            x->dport == h->dport && x->ssrc == h->ssrc && x->profile == h->profile) {
+            *cid_out = cid;
+            return x;
+        }
+    }
+
+    uint16_t cid = c->next_cid;
+    c->next_cid = cid == c->max_cid ? 0 : (uint16_t)(cid + 1);
+    rohc_comp_ctx_t *x = &c->ctx[cid];
+    if (x->profile) {
+        rohc_flow_remove(c, cid);
+        // The hole may have moved our probe end; look for a free slot again
+        i = rohc_flow_hash(h->saddr, h->daddr, h->sport, h->dport, h->ssrc, h->profile) & c->hash_mask;
+        while (c->hash[i]) i = (i + 1) & c->hash_mask;
+    }
+
+    memset(x, 0, sizeof(*x));
+    x->saddr = h->saddr;
+    x->daddr = h->daddr;
+    x->sport = h->sport;
+    x->dport = h->dport;
+    x->ssrc = h->ssrc;
+    x->profile = h->profile;
+    x->ir_left = ROHC_IR_REPEAT;
+    x->sn = 0xFFFF;   // First generated SN is 0
+    c->hash[i] = cid + 1u;
+    *cid_out = cid;
+    return x;
+}
+
+static inline int rohc_ipid_ok(const rohc_comp_ctx_t *x, const rohc_hdr_t *h) {
+    switch (x->ipid_mode) {
+    case ROHC_IPID_SEQ:    return (uint16_t)(h->ip_id - x->ip_id) == (uint16_t)(h->sn - x->sn);
+    case ROHC_IPID_STATIC: return h->ip_id == x->ip_id;
+    default:               return 1;
+    }
+}
+
+// Fields the small packets cannot carry
+static inline int rohc_dyn_changed(const rohc_comp_ctx_t *x, const rohc_hdr_t *h) {
+    return h->tos != x->tos || h->ttl != x->ttl || h->df != x->df ||
+           h->rtp_b0 != x->rtp_b0 || (h->rtp_b1 & 0x7F) != x->rtp_pt ||
+           (h->udp_csum != 0) != x->udp_csum || !rohc_ipid_ok(x, h);
+}
+
+// True if k SN bits (and k_ts TS_SCALED bits, 0 = TS from stride) decode h against every reference
+static int rohc_wlsb_fits(const rohc_comp_ctx_t *x, const rohc_hdr_t *h, unsigned k, unsigned k_ts) {
+    for (int r = 0; r < x->n_refs; r++) {
+        const rohc_wlsb_ref_t *ref = &x->refs[r];
+        uint16_t sn = rohc_sn_decode(ref->sn, h->sn, k);
+        if (sn != h->sn) return 0;
+        if (h->profile != ROHC_PROFILE_RTP) continue;
+
+        uint32_t ts;
+        if (k_ts) {
+            uint32_t lsb = x->ts_stride ? h->ts / x->ts_stride : 0;
+            ts = rohc_ts_decode(ref->ts, x->ts_stride, lsb, k_ts);
+        } else {
+            ts = ref->ts + x->ts_stride * (uint16_t)(sn - ref->sn);
+        }
+        if (ts != h->ts) return 0;
+    }
+    return x->n_refs != 0;
+}
+
+static void rohc_wlsb_push(rohc_comp_ctx_t *x, uint16_t sn, uint32_t ts) {
+    if (x->n_refs == ROHC_WLSB_WIDTH) {
+        memmove(&x->refs[0], &x->refs[1], (ROHC_WLSB_WIDTH - 1) * sizeof(x->refs[0]));
+        x->n_refs--;
+    }
+    x->refs[x->n_refs].sn = sn;
+    x->refs[x->n_refs].ts = ts;
+    x->n_refs++;
+}
+
+// Re-derive IP-ID behaviour and TS stride from the last packet before an IR
+static void rohc_ir_refresh(rohc_comp_ctx_t *x, const rohc_hdr_t *h, int first) {
+    if (first) {
+        x->ipid_mode = ROHC_IPID_SEQ;
+        x->ts_stride = 0;
+        return;
+    }
+    uint16_t dsn = (uint16_t)(h->sn - x->sn);
+    if (h->ip_id == x->ip_id)
+        x->ipid_mode = ROHC_IPID_STATIC;
+    else if ((uint16_t)(h->ip_id - x->ip_id) == dsn)
+        x->ipid_mode = ROHC_IPID_SEQ;
+    else
+        x->ipid_mode = ROHC_IPID_RANDOM;
+
+    uint32_t dts = h->ts - x->ts;
+    if (dsn && dts % dsn == 0) x->ts_stride = dts / dsn;
+}
+
+static size_t rohc_build_ir(const rohc_comp_t *c, uint16_t cid, const rohc_comp_ctx_t *x,
+                            const rohc_hdr_t *h, uint8_t *out) {
+    size_t n = rohc_put_cid(out, c->large_cid, cid, ROHC_PKT_IR);
+    uint8_t *p = out + n;
+
+    p[0] = (uint8_t)h->profile;
+    p[1] = 0;                         // CRC-8, filled below
+    p += 2;
+
+    // Static chain
+    wr32(p, h->saddr);
+    wr32(p + 4, h->daddr);
+    wr16(p + 8, h->sport);
+    wr16(p + 10, h->dport);
+    p += 12;
+    if (h->profile == ROHC_PROFILE_RTP) {
+        wr32(p, h->ssrc);
+        p += 4;
+    }
+
+    // Dynamic chain
+    p[0] = h->tos;
+    p[1] = h->ttl;
+    wr16(p + 2, h->ip_id);
+    p[4] = (uint8_t)(h->df << 7 | x->ipid_mode);
+    wr16(p + 5, h->udp_csum);
+    p += 7;
+    if (h->profile == ROHC_PROFILE_RTP) {
+        p[0] = h->rtp_b0;
+        p[1] = h->rtp_b1;
+        wr16(p + 2, h->sn);
+        wr32(p + 4, h->ts);
+        wr32(p + 8, x->ts_stride);
+        p += 12;
+    } else {
+        wr16(p, h->sn);
+        p += 2;
+    }
+
+    size_t len = (size_t)(p - out);
+    out[n + 1] = rohc_crc(rohc_crc8_t, ROHC_CRC8_INIT, out, len);
+    return len;
+}
+
+int rohc_compress(rohc_comp_t *c, const uint8_t *pkt, size_t len, uint8_t *out, size_t out_size) {
+    rohc_hdr_t h;
+    if (rohc_hdr_parse(c, pkt, len, &h) < 0) {
+        c->rejected++;
+        return -1;
+    }
+
+    uint16_t cid;
+    rohc_comp_ctx_t *x = rohc_flow_get(c, &h, &cid);
+    if (h.profile == ROHC_PROFILE_UDP) h.sn = (uint16_t)(x->sn + 1);
+
+    // IR + payload is the largest output
+    size_t payload = len - h.hdr_len;
+    if (out_size < payload + 3 + 2 + 16 + 7 + 12) return -1;
+
+    int first = x->n_refs == 0;
+    int changed = !first && rohc_dyn_changed(x, &h);
+    int m = (h.rtp_b1 >> 7) & 1;
+    int ir = 0;
+    size_t n;
+    uint8_t uncomp[ROHC_MAX_HDR];
+
+    if (!x->ir_left && !changed && (h.profile == ROHC_PROFILE_UDP || !m) && rohc_wlsb_fits(x, &h, 4, 0)) {
+        // UO-0: | 0 | SN (4) | CRC (3) |
+        rohc_hdr_build(&h, payload, uncomp);
+        uint8_t crc = rohc_crc(rohc_crc3_t, ROHC_CRC3_INIT, uncomp, h.hdr_len);
+        n = rohc_put_cid(out, c->large_cid, cid, (uint8_t)((h.sn & 0x0F) << 3 | crc));
+        c->uo0_sent++;
+    } else if (!x->ir_left && !changed &&
+               rohc_wlsb_fits(x, &h, h.profile == ROHC_PROFILE_RTP ? 6 : 5, 6)) {
+        // UOR-2: | 110 | TS (5) | TS | M | SN (6) | X | CRC (7) |  (UDP: | 110 | SN (5) | X | CRC (7) |)
+        rohc_hdr_build(&h, payload, uncomp);
+        uint8_t crc = rohc_crc(rohc_crc7_t, ROHC_CRC7_INIT, uncomp, h.hdr_len);
+        if (h.profile == ROHC_PROFILE_RTP) {
+            uint32_t ts_scaled = x->ts_stride ? h.ts / x->ts_stride : 0;
+            n = rohc_put_cid(out, c->large_cid, cid, (uint8_t)(ROHC_PKT_UOR2 | ((ts_scaled >> 1) & 0x1F)));
+            out[n++] = (uint8_t)((ts_scaled & 1) << 7 | m << 6 | (h.sn & 0x3F));
+        } else {
+            n = rohc_put_cid(out, c->large_cid, cid, (uint8_t)(ROHC_PKT_UOR2 | (h.sn & 0x1F)));
+        }
+        out[n++] = crc;   // X = 0
+        c->uor2_sent++;
+    } else {
+        if (changed) x->n_refs = 0;
+        rohc_ir_refresh(x, &h, first);
+        n = rohc_build_ir(c, cid, x, &h, out);
+        if (x->ir_left) x->ir_left--;
+        c->ir_sent++;
+        ir = 1;
+    }
+
+    // Fields sent in every compressed packet, not part of IR
+    if (!ir) {
+        if (x->ipid_mode == ROHC_IPID_RANDOM) {
+            wr16(out + n, h.ip_id);
+            n += 2;
+        }
+        if (h.udp_csum) {
+            wr16(out + n, h.udp_csum);
+            n += 2;
+        }
+    }
+
+    x->tos = h.tos;
+    x->ttl = h.ttl;
+    x->df = h.df;
+    x->rtp_b0 = h.rtp_b0;
+    x->rtp_pt = h.rtp_b1 & 0x7F;
+    x->udp_csum = h.udp_csum != 0;
+    x->sn = h.sn;
+    x->ip_id = h.ip_id;
+    x->ts = h.ts;
+    rohc_wlsb_push(x, h.sn, h.ts);
+
+    memcpy(out + n, pkt + h.hdr_len, payload);
+    return (int)(n + payload);
+}
+
+/*----------------------------------------------------------------------------
+ * Feedback (RFC 3095 Section 5.2.2, 5.7.6)
+ *
+ *   | 11110 | Code (3) | [Size] | [Add-CID / large CID] | feedback data |
+ *   FEEDBACK-1: | SN (8) |
+ *   FEEDBACK-2: | Acktype (2) | Mode (2) | SN (4) | SN (8) |
+ *--------------------------------------------------------------------------*/
+
+#define ROHC_MODE_O  2
+
+int rohc_feedback_build(uint8_t *fb, size_t fb_size, int large_cid, uint16_t cid,
+                        rohc_ack_type_t type, uint16_t sn) {
+    uint8_t data[5];
+    size_t n = 0;
+
+    if (!large_cid) {
+        if (cid) data[n++] = (uint8_t)(ROHC_ADD_CID | cid);
+    } else if (cid < 128) {
+        data[n++] = (uint8_t)cid;
+    } else {
+        data[n++] = (uint8_t)(0x80 | cid >> 8);
+        data[n++] = (uint8_t)cid;
+    }
+    data[n++] = (uint8_t)(type << 6 | ROHC_MODE_O << 4 | ((sn >> 8) & 0x0F));
+    data[n++] = (uint8_t)sn;
+
+    if (fb_size < n + 1) return -1;
+    fb[0] = (uint8_t)(ROHC_FEEDBACK | n);
+    memcpy(fb + 1, data, n);
+    return (int)(n + 1);
+}
+
+int rohc_comp_feedback(rohc_comp_t *c, const uint8_t *fb, size_t len) {
+    if (len < 2 || (fb[0] & 0xF8) != ROHC_FEEDBACK) return -1;
+
+    size_t size = fb[0] & 0x07, off = 1;
+    if (!size) size = fb[off++];
+    if (len < off + size || !size) return -1;
+    const uint8_t *p = fb + off;
+
+    uint16_t cid = 0;
+    if (!c->large_cid) {
+        if ((p[0] & 0xF0) == ROHC_ADD_CID) {
+            cid = p[0] & 0x0F;
+            p++;
+            size--;
+        }
+    } else if (!(p[0] & 0x80)) {
+        cid = p[0];
+        p++;
+        size--;
+    } else {
+        if (size < 2) return -1;
+        cid = (uint16_t)((p[0] & 0x3F) << 8 | p[1]);
+        p += 2;
+        size -= 2;
+    }
+    if (!size || cid > c->max_cid || !c->ctx[cid].profile) return -1;
+
+    rohc_comp_ctx_t *x = &c->ctx[cid];
+    rohc_ack_type_t type = ROHC_ACK;
+    uint16_t sn = p[0], mask = 0xFF;
+    if (size >= 2) {
+        type = (rohc_ack_type_t)(p[0] >> 6);
+        sn = (uint16_t)((p[0] & 0x0F) << 8 | p[1]);
+        mask = 0x0FFF;
+    }
+
+    switch (type) {
+    case ROHC_ACK:
+        // The decompressor holds sn: older references can go
+        for (int r = x->n_refs - 1; r >= 0; r--) {
+            if ((x->refs[r].sn & mask) != sn) continue;
+            memmove(&x->refs[0], &x->refs[r], (size_t)(x->n_refs - r) * sizeof(x->refs[0]));
+            x->n_refs = (uint8_t)(x->n_refs - r);
+            x->ir_left = 0;
+            break;
+        }
+        break;
+    case ROHC_NACK:
+        x->ir_left = 1;
+        break;
+    case ROHC_STATIC_NACK:
+        x->ir_left = ROHC_IR_REPEAT;
+        x->n_refs = 0;
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------
+ * Decompressor
+ *--------------------------------------------------------------------------*/
+
+int rohc_decomp_init(rohc_decomp_t *d, uint16_t max_cid, int large_cid) {
+    memset(d, 0, sizeof(*d));
+    if (max_cid > (large_cid ? ROHC_LARGE_CID_MAX : ROHC_SMALL_CID_MAX)) return -1;
+    pthread_once(&rohc_crc_once, rohc_crc_init);
+
+    d->ctx = calloc(max_cid + 1u, sizeof(*d->ctx));
+    if (!d->ctx) return -1;
+    d->max_cid = max_cid;
+    d->large_cid = (uint8_t)(large_cid != 0);
+    return 0;
+}
+
+void rohc_decomp_destroy(rohc_decomp_t *d) {
+    free(d->ctx);
+    memset(d, 0, sizeof(*d));
+}
+
+static void rohc_ctx_to_hdr(const rohc_decomp_ctx_t *x, rohc_hdr_t *h) {
+    h->saddr = x->saddr;
+    h->daddr = x->daddr;
+    h->sport = x->sport;
+    h->dport = x->dport;
+    h->ssrc = x->ssrc;
+    h->profile = x->profile;
+    h->hdr_len = x->profile == ROHC_PROFILE_RTP ? ROHC_IPV4_LEN + ROHC_UDP_LEN + ROHC_RTP_LEN
+                                                : ROHC_IPV4_LEN + ROHC_UDP_LEN;
+    h->tos = x->tos;
+    h->ttl = x->ttl;
+    h->df = x->df;
+    h->rtp_b0 = x->rtp_b0;
+    h->rtp_b1 = x->rtp_pt;
+}
+
+// IR: returns bytes consumed after the type octet / CID, 0 if malformed
+static size_t rohc_decomp_ir(rohc_decomp_t *d, const uint8_t *in, size_t len, size_t hdr_off,
+                             rohc_decomp_ctx_t *x, rohc_hdr_t *h) {
+    const uint8_t *p = in + hdr_off;
+    size_t avail = len - hdr_off;
+    if (avail < 2) return 0;
+
+    uint16_t profile = p[0];
+    size_t need = profile == ROHC_PROFILE_RTP ? 2 + 16 + 7 + 12 : 2 + 12 + 7 + 2;
+    if ((profile != ROHC_PROFILE_RTP && profile != ROHC_PROFILE_UDP) || avail < need) return 0;
+
+    // CRC-8 over the IR header with the CRC octet taken as zero
+    static const uint8_t zero = 0;
+    uint8_t crc = rohc_crc(rohc_crc8_t, ROHC_CRC8_INIT, in, hdr_off + 1);
+    crc = rohc_crc(rohc_crc8_t, crc, &zero, 1);
+    crc = rohc_crc(rohc_crc8_t, crc, p + 2, need - 2);
+    if (crc != p[1]) {
+        d->crc_failures++;
+        return 0;
+    }
+    p += 2;
+
+    memset(x, 0, sizeof(*x));
+    x->profile = profile;
+    x->saddr = rd32(p);
+    x->daddr = rd32(p + 4);
+    x->sport = rd16(p + 8);
+    x->dport = rd16(p + 10);
+    p += 12;
+    if (profile == ROHC_PROFILE_RTP) {
+        x->ssrc = rd32(p);
+        p += 4;
+    }
+
+    x->tos = p[0];
+    x->ttl = p[1];
+    x->ip_id = rd16(p + 2);
+    x->df = p[4] >> 7;
+    x->ipid_mode = p[4] & 0x03;
+    uint16_t udp_csum = rd16(p + 5);
+    x->udp_csum = udp_csum != 0;
+    p += 7;
+    uint8_t rtp_b1 = 0;
+    if (profile == ROHC_PROFILE_RTP) {
+        x->rtp_b0 = p[0];
+        x->rtp_pt = p[1] & 0x7F;
+        x->sn = rd16(p + 2);
+        x->ts = rd32(p + 4);
+        x->ts_stride = rd32(p + 8);
+        rtp_b1 = p[1];
+    } else {
+        x->sn = rd16(p);
+    }
+
+    rohc_ctx_to_hdr(x, h);
+    h->rtp_b1 = rtp_b1;   // IR carries the marker bit
+    h->udp_csum = udp_csum;
+    h->sn = x->sn;
+    h->ts = x->ts;
+    h->ip_id = x->ip_id;
+    return need;
+}
+
+int rohc_decompress(rohc_decomp_t *d, const uint8_t *in, size_t len, uint8_t *out, size_t out_size,
+                    uint8_t *fb, size_t fb_size, size_t *fb_len) {
+    uint16_t cid;
+    uint8_t first;
+    size_t off = rohc_get_cid(in, len, d->large_cid, &cid, &first);
+    if (fb_len) *fb_len = 0;
+    if (!off || cid > d->max_cid) return -1;
+
+    rohc_decomp_ctx_t *x = &d->ctx[cid];
+    rohc_hdr_t h;
+    rohc_ack_type_t fb_type = ROHC_ACK;
+    int send_fb = 0;
+
+    if (first == ROHC_PKT_IR) {
+        size_t n = rohc_decomp_ir(d, in, len, off, x, &h);
+        if (!n) {
+            x->profile = 0;
+            fb_type = ROHC_STATIC_NACK;
+            send_fb = 1;
+            goto fail;
+        }
+        off += n;
+        send_fb = 1;
+    } else if (!(first & 0x80) || (first & 0xE0) == ROHC_PKT_UOR2) {
+        if (!x->profile) {
+            d->no_context++;
+            fb_type = ROHC_STATIC_NACK;
+            send_fb = 1;
+            goto fail;
+        }
+
+        int uo0 = !(first & 0x80);
+        uint8_t crc_rx;
+        uint32_t m = 0;
+        rohc_ctx_to_hdr(x, &h);
+
+        if (uo0) {
+            h.sn = rohc_sn_decode(x->sn, (first >> 3) & 0x0F, 4);
+            h.ts = x->ts + x->ts_stride * (uint16_t)(h.sn - x->sn);
+            crc_rx = first & 0x07;
+        } else if (x->profile == ROHC_PROFILE_RTP) {
+            if (len < off + 2) goto fail;
+            m = (in[off] >> 6) & 1;
+            h.sn = rohc_sn_decode(x->sn, in[off] & 0x3F, 6);
+            h.ts = rohc_ts_decode(x->ts, x->ts_stride, (uint32_t)(first & 0x1F) << 1 | in[off] >> 7, 6);
+            crc_rx = in[off + 1] & 0x7F;
+            off += 2;
+        } else {
+            if (len < off + 1) goto fail;
+            h.sn = rohc_sn_decode(x->sn, first & 0x1F, 5);
+            crc_rx = in[off] & 0x7F;
+            off += 1;
+        }
+        h.rtp_b1 = (uint8_t)(m << 7 | x->rtp_pt);
+
+        switch (x->ipid_mode) {
+        case ROHC_IPID_SEQ:
+            h.ip_id = (uint16_t)(x->ip_id + (uint16_t)(h.sn - x->sn));
+            break;
+        case ROHC_IPID_STATIC:
+            h.ip_id = x->ip_id;
+            break;
+        default:
+            if (len < off + 2) goto fail;
+            h.ip_id = rd16(in + off);
+            off += 2;
+        }
+        h.udp_csum = 0;
+        if (x->udp_csum) {
+            if (len < off + 2) goto fail;
+            h.udp_csum = rd16(in + off);
+            off += 2;
+        }
+
+        if (out_size < h.hdr_len + (len - off)) goto fail;
+        rohc_hdr_build(&h, len - off, out);
+        uint8_t crc = uo0 ? rohc_crc(rohc_crc3_t, ROHC_CRC3_INIT, out, h.hdr_len)
+                          : rohc_crc(rohc_crc7_t, ROHC_CRC7_INIT, out, h.hdr_len);
+        if (crc != crc_rx) {
+            d->crc_failures++;
+            fb_type = ROHC_NACK;
+            send_fb = 1;
+            goto fail;
+        }
+        x->sn = h.sn;
+        x->ts = h.ts;
+        x->ip_id = h.ip_id;
+    } else {
+        // UO-1, IR-DYN, segments and feedback are not produced by rohc_compress()
+        goto fail;
+    }
+
+    if (out_size < h.hdr_len + (len - off)) goto fail;
+    if (first == ROHC_PKT_IR) rohc_hdr_build(&h, len - off, out);
+    memcpy(out + h.hdr_len, in + off, len - off);
+    d->ok++;
+
+    if (send_fb && fb && fb_len) {
+        int n = rohc_feedback_build(fb, fb_size, d->large_cid, cid, fb_type, x->sn);
+        if (n > 0) *fb_len = (size_t)n;
+    }
+    return (int)(h.hdr_len + (len - off));
+
+fail:
+    if (send_fb && fb && fb_len) {
+        int n = rohc_feedback_build(fb, fb_size, d->large_cid, cid, fb_type, x->sn);
+        if (n > 0) *fb_len = (size_t)n;
+    }
+    return -1;
+}
+
+/*----------------------------------------------------------------------------
+ * PDCP Control PDU for interspersed ROHC feedback
+ *--------------------------------------------------------------------------*/
+
+#define PDCP_ROHC_FB_HDR_LEN  sizeof(pdcp_control_pdu_rohc_feedback_t)
+
+int pdcp_rohc_feedback_pdu_build(uint8_t *buf, size_t size, const uint8_t *fb, size_t fb_len) {
+    if (!fb_len || size < PDCP_ROHC_FB_HDR_LEN + fb_len) return -1;
+    buf[0] = (uint8_t)(0 << 7 | PDCP_CONTROL_PDU_TYPE_ROHC_FEEDBACK << 4);
+    memcpy(buf + PDCP_ROHC_FB_HDR_LEN, fb, fb_len);
+    return (int)(PDCP_ROHC_FB_HDR_LEN + fb_len);
+}
+
+int pdcp_rohc_feedback_pdu_parse(const uint8_t *pdu, size_t len, const uint8_t **fb, size_t *fb_len) {
+    if (len <= PDCP_ROHC_FB_HDR_LEN || (pdu[0] >> 7) != 0 ||
+        ((pdu[0] >> 4) & 0x07) != PDCP_CONTROL_PDU_TYPE_ROHC_FEEDBACK)
+        return -1;
+    *fb = pdu + PDCP_ROHC_FB_HDR_LEN;
+    *fb_len = len - PDCP_ROHC_FB_HDR_LEN;
+    return 0;
+}
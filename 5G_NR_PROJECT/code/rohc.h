@@ -0,0 +1,179 @@
+// rohc.h
+#ifndef _ROHC_H_
+#define _ROHC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "5g_nr_pdu_structures.h"
+
+/*============================================================================
+ * ROHC HEADER COMPRESSION (PROFILES 0x0001 RTP/UDP/IP, 0x0002 UDP/IP)
+ * Reference: RFC 3095, RFC 5795, 3GPP TS 38.323 Section 5.7
+ *==========================================================================*/
+
+/**
+ * ROHC compressor / decompressor
+ *
+ * Description:
+ * One rohc_comp_t / rohc_decomp_t pair per PDCP bearer with header
+ * compression configured. Per-flow contexts live in arrays indexed by CID,
+ * so the decompressor resolves a packet's context with one array index.
+ * The compressor maps a flow (addresses, ports, SSRC) to its CID with an
+ * open-addressing hash table sized at init; no allocation happens per
+ * packet.
+ *
+ * Packet types:
+ * - IR:    full static + dynamic chain, sent at context start, on any
+ *          change that the small packets cannot express and on NACK
+ * - UO-0:  1 byte, SN (4 LSBs) + CRC-3; M = 0 and TS follows the stride
+ * - UOR-2: 3 bytes, SN (6 LSBs) + TS_SCALED (6 LSBs) + M + CRC-7 for RTP,
+ *          SN (5 LSBs) + CRC-7 for UDP
+ *
+ * SN and TS_SCALED are W-LSB encoded against the window of references the
+ * decompressor may still hold (RFC 3095 Section 4.5.2). ACK feedback
+ * shrinks the window, NACK / STATIC-NACK force the context back to IR.
+ * The IR dynamic chain also carries TS_STRIDE, which RFC 3095 sends in
+ * Extension 3.
+ *
+ * CRC-3, CRC-7 and CRC-8 (RFC 3095 Section 5.9) are computed with
+ * slicing-by-8 tables: eight header bytes per step, one table lookup per
+ * byte and no per-bit work.
+ *
+ * Limits: IPv4 without options or fragmentation, RTP without CSRCs.
+ * Other packets are rejected and must be sent on a bearer without ROHC.
+ */
+#define ROHC_PROFILE_RTP      0x0001
+#define ROHC_PROFILE_UDP      0x0002
+
+#define ROHC_SMALL_CID_MAX    15
+#define ROHC_LARGE_CID_MAX    16383
+#define ROHC_WLSB_WIDTH       4      // References kept per context
+#define ROHC_IR_REPEAT        3      // IR packets sent before going optimistic
+#define ROHC_MAX_HDR          40     // IPv4 + UDP + RTP
+
+typedef enum rohc_ipid_mode {
+    ROHC_IPID_SEQ    = 0,   // IP-ID - SN is constant
+    ROHC_IPID_STATIC = 1,   // IP-ID never changes (e.g. 0 with DF set)
+    ROHC_IPID_RANDOM = 2,   // Sent in full in every packet
+} rohc_ipid_mode_t;
+
+typedef enum rohc_ack_type {
+    ROHC_ACK         = 0,
+    ROHC_NACK        = 1,
+    ROHC_STATIC_NACK = 2,
+} rohc_ack_type_t;
+
+typedef struct rohc_wlsb_ref {
+    uint16_t sn;
+    uint32_t ts;
+} rohc_wlsb_ref_t;
+
+typedef struct rohc_comp_ctx {
+    // Static chain
+    uint32_t saddr, daddr;
+    uint16_t sport, dport;
+    uint32_t ssrc;
+    uint16_t profile;          // 0 = free slot
+    uint8_t  ir_left;          // IR packets still to send
+    uint8_t  ipid_mode;        // rohc_ipid_mode_t
+    // Dynamic chain as last sent
+    uint8_t  tos, ttl, df;
+    uint8_t  rtp_b0, rtp_pt;   // RTP V/P/X/CC octet, payload type
+    uint8_t  udp_csum;         // UDP checksum in use
+    uint16_t sn;               // RTP SN, or generated SN for UDP
+    uint16_t ip_id;
+    uint32_t ts;
+    uint32_t ts_stride;        // Stride the decompressor knows, 0 if none
+    // W-LSB references
+    uint8_t  n_refs;
+    rohc_wlsb_ref_t refs[ROHC_WLSB_WIDTH];
+} rohc_comp_ctx_t;
+
+typedef struct rohc_comp {
+    rohc_comp_ctx_t *ctx;      // [max_cid + 1]
+    uint32_t *hash;            // Flow hash table: CID + 1, 0 = empty
+    uint32_t hash_mask;
+    uint16_t max_cid;
+    uint16_t next_cid;         // Next CID to hand out / evict
+    uint8_t  large_cid;
+    uint16_t rtp_port_min;     // UDP destination ports treated as RTP
+    uint16_t rtp_port_max;
+    uint64_t ir_sent, uo0_sent, uor2_sent, rejected;
+} rohc_comp_t;
+
+typedef struct rohc_decomp_ctx {
+    uint32_t saddr, daddr;
+    uint16_t sport, dport;
+    uint32_t ssrc;
+    uint16_t profile;          // 0 = no context
+    uint8_t  ipid_mode;
+    uint8_t  tos, ttl, df;
+    uint8_t  rtp_b0, rtp_pt;
+    uint8_t  udp_csum;
+    uint16_t sn;
+    uint16_t ip_id;
+    uint32_t ts;
+    uint32_t ts_stride;
+} rohc_decomp_ctx_t;
+
+typedef struct rohc_decomp {
+    rohc_decomp_ctx_t *ctx;    // [max_cid + 1]
+    uint16_t max_cid;
+    uint8_t  large_cid;
+    uint64_t ok, crc_failures, no_context;
+} rohc_decomp_t;
+
+int  rohc_comp_init(rohc_comp_t *c, uint16_t max_cid, int large_cid,
+                    uint16_t rtp_port_min, uint16_t rtp_port_max);
+void rohc_comp_destroy(rohc_comp_t *c);
+
+/**
+ * Compress one IPv4/UDP[/RTP] packet into out (ROHC header + payload).
+ * Returns the output length, -1 if the packet cannot be compressed or out
+ * is too small.
+ */
+int rohc_compress(rohc_comp_t *c, const uint8_t *pkt, size_t len, uint8_t *out, size_t out_size);
+
+// Apply one ROHC feedback packet (11110 prefix). Returns 0, -1 if malformed.
+int rohc_comp_feedback(rohc_comp_t *c, const uint8_t *fb, size_t len);
+
+int  rohc_decomp_init(rohc_decomp_t *d, uint16_t max_cid, int large_cid);
+void rohc_decomp_destroy(rohc_decomp_t *d);
+
+/**
+ * Decompress one ROHC packet into out.
+ *
+ * When fb is not NULL, a feedback packet (ACK for IR, NACK on CRC
+ * failure, STATIC-NACK without context) is written to it and its length
+ * stored in *fb_len (0 when none is needed).
+ *
+ * Returns the uncompressed packet length, -1 on failure.
+ */
+int rohc_decompress(rohc_decomp_t *d, const uint8_t *in, size_t len, uint8_t *out, size_t out_size,
+                    uint8_t *fb, size_t fb_size, size_t *fb_len);
+
+// Build a FEEDBACK-2 packet. Returns its length, -1 if fb_size is too small.
+int rohc_feedback_build(uint8_t *fb, size_t fb_size, int large_cid, uint16_t cid,
+                        rohc_ack_type_t type, uint16_t sn);
+
+/*----------------------------------------------------------------------------
+ * PDCP glue (TS 38.323 Section 6.2.3.3)
+ *--------------------------------------------------------------------------*/
+
+#define PDCP_CONTROL_PDU_TYPE_ROHC_FEEDBACK 0x1
+
+/**
+ * Wrap a ROHC feedback packet in a PDCP Control PDU for interspersed ROHC
+ * feedback: | D/C = 0 | PDU Type = 001 | R R R R | feedback ... |
+ * Returns the PDU length, -1 if it does not fit.
+ */
+int pdcp_rohc_feedback_pdu_build(uint8_t *buf, size_t size, const uint8_t *fb, size_t fb_len);
+
+/**
+ * Check a PDCP Control PDU is ROHC feedback and locate the feedback packet.
+ * Returns 0 and sets *fb / *fb_len, -1 otherwise.
+ */
+int pdcp_rohc_feedback_pdu_parse(const uint8_t *pdu, size_t len, const uint8_t **fb, size_t *fb_len);
+
+#endif
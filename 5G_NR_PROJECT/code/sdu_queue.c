@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdu_queue.h"
+
+int sdu_queue_init(sdu_queue_t *q, l2_buf_pool_t *pool, uint32_t capacity, uint64_t limit_bytes,
+                   uint64_t high_wm, uint64_t low_wm, uint64_t target_ns, uint64_t interval_ns) {
+    memset(q, 0, sizeof(*q));
+    if (!capacity || capacity > (1u << 31) || low_wm > high_wm) return -1;
+
+    uint32_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    q->ring = malloc((size_t)cap * sizeof(*q->ring));
+    if (!q->ring) return -1;
+
+    q->mask = cap - 1;
+    q->pool = pool;
+    q->limit_bytes = limit_bytes;
+    q->high_wm = high_wm;
+    q->low_wm = low_wm;
+    q->target_ns = target_ns ? target_ns : SDU_QUEUE_TARGET_NS;
+    q->interval_ns = interval_ns ? interval_ns : SDU_QUEUE_INTERVAL_NS;
+    q->rec_inv_sqrt = UINT32_MAX;
+    return 0;
+}
+
+void sdu_queue_destroy(sdu_queue_t *q) {
+    for (; q->head != q->tail; q->head++) l2_buf_put(q->pool, q->ring[q->head & q->mask].buf);
+    free(q->ring);
+    memset(q, 0, sizeof(*q));
+}
+
+uint32_t sdu_queue_purge(sdu_queue_t *q) {
+    uint32_t n = q->tail - q->head;
+    for (; q->head != q->tail; q->head++) l2_buf_put(q->pool, q->ring[q->head & q->mask].buf);
+    q->bytes = 0;
+    q->xoff = 0;
+    q->dropping = 0;
+    q->count = q->lastcount = 0;
+    q->rec_inv_sqrt = UINT32_MAX;
+    q->first_above_ns = 0;
+    return n;
+}
+
+static inline void sdu_queue_update_xoff(sdu_queue_t *q) {
+    if (!q->xoff && q->bytes > q->high_wm) {
+        q->xoff = 1;
+        q->stats.xoff_events++;
+    } else if (q->xoff && q->bytes < q->low_wm) {
+        q->xoff = 0;
+    }
+}
+
+int sdu_queue_enqueue(sdu_queue_t *q, l2_buf_ref_t buf, uint32_t len, uint64_t now_ns) {
+    if (q->tail - q->head > q->mask || q->bytes + len > q->limit_bytes) {
+        q->stats.tail_drops++;
+        q->stats.tail_drop_bytes += len;
+        l2_buf_put(q->pool, buf);
+        return -1;
+    }
+
+    sdu_queue_entry_t *e = &q->ring[q->tail++ & q->mask];
+    e->buf = buf;
+    e->len = len;
+    e->off = 0;
+    e->enq_ns = now_ns;
+
+    q->bytes += len;
+    if (len > q->maxpacket) q->maxpacket = len;
+    q->stats.enq_pkts++;
+    q->stats.enq_bytes += len;
+    sdu_queue_update_xoff(q);
+    return 0;
+}
+
+uint32_t sdu_queue_consume_head(sdu_queue_t *q, uint32_t bytes) {
+    if (q->head == q->tail) return 0;
+    sdu_queue_entry_t *e = &q->ring[q->head & q->mask];
+    if (bytes > e->len) bytes = e->len;
+    e->len -= bytes;
+    e->off += bytes;
+    q->bytes -= bytes;
+    q->stats.deq_bytes += bytes;
+    sdu_queue_update_xoff(q);
+    return e->len;
+}
+
+/*----------------------------------------------------------------------------
+ * CoDel
+ *--------------------------------------------------------------------------*/
+
+/**
+ * One Newton step towards 1 / sqrt(count) in Q0.32:
+ *   x' = x * (3 - count * x^2) / 2
+ * Run on every count change; the estimate converges over a few drops,
+ * which is all the control law needs.
+ */
+static void sdu_queue_newton_step(sdu_queue_t *q) {
+    uint64_t x = q->rec_inv_sqrt;
+    uint64_t x2 = (x * x) >> 32;
+    uint64_t val = (3ull << 32) - (uint64_t)q->count * x2;
+
+    val >>= 2;                          // Keep x * val within 64 bits
+    val = (val * x) >> (32 - 2 + 1);
+    q->rec_inv_sqrt = val > UINT32_MAX ? UINT32_MAX : (uint32_t)val;
+}
+
+// Next drop time: t + interval / sqrt(count)
+static inline uint64_t sdu_queue_control_law(const sdu_queue_t *q, uint64_t t) {
+    return t + ((q->interval_ns * q->rec_inv_sqrt) >> 32);
+}
+
+// Pop the head and decide whether CoDel may drop it (RFC 8289 dodequeue)
+static l2_buf_ref_t sdu_queue_pop(sdu_queue_t *q, uint64_t now_ns, uint32_t *len, uint32_t *off,
+                                  int *ok_to_drop) {
+    *ok_to_drop = 0;
+    if (q->head == q->tail) {
+        q->first_above_ns = 0;
+        return L2_BUF_NONE;
+    }
+
+    sdu_queue_entry_t *e = &q->ring[q->head++ & q->mask];
+    uint64_t sojourn = now_ns - e->enq_ns;
+    *len = e->len;
+    *off = e->off;
+    q->bytes -= e->len;
+    q->stats.last_sojourn_ns = sojourn;
+    if (sojourn > q->stats.max_sojourn_ns) q->stats.max_sojourn_ns = sojourn;
+
+    if (sojourn < q->target_ns || q->bytes <= q->maxpacket) {
+        // Below target, or less than one SDU left: no standing queue
+        q->first_above_ns = 0;
+    } else if (!q->first_above_ns) {
+        q->first_above_ns = now_ns + q->interval_ns;
+    } else if (now_ns >= q->first_above_ns) {
+        *ok_to_drop = 1;
+    }
+    return e->buf;
+}
+
+static inline void sdu_queue_drop(sdu_queue_t *q, l2_buf_ref_t buf, uint32_t len) {
+    q->stats.codel_drops++;
+    q->stats.codel_drop_bytes += len;
+    l2_buf_put(q->pool, buf);
+}
+
+l2_buf_ref_t sdu_queue_dequeue(sdu_queue_t *q, uint64_t now_ns, uint32_t *len, uint32_t *off) {
+    uint32_t l = 0, o = 0;
+    int ok_to_drop;
+    l2_buf_ref_t buf = sdu_queue_pop(q, now_ns, &l, &o, &ok_to_drop);
+
+    if (q->dropping) {
+        if (!ok_to_drop) {
+            q->dropping = 0;
+        } else {
+            // A partly segmented SDU is exempt; the drop waits for the next one
+            while (q->dropping && now_ns >= q->drop_next_ns && !o) {
+                sdu_queue_drop(q, buf, l);
+                q->count++;
+                sdu_queue_newton_step(q);
+                buf = sdu_queue_pop(q, now_ns, &l, &o, &ok_to_drop);
+                if (!ok_to_drop)
+                    q->dropping = 0;
+                else
+                    q->drop_next_ns = sdu_queue_control_law(q, q->drop_next_ns);
+            }
+        }
+    } else if (ok_to_drop && !o) {
+        sdu_queue_drop(q, buf, l);
+        buf = sdu_queue_pop(q, now_ns, &l, &o, &ok_to_drop);
+        q->dropping = 1;
+
+        // Resume near the previous drop rate if we left dropping recently
+        uint32_t delta = q->count - q->lastcount;
+        if (delta > 1 && now_ns - q->drop_next_ns < 16 * q->interval_ns) {
+            q->count = delta;
+            sdu_queue_newton_step(q);
+        } else {
+            q->count = 1;
+            q->rec_inv_sqrt = UINT32_MAX;
+        }
+        q->lastcount = q->count;
+        q->drop_next_ns = sdu_queue_control_law(q, now_ns);
+    }
+
+    if (buf != L2_BUF_NONE) {
+        q->stats.deq_pkts++;
+        q->stats.deq_bytes += l;
+    }
+    sdu_queue_update_xoff(q);
+    if (len) *len = l;
+    if (off) *off = o;
+    return buf;
+}
@@ -0,0 +1,133 @@
+// sdu_queue.h
+#ifndef _SDU_QUEUE_H_
+#define _SDU_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "l2_pool.h"
+
+/*============================================================================
+ * PER-BEARER RLC SDU QUEUE WITH CODEL
+ * Reference: RFC 8289 (Controlled Delay Active Queue Management)
+ *==========================================================================*/
+
+/**
+ * PDCP -> RLC SDU queue
+ *
+ * Description:
+ * One queue per DRB holds PDCP PDUs (RLC SDUs) waiting for a grant. SDUs
+ * are l2_pool buffer references in a power-of-two ring, stamped with
+ * their enqueue time. The byte count is kept up to date on every
+ * operation, so queue size queries (BSR, scheduler) are O(1).
+ *
+ * Admission (enqueue):
+ * - limit_bytes: hard cap, SDUs that would exceed it are tail dropped
+ * - high_wm / low_wm: hysteresis for PDCP flow control; xoff is set when
+ *   the backlog rises above high_wm and cleared when it falls below low_wm
+ *
+ * CoDel (dequeue):
+ * The sojourn time of every dequeued SDU is compared with target. Once it
+ * has stayed above target for a full interval, CoDel enters the dropping
+ * state and drops head SDUs at intervals of interval / sqrt(count) until
+ * the sojourn time falls below target again. This keeps the standing
+ * queue near target regardless of the link rate, so a congested DRB stops
+ * building up seconds of delay while a bursty one is left alone.
+ * An SDU that RLC has already started segmenting (off != 0) is never
+ * dropped: its first segments are on the air, and dropping the rest would
+ * only waste them. A pending drop then falls on the next SDU.
+ *
+ * The queue owns the references it holds: dropped SDUs are returned to
+ * the pool here. Not thread safe; one queue per bearer on its worker.
+ */
+#define SDU_QUEUE_TARGET_NS    5000000ull     // 5 ms
+#define SDU_QUEUE_INTERVAL_NS  100000000ull   // 100 ms
+
+typedef struct sdu_queue_entry {
+    l2_buf_ref_t buf;
+    uint32_t len;              // Bytes not yet taken by RLC
+    uint32_t off;              // Bytes already sent in segments
+    uint64_t enq_ns;
+} sdu_queue_entry_t;
+
+typedef struct sdu_queue_stats {
+    uint64_t enq_pkts, enq_bytes;
+    uint64_t deq_pkts, deq_bytes;
+    uint64_t tail_drops, tail_drop_bytes;
+    uint64_t codel_drops, codel_drop_bytes;
+    uint64_t xoff_events;
+    uint64_t max_sojourn_ns;
+    uint64_t last_sojourn_ns;
+} sdu_queue_stats_t;
+
+typedef struct sdu_queue {
+    sdu_queue_entry_t *ring;
+    uint32_t mask;             // Capacity - 1
+    uint32_t head, tail;       // Free running indexes
+    uint64_t bytes;            // Current backlog
+    l2_buf_pool_t *pool;
+
+    // Admission
+    uint64_t limit_bytes;
+    uint64_t high_wm, low_wm;
+    uint8_t  xoff;
+
+    // CoDel state (RFC 8289 Section 5)
+    uint8_t  dropping;
+    uint32_t count, lastcount;
+    uint32_t rec_inv_sqrt;     // 1 / sqrt(count), Q0.32
+    uint32_t maxpacket;        // Largest SDU seen; no drops below one of these
+    uint64_t first_above_ns;
+    uint64_t drop_next_ns;
+    uint64_t target_ns, interval_ns;
+
+    sdu_queue_stats_t stats;
+} sdu_queue_t;
+
+/**
+ * capacity: SDU slots, rounded up to a power of two
+ * target_ns / interval_ns: 0 selects the RFC 8289 defaults (5 ms / 100 ms)
+ * Returns 0, -1 on allocation failure or inconsistent watermarks.
+ */
+int sdu_queue_init(sdu_queue_t *q, l2_buf_pool_t *pool, uint32_t capacity, uint64_t limit_bytes,
+                   uint64_t high_wm, uint64_t low_wm, uint64_t target_ns, uint64_t interval_ns);
+
+// Release every queued buffer and the ring
+void sdu_queue_destroy(sdu_queue_t *q);
+
+/**
+ * Drop every queued SDU and reset CoDel, keeping the ring (RLC
+ * re-establishment discards what was queued under the old keys).
+ * Returns the number of SDUs dropped.
+ */
+uint32_t sdu_queue_purge(sdu_queue_t *q);
+
+/**
+ * Queue one SDU. The queue takes the reference; on tail drop (byte limit
+ * or ring full) it is put back to the pool and -1 is returned.
+ */
+int sdu_queue_enqueue(sdu_queue_t *q, l2_buf_ref_t buf, uint32_t len, uint64_t now_ns);
+
+/**
+ * Remove the next SDU, running CoDel. Returns L2_BUF_NONE when empty.
+ * *len gets the SDU's remaining length, *off the bytes already taken
+ * from its front by sdu_queue_consume_head().
+ */
+l2_buf_ref_t sdu_queue_dequeue(sdu_queue_t *q, uint64_t now_ns, uint32_t *len, uint32_t *off);
+
+/**
+ * RLC segmentation: bytes of the head SDU were sent in a segment. The SDU
+ * stays at the head with its remaining length. Returns the bytes left.
+ */
+uint32_t sdu_queue_consume_head(sdu_queue_t *q, uint32_t bytes);
+
+static inline uint64_t sdu_queue_bytes(const sdu_queue_t *q) { return q->bytes; }
+static inline uint32_t sdu_queue_pkts(const sdu_queue_t *q) { return q->tail - q->head; }
+static inline int sdu_queue_xoff(const sdu_queue_t *q) { return q->xoff; }
+
+// Head SDU without removing it, NULL when empty
+static inline const sdu_queue_entry_t *sdu_queue_peek(const sdu_queue_t *q) {
+    return q->head == q->tail ? NULL : &q->ring[q->head & q->mask];
+}
+
+#endif
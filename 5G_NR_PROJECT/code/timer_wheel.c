@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "timer_wheel.h"
+
+void tw_init(tw_wheel_t *w, uint64_t now) {
+    memset(w, 0, sizeof(*w));
+    w->now = now;
+}
+
+static inline void tw_link(tw_timer_t **head, tw_timer_t *t) {
+    t->next = *head;
+    if (t->next) t->next->pprev = &t->next;
+    *head = t;
+    t->pprev = head;
+}
+
+void tw_enqueue(tw_wheel_t *w, tw_timer_t *t) {
+    if (t->expires < w->now) t->expires = w->now;
+    uint64_t delta = t->expires - w->now;
+
+    if (delta < TW_L0_SLOTS) {
+        size_t slot = t->expires & (TW_L0_SLOTS - 1);
+        tw_link(&w->l0[slot], t);
+        w->l0_busy[slot / 64] |= 1ull << (slot % 64);
+        return;
+    }
+
+    // Level l (1..4) covers delta < 2^(8 + 6 * l)
+    int l = 1;
+    while (l < TW_LEVELS - 1 && delta >= 1ull << (TW_L0_BITS + TW_LN_BITS * l)) l++;
+    if (delta > TW_MAX_DELTA) t->expires = w->now + TW_MAX_DELTA;
+
+    unsigned shift = TW_L0_BITS + TW_LN_BITS * (l - 1);
+    tw_link(&w->ln[l - 1][(t->expires >> shift) & (TW_LN_SLOTS - 1)], t);
+}
+
+/**
+ * Called when level 0 wraps at tick w->now: move the timers of the level-l
+ * slot that covers the new block one or more levels down. Higher levels
+ * cascade first when they wrap too.
+ */
+static void tw_cascade(tw_wheel_t *w) {
+    for (int l = 1; l < TW_LEVELS; l++) {
+        unsigned shift = TW_L0_BITS + TW_LN_BITS * (l - 1);
+        size_t idx = (w->now >> shift) & (TW_LN_SLOTS - 1);
+
+        tw_timer_t *t = w->ln[l - 1][idx];
+        w->ln[l - 1][idx] = NULL;
+        while (t) {
+            tw_timer_t *next = t->next;
+            tw_enqueue(w, t);
+            t = next;
+        }
+        if (idx) break;   // This level did not wrap, nothing above to pull
+    }
+}
+
+// Ticks from now to the next busy level-0 slot of the current block, or to its end
+static inline uint64_t tw_next_busy(const tw_wheel_t *w) {
+    size_t idx = w->now & (TW_L0_SLOTS - 1);
+    for (size_t word = idx / 64; word < TW_L0_SLOTS / 64; word++) {
+        uint64_t bits = w->l0_busy[word];
+        if (word == idx / 64) bits &= ~0ull << (idx % 64);
+        if (bits) return word * 64 + (size_t)__builtin_ctzll(bits) - idx;
+    }
+    return TW_L0_SLOTS - idx;
+}
+
+uint64_t tw_advance(tw_wheel_t *w, uint64_t now, tw_expire_fn fn, void *ctx) {
+    uint64_t fired = 0;
+
+    while (w->now <= now) {
+        if (!w->n_timers) {
+            w->now = now + 1;
+            break;
+        }
+        if (!(w->now & (TW_L0_SLOTS - 1))) tw_cascade(w);
+
+        // Skip idle ticks, stopping at the end of the block for the next cascade
+        uint64_t skip = tw_next_busy(w);
+        if (skip) {
+            uint64_t room = now + 1 - w->now;
+            w->now += skip < room ? skip : room;
+            continue;
+        }
+
+        size_t slot = w->now & (TW_L0_SLOTS - 1);
+        tw_timer_t *expired = w->l0[slot], *t;
+        w->l0[slot] = NULL;
+        w->l0_busy[slot / 64] &= ~(1ull << (slot % 64));
+        if (expired) expired->pprev = &expired;
+        w->now++;
+
+        /*
+         * The slot moves onto a local head, so callbacks may restart timers
+         * freely, and a tw_stop() on a sibling still pending here unlinks it
+         * from this list instead of letting it fire.
+         */
+        while ((t = expired) != NULL) {
+            expired = t->next;
+            if (expired) expired->pprev = &expired;
+            t->next = NULL;
+            t->pprev = NULL;
+            w->n_timers--;
+            fired++;
+            fn(t, ctx);
+        }
+    }
+    w->expired += fired;
+    return fired;
+}
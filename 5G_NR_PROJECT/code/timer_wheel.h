@@ -0,0 +1,141 @@
+// timer_wheel.h
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*============================================================================
+ * HIERARCHICAL TIMER WHEEL
+ * Reference: TS 38.323 Section 5.2.1 (discardTimer), 5.2.2.2 (t-Reordering)
+ *            TS 38.322 Section 5.2.2.2.4 (t-Reassembly), 5.3.3.4
+ *            (t-PollRetransmit), 5.3.4 (t-StatusProhibit)
+ *==========================================================================*/
+
+/**
+ * Per-core protocol timer wheel
+ *
+ * Description:
+ * Time is counted in ticks (normally one slot). Level 0 has 256 slots of
+ * one tick; levels 1-4 have 64 slots each covering 2^8, 2^14, 2^20 and
+ * 2^26 ticks, for a total range of 2^32 ticks. A timer sits in the level
+ * whose span covers its remaining time and is moved down a level
+ * (cascaded) when the level below wraps, so it reaches level 0 before it
+ * fires.
+ *
+ * start / stop / restart are O(1): the timer node (tw_timer_t) is embedded
+ * in the object that owns it, e.g. the discard timer in each buffered PDCP
+ * SDU, and is linked into its slot with no allocation. Expired level-0
+ * slots are detached whole and their timers are handed to the callback
+ * in one batch per tick. A bitmap of busy level-0 slots lets
+ * tw_advance() skip idle ticks.
+ *
+ * A wheel belongs to one worker thread; it is not thread safe.
+ */
+#define TW_L0_BITS     8
+#define TW_LN_BITS     6
+#define TW_LEVELS      5
+#define TW_L0_SLOTS    (1u << TW_L0_BITS)
+#define TW_LN_SLOTS    (1u << TW_LN_BITS)
+#define TW_MAX_DELTA   UINT32_MAX   // Longest timer (ticks)
+
+// Timer kinds, so one wheel serves every protocol timer of a core
+typedef enum tw_kind {
+    TW_PDCP_DISCARD,          // discardTimer, one per buffered SDU
+    TW_PDCP_T_REORDERING,
+    TW_RLC_T_REASSEMBLY,
+    TW_RLC_T_POLL_RETRANSMIT,
+    TW_RLC_T_STATUS_PROHIBIT,
+    TW_KIND_USER,             // First value free for other users
+} tw_kind_t;
+
+/**
+ * Intrusive timer node
+ *
+ * pprev points at the link that points to this node (the slot head or the
+ * previous node's next), which makes unlinking O(1) without a back
+ * pointer to the slot. pprev == NULL means the timer is not running.
+ */
+typedef struct tw_timer {
+    struct tw_timer *next;
+    struct tw_timer **pprev;
+    uint64_t expires;          // Absolute tick
+    uint32_t kind;             // tw_kind_t or user value
+    uint32_t arg;              // Free for the owner (e.g. SN)
+} tw_timer_t;
+
+#define TW_CONTAINER_OF(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+typedef struct tw_wheel {
+    uint64_t now;              // Next tick to process
+    uint64_t n_timers;         // Running timers
+    uint64_t expired;          // Total timers fired
+    uint64_t l0_busy[TW_L0_SLOTS / 64];
+    tw_timer_t *l0[TW_L0_SLOTS];
+    tw_timer_t *ln[TW_LEVELS - 1][TW_LN_SLOTS];
+} tw_wheel_t;
+
+// Called for each expired timer; it may restart t or free its owner
+typedef void (*tw_expire_fn)(tw_timer_t *t, void *ctx);
+
+void tw_init(tw_wheel_t *w, uint64_t now);
+
+static inline void tw_timer_init(tw_timer_t *t, uint32_t kind, uint32_t arg) {
+    t->next = NULL;
+    t->pprev = NULL;
+    t->expires = 0;
+    t->kind = kind;
+    t->arg = arg;
+}
+
+static inline int tw_timer_running(const tw_timer_t *t) {
+    return t->pprev != NULL;
+}
+
+// Link t into the slot covering t->expires (internal, used by start and cascade)
+void tw_enqueue(tw_wheel_t *w, tw_timer_t *t);
+
+// Fire t after ticks ticks (0 = on the next tw_advance). t must not be running.
+static inline void tw_start(tw_wheel_t *w, tw_timer_t *t, uint32_t ticks) {
+    t->expires = w->now + ticks;
+    tw_enqueue(w, t);
+    w->n_timers++;
+}
+
+static inline void tw_stop(tw_wheel_t *w, tw_timer_t *t) {
+    if (!t->pprev) return;
+    *t->pprev = t->next;
+    if (t->next) {
+        t->next->pprev = t->pprev;
+    } else {
+        // Last node of a level-0 slot: clear its busy bit if now empty
+        uintptr_t p = (uintptr_t)t->pprev, base = (uintptr_t)&w->l0[0];
+        if (p >= base && p < base + sizeof(w->l0)) {
+            size_t slot = (p - base) / sizeof(w->l0[0]);
+            if (!w->l0[slot]) w->l0_busy[slot / 64] &= ~(1ull << (slot % 64));
+        }
+    }
+    t->next = NULL;
+    t->pprev = NULL;
+    w->n_timers--;
+}
+
+static inline void tw_restart(tw_wheel_t *w, tw_timer_t *t, uint32_t ticks) {
+    tw_stop(w, t);
+    tw_start(w, t, ticks);
+}
+
+/**
+ * Process every tick up to and including now, calling fn for each timer
+ * that expires. Returns the number of timers fired.
+ */
+uint64_t tw_advance(tw_wheel_t *w, uint64_t now, tw_expire_fn fn, void *ctx);
+
+// Timer length in ticks, rounded up (e.g. discardTimer ms with 500 us slots)
+static inline uint32_t tw_ms_to_ticks(uint32_t ms, uint32_t tick_us) {
+    uint64_t t = ((uint64_t)ms * 1000 + tick_us - 1) / tick_us;
+    return t > TW_MAX_DELTA ? TW_MAX_DELTA : (uint32_t)t;
+}
+
+#endif
@@ -0,0 +1,273 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define UE_CTX_X86 1
+#endif
+
+#include "ue_ctx_store.h"
+
+_Static_assert(sizeof(ue_ctx_t) <= UE_CTX_SLOT_SIZE, "UE context must fit its slot");
+_Static_assert(sizeof(ue_ctx_file_hdr_t) <= UE_CTX_HDR_SIZE, "file header must fit its page");
+
+static size_t ue_ctx_file_size(uint32_t n_slots) {
+    return UE_CTX_HDR_SIZE + (size_t)n_slots * UE_CTX_SLOT_SIZE;
+}
+
+/*----------------------------------------------------------------------------
+ * CRC32C (Castagnoli, reflected polynomial 0x82F63B78)
+ *--------------------------------------------------------------------------*/
+
+static uint32_t ue_ctx_crc_table[256];
+
+static uint32_t ue_ctx_crc_table_update(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len--) crc = (crc >> 8) ^ ue_ctx_crc_table[(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#ifdef UE_CTX_X86
+// The crc32 instruction computes the same CRC32C, eight bytes per step
+__attribute__((target("sse4.2")))
+static uint32_t ue_ctx_crc_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    uint64_t c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        c = _mm_crc32_u64(c, v);
+    }
+    crc = (uint32_t)c;
+    while (len--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+static uint32_t (*ue_ctx_crc_update)(uint32_t crc, const uint8_t *p, size_t len) = ue_ctx_crc_table_update;
+
+static void ue_ctx_crc_init(void) {
+    if (ue_ctx_crc_table[1]) return;
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t r = i;
+        for (int b = 0; b < 8; b++) r = (r >> 1) ^ (0x82F63B78u & (0u - (r & 1)));
+        ue_ctx_crc_table[i] = r;
+    }
+#ifdef UE_CTX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) ue_ctx_crc_update = ue_ctx_crc_sse42;
+#endif
+}
+
+static uint32_t ue_ctx_crc32c(const void *p, size_t len) {
+    return ~ue_ctx_crc_update(0xFFFFFFFFu, p, len);
+}
+
+uint32_t ue_ctx_crc(const ue_ctx_t *c) {
+    return ue_ctx_crc32c(&c->st, sizeof(c->st));
+}
+
+// Full check on reattach: the state CRC, then the RRC record against its CRC in the state
+static int ue_ctx_intact(const ue_ctx_t *c) {
+    return c->st.rrc_len <= UE_CTX_RRC_MAX && c->crc == ue_ctx_crc(c) &&
+           c->st.rrc_crc == ue_ctx_crc32c(c->rrc, c->st.rrc_len);
+}
+
+/*----------------------------------------------------------------------------
+ * Store
+ *--------------------------------------------------------------------------*/
+
+// Rebuild the process-side free list, dropping slots that were mid-update or damaged
+static void ue_ctx_store_scan(ue_ctx_store_t *s) {
+    s->n_free = 0;
+    s->restored = 0;
+    s->torn = 0;
+    s->corrupt = 0;
+
+    for (uint32_t i = s->n_slots; i-- > 0;) {
+        ue_ctx_t *c = ue_ctx_get(s, i);
+        uint64_t gen = atomic_load_explicit(&c->gen, memory_order_relaxed);
+
+        if (gen & 1) {
+            s->torn++;
+        } else if (c->st.in_use && !ue_ctx_intact(c)) {
+            s->corrupt++;
+        } else if (c->st.in_use) {
+            s->restored++;
+            continue;
+        } else {
+            s->free_list[s->n_free++] = i;   // Lowest index ends on top
+            continue;
+        }
+        // Discarded: leave the slot empty and consistent for its next user
+        memset(&c->st, 0, sizeof(c->st));
+        c->crc = ue_ctx_crc(c);
+        atomic_store_explicit(&c->gen, (gen | 1) + 1, memory_order_relaxed);
+        s->free_list[s->n_free++] = i;
+    }
+}
+
+int ue_ctx_store_open(ue_ctx_store_t *s, const char *path, uint32_t n_slots) {
+    struct stat st;
+
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    if (!n_slots) return -1;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) < 0) goto fail;
+
+    size_t size = ue_ctx_file_size(n_slots);
+    int fresh = (st.st_size == 0);
+    if (fresh && ftruncate(fd, (off_t)size) < 0) goto fail;
+    if (!fresh && (size_t)st.st_size != size) {
+        fprintf(stderr, " %s: size does not match %u UE slots.\n", path, n_slots);
+        goto fail;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) goto fail;
+
+    s->hdr = base;
+    s->slots = (uint8_t *)base + UE_CTX_HDR_SIZE;
+    s->map_len = size;
+    s->fd = fd;
+    s->n_slots = n_slots;
+
+    ue_ctx_file_hdr_t *h = s->hdr;
+    if (fresh) {
+        h->magic = UE_CTX_MAGIC;
+        h->version = UE_CTX_VERSION;
+        h->n_slots = n_slots;
+        h->slot_size = UE_CTX_SLOT_SIZE;
+        h->state_size = sizeof(ue_ctx_state_t);
+    } else if (h->magic != UE_CTX_MAGIC || h->version != UE_CTX_VERSION ||
+               h->n_slots != n_slots || h->slot_size != UE_CTX_SLOT_SIZE ||
+               h->state_size != sizeof(ue_ctx_state_t)) {
+        fprintf(stderr, " %s is not a compatible UE context file.\n", path);
+        goto fail_map;
+    }
+
+    s->free_list = malloc((size_t)n_slots * sizeof(*s->free_list));
+    s->dirty = calloc(((size_t)n_slots + 63) / 64, sizeof(*s->dirty));
+    if (!s->free_list || !s->dirty) goto fail_map;
+
+    s->was_clean = !fresh && h->clean;
+    ue_ctx_crc_init();
+    ue_ctx_store_scan(s);
+    h->clean = 0;
+    h->attach_count++;
+    return 0;
+
+fail_map:
+    munmap(base, size);
+    free(s->free_list);
+    free(s->dirty);
+fail:
+    close(fd);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    return -1;
+}
+
+int ue_ctx_store_checkpoint(ue_ctx_store_t *s) {
+    int synced = 0, ret = 0;
+
+    for (uint32_t w = 0; w < (s->n_slots + 63) / 64; w++) {
+        uint64_t bits = s->dirty[w];
+        while (bits) {
+            // Sync runs of adjacent dirty slots with one call
+            uint32_t first = (uint32_t)__builtin_ctzll(bits);
+            uint64_t rest = bits >> first;
+            uint32_t run = ~rest ? (uint32_t)__builtin_ctzll(~rest) : 64 - first;
+            uint64_t run_bits = run == 64 ? ~0ull : ((1ull << run) - 1) << first;
+            bits &= ~run_bits;
+
+            uint32_t idx = w * 64 + first;
+            if (msync(ue_ctx_get(s, idx), (size_t)run * UE_CTX_SLOT_SIZE, MS_SYNC) < 0) {
+                ret = -1;
+                continue;
+            }
+            s->dirty[w] &= ~run_bits;
+            synced += (int)run;
+        }
+    }
+    return ret < 0 ? -1 : synced;
+}
+
+void ue_ctx_store_close(ue_ctx_store_t *s, int clean) {
+    if (!s->hdr) return;
+
+    ue_ctx_store_checkpoint(s);
+    if (clean) {
+        s->hdr->clean = 1;
+        msync(s->hdr, s->map_len, MS_SYNC);
+    }
+    munmap(s->hdr, s->map_len);
+    close(s->fd);
+    free(s->free_list);
+    free(s->dirty);
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+}
+
+uint32_t ue_ctx_alloc(ue_ctx_store_t *s, uint32_t ue_id, uint16_t rnti, uint64_t now_ns) {
+    if (!s->n_free) return UE_CTX_INVALID;
+
+    uint32_t idx = s->free_list[--s->n_free];
+    ue_ctx_t *c = ue_ctx_get(s, idx);
+    ue_ctx_write_begin(c);
+    memset(&c->st, 0, sizeof(c->st));
+    c->st.ue_id = ue_id;
+    c->st.rnti = rnti;
+    c->st.in_use = 1;
+    c->st.updated_ns = now_ns;
+    ue_ctx_write_end(s, c);
+    return idx;
+}
+
+void ue_ctx_release(ue_ctx_store_t *s, uint32_t idx) {
+    ue_ctx_t *c = ue_ctx_get(s, idx);
+    if (!c->st.in_use) return;
+
+    ue_ctx_write_begin(c);
+    memset(&c->st, 0, sizeof(c->st));
+    ue_ctx_write_end(s, c);
+    s->free_list[s->n_free++] = idx;
+}
+
+uint32_t ue_ctx_next(const ue_ctx_store_t *s, uint32_t idx) {
+    for (uint32_t i = idx == UE_CTX_INVALID ? 0 : idx + 1; i < s->n_slots; i++)
+        if (ue_ctx_get(s, i)->st.in_use) return i;
+    return UE_CTX_INVALID;
+}
+
+int ue_ctx_set_rrc(ue_ctx_store_t *s, uint32_t idx, const void *rec, size_t len) {
+    if (len > UE_CTX_RRC_MAX) return -1;
+
+    // Hashed once here; state updates only rehash st, which carries this CRC
+    uint32_t rrc_crc = ue_ctx_crc32c(rec, len);
+    ue_ctx_t *c = ue_ctx_get(s, idx);
+    ue_ctx_write_begin(c);
+    memcpy(c->rrc, rec, len);
+    c->st.rrc_len = (uint32_t)len;
+    c->st.rrc_crc = rrc_crc;
+    ue_ctx_write_end(s, c);
+    return 0;
+}
+
+int ue_ctx_read(const ue_ctx_t *c, ue_ctx_state_t *out) {
+    for (int tries = 0; tries < 64; tries++) {
+        uint64_t g0 = atomic_load_explicit(&c->gen, memory_order_acquire);
+        if (g0 & 1) continue;
+        memcpy(out, &c->st, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&c->gen, memory_order_relaxed) == g0) return 0;
+    }
+    return -1;
+}
@@ -0,0 +1,188 @@
+// ue_ctx_store.h
+#ifndef _UE_CTX_STORE_H_
+#define _UE_CTX_STORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*============================================================================
+ * PERSISTENT PER-UE CONTEXT STORE (WARM RESTART)
+ * Reference: 3GPP TS 38.323 Section 7.1, TS 38.322 Section 7.1
+ *==========================================================================*/
+
+/**
+ * UE context store
+ *
+ * Description:
+ * The state a UE cannot lose without re-establishing - PDCP COUNTs (HFN
+ * and SN), RLC window variables and the last RRCReconfiguration - lives
+ * in fixed-size, page-aligned slots of a MAP_SHARED file. The data path
+ * updates it in place, so the file is always current in the page cache:
+ * a crashed or upgraded process reopens the file and reattaches every UE
+ * with one scan of the slot headers, without rebuilding anything.
+ *
+ * Consistency: each slot carries a generation counter used as a seqlock.
+ * ue_ctx_write_begin() makes it odd, ue_ctx_write_end() even again. A
+ * slot found odd on reattach was being modified when the process died;
+ * it is discarded (that UE re-establishes) and counted in torn.
+ *
+ * Durability against host crashes: ue_ctx_write_end() marks the slot in a
+ * dirty bitmap, and ue_ctx_store_checkpoint() writes back only the dirty
+ * slots (msync MS_SYNC). With one slot per UE spanning whole pages, dirty
+ * slots map directly to dirty pages and a checkpoint costs in proportion
+ * to UEs that changed. The kernel may still write a slot's two pages back
+ * separately, so after a host crash an even generation does not prove the
+ * slot whole: ue_ctx_set_rrc() stores a CRC32C of the RRC record in the
+ * state, ue_ctx_write_end() a CRC32C of the state (SSE4.2 crc32 where the
+ * CPU has it, so a state update does not rehash the RRC record), and a
+ * slot whose CRCs do not match on reattach is discarded and counted in
+ * corrupt. Changes after the last checkpoint may be lost.
+ *
+ * The RRC configuration is kept as an rrc_frozen_msg_t record (see
+ * 5G/rrc_freeze.h), i.e. flat UPER bytes that rrc_thaw() decodes back
+ * into the asn1c tree after a restart. This module only copies the bytes.
+ *
+ * File layout:
+ * +----------------------------+--------+--------+-----+
+ * | ue_ctx_file_hdr_t (1 page) | slot 0 | slot 1 | ... |
+ * +----------------------------+--------+--------+-----+
+ */
+#define UE_CTX_MAGIC          0x58435555u   // "UUCX"
+#define UE_CTX_VERSION        3
+#define UE_CTX_HDR_SIZE       4096
+#define UE_CTX_SLOT_SIZE      8192          // Two pages per UE
+#define UE_CTX_MAX_BEARERS    16
+#define UE_CTX_INVALID        UINT32_MAX
+
+typedef struct ue_ctx_bearer {
+    uint8_t  active;
+    uint8_t  lcid;
+    uint8_t  rb_id;            // DRB / SRB identity
+    uint8_t  is_srb;
+    uint8_t  pdcp_sn_bits;     // 12 / 18
+    uint8_t  rlc_mode;         // rlc_mode_t
+    uint8_t  rlc_sn_bits;
+    uint8_t  rsv;
+
+    // PDCP state variables, full COUNT values (HFN | SN)
+    uint32_t pdcp_tx_next;     // TX_NEXT
+    uint32_t pdcp_rx_next;     // RX_NEXT
+    uint32_t pdcp_rx_deliv;    // RX_DELIV
+    uint32_t pdcp_rx_reord;    // RX_REORD
+
+    // RLC state variables
+    uint32_t rlc_tx_next;      // TX_Next
+    uint32_t rlc_tx_next_ack;  // TX_Next_Ack (AM)
+    uint32_t rlc_rx_next;      // RX_Next / RX_Next_Reassembly
+    uint32_t rlc_rx_next_highest;
+} ue_ctx_bearer_t;
+
+typedef struct ue_ctx_state {
+    uint32_t ue_id;
+    uint16_t rnti;
+    uint8_t  in_use;
+    uint8_t  n_bearers;
+    uint64_t updated_ns;       // Caller supplied time of the last change
+    ue_ctx_bearer_t bearer[UE_CTX_MAX_BEARERS];
+    uint32_t rrc_len;          // Bytes of the frozen RRC record, 0 if none
+    uint32_t rrc_crc;          // CRC32C of rrc[0..rrc_len), set by ue_ctx_set_rrc()
+} ue_ctx_state_t;
+
+#define UE_CTX_RRC_MAX (UE_CTX_SLOT_SIZE - 16 - sizeof(ue_ctx_state_t))
+
+typedef struct ue_ctx {
+    _Atomic uint64_t gen;      // Odd while being written
+    uint32_t crc;              // CRC32C of st, set by ue_ctx_write_end()
+    uint32_t rsv;
+    ue_ctx_state_t st;
+    uint8_t rrc[UE_CTX_RRC_MAX];   // rrc_frozen_msg_t record, 8-byte aligned
+} ue_ctx_t;
+
+typedef struct ue_ctx_file_hdr {
+    uint32_t magic;            // UE_CTX_MAGIC
+    uint32_t version;          // UE_CTX_VERSION
+    uint32_t n_slots;
+    uint32_t slot_size;        // UE_CTX_SLOT_SIZE
+    uint32_t state_size;       // sizeof(ue_ctx_state_t), layout check
+    uint32_t clean;            // 1 after ue_ctx_store_close(.., 1)
+    uint64_t attach_count;     // Incremented on every open
+} ue_ctx_file_hdr_t;
+
+typedef struct ue_ctx_store {
+    ue_ctx_file_hdr_t *hdr;
+    uint8_t *slots;
+    size_t map_len;
+    int fd;
+    uint32_t n_slots;
+
+    uint32_t *free_list;       // Free slot indexes (process memory)
+    uint32_t n_free;
+    uint64_t *dirty;           // One bit per slot since the last checkpoint
+
+    // Result of the last open
+    uint32_t restored;         // Consistent UEs reattached
+    uint32_t torn;             // Slots discarded as mid-update
+    uint32_t corrupt;          // Slots discarded on a CRC or length mismatch
+    int      was_clean;        // Previous process closed the file cleanly
+} ue_ctx_store_t;
+
+/**
+ * Open path with n_slots UE slots. A valid existing file is reattached
+ * (n_slots must match); otherwise the file is created and sized.
+ * Returns 0, -1 on error or layout mismatch.
+ */
+int  ue_ctx_store_open(ue_ctx_store_t *s, const char *path, uint32_t n_slots);
+
+// Checkpoint and unmap; clean = 1 records an orderly shutdown
+void ue_ctx_store_close(ue_ctx_store_t *s, int clean);
+
+/**
+ * Write back the slots written since the last checkpoint and wait for the
+ * I/O. Slots that failed stay dirty for the next checkpoint.
+ * Returns slots synced, -1 if any failed.
+ */
+int  ue_ctx_store_checkpoint(ue_ctx_store_t *s);
+
+// CRC32C of a slot's state (which holds the RRC record's CRC)
+uint32_t ue_ctx_crc(const ue_ctx_t *c);
+
+static inline ue_ctx_t *ue_ctx_get(const ue_ctx_store_t *s, uint32_t idx) {
+    return (ue_ctx_t *)(s->slots + (size_t)idx * UE_CTX_SLOT_SIZE);
+}
+
+static inline uint32_t ue_ctx_index(const ue_ctx_store_t *s, const ue_ctx_t *c) {
+    return (uint32_t)(((const uint8_t *)c - s->slots) / UE_CTX_SLOT_SIZE);
+}
+
+// Claim a free slot for a new UE. Returns its index, UE_CTX_INVALID when full.
+uint32_t ue_ctx_alloc(ue_ctx_store_t *s, uint32_t ue_id, uint16_t rnti, uint64_t now_ns);
+void     ue_ctx_release(ue_ctx_store_t *s, uint32_t idx);
+
+// Next slot in use after idx (start with UE_CTX_INVALID), UE_CTX_INVALID at the end
+uint32_t ue_ctx_next(const ue_ctx_store_t *s, uint32_t idx);
+
+static inline void ue_ctx_write_begin(ue_ctx_t *c) {
+    atomic_store_explicit(&c->gen, atomic_load_explicit(&c->gen, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void ue_ctx_write_end(ue_ctx_store_t *s, ue_ctx_t *c) {
+    c->crc = ue_ctx_crc(c);
+    atomic_store_explicit(&c->gen, atomic_load_explicit(&c->gen, memory_order_relaxed) + 1,
+                          memory_order_release);
+    uint32_t idx = ue_ctx_index(s, c);
+    s->dirty[idx / 64] |= 1ull << (idx % 64);
+}
+
+// Store a frozen RRC record (bytes of an rrc_frozen_msg_t). Returns 0, -1 if too large.
+int ue_ctx_set_rrc(ue_ctx_store_t *s, uint32_t idx, const void *rec, size_t len);
+
+/**
+ * Consistent copy of a slot's state, e.g. for a monitoring reader in
+ * another process. Returns 0, -1 if the slot stayed busy.
+ */
+int ue_ctx_read(const ue_ctx_t *c, ue_ctx_state_t *out);
+
+#endif